@@ -35,7 +35,8 @@ namespace adevs
 template <class X, class T> class Network;
 template <class X, class T> class Atomic;
 template <class X, class T> class Schedule;
-template <class X, class T> class Simulator;
+template <class X, class T, class S> class Simulator;
+template <class X, class T> class TimingWheel;
 
 /*
  * Constant indicating no processor assignment for the model. This is used by the
@@ -253,8 +254,9 @@ template <class X, class T = double> class Atomic: public Devs<X,T>
 
 	private:
 
-		friend class Simulator<X,T>;
+		template <class, class, class> friend class Simulator;
 		friend class Schedule<X,T>;
+		friend class TimingWheel<X,T>;
 
 		// Time of last event
 		T tL;
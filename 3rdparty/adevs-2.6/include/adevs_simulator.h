@@ -23,6 +23,7 @@ Bugs, comments, and questions can be sent to nutaro@gmail.com
 #include "adevs_models.h"
 #include "adevs_event_listener.h"
 #include "adevs_sched.h"
+#include "adevs_wheel.h"
 #include "adevs_bag.h"
 #include "adevs_set.h"
 #include "object_pool.h"
@@ -40,8 +41,11 @@ namespace adevs
  * Its methods throw adevs::exception objects if any of the DEVS model
  * constraints are violated (i.e., a negative time advance or a model
  * attempting to send an input directly to itself).
+ * The schedule S holds the next event times of the atomic models. The
+ * TimingWheel can be used instead of the default binary heap when the
+ * time is an integer.
  */
-template <class X, class T = double> class Simulator:
+template <class X, class T = double, class S = Schedule<X,T> > class Simulator:
 	public AbstractSimulator<X,T>
 {
 	public:
@@ -107,6 +111,31 @@ template <class X, class T = double> class Simulator:
 		{
 			schedule(model,nextEventTime());
 		}
+		/**
+		 * Notify the simulator that the time advance of the model changed
+		 * outside of its own state transition, for example because another
+		 * model changed its state directly. The model is moved in the
+		 * schedule as if its last event happened at nextEventTime().
+		 * Models which are in the middle of their transition are left
+		 * alone, because they are scheduled again once it finishes.
+		 */
+		void timeAdvanceChanged(Atomic<X,T>* model)
+		{
+			if (model->active) return;
+			T t = nextEventTime();
+			model->tL = t;
+			T dt = model->ta();
+			if (dt < adevs_zero<T>())
+			{
+				exception err("Negative time advance",model);
+				throw err;
+			}
+			// The event never happens when the schedule is empty
+			if (dt == adevs_inf<T>() || t == adevs_inf<T>())
+				sched.schedule(model,adevs_inf<T>());
+			else
+				sched.schedule(model,t+dt);
+		}
 		/**
 		 * Create a simulator that will be used by an LP as part of a parallel
 		 * simulation. This method is used by the parallel simulator.
@@ -152,7 +181,7 @@ template <class X, class T = double> class Simulator:
 		// Bogus input bag for execNextEvent() method
 		Bag<Event<X,T> > bogus_input;
 		// The event schedule
-		Schedule<X,T> sched;
+		S sched;
 		// List of imminent models
 		Bag<Atomic<X,T>*> imm;
 		// List of models activated by input
@@ -261,8 +290,8 @@ template <class X, class T = double> class Simulator:
 		bool manage_lookahead_data(Atomic<X,T>* model);
 };
 
-template <class X, class T>
-void Simulator<X,T>::computeNextOutput()
+template <class X, class T, class S>
+void Simulator<X,T,S>::computeNextOutput()
 {
 	// If the imminent set is up to date, then just return
 	if (imm.empty() == false) return;
@@ -291,8 +320,8 @@ void Simulator<X,T>::computeNextOutput()
 	}
 }
 
-template <class X, class T>
-void Simulator<X,T>::computeNextState(Bag<Event<X,T> >& input, T t)
+template <class X, class T, class S>
+void Simulator<X,T,S>::computeNextState(Bag<Event<X,T> >& input, T t)
 {
 	// Clean up if there was a previous IO calculation
 	if (t < sched.minPriority())
@@ -459,8 +488,8 @@ void Simulator<X,T>::computeNextState(Bag<Event<X,T> >& input, T t)
 	}
 }
 
-template <class X, class T>
-void Simulator<X,T>::clean_up(Devs<X,T>* model)
+template <class X, class T, class S>
+void Simulator<X,T,S>::clean_up(Devs<X,T>* model)
 {
 	Atomic<X,T>* amodel = model->typeIsAtomic();
 	if (amodel != NULL)
@@ -492,8 +521,8 @@ void Simulator<X,T>::clean_up(Devs<X,T>* model)
 	}
 }
 
-template <class X, class T>
-void Simulator<X,T>::unschedule_model(Devs<X,T>* model)
+template <class X, class T, class S>
+void Simulator<X,T,S>::unschedule_model(Devs<X,T>* model)
 {
 	if (model->typeIsAtomic() != NULL)
 	{
@@ -513,8 +542,8 @@ void Simulator<X,T>::unschedule_model(Devs<X,T>* model)
 	}
 }
 
-template <class X, class T>
-void Simulator<X,T>::schedule(Devs<X,T>* model, T t)
+template <class X, class T, class S>
+void Simulator<X,T,S>::schedule(Devs<X,T>* model, T t)
 {
 	Atomic<X,T>* a = model->typeIsAtomic();
 	if (a != NULL)
@@ -543,8 +572,8 @@ void Simulator<X,T>::schedule(Devs<X,T>* model, T t)
 	}
 }
 
-template <class X, class T>
-void Simulator<X,T>::inject_event(Atomic<X,T>* model, X& value)
+template <class X, class T, class S>
+void Simulator<X,T,S>::inject_event(Atomic<X,T>* model, X& value)
 {
 	if (model->active == false)
 	{
@@ -558,8 +587,8 @@ void Simulator<X,T>::inject_event(Atomic<X,T>* model, X& value)
 	model->x->insert(value);
 }
 
-template <class X, class T>
-void Simulator<X,T>::route(Network<X,T>* parent, Devs<X,T>* src, X& x)
+template <class X, class T, class S>
+void Simulator<X,T,S>::route(Network<X,T>* parent, Devs<X,T>* src, X& x)
 {
 	// Notify event listeners if this is an output event
 // 	if (parent != src && (lps == NULL || lps->out_flag != RESTORING_OUTPUT))
@@ -610,8 +639,8 @@ void Simulator<X,T>::route(Network<X,T>* parent, Devs<X,T>* src, X& x)
 	recv_pool.destroy_obj(recvs);
 }
 
-template <class X, class T>
-void Simulator<X,T>::exec_event(Atomic<X,T>* model, bool internal, T t)
+template <class X, class T, class S>
+void Simulator<X,T,S>::exec_event(Atomic<X,T>* model, bool internal, T t)
 {
 	if (!manage_lookahead_data(model)) return;
 	// Compute the state change
@@ -636,8 +665,8 @@ void Simulator<X,T>::exec_event(Atomic<X,T>* model, bool internal, T t)
 	}
 }
 
-template <class X, class T>
-void Simulator<X,T>::getAllChildren(Network<X,T>* model, Set<Devs<X,T>*>& s)
+template <class X, class T, class S>
+void Simulator<X,T,S>::getAllChildren(Network<X,T>* model, Set<Devs<X,T>*>& s)
 {
 	Set<Devs<X,T>*> tmp;
 	// Get the component set
@@ -658,8 +687,8 @@ void Simulator<X,T>::getAllChildren(Network<X,T>* model, Set<Devs<X,T>*>& s)
 	}
 }
 
-template <class X, class T>
-Simulator<X,T>::~Simulator()
+template <class X, class T, class S>
+Simulator<X,T,S>::~Simulator()
 {
 	// Clean up the models with stale IO
 	typename Bag<Atomic<X,T>*>::iterator imm_iter;
@@ -673,8 +702,8 @@ Simulator<X,T>::~Simulator()
 	}
 }
 
-template <class X, class T>
-Simulator<X,T>::Simulator(LogicalProcess<X,T>* lp):
+template <class X, class T, class S>
+Simulator<X,T,S>::Simulator(LogicalProcess<X,T>* lp):
 	AbstractSimulator<X,T>()
 {
 	lps = new lp_support;
@@ -684,8 +713,8 @@ Simulator<X,T>::Simulator(LogicalProcess<X,T>* lp):
 	lps->out_flag = OUTPUT_OK;
 }
 
-template <class X, class T>
-void Simulator<X,T>::beginLookahead()
+template <class X, class T, class S>
+void Simulator<X,T,S>::beginLookahead()
 {
 	if (lps == NULL)
 	{
@@ -697,14 +726,14 @@ void Simulator<X,T>::beginLookahead()
 		lps->out_flag = OUTPUT_NOT_OK; 
 }
 
-template <class X, class T>
-void Simulator<X,T>::lookNextEvent()
+template <class X, class T, class S>
+void Simulator<X,T,S>::lookNextEvent()
 {
 	execNextEvent();
 }
 
-template <class X, class T>
-void Simulator<X,T>::endLookahead()
+template <class X, class T, class S>
+void Simulator<X,T,S>::endLookahead()
 {
 	if (lps == NULL) return;
 	typename Bag<Atomic<X,T>*>::iterator iter = lps->to_restore.begin();
@@ -728,8 +757,8 @@ void Simulator<X,T>::endLookahead()
 	lps->stop_forced = false;
 }
 
-template <class X, class T>
-bool Simulator<X,T>::manage_lookahead_data(Atomic<X,T>* model)
+template <class X, class T, class S>
+bool Simulator<X,T,S>::manage_lookahead_data(Atomic<X,T>* model)
 {
 	if (lps == NULL) return true;
 	if (lps->look_ahead && model->tL_cp < adevs_zero<T>())
@@ -0,0 +1,380 @@
+/***************
+Copyright (C) 2000-2006 by James Nutaro
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+Bugs, comments, and questions can be sent to nutaro@gmail.com
+***************/
+#ifndef __adevs_wheel_h_
+#define __adevs_wheel_h_
+#include "adevs_time.h"
+#include "adevs_models.h"
+#include "adevs_bag.h"
+#include <vector>
+#include <stdint.h>
+
+namespace adevs
+{
+
+/**
+ * This is a hierarchical timing wheel for scheduling Atomic models whose
+ * time type is a non-negative integer. It has the interface of the Schedule
+ * and can be passed to the Simulator in its place. Adding, moving and
+ * removing a model takes constant time, unless the model is scheduled
+ * before the base time of the wheel.
+ *
+ * The wheel has a level of 64 slots for every 6 bits of the time. A model
+ * is put into the level of the highest 6 bits in which its next event time
+ * differs from the base time of the wheel, which is never greater than the
+ * next event time of any model. All models in a slot of the first level
+ * are therefore imminent at the same time. The base moves only when the
+ * minimum is asked for. If the first level is empty then, the base moves
+ * up to the earliest model in the first non-empty slot of the lowest
+ * non-empty level and the slot is spread over the levels below it. The
+ * Simulator asks for the minimum only at the time of the next event and
+ * reschedules the imminent and the activated models before asking again,
+ * so the base never moves past the current time during a transition. A
+ * model is scheduled before the base only when an input is injected before
+ * the next event time, and the wheel is then built again. Like the
+ * Schedule, the wheel uses the q_index attribute of the model to find it
+ * and sets the active flag to indicate its imminent status.
+ *
+ * The binary heap has smaller constant costs, so the wheel is faster only
+ * when there are a few hundreds of models or more.
+ */
+template <class X, class T> class TimingWheel
+{
+	public:
+		/// Creates a wheel with the default or specified initial capacity.
+		TimingWheel(unsigned int capacity = 100);
+		/// Get a model at the front of the queue.
+		Atomic<X,T>* getMinimum();
+		/// Get the time of the next event.
+		T minPriority() { if (stale) find_min(); return min; }
+		/// Get the imminent models and set their active flags to true.
+		void getImminent(Bag<Atomic<X,T>*>& imm);
+		/// Remove a model at the front of the queue.
+		void removeMinimum();
+		/// Remove the imminent models from the queue.
+		void removeImminent();
+		/// Add, remove, or move a model as required by its priority.
+		void schedule(Atomic<X,T>* model, T priority);
+		/// Returns true if the queue is empty, and false otherwise.
+		bool empty() const { return size == 0; }
+		/// Get the number of models in the wheel.
+		unsigned int getSize() const { return size; }
+		/// Get the number of times the wheel was built again.
+		unsigned int getRebaseCount() const { return rebases; }
+	private:
+		enum
+		{
+			SLOT_BITS = 6,
+			SLOTS = 1 << SLOT_BITS,
+			LEVELS = (sizeof(T) * 8 + SLOT_BITS - 1) / SLOT_BITS
+		};
+		// A model in the wheel. The nodes of a slot form a doubly linked
+		// list. The index 0 is not used and terminates the lists.
+		struct node
+		{
+			Atomic<X,T>* item;
+			T priority;
+			unsigned int prev, next;
+			unsigned char level, slot;
+		};
+		std::vector<node> nodes;
+		// First unused node
+		unsigned int free_nodes;
+		// First node in every slot and the bit mask of non-empty slots. Not
+		// named slots, which is a macro in Qt.
+		unsigned int slot_heads[LEVELS][SLOTS];
+		uint64_t occupied[LEVELS];
+		// Bit mask of non-empty levels
+		unsigned int occupied_levels;
+		uint64_t base;
+		// The minimum, which is valid only if the stale flag is false. It
+		// is then equal to the base.
+		T min;
+		bool stale;
+		unsigned int size;
+		unsigned int rebases;
+		// Nodes taken out by rebase, kept to reuse its storage
+		std::vector<unsigned int> linked;
+		/// Get the level of the time relative to the base
+		unsigned int level_of(uint64_t t) const
+		{
+			return (t == base) ? 0 : highest_bit(t ^ base) / SLOT_BITS;
+		}
+		/// Put the node into the slot given by its priority
+		void link(unsigned int index);
+		/// Take the node out of its slot
+		void unlink(unsigned int index);
+		/// Find the minimum, moving the base of the wheel up to it
+		void find_min();
+		/// Move the base of the wheel back to the given time
+		void rebase(uint64_t t);
+		static unsigned int lowest_bit(uint64_t bits);
+		static unsigned int highest_bit(uint64_t bits);
+};
+
+template <class X, class T>
+TimingWheel<X,T>::TimingWheel(unsigned int capacity):
+free_nodes(0),occupied_levels(0),base(0),min(adevs_inf<T>()),stale(false),
+size(0),rebases(0)
+{
+	nodes.reserve(capacity + 1);
+	nodes.push_back(node());
+	for (unsigned int level = 0; level < LEVELS; level++)
+	{
+		occupied[level] = 0;
+		for (unsigned int slot = 0; slot < SLOTS; slot++)
+			slot_heads[level][slot] = 0;
+	}
+}
+
+template <class X, class T>
+Atomic<X,T>* TimingWheel<X,T>::getMinimum()
+{
+	if (size == 0) return NULL;
+	if (stale) find_min();
+	return nodes[slot_heads[0][base & (SLOTS - 1)]].item;
+}
+
+template <class X, class T>
+void TimingWheel<X,T>::getImminent(Bag<Atomic<X,T>*>& imm)
+{
+	if (size == 0) return;
+	if (stale) find_min();
+	// The minimum is always in the first level, where the slot holds
+	// only the models with the same next event time.
+	for (unsigned int index = slot_heads[0][base & (SLOTS - 1)]; index != 0;
+		index = nodes[index].next)
+	{
+		nodes[index].item->active = true;
+		imm.insert(nodes[index].item);
+	}
+}
+
+template <class X, class T>
+void TimingWheel<X,T>::removeMinimum()
+{
+	if (size == 0) return;
+	schedule(getMinimum(),adevs_inf<T>());
+}
+
+template <class X, class T>
+void TimingWheel<X,T>::removeImminent()
+{
+	if (size == 0) return;
+	T tN = minPriority();
+	while (minPriority() <= tN)
+		removeMinimum();
+}
+
+template <class X, class T>
+void TimingWheel<X,T>::schedule(Atomic<X,T>* model, T priority)
+{
+	unsigned int index = model->q_index;
+	T old_priority = adevs_inf<T>();
+	// If the model is in the wheel, take it out of its slot
+	if (index != 0)
+	{
+		old_priority = nodes[index].priority;
+		if (old_priority == priority) return;
+		unlink(index);
+		// Remove the model if the next event time is infinite
+		if (priority >= adevs_inf<T>())
+		{
+			nodes[index].item = NULL;
+			nodes[index].next = free_nodes;
+			free_nodes = index;
+			model->q_index = 0;
+			size--;
+			// The base stays where it is until the minimum is asked for
+			if ((uint64_t)old_priority == base) stale = true;
+			return;
+		}
+	}
+	// If it is not in the wheel and the next event time is
+	// not at infinity, then add it to the wheel
+	else if (priority < adevs_inf<T>())
+	{
+		if (free_nodes != 0)
+		{
+			index = free_nodes;
+			free_nodes = nodes[index].next;
+		}
+		else
+		{
+			index = nodes.size();
+			nodes.push_back(node());
+		}
+		nodes[index].item = model;
+		model->q_index = index;
+		size++;
+	}
+	// Otherwise, the model is not enqueued and has no next event
+	else return;
+	nodes[index].priority = priority;
+	// The model is the new minimum and the base moves back to it
+	if ((uint64_t)priority < base)
+	{
+		rebase(priority);
+		link(index);
+		min = priority;
+		stale = false;
+		return;
+	}
+	link(index);
+	// The model at the front of the queue moved or the wheel was empty.
+	// The base is kept, so the other models scheduled at the current time
+	// stay above it.
+	if ((uint64_t)old_priority == base || size == 1) stale = true;
+}
+
+template <class X, class T>
+void TimingWheel<X,T>::link(unsigned int index)
+{
+	node& n = nodes[index];
+	uint64_t t = (uint64_t)n.priority;
+	unsigned int level = level_of(t);
+	unsigned int slot = (t >> (level * SLOT_BITS)) & (SLOTS - 1);
+	n.level = level;
+	n.slot = slot;
+	n.prev = 0;
+	n.next = slot_heads[level][slot];
+	if (n.next != 0) nodes[n.next].prev = index;
+	slot_heads[level][slot] = index;
+	occupied[level] |= (uint64_t)1 << slot;
+	occupied_levels |= 1u << level;
+}
+
+template <class X, class T>
+void TimingWheel<X,T>::unlink(unsigned int index)
+{
+	node& n = nodes[index];
+	if (n.next != 0) nodes[n.next].prev = n.prev;
+	if (n.prev != 0) nodes[n.prev].next = n.next;
+	else
+	{
+		slot_heads[n.level][n.slot] = n.next;
+		if (n.next == 0)
+		{
+			occupied[n.level] &= ~((uint64_t)1 << n.slot);
+			if (occupied[n.level] == 0) occupied_levels &= ~(1u << n.level);
+		}
+	}
+}
+
+template <class X, class T>
+void TimingWheel<X,T>::find_min()
+{
+	stale = false;
+	if (size == 0)
+	{
+		min = adevs_inf<T>();
+		return;
+	}
+	for (;;)
+	{
+		// The models in the first level differ from the base only in the
+		// lowest bits, so the first non-empty slot is the minimum
+		if ((occupied_levels & 1) != 0)
+		{
+			base = (base & ~(uint64_t)(SLOTS - 1)) | lowest_bit(occupied[0]);
+			min = (T)base;
+			return;
+		}
+		unsigned int level = lowest_bit(occupied_levels);
+		unsigned int slot = lowest_bit(occupied[level]);
+		// The minimum is in the first slot of the lowest non-empty level.
+		// Move the base up to it and spread the slot over the lower
+		// levels, which puts the minimum into the first level.
+		unsigned int first = slot_heads[level][slot];
+		slot_heads[level][slot] = 0;
+		occupied[level] &= ~((uint64_t)1 << slot);
+		if (occupied[level] == 0) occupied_levels &= ~(1u << level);
+		T slot_min = nodes[first].priority;
+		for (unsigned int index = nodes[first].next; index != 0;
+			index = nodes[index].next)
+		{
+			if (nodes[index].priority < slot_min)
+				slot_min = nodes[index].priority;
+		}
+		base = (uint64_t)slot_min;
+		for (unsigned int index = first; index != 0;)
+		{
+			unsigned int next = nodes[index].next;
+			link(index);
+			index = next;
+		}
+	}
+}
+
+template <class X, class T>
+void TimingWheel<X,T>::rebase(uint64_t t)
+{
+	// This happens only when an input is injected before the next event
+	// time, so the wheel is simply built again.
+	rebases++;
+	linked.clear();
+	for (unsigned int level = 0; level < LEVELS; level++)
+	{
+		for (unsigned int slot = 0; slot < SLOTS; slot++)
+		{
+			for (unsigned int index = slot_heads[level][slot]; index != 0;
+				index = nodes[index].next)
+				linked.push_back(index);
+			slot_heads[level][slot] = 0;
+		}
+		occupied[level] = 0;
+	}
+	occupied_levels = 0;
+	base = t;
+	for (unsigned int i = 0; i < linked.size(); i++)
+		link(linked[i]);
+}
+
+template <class X, class T>
+unsigned int TimingWheel<X,T>::lowest_bit(uint64_t bits)
+{
+#ifdef __GNUC__
+	return __builtin_ctzll(bits);
+#else
+	unsigned int bit = 0;
+	while ((bits & 1) == 0)
+	{
+		bits >>= 1;
+		bit++;
+	}
+	return bit;
+#endif
+}
+
+template <class X, class T>
+unsigned int TimingWheel<X,T>::highest_bit(uint64_t bits)
+{
+#ifdef __GNUC__
+	return 63 - __builtin_clzll(bits);
+#else
+	unsigned int bit = 0;
+	while (bits >>= 1)
+		bit++;
+	return bit;
+#endif
+}
+
+} // end of namespace
+
+#endif
@@ -304,7 +304,8 @@ void Disassembler::reloadFileAssembler(QStringList &lines) {
 					previousLine = l.getLineNumber();
 				}
 
-				addInstructionLine(l.getAddr(), l.getData(), tooltip);
+				// Text of the instructions is generated only for the shown file
+				addInstructionLine(l.getAddr(), l.getData().isEmpty() ? m_mcu->disassemble(l.getAddr()) : l.getData(), tooltip);
 				break;
 			case DisassembledLine::Section:
 				addSectionLine(l.getAddr(), l.getData());
@@ -378,8 +379,14 @@ void Disassembler::reloadCode() {
 		return;
 	}
 
+	delete m_dd;
+	m_dd = m_mcu->getDebugData();
+	if (!m_dd) {
+		qDebug() << "Warning: No DWARF debug data available";
+	}
+
 	// Fill in the files list
-	m_files = m_mcu->getDisassembledCode();
+	m_files = m_mcu->getDisassembledCode(m_dd);
 	DisassembledFiles::iterator it = m_files.begin();
 	while (it != m_files.end()) {
 		QString f = it.key();
@@ -388,12 +395,6 @@ void Disassembler::reloadCode() {
 		++it;
 	}
 
-	delete m_dd;
-	m_dd = m_mcu->getDebugData();
-	if (!m_dd) {
-		qDebug() << "Warning: No DWARF debug data available";
-	}
-
 	view->resizeColumnToContents(0);
 }
 
@@ -0,0 +1,123 @@
+/**
+ * QSimKit - MSP430 simulator
+ * Copyright (C) 2013 Jan "HanzZ" Kaluza (hanzz.k@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+
+#include "Profiler.h"
+
+#include "ui/QSimKit.h"
+#include "MCU/MCU.h"
+
+#include <QWidget>
+#include <QString>
+#include <QFile>
+#include <QFileDialog>
+#include <QTextStream>
+#include <QTreeWidgetItem>
+#include <QDebug>
+
+Profiler::Profiler(QSimKit *simkit) :
+DockWidget(simkit), m_mcu(0), m_simkit(simkit), m_dd(0) {
+	setupUi(this);
+
+	connect(enabled, SIGNAL(toggled(bool)), this, SLOT(setProfiling(bool)) );
+	connect(save, SIGNAL(clicked()), this, SLOT(saveReport()) );
+}
+
+void Profiler::setMCU(MCU *mcu) {
+	m_mcu = mcu;
+	connect(m_mcu, SIGNAL(onCodeLoaded()), this, SLOT(reloadCode()) );
+	m_mcu->setProfiling(enabled->isChecked());
+	reloadCode();
+}
+
+void Profiler::reloadCode() {
+	delete m_dd;
+	m_dd = m_mcu->getDebugData();
+	refresh();
+}
+
+void Profiler::setProfiling(bool enabled) {
+	if (m_mcu) {
+		m_mcu->setProfiling(enabled);
+	}
+	refresh();
+}
+
+void Profiler::addFunction(QTreeWidgetItem *parent, const ProfiledFunction &f) {
+	QTreeWidgetItem *item = new QTreeWidgetItem(parent);
+	item->setText(0, f.name);
+	item->setText(1, QString::number(m_profile.totalCycles ? 100.0 * f.selfCycles / m_profile.totalCycles : 0, 'f', 2));
+	item->setText(2, QString::number(f.selfCycles));
+	item->setText(3, QString::number(f.inclusiveCycles));
+	item->setText(4, QString::number(f.calls));
+	item->setText(5, QString::number(f.instructions));
+
+	foreach(const ProfiledCall &call, f.callees) {
+		QTreeWidgetItem *child = new QTreeWidgetItem(item);
+		child->setText(0, "-> " + call.name);
+		child->setText(3, QString::number(call.cycles));
+		child->setText(4, QString::number(call.calls));
+	}
+}
+
+void Profiler::refresh() {
+	view->clear();
+	if (!m_mcu || !m_mcu->isProfiling()) {
+		total->setText("");
+		return;
+	}
+
+	m_profile = m_mcu->getProfile(m_dd);
+	total->setText(QString("%1 cycles").arg(m_profile.totalCycles));
+
+	QTreeWidgetItem *functions = new QTreeWidgetItem(view);
+	functions->setText(0, tr("Functions"));
+	foreach(const ProfiledFunction &f, m_profile.functions) {
+		addFunction(functions, f);
+	}
+
+	QTreeWidgetItem *interrupts = new QTreeWidgetItem(view);
+	interrupts->setText(0, tr("Interrupts"));
+	foreach(const ProfiledFunction &f, m_profile.interrupts) {
+		addFunction(interrupts, f);
+	}
+
+	functions->setExpanded(true);
+	interrupts->setExpanded(true);
+	for (int i = 0; i < 6; ++i) {
+		view->resizeColumnToContents(i);
+	}
+}
+
+void Profiler::saveReport() {
+	QString filename = QFileDialog::getSaveFileName(this, tr("Save profile"),
+		QString(), tr("Text report (*.txt);;JSON report (*.json)"));
+	if (filename.isEmpty()) {
+		return;
+	}
+
+	QFile file(filename);
+	if (!file.open(QFile::WriteOnly | QFile::Truncate | QIODevice::Text)) {
+		qDebug() << "Cannot write profile to" << filename;
+		return;
+	}
+
+	QTextStream stream(&file);
+	stream << (filename.endsWith(".json") ? m_profile.toJSON() : m_profile.toText());
+}
@@ -0,0 +1,58 @@
+/**
+ * QSimKit - MSP430 simulator
+ * Copyright (C) 2013 Jan "HanzZ" Kaluza (hanzz.k@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+
+#pragma once
+
+#include <QString>
+#include <DockWidgets/DockWidget.h>
+
+#include "ui_Profiler.h"
+#include "MCU/Profile.h"
+
+class MCU;
+class QSimKit;
+class DebugData;
+
+/// Shows the cycles spent in the firmware functions and their calls.
+class Profiler : public DockWidget, public Ui::Profiler
+{
+	Q_OBJECT
+
+	public:
+		Profiler(QSimKit *simkit);
+
+		void setMCU(MCU *mcu);
+
+		void refresh();
+
+	public slots:
+		void reloadCode();
+		void setProfiling(bool enabled);
+		void saveReport();
+
+	private:
+		void addFunction(QTreeWidgetItem *parent, const ProfiledFunction &f);
+
+	private:
+		MCU *m_mcu;
+		QSimKit *m_simkit;
+		DebugData *m_dd;
+		Profile m_profile;
+};
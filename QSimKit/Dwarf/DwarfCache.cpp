@@ -0,0 +1,414 @@
+/**
+ * QSimKit - MSP430 simulator
+ * Copyright (C) 2013 Jan "HanzZ" Kaluza (hanzz.k@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#include "DwarfCache.h"
+#include "DwarfDebugData.h"
+#include "DwarfSubprogram.h"
+#include "DwarfVariable.h"
+#include "DwarfLocation.h"
+#include "DwarfLocationList.h"
+#include "DwarfExpression.h"
+
+#include <QCryptographicHash>
+#include <QDesktopServices>
+#include <QStringList>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QHash>
+#include <QDebug>
+
+#define CACHE_MAGIC 0x51534b43
+// Increase when the format of the cached data changes
+#define CACHE_VERSION 3
+#define CACHE_HASH_SIZE 20
+#define CACHE_HEADER_SIZE (12 + CACHE_HASH_SIZE)
+
+DwarfCache::DwarfCache(const QByteArray &elf, const QString &dir) {
+	if (elf.isEmpty()) {
+		return;
+	}
+
+	QString cacheDir = dir;
+	if (cacheDir.isEmpty()) {
+		cacheDir = QDesktopServices::storageLocation(QDesktopServices::CacheLocation);
+		if (cacheDir.isEmpty()) {
+			cacheDir = QDir::tempPath();
+		}
+		cacheDir += "/debug";
+	}
+
+	m_hash = QCryptographicHash::hash(elf, QCryptographicHash::Sha1);
+	m_path = cacheDir + "/" + m_hash.toHex();
+}
+
+QByteArray DwarfCache::read(const QString &path) {
+	QFile file(path);
+	if (!file.open(QIODevice::ReadOnly)) {
+		return QByteArray();
+	}
+
+	QByteArray data = file.readAll();
+	if (data.size() < CACHE_HEADER_SIZE) {
+		return QByteArray();
+	}
+
+	QDataStream header(data.left(12));
+	quint32 magic, version, size;
+	header >> magic >> version >> size;
+	if (magic != CACHE_MAGIC || version != CACHE_VERSION || size != (quint32) data.size() - CACHE_HEADER_SIZE) {
+		return QByteArray();
+	}
+
+	// The file may have been copied or renamed from other ELF file
+	if (data.mid(12, CACHE_HASH_SIZE) != m_hash) {
+		return QByteArray();
+	}
+
+	return data.mid(CACHE_HEADER_SIZE);
+}
+
+void DwarfCache::write(const QString &path, const QByteArray &data) {
+	QDir().mkpath(QFileInfo(path).path());
+
+	// Write to the temporary file first, so other instance never reads
+	// partially written file
+	QFile file(path + ".tmp");
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		qDebug() << "Cannot write the cache file" << file.fileName();
+		return;
+	}
+
+	QDataStream header(&file);
+	header << (quint32) CACHE_MAGIC << (quint32) CACHE_VERSION << (quint32) data.size();
+	file.write(m_hash);
+	file.write(data);
+	file.close();
+
+	QFile::remove(path);
+	QFile::rename(file.fileName(), path);
+}
+
+bool DwarfCache::readCount(QDataStream &in, uint32_t &count) {
+	quint32 c;
+	in >> c;
+	count = c;
+	return in.status() == QDataStream::Ok && count <= in.device()->bytesAvailable();
+}
+
+void DwarfCache::writeExpression(QDataStream &out, DwarfExpression *expr) {
+	out << (bool) (expr != 0);
+	if (expr) {
+		out << (quint8) expr->getAddressSize() << expr->getCode();
+	}
+}
+
+bool DwarfCache::readExpression(QDataStream &in, DwarfExpression *&expr) {
+	bool present;
+	in >> present;
+	if (!present) {
+		expr = 0;
+		return in.status() == QDataStream::Ok;
+	}
+
+	quint8 addressSize;
+	QByteArray code;
+	in >> addressSize >> code;
+	if (in.status() != QDataStream::Ok) {
+		return false;
+	}
+
+	expr = new DwarfExpression((const uint8_t *) code.constData(), code.size(), addressSize);
+	return true;
+}
+
+void DwarfCache::writeLocationList(QDataStream &out, DwarfLocationList *ll) {
+	out << (bool) (ll != 0);
+	if (!ll) {
+		return;
+	}
+
+	out << (quint32) ll->getLocations().size();
+	foreach(DwarfLocation *l, ll->getLocations()) {
+		out << (quint16) l->getPCLow() << (quint16) l->getPCHigh();
+		writeExpression(out, l->getExpression());
+	}
+}
+
+bool DwarfCache::readLocationList(QDataStream &in, DwarfLocationList *&ll) {
+	bool present;
+	in >> present;
+	ll = 0;
+	if (!present) {
+		return in.status() == QDataStream::Ok;
+	}
+
+	uint32_t count;
+	if (!readCount(in, count)) {
+		return false;
+	}
+
+	ll = new DwarfLocationList();
+	for (uint32_t i = 0; i < count; ++i) {
+		quint16 pcLow, pcHigh;
+		DwarfExpression *expr;
+		in >> pcLow >> pcHigh;
+		if (!readExpression(in, expr)) {
+			return false;
+		}
+
+		ll->append(new DwarfLocation(expr, pcLow, pcHigh));
+	}
+
+	return true;
+}
+
+DwarfDebugData *DwarfCache::loadDebugData() {
+	if (m_path.isEmpty()) {
+		return 0;
+	}
+
+	QByteArray payload = read(m_path + ".debug");
+	if (payload.isEmpty()) {
+		return 0;
+	}
+
+	QDataStream in(payload);
+	DwarfDebugData *dd = new DwarfDebugData();
+	bool ok = true;
+
+	// Types, every subtype is stored before the type using it
+	QList<VariableType *> types;
+	uint32_t count;
+	ok = readCount(in, count);
+	for (uint32_t i = 0; ok && i < count; ++i) {
+		QString name;
+		quint8 byteSize, encoding, type;
+		quint16 upperBound;
+		qint32 subtype;
+		in >> name >> byteSize >> encoding >> type >> upperBound >> subtype;
+		if (in.status() != QDataStream::Ok || subtype >= (qint32) i) {
+			ok = false;
+			break;
+		}
+
+		VariableType *t = new VariableType(name, byteSize, (VariableType::Encoding) encoding,
+			(VariableType::Type) type, upperBound, subtype < 0 ? 0 : types[subtype]);
+		dd->addVariableType(t);
+		types.append(t);
+	}
+
+	// Subprograms with their variables
+	uint32_t files = 0;
+	ok = ok && readCount(in, files);
+	for (uint32_t f = 0; ok && f < files; ++f) {
+		QString file;
+		in >> file;
+		ok = readCount(in, count);
+		for (uint32_t i = 0; ok && i < count; ++i) {
+			QString name;
+			quint16 pcLow, pcHigh;
+			DwarfLocationList *ll;
+			DwarfExpression *expr = 0;
+			in >> name >> pcLow >> pcHigh;
+			if (!readLocationList(in, ll) || !readExpression(in, expr)) {
+				delete ll;
+				ok = false;
+				break;
+			}
+
+			DwarfSubprogram *subprogram = new DwarfSubprogram(name, pcLow, pcHigh, ll, expr);
+			dd->addSubprogram(file, subprogram);
+
+			uint32_t variables;
+			ok = readCount(in, variables);
+			for (uint32_t v = 0; ok && v < variables; ++v) {
+				qint32 type;
+				bool arg;
+				in >> name >> type >> arg;
+				if (in.status() != QDataStream::Ok || type >= types.size()) {
+					ok = false;
+					break;
+				}
+
+				expr = 0;
+				if (!readLocationList(in, ll) || !readExpression(in, expr)) {
+					delete ll;
+					ok = false;
+					break;
+				}
+
+				DwarfVariable *variable = new DwarfVariable(type < 0 ? 0 : types[type], name, ll, expr);
+				if (arg) {
+					subprogram->addArg(variable);
+				}
+				else {
+					subprogram->addVariable(variable);
+				}
+			}
+		}
+	}
+
+	// Line table, file names are stored only once
+	QStringList names;
+	in >> names;
+	ok = ok && in.status() == QDataStream::Ok && readCount(in, count);
+	for (uint32_t i = 0; ok && i < count; ++i) {
+		quint16 pc;
+		quint32 file;
+		qint32 line;
+		in >> pc >> file >> line;
+		if (in.status() != QDataStream::Ok || file >= (quint32) names.size()) {
+			ok = false;
+			break;
+		}
+
+		dd->addLine(names[file], line, pc);
+	}
+
+	if (!ok) {
+		qDebug() << "Corrupted cache file" << m_path + ".debug";
+		delete dd;
+		return 0;
+	}
+
+	return dd;
+}
+
+void DwarfCache::saveDebugData(DwarfDebugData *dd) {
+	if (m_path.isEmpty() || !dd) {
+		return;
+	}
+
+	QByteArray data;
+	QDataStream out(&data, QIODevice::WriteOnly);
+
+	QHash<VariableType *, qint32> types;
+	const QList<VariableType *> &t = dd->getVariableTypes();
+	out << (quint32) t.size();
+	for (int i = 0; i < t.size(); ++i) {
+		out << t[i]->getName() << (quint8) t[i]->getByteSize() << (quint8) t[i]->getEncoding();
+		out << (quint8) t[i]->getType() << (quint16) t[i]->getUpperBound();
+		out << types.value(t[i]->getSubtype(), -1);
+		types[t[i]] = i;
+	}
+
+	const QMap<QString, Subprograms> &subprograms = dd->getAllSubprograms();
+	out << (quint32) subprograms.size();
+	for (QMap<QString, Subprograms>::const_iterator it = subprograms.begin(); it != subprograms.end(); ++it) {
+		out << it.key() << (quint32) it.value().size();
+		foreach(Subprogram *s, it.value()) {
+			DwarfSubprogram *subprogram = static_cast<DwarfSubprogram *>(s);
+			out << subprogram->getName() << (quint16) subprogram->getPCLow() << (quint16) subprogram->getPCHigh();
+			writeLocationList(out, subprogram->getLocationList());
+			writeExpression(out, subprogram->getExpression());
+
+			const Variables &vars = subprogram->getVariables();
+			out << (quint32) vars.size();
+			foreach(Variable *v, vars) {
+				DwarfVariable *variable = static_cast<DwarfVariable *>(v);
+				out << variable->getName() << types.value(variable->getType(), -1);
+				out << subprogram->getArgs().contains(variable);
+				writeLocationList(out, variable->getLocationList());
+				writeExpression(out, variable->getExpression());
+			}
+		}
+	}
+
+	const QMap<uint16_t, DwarfDebugData::Line> &lines = dd->getLines();
+	QStringList names;
+	QHash<QString, quint32> indexes;
+	for (QMap<uint16_t, DwarfDebugData::Line>::const_iterator it = lines.begin(); it != lines.end(); ++it) {
+		if (!indexes.contains(it.value().file)) {
+			indexes[it.value().file] = names.size();
+			names.append(it.value().file);
+		}
+	}
+
+	out << names << (quint32) lines.size();
+	for (QMap<uint16_t, DwarfDebugData::Line>::const_iterator it = lines.begin(); it != lines.end(); ++it) {
+		out << (quint16) it.key() << indexes[it.value().file] << (qint32) it.value().line;
+	}
+
+	write(m_path + ".debug", data);
+}
+
+bool DwarfCache::loadDisassembledCode(DisassembledFiles &files) {
+	if (m_path.isEmpty()) {
+		return false;
+	}
+
+	QByteArray payload = read(m_path + ".code");
+	if (payload.isEmpty()) {
+		return false;
+	}
+
+	QDataStream in(payload);
+	uint32_t count;
+	if (!readCount(in, count)) {
+		return false;
+	}
+
+	DisassembledFiles df;
+	for (uint32_t f = 0; f < count; ++f) {
+		QString name;
+		uint32_t lines;
+		in >> name;
+		if (!readCount(in, lines)) {
+			return false;
+		}
+
+		DisassembledCode &code = df[name];
+		code.reserve(lines);
+		for (uint32_t i = 0; i < lines; ++i) {
+			quint16 addr;
+			qint32 line;
+			quint8 type;
+			QString data;
+			in >> addr >> line >> type >> data;
+			code.append(DisassembledLine(addr, line, (DisassembledLine::Type) type, data));
+		}
+	}
+
+	if (in.status() != QDataStream::Ok) {
+		return false;
+	}
+
+	files = df;
+	return true;
+}
+
+void DwarfCache::saveDisassembledCode(const DisassembledFiles &files) {
+	if (m_path.isEmpty()) {
+		return;
+	}
+
+	QByteArray data;
+	QDataStream out(&data, QIODevice::WriteOnly);
+
+	out << (quint32) files.size();
+	for (DisassembledFiles::const_iterator it = files.begin(); it != files.end(); ++it) {
+		out << it.key() << (quint32) it.value().size();
+		foreach(const DisassembledLine &l, it.value()) {
+			out << (quint16) l.getAddr() << (qint32) l.getLineNumber() << (quint8) l.getType() << l.getData();
+		}
+	}
+
+	write(m_path + ".code", data);
+}
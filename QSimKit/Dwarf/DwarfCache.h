@@ -0,0 +1,73 @@
+/**
+ * QSimKit - MSP430 simulator
+ * Copyright (C) 2013 Jan "HanzZ" Kaluza (hanzz.k@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QDataStream>
+#include <stdint.h>
+
+#include "QSimKit/MCU/MCU.h"
+
+class DwarfDebugData;
+class DwarfExpression;
+class DwarfLocationList;
+
+/// Stores the debug data and the disassembled code of the ELF file in the
+/// user's cache directory, so they do not have to be built again when the
+/// same file is loaded. Files are named by the SHA-1 hash of the ELF bytes
+/// and the hash is stored in their header too. The data are serialized
+/// with QDataStream, so they are read as a whole and not mapped in place.
+class DwarfCache {
+	public:
+		/// Uses the user's cache directory when the dir is empty.
+		DwarfCache(const QByteArray &elf, const QString &dir = QString());
+
+		/// Returns the cached debug data or 0 if they are not cached.
+		DwarfDebugData *loadDebugData();
+
+		void saveDebugData(DwarfDebugData *dd);
+
+		/// Returns false if the code is not cached.
+		bool loadDisassembledCode(DisassembledFiles &files);
+
+		void saveDisassembledCode(const DisassembledFiles &files);
+
+	private:
+		/// Returns the payload of the cached file or an empty array if the
+		/// file is missing, corrupted or belongs to other ELF file.
+		QByteArray read(const QString &path);
+
+		void write(const QString &path, const QByteArray &data);
+
+		void writeExpression(QDataStream &out, DwarfExpression *expr);
+		void writeLocationList(QDataStream &out, DwarfLocationList *ll);
+		bool readExpression(QDataStream &in, DwarfExpression *&expr);
+		bool readLocationList(QDataStream &in, DwarfLocationList *&ll);
+
+		/// Returns false if the count read from the stream cannot fit into
+		/// the rest of the cached data, which means the file is corrupted.
+		bool readCount(QDataStream &in, uint32_t &count);
+
+	private:
+		QString m_path;
+		QByteArray m_hash;
+};
+
@@ -21,7 +21,7 @@
 
 #include <QDebug>
 
-DwarfDebugData::DwarfDebugData() {}
+DwarfDebugData::DwarfDebugData() : m_indexValid(false) {}
 
 DwarfDebugData::~DwarfDebugData() {
 	QMap<QString, Subprograms>::iterator i = m_subprograms.begin();
@@ -40,6 +40,7 @@ DwarfDebugData::~DwarfDebugData() {
 
 void DwarfDebugData::addSubprogram(const QString &file, Subprogram *subprogram) {
 	m_subprograms[file].append(subprogram);
+	m_indexValid = false;
 }
 
 const Subprograms &DwarfDebugData::getSubprograms(const QString &file) {
@@ -57,17 +58,72 @@ Subprogram *DwarfDebugData::getSubprogram(const QString &file, uint16_t pc) {
 	return 0;
 }
 
-Subprogram *DwarfDebugData::getSubprogram(uint16_t pc) {
+void DwarfDebugData::buildIndex() {
+	m_subprogramIndex.fill(0, 0x10000);
+	m_indexedSubprograms.clear();
+
+	// The first subprogram found for the address wins, so the files are
+	// walked in the same order as the lookup used to walk them
 	QMap<QString, Subprograms>::iterator i = m_subprograms.begin();
 	while (i != m_subprograms.end()) {
-		Subprograms &subprograms = i.value();
-		foreach(Subprogram *s, subprograms) {
-			if (pc >= s->getPCLow() && pc < s->getPCHigh()) {
-				return s;
+		foreach(Subprogram *s, i.value()) {
+			if (m_indexedSubprograms.size() == 0xffff) {
+				break;
+			}
+
+			m_indexedSubprograms.append(s);
+			uint16_t index = m_indexedSubprograms.size();
+			for (uint32_t pc = s->getPCLow(); pc < s->getPCHigh(); ++pc) {
+				if (m_subprogramIndex[pc] == 0) {
+					m_subprogramIndex[pc] = index;
+				}
 			}
 		}
 		++i;
 	}
 
-	return 0;
+	// The row with the highest address lower or equal to pc covers it
+	m_lineIndex.fill(0, 0x10000);
+	m_indexedLines.clear();
+	QMap<uint16_t, Line>::const_iterator it = m_lines.constBegin();
+	while (it != m_lines.constEnd()) {
+		m_indexedLines.append(it.value());
+		uint32_t start = it.key();
+		++it;
+		uint32_t end = it == m_lines.constEnd() ? 0x10000 : it.key();
+		for (uint32_t pc = start; pc < end; ++pc) {
+			m_lineIndex[pc] = m_indexedLines.size();
+		}
+	}
+
+	m_indexValid = true;
+}
+
+Subprogram *DwarfDebugData::getSubprogram(uint16_t pc) {
+	if (!m_indexValid) {
+		buildIndex();
+	}
+
+	uint16_t index = m_subprogramIndex[pc];
+	return index ? m_indexedSubprograms[index - 1] : 0;
+}
+
+void DwarfDebugData::addLine(const QString &file, int line, uint16_t pc) {
+	m_lines[pc] = Line(file, line);
+	m_indexValid = false;
+}
+
+int DwarfDebugData::getLine(uint16_t pc, QString &file) {
+	if (!m_indexValid) {
+		buildIndex();
+	}
+
+	uint32_t index = m_lineIndex[pc];
+	if (index == 0) {
+		return 0;
+	}
+
+	const Line &line = m_indexedLines[index - 1];
+	file = line.file;
+	return line.line;
 }
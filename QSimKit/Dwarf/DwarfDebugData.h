@@ -24,12 +24,22 @@
 #include <QChar>
 #include <QRect>
 #include <QList>
+#include <QMap>
+#include <QVector>
 #include <stdint.h>
 
 #include "QSimKit/MCU/MCU.h"
 
 class DwarfDebugData : public DebugData {
 	public:
+		class Line {
+			public:
+				Line(const QString &file = QString(), int line = 0) : file(file), line(line) {}
+
+				QString file;
+				int line;
+		};
+
 		DwarfDebugData();
 		~DwarfDebugData();
 
@@ -41,13 +51,46 @@ class DwarfDebugData : public DebugData {
 
 		Subprogram *getSubprogram(uint16_t pc);
 
+		void addLine(const QString &file, int line, uint16_t pc);
+
+		int getLine(uint16_t pc, QString &file);
+
 		void addVariableType(VariableType *type) {
 			m_types.append(type);
 		}
 
+		/// Returns the subprograms of all the files.
+		const QMap<QString, Subprograms> &getAllSubprograms() const {
+			return m_subprograms;
+		}
+
+		/// Returns the rows of the line table keyed by their address.
+		const QMap<uint16_t, Line> &getLines() const {
+			return m_lines;
+		}
+
+		/// Returns all the types. Subtype of every type is stored before it.
+		const QList<VariableType *> &getVariableTypes() const {
+			return m_types;
+		}
+
+	private:
+		/// Builds the lookup tables used by getSubprogram(pc) and getLine().
+		void buildIndex();
+
 	private:
 		QMap<QString, Subprograms> m_subprograms;
+		QMap<uint16_t, Line> m_lines;
 		QList<VariableType *> m_types;
+
+		// The address space is only 64KB, so every address has its entry in
+		// the tables. Entries are indexes to the lists below increased by
+		// one; zero means the address is not covered.
+		bool m_indexValid;
+		QVector<uint16_t> m_subprogramIndex;
+		QVector<uint32_t> m_lineIndex;
+		QList<Subprogram *> m_indexedSubprograms;
+		QList<Line> m_indexedLines;
 };
 
 
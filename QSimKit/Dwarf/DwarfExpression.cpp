@@ -46,341 +46,377 @@
 #include "QSimKit/MCU/Register.h"
 #include "QSimKit/MCU/Memory.h"
 
+#include "DwarfReader.h"
 #include "dwarf.h"
 
-#include <QFile>
-#include <QProcess>
-#include <QDir>
 #include <QDebug>
+#include <QHash>
+#include <QPair>
 
 #include "QSimKit/MCU/MCU.h"
 
-DwarfExpression::DwarfExpression(const QString &expression) {
-	parse(expression);
+#define STACK_SIZE 64
+// Limits the number of taken branches, so the looping expression cannot
+// freeze the UI
+#define MAX_BRANCHES 1024
+
+#define NEED(N) if (sp < (int) (N)) { return VariableValue(); }
+#define PUSH(V) if (sp == STACK_SIZE) { return VariableValue(); } stack[sp++] = (V);
+
+DwarfExpression::DwarfExpression(const uint8_t *data, uint32_t size, uint8_t addressSize) :
+m_valid(false), m_code((const char *) data, size), m_addressSize(addressSize) {
+	compile(data, size, addressSize);
 }
 
 DwarfExpression::~DwarfExpression() {
 	
 }
 
-DwarfExpression::Instruction DwarfExpression::getInstruction(const QString &expr) {
-	Instruction inst;
-	inst.op = 0;
+bool DwarfExpression::compile(const uint8_t *data, uint32_t size, uint8_t addressSize) {
+	// DWARF operations without operands and the operations they compile to
+	static const struct {
+		uint8_t dwarf;
+		OpCode op;
+	} simpleOps[] = {
+		{DW_OP_deref, OpDeref}, {DW_OP_dup, OpDup}, {DW_OP_drop, OpDrop},
+		{DW_OP_over, OpOver}, {DW_OP_swap, OpSwap}, {DW_OP_rot, OpRot},
+		{DW_OP_abs, OpAbs}, {DW_OP_neg, OpNeg}, {DW_OP_not, OpNot},
+		{DW_OP_and, OpAnd}, {DW_OP_or, OpOr}, {DW_OP_xor, OpXor},
+		{DW_OP_plus, OpPlus}, {DW_OP_minus, OpMinus}, {DW_OP_mul, OpMul},
+		{DW_OP_div, OpDiv}, {DW_OP_mod, OpMod}, {DW_OP_shl, OpShl},
+		{DW_OP_shr, OpShr}, {DW_OP_shra, OpShra}, {DW_OP_eq, OpEq},
+		{DW_OP_ne, OpNe}, {DW_OP_lt, OpLt}, {DW_OP_le, OpLe},
+		{DW_OP_gt, OpGt}, {DW_OP_ge, OpGe}, {DW_OP_stack_value, OpStackValue},
+	};
 
-	if (expr.startsWith("DW_OP_addr")) inst.op = DW_OP_addr;
-	else if (expr.startsWith("DW_OP_const1u")) inst.op = DW_OP_const1u;
-	else if (expr.startsWith("DW_OP_const1s")) inst.op = DW_OP_const1s;
-	else if (expr.startsWith("DW_OP_const2u")) inst.op = DW_OP_const2u;
-	else if (expr.startsWith("DW_OP_const2s")) inst.op = DW_OP_const2s;
-	else if (expr.startsWith("DW_OP_const4u")) inst.op = DW_OP_const4u;
-	else if (expr.startsWith("DW_OP_const4s")) inst.op = DW_OP_const4s;
-	else if (expr.startsWith("DW_OP_const8u")) inst.op = DW_OP_const8u;
-	else if (expr.startsWith("DW_OP_const8s")) inst.op = DW_OP_const8s;
-	else if (expr.startsWith("DW_OP_constu")) inst.op = DW_OP_constu;
-	else if (expr.startsWith("DW_OP_consts")) inst.op = DW_OP_consts;
-	else if (expr.startsWith("DW_OP_dup")) inst.op = DW_OP_dup;
-	else if (expr.startsWith("DW_OP_drop")) inst.op = DW_OP_drop;
-	else if (expr.startsWith("DW_OP_over")) inst.op = DW_OP_over;
-	else if (expr.startsWith("DW_OP_pick")) inst.op = DW_OP_pick;
-	else if (expr.startsWith("DW_OP_swap")) inst.op = DW_OP_swap;
-	else if (expr.startsWith("DW_OP_rot")) inst.op = DW_OP_rot;
-	else if (expr.startsWith("DW_OP_xderef")) inst.op = DW_OP_xderef;
-	else if (expr.startsWith("DW_OP_abs")) inst.op = DW_OP_abs;
-	else if (expr.startsWith("DW_OP_and")) inst.op = DW_OP_and;
-	else if (expr.startsWith("DW_OP_div")) inst.op = DW_OP_div;
-	else if (expr.startsWith("DW_OP_minus")) inst.op = DW_OP_minus;
-	else if (expr.startsWith("DW_OP_mod")) inst.op = DW_OP_mod;
-	else if (expr.startsWith("DW_OP_mul")) inst.op = DW_OP_mul;
-	else if (expr.startsWith("DW_OP_neg")) inst.op = DW_OP_neg;
-	else if (expr.startsWith("DW_OP_not")) inst.op = DW_OP_not;
-	else if (expr.startsWith("DW_OP_or")) inst.op = DW_OP_or;
-	else if (expr.startsWith("DW_OP_plus")) inst.op = DW_OP_plus;
-	else if (expr.startsWith("DW_OP_plus_uconst")) inst.op = DW_OP_plus_uconst;
-	else if (expr.startsWith("DW_OP_shl")) inst.op = DW_OP_shl;
-	else if (expr.startsWith("DW_OP_shr")) inst.op = DW_OP_shr;
-	else if (expr.startsWith("DW_OP_shra")) inst.op = DW_OP_shra;
-	else if (expr.startsWith("DW_OP_xor")) inst.op = DW_OP_xor;
-	else if (expr.startsWith("DW_OP_bra")) inst.op = DW_OP_bra;
-	else if (expr.startsWith("DW_OP_eq")) inst.op = DW_OP_eq;
+	m_ops.clear();
+	m_valid = false;
 
-	if (inst.op == 0) {
-	if (expr.startsWith("DW_OP_ge")) inst.op = DW_OP_ge;
-	else if (expr.startsWith("DW_OP_gt")) inst.op = DW_OP_gt;
-	else if (expr.startsWith("DW_OP_le")) inst.op = DW_OP_le;
-	else if (expr.startsWith("DW_OP_lt")) inst.op = DW_OP_lt;
-	else if (expr.startsWith("DW_OP_ne")) inst.op = DW_OP_ne;
-	else if (expr.startsWith("DW_OP_skip")) inst.op = DW_OP_skip;
-	else if (expr.startsWith("DW_OP_lit10")) inst.op = DW_OP_lit10;
-	else if (expr.startsWith("DW_OP_lit11")) inst.op = DW_OP_lit11;
-	else if (expr.startsWith("DW_OP_lit12")) inst.op = DW_OP_lit12;
-	else if (expr.startsWith("DW_OP_lit13")) inst.op = DW_OP_lit13;
-	else if (expr.startsWith("DW_OP_lit14")) inst.op = DW_OP_lit14;
-	else if (expr.startsWith("DW_OP_lit15")) inst.op = DW_OP_lit15;
-	else if (expr.startsWith("DW_OP_lit16")) inst.op = DW_OP_lit16;
-	else if (expr.startsWith("DW_OP_lit17")) inst.op = DW_OP_lit17;
-	else if (expr.startsWith("DW_OP_lit18")) inst.op = DW_OP_lit18;
-	else if (expr.startsWith("DW_OP_lit19")) inst.op = DW_OP_lit19;
-	else if (expr.startsWith("DW_OP_lit20")) inst.op = DW_OP_lit20;
-	else if (expr.startsWith("DW_OP_lit21")) inst.op = DW_OP_lit21;
-	else if (expr.startsWith("DW_OP_lit22")) inst.op = DW_OP_lit22;
-	else if (expr.startsWith("DW_OP_lit23")) inst.op = DW_OP_lit23;
-	else if (expr.startsWith("DW_OP_lit24")) inst.op = DW_OP_lit24;
-	else if (expr.startsWith("DW_OP_lit25")) inst.op = DW_OP_lit25;
-	else if (expr.startsWith("DW_OP_lit26")) inst.op = DW_OP_lit26;
-	else if (expr.startsWith("DW_OP_lit27")) inst.op = DW_OP_lit27;
-	else if (expr.startsWith("DW_OP_lit28")) inst.op = DW_OP_lit28;
-	else if (expr.startsWith("DW_OP_lit29")) inst.op = DW_OP_lit29;
-	else if (expr.startsWith("DW_OP_lit30")) inst.op = DW_OP_lit30;
-	else if (expr.startsWith("DW_OP_lit31")) inst.op = DW_OP_lit31;
-	else if (expr.startsWith("DW_OP_lit0")) inst.op = DW_OP_lit0;
-	else if (expr.startsWith("DW_OP_lit1")) inst.op = DW_OP_lit1;
-	else if (expr.startsWith("DW_OP_lit2")) inst.op = DW_OP_lit2;
-	else if (expr.startsWith("DW_OP_lit3")) inst.op = DW_OP_lit3;
-	else if (expr.startsWith("DW_OP_lit4")) inst.op = DW_OP_lit4;
-	else if (expr.startsWith("DW_OP_lit5")) inst.op = DW_OP_lit5;
-	else if (expr.startsWith("DW_OP_lit6")) inst.op = DW_OP_lit6;
-	else if (expr.startsWith("DW_OP_lit7")) inst.op = DW_OP_lit7;
-	else if (expr.startsWith("DW_OP_lit8")) inst.op = DW_OP_lit8;
-	else if (expr.startsWith("DW_OP_lit9")) inst.op = DW_OP_lit9;
-	else if (expr.startsWith("DW_OP_reg10")) inst.op = DW_OP_reg10;
-	else if (expr.startsWith("DW_OP_reg11")) inst.op = DW_OP_reg11;
-	else if (expr.startsWith("DW_OP_reg12")) inst.op = DW_OP_reg12;
-	else if (expr.startsWith("DW_OP_reg13")) inst.op = DW_OP_reg13;
-	else if (expr.startsWith("DW_OP_reg14")) inst.op = DW_OP_reg14;
-	else if (expr.startsWith("DW_OP_reg15")) inst.op = DW_OP_reg15;
-	else if (expr.startsWith("DW_OP_reg16")) inst.op = DW_OP_reg16;
-	else if (expr.startsWith("DW_OP_reg17")) inst.op = DW_OP_reg17;
-	else if (expr.startsWith("DW_OP_reg18")) inst.op = DW_OP_reg18;
-	else if (expr.startsWith("DW_OP_reg19")) inst.op = DW_OP_reg19;
-	else if (expr.startsWith("DW_OP_reg20")) inst.op = DW_OP_reg20;
-	else if (expr.startsWith("DW_OP_reg21")) inst.op = DW_OP_reg21;
-	else if (expr.startsWith("DW_OP_reg22")) inst.op = DW_OP_reg22;
-	else if (expr.startsWith("DW_OP_reg23")) inst.op = DW_OP_reg23;
-	else if (expr.startsWith("DW_OP_reg24")) inst.op = DW_OP_reg24;
-	else if (expr.startsWith("DW_OP_reg25")) inst.op = DW_OP_reg25;
-	else if (expr.startsWith("DW_OP_reg26")) inst.op = DW_OP_reg26;
-	else if (expr.startsWith("DW_OP_reg27")) inst.op = DW_OP_reg27;
-	else if (expr.startsWith("DW_OP_reg28")) inst.op = DW_OP_reg28;
-	else if (expr.startsWith("DW_OP_reg29")) inst.op = DW_OP_reg29;
-	else if (expr.startsWith("DW_OP_reg30")) inst.op = DW_OP_reg30;
-	}
+	// Branch operands are byte offsets, they are translated to the
+	// operation indexes once all the operations are compiled
+	QHash<uint32_t, int> indexes;
+	QList<QPair<int, uint32_t> > branches;
 
-	if (inst.op == 0) {
-	if (expr.startsWith("DW_OP_reg31")) inst.op = DW_OP_reg31;
-	else if (expr.startsWith("DW_OP_reg0")) inst.op = DW_OP_reg0;
-	else if (expr.startsWith("DW_OP_reg1")) inst.op = DW_OP_reg1;
-	else if (expr.startsWith("DW_OP_reg2")) inst.op = DW_OP_reg2;
-	else if (expr.startsWith("DW_OP_reg3")) inst.op = DW_OP_reg3;
-	else if (expr.startsWith("DW_OP_reg4")) inst.op = DW_OP_reg4;
-	else if (expr.startsWith("DW_OP_reg5")) inst.op = DW_OP_reg5;
-	else if (expr.startsWith("DW_OP_reg6")) inst.op = DW_OP_reg6;
-	else if (expr.startsWith("DW_OP_reg7")) inst.op = DW_OP_reg7;
-	else if (expr.startsWith("DW_OP_reg8")) inst.op = DW_OP_reg8;
-	else if (expr.startsWith("DW_OP_reg9")) inst.op = DW_OP_reg9;
-	else if (expr.startsWith("DW_OP_breg10")) inst.op = DW_OP_breg10;
-	else if (expr.startsWith("DW_OP_breg11")) inst.op = DW_OP_breg11;
-	else if (expr.startsWith("DW_OP_breg12")) inst.op = DW_OP_breg12;
-	else if (expr.startsWith("DW_OP_breg13")) inst.op = DW_OP_breg13;
-	else if (expr.startsWith("DW_OP_breg14")) inst.op = DW_OP_breg14;
-	else if (expr.startsWith("DW_OP_breg15")) inst.op = DW_OP_breg15;
-	else if (expr.startsWith("DW_OP_breg16")) inst.op = DW_OP_breg16;
-	else if (expr.startsWith("DW_OP_breg17")) inst.op = DW_OP_breg17;
-	else if (expr.startsWith("DW_OP_breg18")) inst.op = DW_OP_breg18;
-	else if (expr.startsWith("DW_OP_breg19")) inst.op = DW_OP_breg19;
-	else if (expr.startsWith("DW_OP_breg20")) inst.op = DW_OP_breg20;
-	else if (expr.startsWith("DW_OP_breg21")) inst.op = DW_OP_breg21;
-	else if (expr.startsWith("DW_OP_breg22")) inst.op = DW_OP_breg22;
-	else if (expr.startsWith("DW_OP_breg23")) inst.op = DW_OP_breg23;
-	else if (expr.startsWith("DW_OP_breg24")) inst.op = DW_OP_breg24;
-	else if (expr.startsWith("DW_OP_breg25")) inst.op = DW_OP_breg25;
-	else if (expr.startsWith("DW_OP_breg26")) inst.op = DW_OP_breg26;
-	else if (expr.startsWith("DW_OP_breg27")) inst.op = DW_OP_breg27;
-	else if (expr.startsWith("DW_OP_breg28")) inst.op = DW_OP_breg28;
-	else if (expr.startsWith("DW_OP_breg29")) inst.op = DW_OP_breg29;
-	else if (expr.startsWith("DW_OP_breg30")) inst.op = DW_OP_breg30;
-	else if (expr.startsWith("DW_OP_breg31")) inst.op = DW_OP_breg31;
-	else if (expr.startsWith("DW_OP_breg0")) inst.op = DW_OP_breg0;
-	else if (expr.startsWith("DW_OP_breg1")) inst.op = DW_OP_breg1;
-	else if (expr.startsWith("DW_OP_breg2")) inst.op = DW_OP_breg2;
-	else if (expr.startsWith("DW_OP_breg3")) inst.op = DW_OP_breg3;
-	else if (expr.startsWith("DW_OP_breg4")) inst.op = DW_OP_breg4;
-	else if (expr.startsWith("DW_OP_breg5")) inst.op = DW_OP_breg5;
-	else if (expr.startsWith("DW_OP_breg6")) inst.op = DW_OP_breg6;
-	else if (expr.startsWith("DW_OP_breg7")) inst.op = DW_OP_breg7;
-	else if (expr.startsWith("DW_OP_breg8")) inst.op = DW_OP_breg8;
-	else if (expr.startsWith("DW_OP_breg9")) inst.op = DW_OP_breg9;
-	else if (expr.startsWith("DW_OP_regx")) inst.op = DW_OP_regx;
-	else if (expr.startsWith("DW_OP_fbreg")) inst.op = DW_OP_fbreg;
-	else if (expr.startsWith("DW_OP_bregx")) inst.op = DW_OP_bregx;
-	}
+	DwarfReader reader(data, size);
+	while (!reader.atEnd()) {
+		indexes[reader.getOffset()] = m_ops.size();
 
-	if (inst.op == 0) {
-	if (expr.startsWith("DW_OP_piece")) inst.op = DW_OP_piece;
-	else if (expr.startsWith("DW_OP_deref_size")) inst.op = DW_OP_deref_size;
-	else if (expr.startsWith("DW_OP_xderef_size")) inst.op = DW_OP_xderef_size;
-	else if (expr.startsWith("DW_OP_nop")) inst.op = DW_OP_nop;
-	else if (expr.startsWith("DW_OP_push_object_address")) inst.op = DW_OP_push_object_address;
-	else if (expr.startsWith("DW_OP_call2")) inst.op = DW_OP_call2;
-	else if (expr.startsWith("DW_OP_call4")) inst.op = DW_OP_call4;
-	else if (expr.startsWith("DW_OP_call_ref")) inst.op = DW_OP_call_ref;
-	else if (expr.startsWith("DW_OP_form_tls_address")) inst.op = DW_OP_form_tls_address;
-	else if (expr.startsWith("DW_OP_call_frame_cfa")) inst.op = DW_OP_call_frame_cfa;
-	else if (expr.startsWith("DW_OP_bit_piece")) inst.op = DW_OP_bit_piece;
-	else if (expr.startsWith("DW_OP_implicit_value")) inst.op = DW_OP_implicit_value;
-	else if (expr.startsWith("DW_OP_stack_value")) inst.op = DW_OP_stack_value;
-	else if (expr.startsWith("DW_OP_deref")) inst.op = DW_OP_deref;
-	}
-// 	else { qDebug() << "UNKNOWN OP" << expr; }
+		Operation o;
+		o.op = OpConst;
+		o.reg = 0;
+		o.arg = 0;
 
-	int i = expr.lastIndexOf(':');
-	if (i > 0) {
-		QString str = expr.mid(i + 1).trimmed().remove(')');
-		bool ok;
-		inst.arg = (uint16_t) str.toInt(&ok);
-		if (!ok) {
-			qDebug() << "Cannot convert " << str;
+		uint8_t op = reader.u8();
+		if (op >= DW_OP_lit0 && op <= DW_OP_lit31) {
+			o.arg = op - DW_OP_lit0;
 		}
-	}
-	else {
-		inst.arg = 0;
-	}
+		else if (op >= DW_OP_reg0 && op <= DW_OP_reg31) {
+			o.op = OpReg;
+			o.reg = op - DW_OP_reg0;
+		}
+		else if (op >= DW_OP_breg0 && op <= DW_OP_breg31) {
+			o.op = OpBreg;
+			o.reg = op - DW_OP_breg0;
+			o.arg = reader.sleb128();
+		}
+		else switch (op) {
+			case DW_OP_nop:
+				continue;
+			case DW_OP_addr:
+				o.op = OpAddr;
+				o.arg = reader.readUnsigned(addressSize);
+				break;
+			case DW_OP_const1u:
+				o.arg = reader.u8();
+				break;
+			case DW_OP_const1s:
+				o.arg = (int8_t) reader.u8();
+				break;
+			case DW_OP_const2u:
+				o.arg = reader.u16();
+				break;
+			case DW_OP_const2s:
+				o.arg = (int16_t) reader.u16();
+				break;
+			case DW_OP_const4u:
+			case DW_OP_const4s:
+				o.arg = reader.u32();
+				break;
+			case DW_OP_const8u:
+			case DW_OP_const8s:
+				// The stack is 32-bit wide, enough for MSP430 values
+				o.arg = reader.u64();
+				break;
+			case DW_OP_constu:
+				o.arg = reader.uleb128();
+				break;
+			case DW_OP_consts:
+				o.arg = reader.sleb128();
+				break;
+			case DW_OP_regx:
+			case DW_OP_bregx: {
+				uint64_t reg = reader.uleb128();
+				if (reg > 0xff) {
+					return false;
+				}
+				o.op = op == DW_OP_regx ? OpReg : OpBreg;
+				o.reg = reg;
+				if (op == DW_OP_bregx) {
+					o.arg = reader.sleb128();
+				}
+				break;
+			}
+			case DW_OP_fbreg:
+				o.op = OpFbreg;
+				o.arg = reader.sleb128();
+				break;
+			case DW_OP_deref_size:
+				o.op = OpDerefSize;
+				o.arg = reader.u8();
+				break;
+			case DW_OP_pick:
+				o.op = OpPick;
+				o.arg = reader.u8();
+				break;
+			case DW_OP_plus_uconst:
+				o.op = OpPlusConst;
+				o.arg = reader.uleb128();
+				break;
+			case DW_OP_piece:
+				o.op = OpPiece;
+				o.arg = reader.uleb128();
+				break;
+			case DW_OP_skip:
+			case DW_OP_bra: {
+				int16_t offset = reader.u16();
+				o.op = op == DW_OP_skip ? OpSkip : OpBra;
+				branches.append(qMakePair(m_ops.size(), reader.getOffset() + offset));
+				break;
+			}
+			default: {
+				unsigned int i;
+				for (i = 0; i < sizeof(simpleOps) / sizeof(simpleOps[0]); ++i) {
+					if (simpleOps[i].dwarf == op) {
+						o.op = simpleOps[i].op;
+						break;
+					}
+				}
 
-	return inst;
-}
+				if (i == sizeof(simpleOps) / sizeof(simpleOps[0])) {
+					qDebug() << "DwarfExpression: unsupported opcode" << (int) op;
+					return false;
+				}
+				break;
+			}
+		}
 
-bool DwarfExpression::parse(const QString &expression) {
-	// "DW_OP_breg13 (r13): 0; DW_OP_breg14 (r14): 0; DW_OP_or; DW_OP_stack_value"
-	// "DW_OP_reg15 (r15)"
+		if (reader.hasError()) {
+			return false;
+		}
+		m_ops.append(o);
+	}
 
-	QStringList cmds = expression.split(";", QString::SkipEmptyParts);
-	foreach(const QString &cmd, cmds) {
-		Instruction inst = getInstruction(cmd.trimmed());
-		m_instructions.append(inst);
+	// Branch can also jump right after the last operation
+	indexes[reader.getOffset()] = m_ops.size();
+	for (int i = 0; i < branches.size(); ++i) {
+		QHash<uint32_t, int>::const_iterator it = indexes.find(branches[i].second);
+		if (it == indexes.end()) {
+			return false;
+		}
+		m_ops[branches[i].first].arg = it.value();
 	}
 
+	m_valid = true;
 	return true;
 }
 
 VariableValue DwarfExpression::getValue(RegisterSet *r, Memory *m, DwarfSubprogram *s, uint16_t pc, bool &isAddress) {
 	VariableValue value;
-	unsigned long tmp, stack[64];
-	unsigned sp = 0;
-	bool hasPiece;
+	uint32_t stack[STACK_SIZE];
+	uint32_t a;
+	int sp = 0;
+	int branches = 0;
+	bool hasPiece = false;
 
 	isAddress = true;
-	foreach(const Instruction &inst, m_instructions) {
-		unsigned char opcode = inst.op;
-
-// 		qDebug() << "EXPR OP =" << opcode;
+	if (!m_valid) {
+		return value;
+	}
 
-		if (opcode >= DW_OP_lit0 && opcode <= DW_OP_lit31) {
-			stack[++sp] = opcode - DW_OP_lit0;
-			isAddress = false;
-		}
-		else if (opcode >= DW_OP_reg0 && opcode <= DW_OP_reg31) {
-			stack[++sp] = r->get(opcode - DW_OP_reg0)->getBigEndian();
-			isAddress = false;
-		}
-		else if (opcode >= DW_OP_breg0 && opcode <= DW_OP_breg31) {
-			stack[++sp] = r->get(opcode - DW_OP_breg0)->getBigEndian() + inst.arg;
-			isAddress = true;
-		}
-		else switch (opcode)
-		{
-		case DW_OP_nop: break;
-		case DW_OP_addr: stack[++sp] = inst.arg; break;
-		case DW_OP_const1u: stack[++sp] = inst.arg; isAddress = false; break;
-		case DW_OP_const1s: stack[++sp] = (signed char)inst.arg; isAddress = false; break;
-		case DW_OP_const2u: stack[++sp] = inst.arg; isAddress = false; break;
-		case DW_OP_const2s: stack[++sp] = (short)inst.arg; isAddress = false; break;
-		case DW_OP_const4u: stack[++sp] = inst.arg; isAddress = false; break;
-		case DW_OP_const4s: stack[++sp] = (signed int)inst.arg; isAddress = false; break;
-		case DW_OP_const8u: stack[++sp] = inst.arg; isAddress = false; break;
-		case DW_OP_const8s: stack[++sp] = inst.arg; isAddress = false; break;
-		case DW_OP_constu: stack[++sp] = inst.arg; isAddress = false; break;
-		case DW_OP_consts: stack[++sp] = inst.arg; isAddress = false; break;
-		case DW_OP_deref:
-			isAddress = false;
-			stack[sp] = m->getBigEndian(stack[sp], false);
-			break;
-		case DW_OP_dup: stack[sp + 1] = stack[sp]; sp++; break;
-		case DW_OP_drop: sp--; break;
-		case DW_OP_over: stack[sp + 1] = stack[sp - 1]; sp++; break;
-		case DW_OP_pick: stack[sp + 1] = stack[sp - inst.arg]; sp++; break;
-		case DW_OP_swap: tmp = stack[sp]; stack[sp] = stack[sp-1]; stack[sp-1] = tmp; break;
-		case DW_OP_rot: tmp = stack[sp]; stack[sp] = stack[sp-1]; stack[sp-1] = stack[sp-2]; stack[sp-2] = tmp; break;
-		case DW_OP_abs: stack[sp] = labs(stack[sp]); break;
-		case DW_OP_neg: stack[sp] = -stack[sp]; break;
-		case DW_OP_not: stack[sp] = ~stack[sp]; break;
-		case DW_OP_and: stack[sp-1] &= stack[sp]; sp--; break;
-		case DW_OP_or: stack[sp-1] |= stack[sp]; sp--; break;
-		case DW_OP_minus: stack[sp-1] -= stack[sp]; sp--; break;
-		case DW_OP_mul: stack[sp-1] *= stack[sp]; sp--; break;
-		case DW_OP_plus: stack[sp-1] += stack[sp]; sp--; break;
-		case DW_OP_xor: stack[sp-1] ^= stack[sp]; sp--; break;
-		case DW_OP_shl: stack[sp-1] <<= stack[sp]; sp--; break;
-		case DW_OP_shr: stack[sp-1] >>= stack[sp]; sp--; break;
-		case DW_OP_plus_uconst: stack[sp] += inst.arg; break;
-		case DW_OP_shra: stack[sp-1] = (long)stack[sp-1] / (1 << stack[sp]); sp--; break;
-		case DW_OP_div: stack[sp-1] = (long)stack[sp-1] / (long)stack[sp]; sp--; break;
-		case DW_OP_mod: stack[sp-1] = (long)stack[sp-1] % (long)stack[sp]; sp--; break;
-		case DW_OP_ge: stack[sp-1] = ((long)stack[sp-1] >= (long)stack[sp]); sp--; break;
-		case DW_OP_gt: stack[sp-1] = ((long)stack[sp-1] > (long)stack[sp]); sp--; break;
-		case DW_OP_le: stack[sp-1] = ((long)stack[sp-1] <= (long)stack[sp]); sp--; break;
-		case DW_OP_lt: stack[sp-1] = ((long)stack[sp-1] < (long)stack[sp]); sp--; break;
-		case DW_OP_eq: stack[sp-1] = (stack[sp-1] == stack[sp]); sp--; break;
-		case DW_OP_ne: stack[sp-1] = (stack[sp-1] != stack[sp]); sp--; break;
-		case DW_OP_piece:
-			hasPiece = true;
-			value.prepend(VariableValuePiece(stack[sp], isAddress, inst.arg));
-			break;
-// 		case DW_OP_skip: tmp = (short)inst.arg; ctx.data += tmp; break;
-// 		case DW_OP_bra: tmp = (short)dwarf2_parse_u2(&ctx); if (!stack[sp--]) ctx.data += tmp; break;
-// 		case DW_OP_GNU_encoded_addr:
-// 			tmp = dwarf2_parse_byte(&ctx);
-// 			stack[++sp] = dwarf2_parse_augmentation_ptr(&ctx, tmp);
-// 			break;
-		case DW_OP_regx:
-			isAddress = false;
-			stack[++sp] = r->get(inst.arg)->getBigEndian();
-			break;
-		case DW_OP_bregx:
-			isAddress = true;
-			stack[++sp] = r->get(inst.arg)->getBigEndian() + inst.arg2;
-			break;
-		case DW_OP_fbreg:
-			isAddress = true;
-			stack[++sp] = s->getFrameBase(r, m, pc) + inst.arg;
-			break;
-// TODO
-// 		case DW_OP_deref_size:
-// 			sz = dwarf2_parse_byte(&ctx);
-// 			if (!sw_read_mem(csw, stack[sp], &tmp, sz))
-// 			{
-// 				ERR("Couldn't read memory at %lx\n", stack[sp]);
-// 				tmp = 0;
-// 			}
-// 			/* do integral promotion */
-// 			switch (sz)
-// 			{
-// 			case 1: stack[sp] = *(unsigned char*)&tmp; break;
-// 			case 2: stack[sp] = *(unsigned short*)&tmp; break;
-// 			case 4: stack[sp] = *(unsigned int*)&tmp; break;
-// 			case 8: stack[sp] = *(Ulong*)&tmp; break; /* FIXME: won't work on 32bit platform */
-// 			default: FIXME("Unknown size for deref 0x%lx\n", sz);
-// 			}
-// 			break;
-		case DW_OP_stack_value: break;
-		default:
-			qDebug() << "DwarfExpression: unhandled opcode " << opcode;
+	const Operation *ops = m_ops.constData();
+	int count = m_ops.size();
+	for (int i = 0; i < count; ++i) {
+		const Operation &o = ops[i];
+		switch (o.op) {
+			case OpConst:
+				PUSH(o.arg);
+				isAddress = false;
+				break;
+			case OpAddr:
+				PUSH(o.arg);
+				isAddress = true;
+				break;
+			case OpReg:
+				if (o.reg >= r->size()) {
+					return VariableValue();
+				}
+				PUSH(r->get(o.reg)->getBigEndian());
+				isAddress = false;
+				break;
+			case OpBreg:
+				if (o.reg >= r->size()) {
+					return VariableValue();
+				}
+				PUSH(r->get(o.reg)->getBigEndian() + o.arg);
+				isAddress = true;
+				break;
+			case OpFbreg:
+				if (!s) {
+					return VariableValue();
+				}
+				PUSH(s->getFrameBase(r, m, pc) + o.arg);
+				isAddress = true;
+				break;
+			case OpDeref:
+				NEED(1);
+				stack[sp - 1] = m->getBigEndian(stack[sp - 1], false);
+				isAddress = false;
+				break;
+			case OpDerefSize:
+				NEED(1);
+				a = stack[sp - 1];
+				if (o.arg == 1) {
+					stack[sp - 1] = m->getByte(a, false);
+				}
+				else if (o.arg == 2) {
+					stack[sp - 1] = m->getBigEndian(a, false);
+				}
+				else if (o.arg == 4) {
+					stack[sp - 1] = m->getBigEndian(a, false) | (m->getBigEndian(a + 2, false) << 16);
+				}
+				else {
+					return VariableValue();
+				}
+				isAddress = false;
+				break;
+			case OpDup:
+				NEED(1);
+				PUSH(stack[sp - 1]);
+				break;
+			case OpDrop:
+				NEED(1);
+				sp--;
+				break;
+			case OpOver:
+				NEED(2);
+				PUSH(stack[sp - 2]);
+				break;
+			case OpPick:
+				NEED(o.arg + 1);
+				PUSH(stack[sp - 1 - o.arg]);
+				break;
+			case OpSwap:
+				NEED(2);
+				a = stack[sp - 1];
+				stack[sp - 1] = stack[sp - 2];
+				stack[sp - 2] = a;
+				break;
+			case OpRot:
+				NEED(3);
+				a = stack[sp - 1];
+				stack[sp - 1] = stack[sp - 2];
+				stack[sp - 2] = stack[sp - 3];
+				stack[sp - 3] = a;
+				break;
+			case OpAbs:
+				NEED(1);
+				if ((int32_t) stack[sp - 1] < 0) {
+					stack[sp - 1] = -stack[sp - 1];
+				}
+				break;
+			case OpNeg:
+				NEED(1);
+				stack[sp - 1] = -stack[sp - 1];
+				break;
+			case OpNot:
+				NEED(1);
+				stack[sp - 1] = ~stack[sp - 1];
+				break;
+			case OpPlusConst:
+				NEED(1);
+				stack[sp - 1] += o.arg;
+				break;
+			case OpAnd: case OpOr: case OpXor: case OpPlus: case OpMinus:
+			case OpMul: case OpDiv: case OpMod: case OpShl: case OpShr:
+			case OpShra: case OpEq: case OpNe: case OpLt: case OpLe:
+			case OpGt: case OpGe: {
+				NEED(2);
+				uint32_t b = stack[--sp];
+				a = stack[sp - 1];
+				int32_t sa = a;
+				int32_t sb = b;
+				switch (o.op) {
+					case OpAnd: a &= b; break;
+					case OpOr: a |= b; break;
+					case OpXor: a ^= b; break;
+					case OpPlus: a += b; break;
+					case OpMinus: a -= b; break;
+					case OpMul: a *= b; break;
+					case OpDiv:
+					case OpMod:
+						if (sb == 0) {
+							return VariableValue();
+						}
+						// INT32_MIN / -1 overflows, which traps on x86
+						if (sb == -1) {
+							a = o.op == OpDiv ? 0 - a : 0;
+							break;
+						}
+						a = o.op == OpDiv ? sa / sb : sa % sb;
+						break;
+					case OpShl: a = b < 32 ? a << b : 0; break;
+					case OpShr: a = b < 32 ? a >> b : 0; break;
+					case OpShra: a = b < 32 ? sa >> b : (sa < 0 ? -1 : 0); break;
+					case OpEq: a = sa == sb; break;
+					case OpNe: a = sa != sb; break;
+					case OpLt: a = sa < sb; break;
+					case OpLe: a = sa <= sb; break;
+					case OpGt: a = sa > sb; break;
+					default: a = sa >= sb; break;
+				}
+				stack[sp - 1] = a;
+				break;
+			}
+			case OpBra:
+				NEED(1);
+				if (stack[--sp] == 0) {
+					break;
+				}
+				// fall through
+			case OpSkip:
+				if (++branches > MAX_BRANCHES) {
+					return VariableValue();
+				}
+				// The loop increments i to the target
+				i = o.arg - 1;
+				break;
+			case OpPiece:
+				NEED(1);
+				hasPiece = true;
+				value.prepend(VariableValuePiece(stack[--sp], isAddress, o.arg));
+				break;
+			case OpStackValue:
+				isAddress = false;
+				break;
+			default:
+				return VariableValue();
 		}
 	}
 
 	if (!hasPiece) {
-		VariableValuePiece v(stack[sp], isAddress, 0);
-		value.append(v);
+		NEED(1);
+		value.append(VariableValuePiece(stack[sp - 1], isAddress, 0));
 	}
 
 	return value;
-
 }
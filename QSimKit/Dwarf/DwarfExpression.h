@@ -22,6 +22,7 @@
 #include <QByteArray>
 #include <QString>
 #include <QList>
+#include <QVector>
 #include <stdint.h>
 #include "MCU/MCU.h"
 
@@ -52,24 +53,52 @@ class DwarfExpression {
 			uint8_t piece;
 		} Value;
 
-		DwarfExpression(const QString &expression);
+		/// Creates the expression from DWARF bytecode. Address size is the
+		/// size of the DW_OP_addr operand as defined by the compilation unit.
+		DwarfExpression(const uint8_t *data, uint32_t size, uint8_t addressSize);
 		virtual ~DwarfExpression();
 
+		/// Evaluates the expression. Returns empty value if the expression
+		/// could not be compiled or its evaluation fails.
 		VariableValue getValue(RegisterSet *r, Memory *m, DwarfSubprogram *s, uint16_t pc, bool &isAddress);
 
-		bool parse(const QString &expression);
+		/// Compiles the DWARF bytecode to the operations evaluated by
+		/// getValue(). Returns false if the expression is not supported.
+		bool compile(const uint8_t *data, uint32_t size, uint8_t addressSize);
+
+		/// Returns the DWARF bytecode the expression has been created from.
+		const QByteArray &getCode() const {
+			return m_code;
+		}
+
+		uint8_t getAddressSize() const {
+			return m_addressSize;
+		}
 
 	private:
+		/// Operations of the compiled expression. All the constants are
+		/// pushed by OpConst or OpAddr, the registers are addressed by
+		/// OpReg and OpBreg and the branches jump to the operation index.
+		typedef enum {
+			OpConst, OpAddr, OpReg, OpBreg, OpFbreg,
+			OpDeref, OpDerefSize,
+			OpDup, OpDrop, OpOver, OpPick, OpSwap, OpRot,
+			OpAbs, OpNeg, OpNot, OpAnd, OpOr, OpXor, OpPlus, OpPlusConst,
+			OpMinus, OpMul, OpDiv, OpMod, OpShl, OpShr, OpShra,
+			OpEq, OpNe, OpLt, OpLe, OpGt, OpGe,
+			OpSkip, OpBra, OpPiece, OpStackValue,
+		} OpCode;
+
 		typedef struct {
-			unsigned char op;
-			uint16_t arg;
-			uint16_t arg2;
-		} Instruction;
-		
-		Instruction getInstruction(const QString &expr);
+			uint8_t op;
+			uint8_t reg;
+			int32_t arg;
+		} Operation;
 
 	private:
-		QList<Instruction> m_instructions;
-		
+		QVector<Operation> m_ops;
+		bool m_valid;
+		QByteArray m_code;
+		uint8_t m_addressSize;
 };
 
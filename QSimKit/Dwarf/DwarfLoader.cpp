@@ -17,6 +17,7 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
  **/
 
+
 #include "DwarfLoader.h"
 #include "DwarfDebugData.h"
 #include "DwarfSubprogram.h"
@@ -24,399 +25,725 @@
 #include "DwarfLocationList.h"
 #include "DwarfExpression.h"
 #include "DwarfVariable.h"
+#include "ElfFile.h"
+#include "dwarf.h"
 
-#include <QFile>
-#include <QProcess>
-#include <QDir>
 #include <QDebug>
 
 #include "QSimKit/MCU/MCU.h"
 
-DwarfLoader::DwarfLoader(const QString &objdump) : m_objdump(objdump) {
+// Nested types are resolved recursively, this limits broken type chains
+#define MAX_TYPE_DEPTH 32
+
+static QString baseName(const char *path) {
+	QString name = QString::fromLatin1(path);
+	return name.mid(name.lastIndexOf("/") + 1).trimmed();
+}
+
+static bool isAbsolute(const QString &path) {
+	return path.startsWith("/") || (path.size() > 2 && path[1] == ':');
+}
+
+static QString joinPath(const QString &dir, const QString &name) {
+	if (dir.isEmpty() || isAbsolute(name)) {
+		return name;
+	}
+	return dir + "/" + name;
+}
+
+typedef QMap<uint16_t, DwarfDebugData::Line> LineRows;
+
+/// Adds the rows of one sequence to the line table.
+static void addRows(DwarfDebugData *dd, LineRows &rows) {
+	for (LineRows::const_iterator it = rows.constBegin(); it != rows.constEnd(); ++it) {
+		dd->addLine(it.value().file, it.value().line, it.key());
+	}
+	rows.clear();
+}
+
+DwarfLoader::DwarfLoader() : m_loadedUnits(0) {
 	
 }
 
 DwarfLoader::~DwarfLoader() {
-	
+	clear();
 }
 
-bool DwarfLoader::loadVariableTypes(const QString &out, DwarfDebugData *dd, QMap<uint16_t, VariableType *> &types, QString &error) {
-	QStringList lines = out.split("\n", QString::SkipEmptyParts);
-	bool notFound = true;
-	int maxTries = 10;
-	QStringList notFoundList;
-
-	while (notFound && maxTries-- > 0) {
-		notFound = false;
-		notFoundList.clear();
-		for (int i = 0; i < lines.size(); ++i) {
-			QString &line = lines[i];
-
-			if (line.contains("DW_TAG_base_type")) {
-				QString name;
-				uint16_t addr = 0;
-				uint8_t byteSize = 0;
-				VariableType::Encoding encoding;
-
-				addr = line.mid(line.lastIndexOf("<") + 1, line.lastIndexOf(">") - line.lastIndexOf("<") - 1).trimmed().toUInt(0, 16);
-				if (types.contains(addr)) {
-					continue;
-				}
+void DwarfLoader::clear() {
+	foreach(const PendingSubprogram &s, m_subprograms) {
+		delete s.ll;
+		delete s.expr;
+		foreach(const PendingVariable &v, s.variables) {
+			delete v.ll;
+			delete v.expr;
+		}
+	}
+	m_subprograms.clear();
+	m_info = m_abbrev = m_loc = m_line = m_str = Section();
+	m_abbrevs.clear();
+	m_typeEntries.clear();
+	m_declarations.clear();
+	m_types.clear();
+}
 
-				for (i++; i < lines.size(); ++i) { 
-					QString &l = lines[i];
+bool DwarfLoader::loadSections(const QByteArray &elf, QString &error) {
+	ElfFile file;
+	if (!file.load(elf, error)) {
+		return false;
+	}
 
-					if (l.contains("DW_AT_name")) {
-						name = l.mid(l.lastIndexOf(":") + 2).trimmed();
-					}
-					else if (l.contains("DW_AT_byte_size")) {
-						byteSize = l.mid(l.lastIndexOf(":") + 2).trimmed().toUInt(0, 16);
-					}
-					else if (l.contains("DW_AT_encoding")) {
-						encoding = (VariableType::Encoding) l.mid(l.lastIndexOf(":") + 2, 2).trimmed().toUInt(0, 16);
-					}
-					else if (l.size() > 3 && l[1] == '<' && l[3] == '>') {
-						break;
-					}
-				}
+	m_info = getSection(file, ".debug_info");
+	m_abbrev = getSection(file, ".debug_abbrev");
+	m_loc = getSection(file, ".debug_loc");
+	m_line = getSection(file, ".debug_line");
+	m_str = getSection(file, ".debug_str");
+	if (!m_info.data || !m_abbrev.data) {
+		error = QString("ELF file does not contain DWARF debugging information.");
+		return false;
+	}
 
-				i--; // Otherwise we would skip next header
+	return true;
+}
 
-				if (byteSize != 0) {
-					VariableType *type = new VariableType(name, byteSize, encoding, VariableType::Base);
-					types[addr] = type;
-					dd->addVariableType(type);
-				}
-			}
-			else if (line.contains("DW_TAG_subroutine_type")) {
-				uint16_t addr = line.mid(line.lastIndexOf("<") + 1, line.lastIndexOf(">") - line.lastIndexOf("<") - 1).trimmed().toUInt(0, 16);
-				if (types.contains(addr)) {
-					continue;
-				}
+DwarfLoader::Section DwarfLoader::getSection(const ElfFile &file, const char *name) {
+	Section section;
+	const ElfFile::Section *s = file.getSection(name);
+	if (s) {
+		section.data = s->data;
+		section.size = s->size;
+	}
+	return section;
+}
+
+const DwarfLoader::Abbrevs *DwarfLoader::loadAbbrevs(uint32_t offset) {
+	QHash<uint32_t, Abbrevs>::const_iterator it = m_abbrevs.find(offset);
+	if (it != m_abbrevs.end()) {
+		return &it.value();
+	}
+
+	Abbrevs &abbrevs = m_abbrevs[offset];
+	DwarfReader r(m_abbrev.data, m_abbrev.size, offset);
+	while (!r.hasError()) {
+		uint64_t code = r.uleb128();
+		if (code == 0) {
+			break;
+		}
 
-				VariableType *type = new VariableType("", 0, VariableType::Address, VariableType::Subroutine);
-				types[addr] = type;
-				dd->addVariableType(type);
+		Abbrev &abbrev = abbrevs[code];
+		abbrev.tag = r.uleb128();
+		abbrev.children = r.u8() == DW_CHILDREN_yes;
+		while (!r.hasError()) {
+			uint16_t name = r.uleb128();
+			uint16_t form = r.uleb128();
+			if (name == 0 && form == 0) {
+				break;
 			}
-			else {
-				VariableType::Type type;
-				if (line.contains("DW_TAG_volatile_type")) {
-					type = VariableType::Volatile;
-				}
-				else if (line.contains("DW_TAG_const_type")) {
-					type = VariableType::Const;
+			abbrev.attributes.append(Attribute(name, form));
+		}
+	}
+
+	return &abbrevs;
+}
+
+bool DwarfLoader::readEntry(DwarfReader &info, const Unit &unit, const Abbrev &abbrev, Entry &entry) {
+	entry.tag = abbrev.tag;
+	foreach(const Attribute &a, abbrev.attributes) {
+		uint16_t form = a.form;
+		while (form == DW_FORM_indirect) {
+			form = info.uleb128();
+		}
+
+		uint64_t value = 0;
+		const uint8_t *block = 0;
+		uint32_t blockSize = 0;
+		const char *str = 0;
+		switch (form) {
+			case DW_FORM_addr:
+				value = info.readUnsigned(unit.addressSize);
+				break;
+			case DW_FORM_block1:
+				blockSize = info.u8();
+				block = info.block(blockSize);
+				break;
+			case DW_FORM_block2:
+				blockSize = info.u16();
+				block = info.block(blockSize);
+				break;
+			case DW_FORM_block4:
+				blockSize = info.u32();
+				block = info.block(blockSize);
+				break;
+			case DW_FORM_block:
+			case DW_FORM_exprloc:
+				blockSize = info.uleb128();
+				block = info.block(blockSize);
+				break;
+			case DW_FORM_data1:
+			case DW_FORM_flag:
+			case DW_FORM_ref1:
+				value = info.u8();
+				break;
+			case DW_FORM_data2:
+			case DW_FORM_ref2:
+				value = info.u16();
+				break;
+			case DW_FORM_data4:
+			case DW_FORM_ref4:
+			case DW_FORM_strp:
+			case DW_FORM_sec_offset:
+			case DW_FORM_GNU_ref_alt:
+			case DW_FORM_GNU_strp_alt:
+				value = info.u32();
+				break;
+			case DW_FORM_data8:
+			case DW_FORM_ref8:
+			case DW_FORM_ref_sig8:
+				value = info.u64();
+				break;
+			case DW_FORM_sdata:
+				value = info.sleb128();
+				break;
+			case DW_FORM_udata:
+			case DW_FORM_ref_udata:
+				value = info.uleb128();
+				break;
+			case DW_FORM_string:
+				str = info.cstr();
+				break;
+			case DW_FORM_ref_addr:
+				// DWARF 2 uses address size for the references
+				value = info.readUnsigned(unit.version == 2 ? unit.addressSize : 4);
+				break;
+			case DW_FORM_flag_present:
+				value = 1;
+				break;
+			default:
+				qDebug() << "DwarfLoader: unsupported form" << form;
+				return false;
+		}
+
+		if (info.hasError()) {
+			return false;
+		}
+
+		if (form == DW_FORM_strp) {
+			DwarfReader strReader(m_str.data, m_str.size, value);
+			str = strReader.cstr();
+		}
+
+		switch (a.name) {
+			case DW_AT_name:
+				if (str) {
+					entry.name = QString::fromLatin1(str);
 				}
-				else if (line.contains("DW_TAG_array_type")) {
-					type = VariableType::Array;
+				break;
+			case DW_AT_comp_dir:
+				if (str) {
+					entry.compDir = QString::fromLatin1(str);
 				}
-				else if (line.contains("DW_TAG_pointer_type")) {
-					type = VariableType::Pointer;
+				break;
+			case DW_AT_low_pc:
+				entry.lowPC = value;
+				break;
+			case DW_AT_high_pc:
+				entry.highPC = value;
+				// Since DWARF 4 high_pc can be an offset from low_pc
+				entry.highPCOffset = form != DW_FORM_addr;
+				break;
+			case DW_AT_byte_size:
+				entry.byteSize = value;
+				break;
+			case DW_AT_encoding:
+				entry.encoding = value;
+				break;
+			case DW_AT_upper_bound:
+				entry.upperBound = value;
+				break;
+			case DW_AT_count:
+				entry.upperBound = value - 1;
+				break;
+			case DW_AT_type:
+				entry.type = getReference(unit, form, value);
+				break;
+			case DW_AT_abstract_origin:
+			case DW_AT_specification:
+				entry.origin = getReference(unit, form, value);
+				break;
+			case DW_AT_location:
+			case DW_AT_frame_base:
+				if (block) {
+					entry.expr = block;
+					entry.exprSize = blockSize;
 				}
-				else {
-					continue;
+				else if (form == DW_FORM_data4 || form == DW_FORM_data8 || form == DW_FORM_sec_offset) {
+					entry.locList = value;
 				}
+				break;
+			case DW_AT_stmt_list:
+				entry.stmtList = value;
+				break;
+			default:
+				break;
+		}
+	}
 
-				uint16_t addr = line.mid(line.lastIndexOf("<") + 1, line.lastIndexOf(">") - line.lastIndexOf("<") - 1).trimmed().toUInt(0, 16);
-				if (types.contains(addr)) {
-					continue;
-				}
+	return true;
+}
 
-				VariableType *t = 0;
-				int16_t subrange = 0;
-				uint8_t byteSize = 0;
-				bool typeNotFound = false;
-				for (i++; i < lines.size(); ++i) { 
-					QString &l = lines[i];
-					if (l.contains("DW_AT_type") && subrange == 0) {
-						uint16_t address = l.mid(l.lastIndexOf("<") + 1, l.lastIndexOf(">") - l.lastIndexOf("<") - 1).trimmed().toUInt(0, 16);
-						if (types.contains(address) && types[address] != NULL) {
-							t = types[address];
-						}
-						else {
-							typeNotFound = true;
-							notFoundList << l;
-						}
-					}
-					else if (l.contains("DW_AT_byte_size")) {
-						byteSize = l.mid(l.lastIndexOf(":") + 2).trimmed().toUInt(0, 16);
-					}
-					else if (l.contains("DW_TAG_subrange_type")) {
-						subrange = -1;
-					}
-					else if (l.contains("DW_AT_upper_bound")) {
-						subrange = l.mid(l.lastIndexOf(":") + 2).trimmed().toUInt(0, 10);
-					}
-					else if (l.size() > 3 && l[1] == '<' && l[3] == '>') {
-						i--;
-						break;
-					}
-				}
+uint32_t DwarfLoader::getReference(const Unit &unit, uint16_t form, uint64_t value) {
+	switch (form) {
+		case DW_FORM_ref_addr:
+			return value;
+		case DW_FORM_ref1:
+		case DW_FORM_ref2:
+		case DW_FORM_ref4:
+		case DW_FORM_ref8:
+		case DW_FORM_ref_udata:
+			return unit.offset + value;
+		default:
+			// Type units and supplementary files are not loaded
+			return 0;
+	}
+}
 
-				if (typeNotFound) {
-					notFound = true;
-					continue;
-				}
+bool DwarfLoader::readLocation(const Unit &unit, const Entry &entry, DwarfLocationList **ll, DwarfExpression **expr) {
+	*ll = 0;
+	*expr = 0;
+	if (entry.expr) {
+		*expr = new DwarfExpression(entry.expr, entry.exprSize, unit.addressSize);
+	}
+	else if (entry.locList != -1) {
+		*ll = loadLocationList(entry.locList, unit);
+	}
+	return *ll || *expr;
+}
 
-				VariableType *typeCopy = new VariableType("", byteSize, VariableType::Address, type, subrange, t);
-				types[addr] = typeCopy;
-				dd->addVariableType(typeCopy);
-			}
+DwarfLocationList *DwarfLoader::loadLocationList(uint32_t offset, const Unit &unit) {
+	DwarfReader r(m_loc.data, m_loc.size, offset);
+	uint64_t base = unit.base;
+	uint64_t maxAddress = unit.addressSize == 8 ? ~(uint64_t) 0 : ((uint64_t) 1 << (unit.addressSize * 8)) - 1;
+
+	DwarfLocationList *ll = new DwarfLocationList();
+	while (true) {
+		uint64_t begin = r.readUnsigned(unit.addressSize);
+		uint64_t end = r.readUnsigned(unit.addressSize);
+		if (r.hasError() || (begin == 0 && end == 0)) {
+			break;
+		}
+
+		// Base address selection entry
+		if (begin == maxAddress) {
+			base = end;
+			continue;
+		}
+
+		uint16_t size = r.u16();
+		const uint8_t *data = r.block(size);
+		if (!data) {
+			break;
 		}
-	}
 
-	if (!notFoundList.isEmpty()) {
-		qDebug() << "Didn't find following DWARF types:" << notFoundList;
+		DwarfExpression *expr = new DwarfExpression(data, size, unit.addressSize);
+		ll->append(new DwarfLocation(expr, base + begin, base + end));
 	}
-	return !notFound;
+
+	return ll;
 }
 
-bool DwarfLoader::loadLocations(QString &file, QMap<uint16_t, DwarfLocationList *> &locations, QString &error) {
-	QProcess objdump;
-	objdump.start("msp430-objdump", QStringList() << file << "--dwarf=loc");
-	
-	if (!objdump.waitForStarted()) {
-		error = QString("'msp430-objdump' cannot be started. Is msp430-gcc installed and is msp430-objdump in PATH?");
-		return 0;
+void DwarfLoader::loadLines(uint32_t offset, const QString &compDir, DwarfDebugData *dd) {
+	DwarfReader r(m_line.data, m_line.size, offset);
+	uint32_t length = r.u32();
+	if (length >= 0xfffffff0) {
+		// 64-bit DWARF
+		return;
 	}
 
-	if (!objdump.waitForFinished()) {
-		error = QString("'msp430-objdump' did not finish properly.");
-		return 0;
+	uint32_t end = r.getOffset() + length;
+	uint16_t version = r.u16();
+	uint32_t headerLength = r.u32();
+	uint32_t program = r.getOffset() + headerLength;
+	uint8_t minInstructionLength = r.u8();
+	if (version >= 4) {
+		r.u8(); // maximum_operations_per_instruction
+	}
+	r.u8(); // default_is_stmt
+	int8_t lineBase = r.u8();
+	uint8_t lineRange = r.u8();
+	uint8_t opcodeBase = r.u8();
+	QList<uint8_t> opcodeLengths;
+	for (int i = 1; i < opcodeBase; ++i) {
+		opcodeLengths.append(r.u8());
 	}
 
-	QString out = QString(objdump.readAll());
-
-	QStringList lines = out.split("\n", QString::SkipEmptyParts);
-	foreach(const QString &line, lines) {
-		QString t = line.trimmed();
-
-		QStringList words = t.split(" ", QString::SkipEmptyParts);
-		if (words.size() == 0) {
-			continue;
+	// Directory 0 is the compilation directory
+	QList<QString> dirs;
+	dirs.append(compDir);
+	while (!r.hasError()) {
+		const char *dir = r.cstr();
+		if (*dir == 0) {
+			break;
 		}
+		dirs.append(joinPath(compDir, QString::fromLatin1(dir)));
+	}
 
-		if (words[0][0] != '0') {
-			continue;
+	QList<QString> files;
+	while (!r.hasError()) {
+		const char *name = r.cstr();
+		if (*name == 0) {
+			break;
 		}
+		unsigned int dir = r.uleb128();
+		r.uleb128(); // modification time
+		r.uleb128(); // length
+		files.append(joinPath(dir < (unsigned int) dirs.size() ? dirs[dir] : compDir, QString::fromLatin1(name)));
+	}
+
+	if (r.hasError() || lineRange == 0 || version < 2 || version > 4) {
+		return;
+	}
 
-		uint16_t addr = words[0].toUInt(0, 16);
-		uint16_t pcLow = words[1].toUInt(0, 16);
-		uint16_t pcHigh = words[2].toUInt(0, 16);
-		QString exprString = t.mid(t.indexOf("(") + 1, t.lastIndexOf(")") - t.indexOf("("));
-		if (!exprString.isEmpty()) {
-			DwarfExpression *expr = new DwarfExpression(exprString);
-			DwarfLocation *loc = new DwarfLocation(expr, pcLow, pcHigh);
-			if (!locations.contains(addr)) {
-				locations[addr] = new DwarfLocationList();
+	// Rows are kept until the end of their sequence. The row at the end
+	// address covers no code and must not replace the row of the sequence
+	// which starts there
+	LineRows rows;
+	uint64_t address = 0;
+	unsigned int file = 1;
+	int line = 1;
+	r.setOffset(program);
+	while (r.getOffset() < end && !r.hasError()) {
+		uint8_t opcode = r.u8();
+		bool row = false;
+		if (opcode >= opcodeBase) {
+			int adjusted = opcode - opcodeBase;
+			address += (adjusted / lineRange) * minInstructionLength;
+			line += lineBase + adjusted % lineRange;
+			row = true;
+		}
+		else if (opcode == 0) {
+			uint64_t size = r.uleb128();
+			if (size == 0) {
+				continue;
 			}
-			locations[addr]->append(loc);
+			uint32_t next = r.getOffset() + size;
+			uint8_t extended = r.u8();
+			switch (extended) {
+				case DW_LNE_end_sequence:
+					rows.remove(address);
+					addRows(dd, rows);
+					// Address after the sequence does not belong to any line,
+					// unless other sequence already starts there
+					if (!dd->getLines().contains(address)) {
+						dd->addLine(QString(), 0, address);
+					}
+					address = 0;
+					file = 1;
+					line = 1;
+					break;
+				case DW_LNE_set_address:
+					address = r.readUnsigned(size - 1);
+					break;
+				case DW_LNE_define_file:
+					files.append(joinPath(compDir, QString::fromLatin1(r.cstr())));
+					break;
+				default:
+					break;
+			}
+			r.setOffset(next);
+		}
+		else switch (opcode) {
+			case DW_LNS_copy:
+				row = true;
+				break;
+			case DW_LNS_advance_pc:
+				address += r.uleb128() * minInstructionLength;
+				break;
+			case DW_LNS_advance_line:
+				line += r.sleb128();
+				break;
+			case DW_LNS_set_file:
+				file = r.uleb128();
+				break;
+			case DW_LNS_const_add_pc:
+				address += ((255 - opcodeBase) / lineRange) * minInstructionLength;
+				break;
+			case DW_LNS_fixed_advance_pc:
+				address += r.u16();
+				break;
+			default:
+				// Skip the operands of the opcodes we do not need
+				for (int i = 0; i < opcodeLengths[opcode - 1]; ++i) {
+					r.uleb128();
+				}
+				break;
+		}
+
+		if (row && file >= 1 && file <= (unsigned int) files.size()) {
+			rows[address] = DwarfDebugData::Line(files[file - 1], line);
 		}
 	}
+
+	// Sequence of the truncated program
+	addRows(dd, rows);
 }
 
-void DwarfLoader::parseLocation(const QString &l, QMap<uint16_t, DwarfLocationList *> &locations, DwarfLocationList **ll, DwarfExpression **expr) {
-	if (l.contains("location list")) {
-		QString keyStr = l.mid(l.lastIndexOf(":") + 2, l.lastIndexOf("(") - l.lastIndexOf(":") - 2).trimmed();
-		uint16_t key = keyStr.toUInt(0, 16);
-		*ll = locations[key];
-		// Every DWARF location list is used only once, so we can remove it from
-		// locations variable now.
-		locations.remove(key);
+bool DwarfLoader::loadUnit(DwarfReader &info, DwarfDebugData *dd, QString &error) {
+	Unit unit;
+	unit.offset = info.getOffset();
+	unit.base = 0;
+	uint32_t length = info.u32();
+	if (length >= 0xfffffff0) {
+		error = QString("64-bit DWARF is not supported.");
+		return false;
 	}
-	else {
-		QString exprString = l.mid(l.indexOf("(") + 1, l.lastIndexOf(")") - l.indexOf("("));
-		*expr = new DwarfExpression(exprString);
+
+	uint32_t end = info.getOffset() + length;
+	unit.version = info.u16();
+	uint32_t abbrevOffset = info.u32();
+	unit.addressSize = info.u8();
+	// The unit is skipped up to its end, so the end must not wrap around
+	if (info.hasError() || end < unit.offset) {
+		error = QString("Invalid DWARF compile unit header at 0x%1.").arg(unit.offset, 0, 16);
+		return false;
 	}
-}
 
-#define SCROLL_TO(X, TO) \
-	for (X = i + 1; X < lines.size(); ++X) { \
-		QString &l = lines[X];\
-		if (l.contains(TO)) { \
-			break; \
-		} \
-		else if (l.size() > 3 && l[1] == '<' && l[3] == '>') { \
-			X = -1; \
-			break; \
-		} \
-	}
-
-bool DwarfLoader::loadSubprograms(const QString &out, DwarfDebugData *dd,
-								  QMap<uint16_t, DwarfLocationList *> &locations,
-								  QMap<uint16_t, VariableType *> &types,
-								  QString &error) {
-	int x;
+	// Units of other versions, like DWARF 5 emitted for some objects by
+	// newer compilers, do not prevent loading the rest of the data
+	if (unit.version < 2 || unit.version > 4) {
+		QString warning = QString("DWARF version %1 of the compile unit at 0x%2 is not supported.")
+			.arg(unit.version).arg(unit.offset, 0, 16);
+		qDebug() << warning;
+		m_warnings << warning;
+		info.setOffset(end);
+		return true;
+	}
+	m_loadedUnits++;
+	unit.abbrevs = loadAbbrevs(abbrevOffset);
+
 	QString currentFile;
-	DwarfSubprogram *currentSubprogram = 0;
-
-	QStringList lines = out.split("\n", QString::SkipEmptyParts);
-	for (int i = 0; i < lines.size(); ++i) {
-		QString &line = lines[i];
-
-		if (line.contains("DW_TAG_compile_unit")) {
-			SCROLL_TO(x, "DW_AT_name");
-			if (x > 0) {
-				currentFile = lines[x];
-				if (currentFile.contains("/")) {
-					currentFile = currentFile.mid(currentFile.lastIndexOf("/") + 1);
-				}
-				else {
-					currentFile = currentFile.mid(currentFile.lastIndexOf(":") + 2);
-				}
-				currentFile = currentFile.trimmed();
+	QList<Parent> parents;
+	while (info.getOffset() < end && !info.hasError()) {
+		uint32_t offset = info.getOffset();
+		uint64_t code = info.uleb128();
+		if (code == 0) {
+			if (!parents.empty()) {
+				parents.removeLast();
 			}
+			continue;
 		}
-		else if (line.contains("DW_TAG_subprogram")) {
-			QString name;
-			uint16_t pcLow;
-			uint16_t pcHigh;
-			DwarfLocationList *ll = 0;
-			DwarfExpression *expr = 0;
-
-			for (i++; i < lines.size(); ++i) { 
-				QString &l = lines[i];
-
-				if (l.contains("DW_AT_name")) {
-					name = l.mid(l.lastIndexOf(":") + 2).trimmed();
-				}
-				else if (l.contains("DW_AT_low_pc")) {
-					pcLow = l.mid(l.lastIndexOf(":") + 2).trimmed().toUInt(0, 16);
-				}
-				else if (l.contains("DW_AT_high_pc")) {
-					pcHigh = l.mid(l.lastIndexOf(":") + 2).trimmed().toUInt(0, 16);
-				}
-				else if (l.contains("DW_AT_frame_base")) {
-					parseLocation(l, locations, &ll, &expr);
-				}
-				else if (l.size() > 3 && l[1] == '<' && l[3] == '>') {
-					break;
-				}
-			}
-
-			i--; // Otherwise we would skip next header
 
-			if (ll || expr) {
-				currentSubprogram = new DwarfSubprogram(name, pcLow, pcHigh, ll, expr);
-				dd->addSubprogram(currentFile, currentSubprogram);
-			}
+		Abbrevs::const_iterator it = unit.abbrevs->find(code);
+		Entry entry;
+		if (it == unit.abbrevs->end() || !readEntry(info, unit, it.value(), entry)) {
+			error = QString("Invalid DWARF debugging information entry at 0x%1.").arg(offset, 0, 16);
+			return false;
 		}
-		else if (line.contains("DW_TAG_variable")) {
-			if (line[2] == '2') {
-				// Variable related to 'currentSubprogram'
-				QString name;
-				DwarfLocationList *ll = 0;
-				DwarfExpression *expr = 0;
-				VariableType *type = 0;
-
-				for (i++; i < lines.size(); ++i) { 
-					QString &l = lines[i];
-
-					if (l.contains("DW_AT_name")) {
-						name = l.mid(l.lastIndexOf(":") + 2).trimmed();
-					}
-					else if (l.contains("DW_AT_location")) {
-						parseLocation(l, locations, &ll, &expr);
-					}
-					else if (l.contains("DW_AT_type")) {
-						uint16_t addr = l.mid(l.lastIndexOf("<") + 1, l.lastIndexOf(">") - l.lastIndexOf("<") - 1).trimmed().toUInt(0, 16);
-						type = types[addr];
-						if (type == 0) {
-							qDebug() << "Unknown type" << l;
-						}
-					}
-					else if (l.size() > 3 && l[1] == '<' && l[3] == '>') {
-						break;
-					}
-				}
 
-				i--; // Otherwise we would skip next header
+		Parent parent = parents.empty() ? Parent() : parents.last();
+		int subprogram = -1;
+		if (entry.tag == DW_TAG_subprogram || entry.tag == DW_TAG_variable || entry.tag == DW_TAG_formal_parameter) {
+			// Out-of-line instances of inlined functions refer to the abstract
+			// entry for the name and type
+			m_declarations[offset] = Declaration(entry.name, entry.type, entry.origin);
+		}
 
-				if (ll || expr) {
-					DwarfVariable *v = new DwarfVariable(type, name, ll, expr);
-					currentSubprogram->addVariable(v);
+		switch (entry.tag) {
+			case DW_TAG_compile_unit:
+				currentFile = baseName(entry.name.toLatin1().constData());
+				unit.base = entry.lowPC;
+				if (entry.stmtList != -1 && m_line.data) {
+					loadLines(entry.stmtList, entry.compDir, dd);
 				}
+				break;
+			case DW_TAG_base_type:
+			case DW_TAG_subroutine_type:
+			case DW_TAG_volatile_type:
+			case DW_TAG_const_type:
+			case DW_TAG_array_type:
+			case DW_TAG_pointer_type:
+			case DW_TAG_typedef: {
+				TypeEntry &type = m_typeEntries[offset];
+				type.tag = entry.tag;
+				type.name = entry.name;
+				type.byteSize = entry.byteSize;
+				type.encoding = entry.encoding;
+				type.upperBound = -1;
+				type.type = entry.type;
+				break;
 			}
-			else {
-				// Variable related to 'currentFile'
-			}
-		}
-		else if (line.contains("DW_TAG_formal_parameter")) {
-			QString name;
-			DwarfLocationList *ll = 0;
-			DwarfExpression *expr = 0;
-			VariableType *type = 0;
-
-			for (i++; i < lines.size(); ++i) { 
-				QString &l = lines[i];
-
-				if (l.contains("DW_AT_name")) {
-					name = l.mid(l.lastIndexOf(":") + 2).trimmed();
+			case DW_TAG_subrange_type:
+				// Only the first dimension of the array is used
+				if (parent.tag == DW_TAG_array_type && m_typeEntries[parent.offset].upperBound == -1) {
+					m_typeEntries[parent.offset].upperBound = entry.upperBound;
 				}
-				else if (l.contains("DW_AT_location")) {
-					parseLocation(l, locations, &ll, &expr);
+				break;
+			case DW_TAG_subprogram: {
+				PendingSubprogram s;
+				if (!readLocation(unit, entry, &s.ll, &s.expr)) {
+					break;
 				}
-				else if (l.contains("DW_AT_type")) {
-					uint16_t addr = l.mid(l.lastIndexOf("<") + 1, l.lastIndexOf(">") - l.lastIndexOf("<") - 1).trimmed().toUInt(0, 16);
-					type = types[addr];
-					if (type == 0) {
-						qDebug() << "Unknown type" << l;
-					}
+				s.file = currentFile;
+				s.name = entry.name;
+				s.origin = entry.origin;
+				s.pcLow = entry.lowPC;
+				s.pcHigh = entry.highPCOffset ? entry.lowPC + entry.highPC : entry.highPC;
+				subprogram = m_subprograms.size();
+				m_subprograms.append(s);
+				break;
+			}
+			case DW_TAG_lexical_block:
+				// Variables of the nested blocks belong to the subprogram too
+				subprogram = parent.subprogram;
+				break;
+			case DW_TAG_variable:
+			case DW_TAG_formal_parameter: {
+				// Global variables are not handled yet
+				if (parent.subprogram == -1) {
+					break;
 				}
-				else if (l.size() > 3 && l[1] == '<' && l[3] == '>') {
+
+				PendingVariable v;
+				if (!readLocation(unit, entry, &v.ll, &v.expr)) {
 					break;
 				}
+				v.name = entry.name;
+				v.type = entry.type;
+				v.origin = entry.origin;
+				v.arg = entry.tag == DW_TAG_formal_parameter;
+				m_subprograms[parent.subprogram].variables.append(v);
+				break;
 			}
+			default:
+				break;
+		}
 
-			i--; // Otherwise we would skip next header
-
-			if (ll || expr) {
-				DwarfVariable *v = new DwarfVariable(type, name, ll, expr);
-				currentSubprogram->addArg(v);
-			}
+		if (it.value().children) {
+			parents.append(Parent(entry.tag, offset, subprogram));
 		}
 	}
 
-	return true;
+	info.setOffset(end);
+	return !info.hasError();
 }
 
-DebugData *DwarfLoader::load(QString &file, QString &error) {
-	QProcess objdump;
-	objdump.start("msp430-objdump", QStringList() << file << "--dwarf=info");
-	
-	if (!objdump.waitForStarted()) {
-		error = QString("'msp430-objdump' cannot be started. Is msp430-gcc installed and is msp430-objdump in PATH?");
-		return 0;
+void DwarfLoader::resolveOrigin(uint32_t origin, QString &name, uint32_t &type) {
+	for (int depth = 0; origin != 0 && depth < MAX_TYPE_DEPTH; ++depth) {
+		QHash<uint32_t, Declaration>::const_iterator it = m_declarations.find(origin);
+		if (it == m_declarations.end()) {
+			break;
+		}
+
+		if (name.isEmpty()) {
+			name = it.value().name;
+		}
+		if (type == 0) {
+			type = it.value().type;
+		}
+		origin = it.value().origin;
+	}
+}
+
+VariableType *DwarfLoader::getType(uint32_t offset, DwarfDebugData *dd, int depth) {
+	QHash<uint32_t, VariableType *>::const_iterator it = m_types.find(offset);
+	if (it != m_types.end()) {
+		return it.value();
 	}
 
-	if (!objdump.waitForFinished()) {
-		error = QString("'msp430-objdump' did not finish properly.");
+	QHash<uint32_t, TypeEntry>::const_iterator e = m_typeEntries.find(offset);
+	if (e == m_typeEntries.end() || depth > MAX_TYPE_DEPTH) {
 		return 0;
 	}
 
-	DwarfDebugData *dd = new DwarfDebugData();
+	const TypeEntry &entry = e.value();
+	VariableType *type = 0;
+	switch (entry.tag) {
+		case DW_TAG_base_type:
+			if (entry.byteSize != 0) {
+				type = new VariableType(entry.name, entry.byteSize, (VariableType::Encoding) entry.encoding, VariableType::Base);
+			}
+			break;
+		case DW_TAG_subroutine_type:
+			type = new VariableType("", 0, VariableType::Address, VariableType::Subroutine);
+			break;
+		case DW_TAG_typedef:
+			// Typedef is the same type under other name
+			type = getType(entry.type, dd, depth + 1);
+			m_types[offset] = type;
+			return type;
+		default: {
+			VariableType::Type t = VariableType::Pointer;
+			if (entry.tag == DW_TAG_volatile_type) t = VariableType::Volatile;
+			else if (entry.tag == DW_TAG_const_type) t = VariableType::Const;
+			else if (entry.tag == DW_TAG_array_type) t = VariableType::Array;
+
+			VariableType *subtype = entry.type ? getType(entry.type, dd, depth + 1) : 0;
+			uint16_t upperBound = entry.upperBound == -1 ? 0 : entry.upperBound;
+			type = new VariableType("", entry.byteSize, VariableType::Address, t, upperBound, subtype);
+			break;
+		}
+	}
 
-	QString result = QString(objdump.readAll());
+	if (type) {
+		dd->addVariableType(type);
+	}
+	m_types[offset] = type;
+	return type;
+}
 
-	QMap<uint16_t, VariableType *> types;
-	if (!loadVariableTypes(result, dd, types, error)) {
-		delete dd;
+DwarfDebugData *DwarfLoader::load(const QByteArray &elf, QString &error) {
+	clear();
+	m_warnings.clear();
+	m_loadedUnits = 0;
+	if (!loadSections(elf, error)) {
 		return 0;
 	}
 
-	QMap<uint16_t, DwarfLocationList *> locations;
-	loadLocations(file, locations, error);
+	DwarfDebugData *dd = new DwarfDebugData();
+	DwarfReader info(m_info.data, m_info.size);
+	while (!info.atEnd()) {
+		if (!loadUnit(info, dd, error)) {
+			clear();
+			delete dd;
+			return 0;
+		}
+	}
 
-	if (!loadSubprograms(result, dd, locations, types, error)) {
+	if (m_loadedUnits == 0 && !m_warnings.empty()) {
+		error = m_warnings.first();
+		clear();
 		delete dd;
-		dd = 0;
+		return 0;
 	}
 
-	QMap<uint16_t, DwarfLocationList *>::iterator i = locations.begin();
-	while (i != locations.end()) {
-		delete i.value();
-		++i;
-	}
+	// All the types are known now, so the variables can be created
+	foreach(const PendingSubprogram &s, m_subprograms) {
+		QString name = s.name;
+		uint32_t typeOffset = 0;
+		resolveOrigin(s.origin, name, typeOffset);
+
+		DwarfSubprogram *subprogram = new DwarfSubprogram(name, s.pcLow, s.pcHigh, s.ll, s.expr);
+		foreach(const PendingVariable &v, s.variables) {
+			name = v.name;
+			typeOffset = v.type;
+			resolveOrigin(v.origin, name, typeOffset);
+
+			VariableType *type = getType(typeOffset, dd);
+			if (type == 0) {
+				qDebug() << "Unknown type of" << name;
+			}
 
+			DwarfVariable *variable = new DwarfVariable(type, name, v.ll, v.expr);
+			if (v.arg) {
+				subprogram->addArg(variable);
+			}
+			else {
+				subprogram->addVariable(variable);
+			}
+		}
+		dd->addSubprogram(s.file, subprogram);
+	}
 
+	// Ownership of the locations has been passed to the subprograms
+	m_subprograms.clear();
+	clear();
 	return dd;
 }
@@ -17,35 +17,187 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
  **/
 
+
 #pragma once
 
 #include <QByteArray>
 #include <QString>
+#include <QStringList>
 #include <QMap>
+#include <QHash>
 #include <QList>
 #include <stdint.h>
 
+#include "DwarfReader.h"
+
 class DwarfDebugData;
 class DebugData;
 class DwarfLocation;
 class DwarfLocationList;
 class DwarfExpression;
 class VariableType;
+class ElfFile;
 
+/// Loads the debug data directly from the .debug_info, .debug_abbrev,
+/// .debug_loc and .debug_line sections of the ELF file. DWARF versions 2 to
+/// 4 with 32-bit offsets are supported. Compile units of other versions are
+/// skipped with a warning.
 class DwarfLoader {
 	public:
-		DwarfLoader(const QString &objdump);
+		DwarfLoader();
 		virtual ~DwarfLoader();
 
-		DebugData *load(QString &file, QString &error);
+		DwarfDebugData *load(const QByteArray &elf, QString &error);
+
+		/// Returns the warnings about the data skipped by the last load().
+		const QStringList &getWarnings() const {
+			return m_warnings;
+		}
 
 	private:
-		bool loadVariableTypes(const QString &out, DwarfDebugData *dd, QMap<uint16_t, VariableType *> &types, QString &error);
-		bool loadSubprograms(const QString &out, DwarfDebugData *dd, QMap<uint16_t, DwarfLocationList *> &locations, QMap<uint16_t, VariableType *> &types, QString &error);
-		bool loadLocations(QString &file, QMap<uint16_t, DwarfLocationList *> &locations, QString &error);
-		void parseLocation(const QString &line, QMap<uint16_t, DwarfLocationList *> &locations, DwarfLocationList **ll, DwarfExpression **expr);
+		class Section {
+			public:
+				Section() : data(0), size(0) {}
+
+				const uint8_t *data;
+				uint32_t size;
+		};
+
+		class Attribute {
+			public:
+				Attribute(uint16_t name = 0, uint16_t form = 0) : name(name), form(form) {}
+
+				uint16_t name;
+				uint16_t form;
+		};
+
+		class Abbrev {
+			public:
+				Abbrev() : tag(0), children(false) {}
+
+				uint16_t tag;
+				bool children;
+				QList<Attribute> attributes;
+		};
+
+		typedef QHash<uint64_t, Abbrev> Abbrevs;
+
+		class Unit {
+			public:
+				uint32_t offset;
+				uint16_t version;
+				uint8_t addressSize;
+				uint64_t base;
+				const Abbrevs *abbrevs;
+		};
+
+		/// Attributes of the debugging information entry used by QSimKit.
+		class Entry {
+			public:
+				Entry() : tag(0), lowPC(0), highPC(0), highPCOffset(false),
+					byteSize(0), encoding(0), upperBound(-1), type(0),
+					origin(0), expr(0), exprSize(0), locList(-1), stmtList(-1) {}
+
+				uint16_t tag;
+				QString name;
+				QString compDir;
+				uint64_t lowPC;
+				uint64_t highPC;
+				bool highPCOffset;
+				uint64_t byteSize;
+				uint8_t encoding;
+				int64_t upperBound;
+				uint32_t type;
+				// DW_AT_abstract_origin or DW_AT_specification
+				uint32_t origin;
+				// DW_AT_location or DW_AT_frame_base
+				const uint8_t *expr;
+				uint32_t exprSize;
+				int64_t locList;
+				int64_t stmtList;
+		};
+
+		/// Entry owning the entries being read, subprogram is the index in
+		/// m_subprograms or -1.
+		class Parent {
+			public:
+				Parent(uint16_t tag = 0, uint32_t offset = 0, int subprogram = -1) :
+					tag(tag), offset(offset), subprogram(subprogram) {}
+
+				uint16_t tag;
+				uint32_t offset;
+				int subprogram;
+		};
+
+		/// Type entry, VariableTypes are created once all of them are known.
+		class TypeEntry {
+			public:
+				uint16_t tag;
+				QString name;
+				uint8_t byteSize;
+				uint8_t encoding;
+				int64_t upperBound;
+				uint32_t type;
+		};
+
+		/// Name and type of the subprogram or variable which can be referred
+		/// by other entries.
+		class Declaration {
+			public:
+				Declaration(const QString &name = QString(), uint32_t type = 0, uint32_t origin = 0) :
+					name(name), type(type), origin(origin) {}
+
+				QString name;
+				uint32_t type;
+				uint32_t origin;
+		};
+
+		class PendingVariable {
+			public:
+				QString name;
+				uint32_t type;
+				uint32_t origin;
+				DwarfLocationList *ll;
+				DwarfExpression *expr;
+				bool arg;
+		};
+
+		class PendingSubprogram {
+			public:
+				QString file;
+				QString name;
+				uint16_t pcLow;
+				uint16_t pcHigh;
+				uint32_t origin;
+				DwarfLocationList *ll;
+				DwarfExpression *expr;
+				QList<PendingVariable> variables;
+		};
+
+		bool loadSections(const QByteArray &elf, QString &error);
+		Section getSection(const ElfFile &file, const char *name);
+		const Abbrevs *loadAbbrevs(uint32_t offset);
+		bool loadUnit(DwarfReader &info, DwarfDebugData *dd, QString &error);
+		bool readEntry(DwarfReader &info, const Unit &unit, const Abbrev &abbrev, Entry &entry);
+		uint32_t getReference(const Unit &unit, uint16_t form, uint64_t value);
+		bool readLocation(const Unit &unit, const Entry &entry, DwarfLocationList **ll, DwarfExpression **expr);
+		DwarfLocationList *loadLocationList(uint32_t offset, const Unit &unit);
+		void loadLines(uint32_t offset, const QString &compDir, DwarfDebugData *dd);
+		void resolveOrigin(uint32_t origin, QString &name, uint32_t &type);
+		VariableType *getType(uint32_t offset, DwarfDebugData *dd, int depth = 0);
+		void clear();
 
 	private:
-		QString m_objdump;
+		Section m_info;
+		Section m_abbrev;
+		Section m_loc;
+		Section m_line;
+		Section m_str;
+		QHash<uint32_t, Abbrevs> m_abbrevs;
+		QHash<uint32_t, TypeEntry> m_typeEntries;
+		QHash<uint32_t, Declaration> m_declarations;
+		QHash<uint32_t, VariableType *> m_types;
+		QList<PendingSubprogram> m_subprograms;
+		QStringList m_warnings;
+		int m_loadedUnits;
 };
-
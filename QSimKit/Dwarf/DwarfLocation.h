@@ -37,6 +37,14 @@ class DwarfLocation {
 
 		bool contains(uint16_t pc);
 
+		uint16_t getPCLow() const {
+			return m_pcLow;
+		}
+
+		uint16_t getPCHigh() const {
+			return m_pcHigh;
+		}
+
 	private:
 		DwarfExpression *m_expr;
 		uint16_t m_pcLow;
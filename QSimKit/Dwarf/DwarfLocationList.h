@@ -40,6 +40,10 @@ class DwarfLocationList {
 			m_locations.append(l);
 		}
 
+		const QList<DwarfLocation *> &getLocations() const {
+			return m_locations;
+		}
+
 		VariableValue getValue(RegisterSet *r, Memory *m, DwarfSubprogram *p, uint16_t pc, bool &isAddress);
 
 	private:
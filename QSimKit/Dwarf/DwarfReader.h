@@ -0,0 +1,123 @@
+/**
+ * QSimKit - MSP430 simulator
+ * Copyright (C) 2013 Jan "HanzZ" Kaluza (hanzz.k@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+/// Reads little-endian values and LEB128 numbers from a DWARF section.
+/// Reading past the end of the data does not read anything, returns 0 and
+/// sets the error flag.
+class DwarfReader {
+	public:
+		DwarfReader(const uint8_t *data = 0, uint32_t size = 0, uint32_t offset = 0) :
+			m_data(data), m_size(size), m_offset(offset), m_error(offset > size) {}
+
+		uint32_t getOffset() const { return m_offset; }
+
+		void setOffset(uint32_t offset) {
+			m_offset = offset;
+			m_error |= offset > m_size;
+		}
+
+		bool atEnd() const { return m_offset >= m_size; }
+
+		bool hasError() const { return m_error; }
+
+		/// Returns pointer to the current position and skips size bytes.
+		const uint8_t *block(uint32_t size) {
+			if (m_error || size > m_size - m_offset) {
+				m_error = true;
+				return 0;
+			}
+			const uint8_t *ret = m_data + m_offset;
+			m_offset += size;
+			return ret;
+		}
+
+		uint64_t readUnsigned(int size) {
+			const uint8_t *p = block(size);
+			uint64_t value = 0;
+			for (int i = size - 1; p && i >= 0; --i) {
+				value = value << 8 | p[i];
+			}
+			return value;
+		}
+
+		uint8_t u8() { return readUnsigned(1); }
+		uint16_t u16() { return readUnsigned(2); }
+		uint32_t u32() { return readUnsigned(4); }
+		uint64_t u64() { return readUnsigned(8); }
+
+		uint64_t uleb128() {
+			uint64_t value = 0;
+			int shift = 0;
+			uint8_t byte;
+			do {
+				byte = u8();
+				if (shift < 64) {
+					value |= (uint64_t) (byte & 0x7f) << shift;
+				}
+				shift += 7;
+			} while ((byte & 0x80) && !m_error);
+			return value;
+		}
+
+		int64_t sleb128() {
+			int64_t value = 0;
+			int shift = 0;
+			uint8_t byte;
+			do {
+				byte = u8();
+				if (shift < 64) {
+					value |= (int64_t) (byte & 0x7f) << shift;
+				}
+				shift += 7;
+			} while ((byte & 0x80) && !m_error);
+
+			if (shift < 64 && (byte & 0x40)) {
+				value |= -((int64_t) 1 << shift);
+			}
+			return value;
+		}
+
+		/// Returns the null-terminated string at the current position.
+		const char *cstr() {
+			if (m_error || m_offset >= m_size) {
+				m_error = true;
+				return "";
+			}
+			const char *str = (const char *) m_data + m_offset;
+			const void *end = memchr(str, 0, m_size - m_offset);
+			if (!end) {
+				m_error = true;
+				return "";
+			}
+			m_offset = (const char *) end - (const char *) m_data + 1;
+			return str;
+		}
+
+	private:
+		const uint8_t *m_data;
+		uint32_t m_size;
+		uint32_t m_offset;
+		bool m_error;
+};
@@ -34,13 +34,10 @@ DwarfSubprogram::~DwarfSubprogram() {
 	delete m_ll;
 	delete m_expr;
 
+	// Arguments are in the list of variables too
 	foreach(Variable *v, m_vars) {
 		delete v;
 	}
-
-	foreach(Variable *v, m_args) {
-		delete v;
-	}
 }
 
 void DwarfSubprogram::addVariable(DwarfVariable *v) {
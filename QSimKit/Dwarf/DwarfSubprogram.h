@@ -49,6 +49,14 @@ class DwarfSubprogram : public Subprogram {
 
 		uint16_t getFrameBase(RegisterSet *r, Memory *m, uint16_t pc);
 
+		DwarfLocationList *getLocationList() {
+			return m_ll;
+		}
+
+		DwarfExpression *getExpression() {
+			return m_expr;
+		}
+
 	private:
 		Variables m_vars;
 		Variables m_args;
@@ -42,6 +42,14 @@ class DwarfVariable : public Variable {
 
 		QString getValue(RegisterSet *r, Memory *m, Subprogram *p, uint16_t pc);
 
+		DwarfLocationList *getLocationList() {
+			return m_ll;
+		}
+
+		DwarfExpression *getExpression() {
+			return m_expr;
+		}
+
 	private:
 		DwarfLocationList *m_ll;
 		DwarfExpression *m_expr;
@@ -0,0 +1,147 @@
+/**
+ * QSimKit - MSP430 simulator
+ * Copyright (C) 2013 Jan "HanzZ" Kaluza (hanzz.k@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#include "ElfFile.h"
+#include "DwarfReader.h"
+
+#include <string.h>
+
+// Section types
+#define SHT_SYMTAB 2
+
+ElfFile::ElfFile() : m_elf64(false) {
+	
+}
+
+bool ElfFile::load(const QByteArray &elf, QString &error) {
+	m_sections.clear();
+	m_symbols.clear();
+
+	DwarfReader r((const uint8_t *) elf.constData(), elf.size());
+	const uint8_t *ident = r.block(16);
+	if (!ident || memcmp(ident, "\x7f" "ELF", 4) != 0 || ident[5] != 1) {
+		error = QString("File is not a little endian ELF file.");
+		return false;
+	}
+
+	// Only the section headers are needed, so 64-bit ELF is read too
+	m_elf64 = ident[4] == 2;
+	r.setOffset(m_elf64 ? 0x28 : 0x20);
+	uint64_t shoff = m_elf64 ? r.u64() : r.u32();
+	r.setOffset(m_elf64 ? 0x3a : 0x2e);
+	uint16_t shentsize = r.u16();
+	uint16_t shnum = r.u16();
+	uint16_t shstrndx = r.u16();
+	if (r.hasError() || shstrndx >= shnum || shoff > (uint64_t) elf.size()) {
+		error = QString("ELF file does not have valid section headers.");
+		return false;
+	}
+
+	QList<uint32_t> names;
+	QList<uint32_t> types;
+	QList<uint32_t> links;
+	for (int i = 0; i < shnum; ++i) {
+		r.setOffset(shoff + i * shentsize);
+		names.append(r.u32());
+		types.append(r.u32());
+		Section s;
+		uint64_t offset;
+		uint64_t size;
+		if (m_elf64) {
+			s.flags = r.u64();
+			s.address = r.u64();
+			offset = r.u64();
+			size = r.u64();
+		}
+		else {
+			s.flags = r.u32();
+			s.address = r.u32();
+			offset = r.u32();
+			size = r.u32();
+		}
+		links.append(r.u32());
+
+		if (offset <= (uint64_t) elf.size() && size <= elf.size() - offset) {
+			s.data = (const uint8_t *) elf.constData() + offset;
+			s.size = size;
+		}
+		m_sections.append(s);
+	}
+
+	if (r.hasError()) {
+		m_sections.clear();
+		error = QString("ELF file does not have valid section headers.");
+		return false;
+	}
+
+	const Section &strtab = m_sections[shstrndx];
+	for (int i = 0; i < shnum; ++i) {
+		DwarfReader name(strtab.data, strtab.size, names[i]);
+		m_sections[i].name = QString::fromLatin1(name.cstr());
+	}
+
+	for (int i = 0; i < shnum; ++i) {
+		if (types[i] == SHT_SYMTAB && links[i] < shnum) {
+			loadSymbols(m_sections[i], m_sections[links[i]]);
+		}
+	}
+
+	return true;
+}
+
+void ElfFile::loadSymbols(const Section &symtab, const Section &strtab) {
+	DwarfReader r(symtab.data, symtab.size);
+	while (!r.atEnd()) {
+		Symbol s;
+		uint32_t name = r.u32();
+		uint8_t info;
+		if (m_elf64) {
+			info = r.u8();
+			r.u8(); // other
+			s.section = r.u16();
+			s.value = r.u64();
+			r.u64(); // size
+		}
+		else {
+			s.value = r.u32();
+			r.u32(); // size
+			info = r.u8();
+			r.u8(); // other
+			s.section = r.u16();
+		}
+
+		if (r.hasError()) {
+			break;
+		}
+
+		DwarfReader str(strtab.data, strtab.size, name);
+		s.name = QString::fromLatin1(str.cstr());
+		s.type = info & 0xf;
+		m_symbols.append(s);
+	}
+}
+
+const ElfFile::Section *ElfFile::getSection(const QString &name) const {
+	for (int i = 0; i < m_sections.size(); ++i) {
+		if (m_sections[i].name == name) {
+			return &m_sections[i];
+		}
+	}
+	return 0;
+}
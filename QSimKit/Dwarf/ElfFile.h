@@ -0,0 +1,85 @@
+/**
+ * QSimKit - MSP430 simulator
+ * Copyright (C) 2013 Jan "HanzZ" Kaluza (hanzz.k@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QList>
+#include <stdint.h>
+
+/// Reads the section headers and the symbol table of the little-endian ELF
+/// file. Both 32-bit and 64-bit files are accepted. Section data point to
+/// the QByteArray passed to load(), which has to outlive the ElfFile.
+class ElfFile {
+	public:
+		typedef enum {
+			SectionWrite = 0x1,
+			SectionAlloc = 0x2,
+			SectionExec = 0x4,
+		} SectionFlag;
+
+		typedef enum {
+			SymbolNone = 0,
+			SymbolObject = 1,
+			SymbolFunction = 2,
+		} SymbolType;
+
+		class Section {
+			public:
+				Section() : address(0), flags(0), data(0), size(0) {}
+
+				QString name;
+				uint32_t address;
+				uint32_t flags;
+				const uint8_t *data;
+				uint32_t size;
+		};
+
+		class Symbol {
+			public:
+				QString name;
+				uint32_t value;
+				uint8_t type;
+				uint16_t section;
+		};
+
+		ElfFile();
+
+		bool load(const QByteArray &elf, QString &error);
+
+		/// Returns the section with given name or 0.
+		const Section *getSection(const QString &name) const;
+
+		const QList<Section> &getSections() const {
+			return m_sections;
+		}
+
+		const QList<Symbol> &getSymbols() const {
+			return m_symbols;
+		}
+
+	private:
+		void loadSymbols(const Section &symtab, const Section &strtab);
+
+	private:
+		bool m_elf64;
+		QList<Section> m_sections;
+		QList<Symbol> m_symbols;
+};
@@ -31,6 +31,7 @@
 #include "ui/ScreenObject.h"
 #include "Peripherals/Peripheral.h"
 #include "Peripherals/SimulationObject.h"
+#include "MCU/Profile.h"
 
 class Memory;
 class RegisterSet;
@@ -155,6 +156,8 @@ class Variable {
 		Variable(const QString &name, VariableType *type) :
 			m_name(name), m_type(type) { }
 
+		virtual ~Variable() {}
+
 		VariableType *getType() { return m_type; }
 
 		const QString &getName() {
@@ -175,6 +178,8 @@ class Subprogram {
 		Subprogram(const QString &name, uint16_t pcLow, uint16_t pcHigh) :
 			m_name(name), m_pcLow(pcLow), m_pcHigh(pcHigh) {}
 
+		virtual ~Subprogram() {}
+
 		uint16_t getPCLow() const {
 			return m_pcLow;
 		}
@@ -213,6 +218,11 @@ class DebugData {
 		virtual Subprogram *getSubprogram(const QString &file, uint16_t pc) = 0;
 
 		virtual Subprogram *getSubprogram(uint16_t pc) = 0;
+
+		/// Returns the source line of the code at the address pc and sets
+		/// file to the path of its source file. Returns 0 if the line is
+		/// not known.
+		virtual int getLine(uint16_t pc, QString &file) = 0;
 };
 
 class MCU : public Peripheral {
@@ -229,12 +239,45 @@ class MCU : public Peripheral {
 
 		virtual Memory *getMemory() = 0;
 
-		virtual DisassembledFiles getDisassembledCode() = 0;
+		/// Returns the instructions of the loaded code split by the source
+		/// files using the line table from dd, which can be 0. The text of
+		/// the instructions can be empty; disassemble() is used for it then.
+		virtual DisassembledFiles getDisassembledCode(DebugData *dd) = 0;
+
+		/// Returns the assembler text of the instruction at addr.
+		virtual QString disassemble(uint16_t addr) = 0;
 
 		virtual DebugData *getDebugData() = 0;
 
 		virtual QString getFeatures() = 0;
 
+		/// Called with true before the UI steps the MCU instruction by
+		/// instruction and with false once it is done.
+		virtual void setSingleStepping(bool singleStepping) {}
+
+		/// Sets the maximum number of clock ticks the MCU executes ahead of
+		/// the rest of the simulation before synchronizing with it.
+		virtual void setQuantum(int cycles) {}
+
+		/// Returns human readable statistics of the simulation internals,
+		/// one item per line.
+		virtual QStringList getStatistics() {
+			return QStringList();
+		}
+
+		/// Starts counting the cycles spent in the firmware functions. The
+		/// previously collected data are dropped.
+		virtual void setProfiling(bool enabled) {}
+
+		virtual bool isProfiling() {
+			return false;
+		}
+
+		/// Returns the collected profile. Functions are named using the
+		/// debug data, which can be 0.
+		virtual Profile getProfile(DebugData *dd) {
+			return Profile();
+		}
 
 	signals:
 		void onCodeLoaded();
@@ -30,7 +30,7 @@ namespace MSP430 {
 
 ACLK::ACLK(Memory *mem, Variant *variant, VLO *vlo, LFXT1 *lfxt1) :
 m_mem(mem), m_variant(variant), m_source(0), m_vlo(vlo),
-m_lfxt1(lfxt1), m_divider(1), m_counter(0), m_rising(false) {
+m_lfxt1(lfxt1), m_divider(1), m_running(false) {
 
 #define ADD_WATCHER(METHOD) \
 	if (METHOD != 0) { m_mem->addWatcher(METHOD, this); }
@@ -53,6 +53,22 @@ unsigned long ACLK::getFrequency() {
 	return m_source->getFrequency() / m_divider;
 }
 
+SimulationTime ACLK::getStep() {
+	if (!m_source) {
+		return 0;
+	}
+
+	return m_source->getStep() * m_divider;
+}
+
+SimulationTime ACLK::getNextRisingEdge() {
+	if (!m_source) {
+		return SIMULATION_TIME_MAX;
+	}
+
+	return m_source->getNextRisingEdge(this, m_divider);
+}
+
 std::string ACLK::getSourceName() {
 	if (!m_source) {
 		return "None";
@@ -62,42 +78,62 @@ std::string ACLK::getSourceName() {
 }
 
 void ACLK::tickRising() {
-	if (++m_counter >= (m_divider >> 1)) {
-		m_counter = 0;
-
-		m_rising = !m_rising;
-		if (m_rising) {
-			callRisingHandlers();
-		}
-		else {
-			callFallingHandlers();
-		}
-	}
+	callRisingHandlers();
 }
 
 void ACLK::tickFalling() {
-	// Ignore falling tick if divider is one, because falling tick is generated
-	// on second rising tick in this case.
-	if (m_divider != 1) {
+	callFallingHandlers();
+}
+
+void ACLK::start() {
+	if (m_running) {
 		return;
 	}
 
-	tickRising();
+	if (m_source) {
+		m_source->addHandler(this, m_divider);
+		m_running = true;
+	}
+}
+
+void ACLK::pause() {
+	m_running = false;
+
+	if (m_source) {
+		m_source->removeHandler(this);
+	}
 }
 
 void ACLK::reset() {
 	handleMemoryChanged(m_mem, m_variant->getBCSCTL1());
 	handleMemoryChanged(m_mem, m_variant->getBCSCTL3());
+	setSource(m_vlo);
+	clockChanged();
+}
+
+void ACLK::handleFrequencyChanged(Oscillator *oscillator) {
+	clockChanged();
+}
+
+void ACLK::setSource(Oscillator *source) {
+	if (m_source == source) {
+		return;
+	}
+
 	if (m_source) {
 		m_source->removeHandler(this);
+		m_source->removeWatcher(this);
 	}
-	m_source = m_vlo;
-	m_source->addHandler(this);
-}
 
+	m_source = source;
+	m_source->addWatcher(this);
+	if (m_running) {
+		m_source->addHandler(this, m_divider);
+	}
+}
 
 void ACLK::handleMemoryChanged(::Memory *memory, uint16_t address) {
-	uint16_t value = m_mem->getBigEndian(address);
+	uint16_t value = m_mem->getWord(address);
 	if (address == m_variant->getBCSCTL1()) {
 		// Set divider according DIVAx bits
 		switch((value >> 4) & 3) {
@@ -108,22 +144,22 @@ void ACLK::handleMemoryChanged(::Memory *memory, uint16_t address) {
 			default: break;
 		}
 
-		m_counter = m_divider;
+		// Restart the divider with the new value
+		if (m_running && m_source) {
+			m_source->addHandler(this, m_divider);
+		}
 	}
 	else if (address == m_variant->getBCSCTL3()) {
-		if (m_source) {
-			m_source->removeHandler(this);
-		}
-
 		// Choose between VLO and LFXT1
 		if (m_lfxt1->isChosen()) {
-			m_source = m_lfxt1;
+			setSource(m_lfxt1);
 		}
 		else {
-			m_source = m_vlo;
+			setSource(m_vlo);
 		}
-		m_source->addHandler(this);
 	}
+
+	clockChanged();
 }
 
 }
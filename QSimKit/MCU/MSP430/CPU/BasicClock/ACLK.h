@@ -35,15 +35,19 @@ class VLO;
 class LFXT1;
 class Oscillator;
 
-class ACLK : public Clock, public OscillatorHandler, public MemoryWatcher {
+class ACLK : public Clock, public OscillatorHandler, public OscillatorWatcher, public MemoryWatcher {
 	public:
 		ACLK(Memory *mem, Variant *variant, VLO *vlo, LFXT1 *lfxt1);
 		virtual ~ACLK();
 
 		void handleMemoryChanged(::Memory *memory, uint16_t address);
 
+		void handleFrequencyChanged(Oscillator *oscillator);
+
 		unsigned long getFrequency();
 
+		SimulationTime getStep();
+
 		std::string getSourceName();
 
 		void reset();
@@ -51,15 +55,21 @@ class ACLK : public Clock, public OscillatorHandler, public MemoryWatcher {
 		void tickRising();
 		void tickFalling();
 
+		void start();
+		void pause();
+
 	private:
+		SimulationTime getNextRisingEdge();
+
+		void setSource(Oscillator *source);
+
 		Memory *m_mem;
 		Variant *m_variant;
 		Oscillator *m_source;
 		VLO *m_vlo;
 		LFXT1 *m_lfxt1;
 		uint8_t m_divider;
-		uint8_t m_counter;
-		bool m_rising;
+		bool m_running;
 };
 
 }
@@ -21,6 +21,7 @@
 #include "CPU/Variants/Variant.h"
 #include "CPU/Memory/Memory.h"
 #include "CPU/Interrupts/InterruptManager.h"
+#include "CPU/Memory/RegisterFile.h"
 #include <iostream>
 
 #include "VLO.h"
@@ -31,6 +32,7 @@
 #include "DCO.h"
 #include "MCLK.h"
 #include "TimerFactory.h"
+#include "Scheduler.h"
 #include "Timer.h"
 #include "ClockPinHandler.h"
 
@@ -52,6 +54,11 @@ m_pinManager(pinManager) {
 	m_smclk = new SMCLK(m_mem, m_variant, m_dco, m_xt2);
 	m_mclk = new MCLK(m_mem, m_variant, m_dco, m_vlo, m_lfxt1, m_xt2);
 
+	m_scheduler = m_factory->createScheduler(m_dco);
+	m_aclk->setScheduler(m_scheduler);
+	m_smclk->setScheduler(m_scheduler);
+	m_mclk->setScheduler(m_scheduler);
+
 	m_aclkHandler = new ClockPinHandler(m_pinManager, m_aclk, "ACLK");
 	m_smclkHandler = new ClockPinHandler(m_pinManager, m_smclk, "SMCLK");
 	m_mclkHandler = new ClockPinHandler(m_pinManager, m_mclk, "MCLK");
@@ -67,7 +74,7 @@ m_pinManager(pinManager) {
 		intvec1 = m_variant->getTIMER0_A1_VECTOR();
 	}
 
-	m_timerA0 = new Timer(Timer::TimerA, m_pinManager, m_intManager, m_mem, m_variant, m_aclk, m_smclk,
+	m_timerA0 = new Timer(Timer::TimerA, m_pinManager, m_intManager, m_mem, m_variant, m_aclk, m_smclk, m_scheduler,
 									  m_variant->getTA0CTL(), m_variant->getTA0R(),
 									  m_variant->getTA0IV(), intvec0, intvec1);
 	if (m_variant->getTA0CCTL0() != 0) {
@@ -90,7 +97,7 @@ m_pinManager(pinManager) {
 	intvec0 = m_variant->getTIMER1_A0_VECTOR();
 	intvec1 = m_variant->getTIMER1_A1_VECTOR();
 	if (intvec0 != 0 && intvec1 != 0) {
-		m_timerA1 = new Timer(Timer::TimerA, m_pinManager, m_intManager, m_mem, m_variant, m_aclk, m_smclk,
+		m_timerA1 = new Timer(Timer::TimerA, m_pinManager, m_intManager, m_mem, m_variant, m_aclk, m_smclk, m_scheduler,
 										m_variant->getTA1CTL(), m_variant->getTA1R(),
 										m_variant->getTA1IV(), intvec0, intvec1);
 		if (m_variant->getTA0CCTL0() != 0) {
@@ -117,7 +124,7 @@ m_pinManager(pinManager) {
 	intvec0 = m_variant->getTIMERB0_VECTOR();
 	intvec1 = m_variant->getTIMERB1_VECTOR();
 	if (intvec0 != 0 && intvec1 != 0) {
-		m_timerB = new Timer(Timer::TimerB, m_pinManager, m_intManager, m_mem, m_variant, m_aclk, m_smclk,
+		m_timerB = new Timer(Timer::TimerB, m_pinManager, m_intManager, m_mem, m_variant, m_aclk, m_smclk, m_scheduler,
 										m_variant->getTBCTL(), m_variant->getTBR(),
 										m_variant->getTBIV(), intvec0, intvec1);
 		if (m_variant->getTBCCTL0() != 0) {
@@ -160,11 +167,30 @@ BasicClock::~BasicClock() {
 	delete m_smclkHandler;
 	delete m_aclkHandler;
 	delete m_mclkHandler;
+	delete m_scheduler;
 }
 
 void BasicClock::reset() {
+	setLowPowerMode(0);
 	m_dco->reset();
 	m_mclk->reset();
+	m_timerA0->reset();
+	if (m_timerA1) {
+		m_timerA1->reset();
+	}
+	if (m_timerB) {
+		m_timerB->reset();
+	}
+}
+
+void BasicClock::setLowPowerMode(uint16_t sr) {
+	// Paused clock removes itself from its oscillator, so the oscillator
+	// stops generating events once nothing uses it. SCG0 turns the DCO off
+	// only when it does not source MCLK or SMCLK, which is exactly when
+	// the DCO has no handlers, so it does not need special handling here.
+	m_mclk->setEnabled(!(sr & SR_CPU_OFF));
+	m_smclk->setEnabled(!(sr & SR_SCG1));
+	m_aclk->setEnabled(!(sr & SR_OSC_OFF));
 }
 
 }
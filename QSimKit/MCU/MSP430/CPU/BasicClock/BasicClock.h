@@ -41,6 +41,7 @@ class LFXT1;
 class XT2;
 class Timer;
 class TimerFactory;
+class Scheduler;
 class PinManager;
 class ClockPinHandler;
 
@@ -53,6 +54,10 @@ class BasicClock {
 
 		void reset();
 
+		/// Enables or disables the clocks according to the CPUOFF, SCG0,
+		/// SCG1 and OSCOFF bits of the status register.
+		void setLowPowerMode(uint16_t sr);
+
 		DCO *getDCO() {
 			return m_dco;
 		}
@@ -93,6 +98,10 @@ class BasicClock {
 			return m_smclk;
 		}
 
+		Scheduler *getScheduler() {
+			return m_scheduler;
+		}
+
 	private:
 		Memory *m_mem;
 		Variant *m_variant;
@@ -108,6 +117,7 @@ class BasicClock {
 		Timer *m_timerB;
 		InterruptManager *m_intManager;
 		TimerFactory *m_factory;
+		Scheduler *m_scheduler;
 		PinManager *m_pinManager;
 		ClockPinHandler *m_smclkHandler;
 		ClockPinHandler *m_mclkHandler;
@@ -18,12 +18,14 @@
  **/
 
 #include "Clock.h"
+#include "Scheduler.h"
 #include <iostream>
 #include <algorithm>
 
 namespace MSP430 {
 	
-Clock::Clock() {
+Clock::Clock() : m_enabled(true), m_scheduler(0), m_originTime(0),
+m_originCycle(0), m_period(0) {
 }
 
 Clock::~Clock() {
@@ -31,9 +33,13 @@ Clock::~Clock() {
 }
 
 void Clock::addHandler(ClockHandler *handler, Mode mode) {
-	// Start the clock with first handler added
-	if (m_handlers.empty() && m_fallingHandlers.empty()) {
+	// Start the clock with first handler added. The divider of the source
+	// starts with it, so the edges are counted from its phase.
+	if (m_handlers.empty() && m_fallingHandlers.empty() && m_enabled) {
 		start();
+		if (isAnalytic()) {
+			clockChanged();
+		}
 	}
 
 	switch (mode) {
@@ -62,11 +68,89 @@ void Clock::removeHandler(ClockHandler *handler) {
 	}
 
 	// pause clock when it's not used
-	if (m_handlers.empty() || m_fallingHandlers.empty()) {
+	if (!hasHandlers()) {
 		pause();
 	}
 }
 
+void Clock::setEnabled(bool enabled) {
+	if (m_enabled == enabled) {
+		return;
+	}
+
+	m_enabled = enabled;
+	clockChanged();
+
+	if (!hasHandlers()) {
+		return;
+	}
+
+	if (m_enabled) {
+		start();
+	}
+	else {
+		pause();
+	}
+}
+
+void Clock::setScheduler(Scheduler *scheduler) {
+	m_scheduler = scheduler;
+	clockChanged();
+}
+
+uint64_t Clock::getCycle(SimulationTime t) {
+	if (m_period == 0 || t <= m_originTime) {
+		return m_originCycle;
+	}
+
+	return m_originCycle + (t - m_originTime) / m_period;
+}
+
+SimulationTime Clock::getCycleTime(uint64_t cycle) {
+	if (cycle <= m_originCycle) {
+		return m_originTime;
+	}
+
+	if (m_period == 0) {
+		return SIMULATION_TIME_MAX;
+	}
+
+	return m_originTime + (cycle - m_originCycle) * m_period;
+}
+
+void Clock::addWatcher(ClockWatcher *watcher) {
+	m_watchers.push_back(watcher);
+}
+
+void Clock::removeWatcher(ClockWatcher *watcher) {
+	std::vector<ClockWatcher *>::iterator it = std::find(m_watchers.begin(), m_watchers.end(), watcher);
+	if (it != m_watchers.end()) {
+		m_watchers.erase(it);
+	}
+}
+
+void Clock::clockChanged() {
+	// Cycles counted with the old frequency up to now are kept, the new
+	// frequency applies from now on.
+	SimulationTime now = m_scheduler ? m_scheduler->getTime() : 0;
+	SimulationTime period = m_enabled ? getStep() : 0;
+
+	// The next cycle ends with the next real edge of the clock, which
+	// depends on the phase of the source and of the divider. When that
+	// edge happens right now, it has not been counted yet.
+	SimulationTime edge = period != 0 && m_scheduler ? getNextRisingEdge() : SIMULATION_TIME_MAX;
+	m_originCycle = getCycle(edge == now ? now - 1 : now);
+	m_originTime = now;
+	m_period = period;
+	if (edge != SIMULATION_TIME_MAX) {
+		m_originTime = edge - m_period;
+	}
+
+	for (std::vector<ClockWatcher *>::const_iterator it = m_watchers.begin(); it != m_watchers.end(); ++it) {
+		(*it)->handleClockChanged(this);
+	}
+}
+
 void Clock::callRisingHandlers() {
 	for (std::vector<ClockHandler *>::const_iterator it = m_handlers.begin(); it != m_handlers.end(); ++it) {
 		(*it)->tickRising();
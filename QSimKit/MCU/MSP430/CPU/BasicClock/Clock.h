@@ -23,6 +23,8 @@
 #include <string>
 #include <vector>
 
+#include "Peripherals/SimulationTime.h"
+
 namespace MSP430 {
 
 class ClockHandler {
@@ -31,6 +33,21 @@ class ClockHandler {
 		virtual void tickFalling() = 0;
 };
 
+class Clock;
+class Scheduler;
+
+class ClockWatcher {
+	public:
+		/// Called when the frequency of the clock changes or when the clock
+		/// is enabled or disabled. Cycles computed before are still valid,
+		/// but the times of the future cycles have to be computed again.
+		virtual void handleClockChanged(Clock *clock) = 0;
+};
+
+/// Clock derived from one of the oscillators. Edges of the clock are
+/// generated only while it has handlers. Consumers which only need to know
+/// how many cycles have elapsed can use getCycle() and getCycleTime()
+/// instead, which are computed from the frequency of the clock.
 class Clock {
 	public:
 		typedef enum { Rising, Falling, RisingFalling } Mode;
@@ -47,14 +64,72 @@ class Clock {
 			return (!m_handlers.empty() || !m_fallingHandlers.empty());
 		}
 
+		/// Enables or disables the clock. Disabled clock is paused even when
+		/// it has handlers. This is used to turn the clocks off in low-power
+		/// modes.
+		void setEnabled(bool enabled);
+
+		bool isEnabled() {
+			return m_enabled;
+		}
+
+		/// Returns the frequency of the clock in Hz, or 0 when the clock is
+		/// driven by an external signal with unknown frequency.
+		virtual unsigned long getFrequency() = 0;
+
+		/// Returns the period of the clock, or 0 when the clock is driven by
+		/// an external signal with unknown frequency.
+		virtual SimulationTime getStep() = 0;
+
 		virtual void reset() = 0;
 
 		virtual void pause() {}
 		virtual void start() {}
 
+		void setScheduler(Scheduler *scheduler);
+
+		/// Returns true when the clock has known frequency, so getCycle()
+		/// and getCycleTime() describe its real edges. Otherwise the edges
+		/// have to be handled by addHandler().
+		bool isAnalytic() {
+			return getStep() != 0;
+		}
+
+		/// Returns the number of rising edges the clock has made since
+		/// the reset up to the time t, including the edge at the time t.
+		uint64_t getCycle(SimulationTime t);
+
+		/// Returns the time of the rising edge with the given number, or
+		/// SIMULATION_TIME_MAX when the clock is stopped and the edge never
+		/// comes.
+		SimulationTime getCycleTime(uint64_t cycle);
+
+		void addWatcher(ClockWatcher *watcher);
+		void removeWatcher(ClockWatcher *watcher);
+
+	protected:
+		/// Starts counting the cycles with the current frequency from the
+		/// next rising edge of the clock. Called by the derived clocks
+		/// whenever the source, the divider or the frequency of the source
+		/// changes.
+		void clockChanged();
+
+		/// Returns the time of the next rising edge the source makes for
+		/// this clock, or SIMULATION_TIME_MAX when it is not known. Cycles
+		/// are then counted from the current time.
+		virtual SimulationTime getNextRisingEdge() {
+			return SIMULATION_TIME_MAX;
+		}
+
 	private:
 		std::vector<ClockHandler *> m_handlers;
 		std::vector<ClockHandler *> m_fallingHandlers;
+		std::vector<ClockWatcher *> m_watchers;
+		bool m_enabled;
+		Scheduler *m_scheduler;
+		SimulationTime m_originTime;
+		uint64_t m_originCycle;
+		SimulationTime m_period;
 };
 
 }
@@ -30,7 +30,7 @@ namespace MSP430 {
 	if (METHOD != 0) { m_mem->addWatcher(METHOD, this); }
 
 DCO::DCO(Memory *mem, Variant *variant) : Oscillator("DCO"), m_mem(mem), m_variant(variant),
-m_freq(1000000), m_step(1.0/1000000) {
+m_freq(1000000), m_step(frequencyToPeriod(1000000)) {
 	ADD_WATCHER(m_variant->getDCOCTL());
 	ADD_WATCHER(m_variant->getBCSCTL1());
 
@@ -41,7 +41,7 @@ DCO::~DCO() {
 
 }
 
-double DCO::getStep() {
+SimulationTime DCO::getStep() {
 	return m_step;
 }
 
@@ -71,7 +71,8 @@ void DCO::handleMemoryChanged(::Memory *memory, uint16_t address) {
 	}
 
 	m_freq = freq;
-	m_step = 1.0 / m_freq;
+	m_step = frequencyToPeriod(freq);
+	frequencyChanged();
 }
 
 }
@@ -44,13 +44,13 @@ class DCO : public Oscillator, public MemoryWatcher {
 			return m_freq;
 		}
 
-		double getStep();
+		SimulationTime getStep();
 
 	private:
 		Memory *m_mem;
 		Variant *m_variant;
 		unsigned long m_freq;
-		double m_step;
+		SimulationTime m_step;
 };
 
 }
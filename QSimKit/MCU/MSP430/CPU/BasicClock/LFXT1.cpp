@@ -48,7 +48,7 @@ void LFXT1::reset() {
 }
 
 bool LFXT1::isChosen() {
-	uint16_t value = m_mem->getBigEndian(m_variant->getBCSCTL3(), false);
+	uint16_t value = m_mem->getWord(m_variant->getBCSCTL3(), false);
 	// Choose between VLO and LFXT1
 	bool xts = m_mem->isBitSet(m_variant->getBCSCTL1(), 1 << 6);
 	if (xts) {
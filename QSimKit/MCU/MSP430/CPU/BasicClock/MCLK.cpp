@@ -31,8 +31,8 @@
 namespace MSP430 {
 
 MCLK::MCLK(Memory *mem, Variant *variant, DCO *dco, VLO *vlo, LFXT1 *lfxt1, XT2 *xt2) :
-m_mem(mem), m_variant(variant), m_source(dco), m_dco(dco), m_vlo(vlo),
-m_lfxt1(lfxt1), m_xt2(xt2), m_divider(1), m_counter(0), m_rising(false) {
+m_mem(mem), m_variant(variant), m_source(0), m_dco(dco), m_vlo(vlo),
+m_lfxt1(lfxt1), m_xt2(xt2), m_divider(1), m_running(false) {
 
 #define ADD_WATCHER(METHOD) \
 	if (METHOD != 0) { m_mem->addWatcher(METHOD, this); }
@@ -56,6 +56,22 @@ unsigned long MCLK::getFrequency() {
 	return m_source->getFrequency() / m_divider;
 }
 
+SimulationTime MCLK::getStep() {
+	if (!m_source) {
+		return 0;
+	}
+
+	return m_source->getStep() * m_divider;
+}
+
+SimulationTime MCLK::getNextRisingEdge() {
+	if (!m_source) {
+		return SIMULATION_TIME_MAX;
+	}
+
+	return m_source->getNextRisingEdge(this, m_divider);
+}
+
 std::string MCLK::getSourceName() {
 	if (!m_source) {
 		return "None";
@@ -65,72 +81,92 @@ std::string MCLK::getSourceName() {
 }
 
 void MCLK::tickRising() {
-	if (++m_counter >= (m_divider >> 1)) {
-		m_counter = 0;
-
-		m_rising = !m_rising;
-		if (m_rising) {
-			callRisingHandlers();
-		}
-		else {
-			callFallingHandlers();
-		}
-	}
+	callRisingHandlers();
 }
 
 void MCLK::tickFalling() {
-	// Ignore falling tick if divider is one, because falling tick is generated
-	// on second rising tick in this case.
-	if (m_divider != 1) {
+	callFallingHandlers();
+}
+
+void MCLK::start() {
+	if (m_running) {
 		return;
 	}
 
-	tickRising();
+	if (m_source) {
+		m_source->addHandler(this, m_divider);
+		m_running = true;
+	}
+}
+
+void MCLK::pause() {
+	m_running = false;
+
+	if (m_source) {
+		m_source->removeHandler(this);
+	}
 }
 
 void MCLK::reset() {
 	handleMemoryChanged(m_mem, m_variant->getBCSCTL1());
 }
 
-double MCLK::getStep() {
-	return m_source->getStep();
+void MCLK::handleFrequencyChanged(Oscillator *oscillator) {
+	clockChanged();
 }
 
-void MCLK::handleMemoryChanged(::Memory *memory, uint16_t address) {
-	// Set divider and source
-	uint16_t ctl2 = m_mem->getBigEndian(m_variant->getBCSCTL2());
+void MCLK::setSource(Oscillator *source) {
+	if (m_source == source) {
+		return;
+	}
 
 	if (m_source) {
 		m_source->removeHandler(this);
+		m_source->removeWatcher(this);
+	}
+
+	m_source = source;
+	m_source->addWatcher(this);
+	if (m_running) {
+		m_source->addHandler(this, m_divider);
 	}
+}
+
+void MCLK::handleMemoryChanged(::Memory *memory, uint16_t address) {
+	// Set divider and source
+	uint16_t ctl2 = m_mem->getWord(m_variant->getBCSCTL2());
+
+	// Choose divider - DIVMx
+	switch((ctl2 >> 4) & 3) {
+		case 0: m_divider = 1; break;
+		case 1: m_divider = 2; break;
+		case 2: m_divider = 4; break;
+		case 3: m_divider = 8; break;
+		default: break;
+	}
+
 	// Choose source - SELMx
 	switch ((ctl2 >> 6) & 3) {
-		case 0: case 1: m_source = m_dco; break;
-		case 2: m_source = m_xt2; break;
+		case 0: case 1: setSource(m_dco); break;
+		case 2: setSource(m_xt2); break;
 		case 3:
 			if (m_lfxt1->isChosen()) {
-				m_source = m_lfxt1;
+				setSource(m_lfxt1);
 			}
 			else {
-				m_source = m_vlo;
+				setSource(m_vlo);
 			}
 			break;
 		default:
 			break;
 	}
-	m_source->addHandler(this);
 
-	// Choose divider - DIVMx
-	switch((ctl2 >> 4) & 3) {
-		case 0: m_divider = 1; break;
-		case 1: m_divider = 2; break;
-		case 2: m_divider = 4; break;
-		case 3: m_divider = 8; break;
-		default: break;
+	// Restart the divider with the new value
+	if (m_running) {
+		m_source->addHandler(this, m_divider);
 	}
 
-	m_counter = m_divider;
+	clockChanged();
 }
 
 }
-
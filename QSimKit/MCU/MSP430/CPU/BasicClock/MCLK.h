@@ -37,25 +37,38 @@ class LFXT1;
 class XT2;
 class Oscillator;
 
-class MCLK : public Clock, public OscillatorHandler, public MemoryWatcher {
+class MCLK : public Clock, public OscillatorHandler, public OscillatorWatcher, public MemoryWatcher {
 	public:
 		MCLK(Memory *mem, Variant *variant, DCO *dco, VLO *vlo, LFXT1 *lfxt1, XT2 *xt2);
 		virtual ~MCLK();
 
 		void handleMemoryChanged(::Memory *memory, uint16_t address);
 
+		void handleFrequencyChanged(Oscillator *oscillator);
+
 		void reset();
 
 		void tickRising();
 		void tickFalling();
 
-		double getStep();
+		void start();
+		void pause();
 
 		unsigned long getFrequency();
 
+		SimulationTime getStep();
+
 		std::string getSourceName();
 
+		Oscillator *getSource() {
+			return m_source;
+		}
+
 	private:
+		SimulationTime getNextRisingEdge();
+
+		void setSource(Oscillator *source);
+
 		Memory *m_mem;
 		Variant *m_variant;
 		Oscillator *m_source;
@@ -64,8 +77,7 @@ class MCLK : public Clock, public OscillatorHandler, public MemoryWatcher {
 		LFXT1 *m_lfxt1;
 		XT2 *m_xt2;
 		uint8_t m_divider;
-		uint8_t m_counter;
-		bool m_rising;
+		bool m_running;
 };
 
 }
@@ -24,18 +24,49 @@
 namespace MSP430 {
 	
 Oscillator::Oscillator(const std::string &name) : m_name(name),
-m_rising(true), m_inTick(false), m_willAddRemove(false) {
+m_rising(true), m_inTick(false), m_current(0), m_willAddRemove(false) {
 }
 
 Oscillator::~Oscillator() {
 	
 }
 
-void Oscillator::addHandler(OscillatorHandler *handler) {
+std::vector<Oscillator::Handler>::iterator Oscillator::findHandler(OscillatorHandler *handler) {
+	std::vector<Handler>::iterator it = m_handlers.begin();
+	for (; it != m_handlers.end(); ++it) {
+		if (it->handler == handler) {
+			break;
+		}
+	}
+	return it;
+}
+
+void Oscillator::addHandler(OscillatorHandler *handler, unsigned int divider) {
+	// Counter starts full, so the first edge of the divided clock comes
+	// with the next tick of the oscillator.
+	Handler h;
+	h.handler = handler;
+	h.divider = divider;
+	h.counter = divider;
+	h.rising = false;
+
+	// Handler which is already added only changes its divider. This is safe
+	// to do even from the handler itself.
+	std::vector<Handler>::iterator it = findHandler(handler);
+	if (it != m_handlers.end()) {
+		std::vector<OscillatorHandler *>::iterator r = std::find(m_toRemove.begin(), m_toRemove.end(), handler);
+		if (r != m_toRemove.end()) {
+			m_toRemove.erase(r);
+		}
+		it->divider = divider;
+		it->counter = divider;
+		return;
+	}
+
 	// If this method is called from the handler itself, it would segfaulf
 	// if we add the handler right now. Postpone adding in the end of tick().
 	if (m_inTick) {
-		m_toAdd.push_back(handler);
+		m_toAdd.push_back(h);
 		m_willAddRemove = true;
 		return;
 	}
@@ -44,19 +75,27 @@ void Oscillator::addHandler(OscillatorHandler *handler) {
 		start();
 	}
 
-	m_handlers.push_back(handler);
+	m_handlers.push_back(h);
 }
 
 void Oscillator::removeHandler(OscillatorHandler *handler) {
 	// If this method is called from the handler itself, it would segfaulf
 	// if we remove it right now. Postpone removal in the end of tick().
 	if (m_inTick) {
+		for (std::vector<Handler>::iterator it = m_toAdd.begin(); it != m_toAdd.end(); ) {
+			if (it->handler == handler) {
+				it = m_toAdd.erase(it);
+			}
+			else {
+				++it;
+			}
+		}
 		m_toRemove.push_back(handler);
 		m_willAddRemove = true;
 		return;
 	}
 
-	std::vector<OscillatorHandler *>::iterator it = std::find(m_handlers.begin(), m_handlers.end(), handler);
+	std::vector<Handler>::iterator it = findHandler(handler);
 	if (it != m_handlers.end()) {
 		m_handlers.erase(it);
 	}
@@ -66,14 +105,100 @@ void Oscillator::removeHandler(OscillatorHandler *handler) {
 	}
 }
 
+void Oscillator::addWatcher(OscillatorWatcher *watcher) {
+	m_watchers.push_back(watcher);
+}
+
+void Oscillator::removeWatcher(OscillatorWatcher *watcher) {
+	std::vector<OscillatorWatcher *>::iterator it = std::find(m_watchers.begin(), m_watchers.end(), watcher);
+	if (it != m_watchers.end()) {
+		m_watchers.erase(it);
+	}
+}
+
+void Oscillator::frequencyChanged() {
+	for (std::vector<OscillatorWatcher *>::const_iterator it = m_watchers.begin(); it != m_watchers.end(); ++it) {
+		(*it)->handleFrequencyChanged(this);
+	}
+}
+
+void Oscillator::skip(uint64_t periods) {
+	for (std::vector<Handler>::iterator it = m_handlers.begin(); it != m_handlers.end(); ++it) {
+		// Clock with divider 1 changes twice every period, so it ends
+		// in the same state.
+		if (it->divider == 1) {
+			continue;
+		}
+
+		// Full counter changes the state with the next rising tick, the
+		// same way as the counter one below the limit.
+		unsigned int limit = it->divider >> 1;
+		uint64_t counter = std::min(it->counter, limit - 1) + periods;
+		if ((counter / limit) & 1) {
+			it->rising = !it->rising;
+		}
+		it->counter = counter % limit;
+	}
+}
+
+SimulationTime Oscillator::getNextRisingEdge(OscillatorHandler *handler, unsigned int divider) {
+	SimulationTime t = getNextTickTime();
+	SimulationTime half = getStep() / 2;
+	if (t == SIMULATION_TIME_MAX || half == 0) {
+		return SIMULATION_TIME_MAX;
+	}
+
+	// Handler added during the tick is added once the tick ends
+	bool rising = m_inTick ? !m_rising : m_rising;
+	unsigned int counter = divider;
+	bool level = false;
+	std::vector<Handler>::iterator it = findHandler(handler);
+	if (it != m_handlers.end()) {
+		divider = it->divider;
+		counter = it->counter;
+		level = it->rising;
+		// Handler which has not been called yet still sees the current tick
+		if (m_inTick && (unsigned int) (it - m_handlers.begin()) > m_current) {
+			t -= half;
+			rising = m_rising;
+		}
+	}
+
+	// Follow tick() until the divided clock rises
+	while (true) {
+		if ((rising || divider == 1) && ++counter >= (divider >> 1)) {
+			counter = 0;
+			level = !level;
+			if (level) {
+				return t;
+			}
+		}
+		t += half;
+		rising = !rising;
+	}
+}
+
 void Oscillator::tick() {
 	m_inTick = true;
-	for (std::vector<OscillatorHandler *>::const_iterator it = m_handlers.begin(); it != m_handlers.end(); ++it) {
-		if (m_rising) {
-			(*it)->tickRising();
+	for (std::vector<Handler>::iterator it = m_handlers.begin(); it != m_handlers.end(); ++it) {
+		m_current = it - m_handlers.begin();
+		// Divided clock changes its state every (divider / 2) rising ticks.
+		// Divider 1 is special, because such clock follows every tick.
+		if (!m_rising && it->divider != 1) {
+			continue;
+		}
+
+		if (++it->counter < (it->divider >> 1)) {
+			continue;
+		}
+		it->counter = 0;
+
+		it->rising = !it->rising;
+		if (it->rising) {
+			it->handler->tickRising();
 		}
 		else {
-			(*it)->tickFalling();
+			it->handler->tickFalling();
 		}
 	}
 	m_rising = !m_rising;
@@ -82,21 +207,24 @@ void Oscillator::tick() {
 	if (!m_willAddRemove) {
 		return;
 	}
+	m_willAddRemove = false;
 
 	// Remove handlers which called removeHandler() during their callbacks.
 	if (!m_toRemove.empty()) {
-		for (std::vector<OscillatorHandler *>::const_iterator it = m_toRemove.begin(); it != m_toRemove.end(); ++it) {
+		std::vector<OscillatorHandler *> toRemove;
+		toRemove.swap(m_toRemove);
+		for (std::vector<OscillatorHandler *>::const_iterator it = toRemove.begin(); it != toRemove.end(); ++it) {
 			removeHandler(*it);
 		}
-		m_toRemove.clear();
 	}
 
 	// Add handlers which called addHandler() during their callbacks.
 	if (!m_toAdd.empty()) {
-		for (std::vector<OscillatorHandler *>::const_iterator it = m_toAdd.begin(); it != m_toAdd.end(); ++it) {
-			addHandler(*it);
+		std::vector<Handler> toAdd;
+		toAdd.swap(m_toAdd);
+		for (std::vector<Handler>::const_iterator it = toAdd.begin(); it != toAdd.end(); ++it) {
+			addHandler(it->handler, it->divider);
 		}
-		m_toAdd.clear();
 	}
 }
 
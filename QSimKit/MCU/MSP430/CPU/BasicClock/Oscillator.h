@@ -23,6 +23,8 @@
 #include <string>
 #include <vector>
 
+#include "Peripherals/SimulationTime.h"
+
 namespace MSP430 {
 
 class OscillatorHandler {
@@ -31,20 +33,71 @@ class OscillatorHandler {
 		virtual void tickFalling() = 0;
 };
 
+class Oscillator;
+
+class OscillatorWatcher {
+	public:
+		virtual void handleFrequencyChanged(Oscillator *oscillator) = 0;
+};
+
 class Oscillator {
 	public:
 		Oscillator(const std::string &name = "Unnamed oscillator");
 		virtual ~Oscillator();
 
-		void addHandler(OscillatorHandler *handler);
+		/// Adds the handler which sees this oscillator divided by the divider.
+		/// The divider is counted here, so the handler is called only on the
+		/// edges of the divided clock. Adding the handler again changes its
+		/// divider and keeps the phase of its clock.
+		void addHandler(OscillatorHandler *handler, unsigned int divider = 1);
 		void removeHandler(OscillatorHandler *handler);
 
+		/// Adds the watcher which is notified when the frequency changes.
+		/// Watchers are independent on handlers and do not start the oscillator.
+		void addWatcher(OscillatorWatcher *watcher);
+		void removeWatcher(OscillatorWatcher *watcher);
+
 		virtual unsigned long getFrequency() = 0;
 
-		virtual double getStep() = 0;
+		/// Returns the period of the oscillator, or 0 when the oscillator
+		/// is driven by an external signal with unknown frequency.
+		virtual SimulationTime getStep() = 0;
+
+		/// Returns the time of the next tick which has not been executed
+		/// yet, or SIMULATION_TIME_MAX when the oscillator does not know its
+		/// ticks in advance. During the tick, this is the tick after it.
+		virtual SimulationTime getNextTickTime() {
+			return SIMULATION_TIME_MAX;
+		}
+
+		/// Returns the time of the next rising edge of the clock seen by the
+		/// handler, following its current divider counter and level. Handler
+		/// which is not added yet is expected to be added with the given
+		/// divider right now.
+		SimulationTime getNextRisingEdge(OscillatorHandler *handler, unsigned int divider);
 
 		void tick();
 
+		/// Skips the given number of whole periods without calling the
+		/// handlers. Dividers count the skipped periods, so the divided
+		/// clocks keep their phase. Has to be called before the rising tick.
+		void skip(uint64_t periods);
+
+		/// Returns true when the next tick is the rising one.
+		bool isRising() {
+			return m_rising;
+		}
+
+		bool hasHandlers() {
+			return !m_handlers.empty() || !m_toAdd.empty();
+		}
+
+		/// Returns true when the handler is the only one ticked by this
+		/// oscillator.
+		bool hasOnlyHandler(OscillatorHandler *handler) {
+			return m_handlers.size() == 1 && m_handlers[0].handler == handler && m_toAdd.empty();
+		}
+
 		virtual void pause() {}
 		virtual void start() {}
 
@@ -52,14 +105,31 @@ class Oscillator {
 			return m_name;
 		}
 
+	protected:
+		/// Notifies the watchers. Called by the oscillators with variable
+		/// frequency once the new frequency is set.
+		void frequencyChanged();
+
 	private:
+		typedef struct {
+			OscillatorHandler *handler;
+			unsigned int divider;
+			unsigned int counter;
+			bool rising;
+		} Handler;
+
+		std::vector<Handler>::iterator findHandler(OscillatorHandler *handler);
+
 		std::string m_name;
-		std::vector<OscillatorHandler *> m_handlers;
+		std::vector<Handler> m_handlers;
+		std::vector<OscillatorWatcher *> m_watchers;
 		bool m_rising;
 		bool m_inTick;
+		// Index of the handler called by the current tick
+		unsigned int m_current;
 		bool m_willAddRemove;
 		std::vector<OscillatorHandler *> m_toRemove;
-		std::vector<OscillatorHandler *> m_toAdd;
+		std::vector<Handler> m_toAdd;
 };
 
 }
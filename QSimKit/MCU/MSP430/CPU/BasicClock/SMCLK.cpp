@@ -29,8 +29,8 @@
 namespace MSP430 {
 
 SMCLK::SMCLK(Memory *mem, Variant *variant, DCO *dco, XT2 *xt2) :
-m_mem(mem), m_variant(variant), m_source(dco), m_dco(dco), m_xt2(xt2),
-m_divider(1), m_counter(0), m_rising(false), m_running(false) {
+m_mem(mem), m_variant(variant), m_source(0), m_dco(dco), m_xt2(xt2),
+m_divider(1), m_running(false) {
 #define ADD_WATCHER(METHOD) \
 	if (METHOD != 0) { m_mem->addWatcher(METHOD, this); }
 	ADD_WATCHER(m_variant->getBCSCTL2());
@@ -50,6 +50,22 @@ unsigned long SMCLK::getFrequency() {
 	return m_source->getFrequency() / m_divider;
 }
 
+SimulationTime SMCLK::getStep() {
+	if (!m_source) {
+		return 0;
+	}
+
+	return m_source->getStep() * m_divider;
+}
+
+SimulationTime SMCLK::getNextRisingEdge() {
+	if (!m_source) {
+		return SIMULATION_TIME_MAX;
+	}
+
+	return m_source->getNextRisingEdge(this, m_divider);
+}
+
 std::string SMCLK::getSourceName() {
 	if (!m_source) {
 		return "None";
@@ -59,27 +75,11 @@ std::string SMCLK::getSourceName() {
 }
 
 void SMCLK::tickRising() {
-	if (++m_counter >= (m_divider >> 1)) {
-		m_counter = 0;
-
-		m_rising = !m_rising;
-		if (m_rising) {
-			callRisingHandlers();
-		}
-		else {
-			callFallingHandlers();
-		}
-	}
+	callRisingHandlers();
 }
 
 void SMCLK::tickFalling() {
-	// Ignore falling tick if divider is one, because falling tick is generated
-	// on second rising tick in this case.
-	if (m_divider != 1) {
-		return;
-	}
-
-	tickRising();
+	callFallingHandlers();
 }
 
 void SMCLK::start() {
@@ -90,7 +90,7 @@ void SMCLK::start() {
 // 	std::cout << "Starting SMCLK\n";
 
 	if (m_source) {
-		m_source->addHandler(this);
+		m_source->addHandler(this, m_divider);
 		m_running = true;
 	}
 }
@@ -106,16 +106,31 @@ void SMCLK::pause() {
 
 void SMCLK::reset() {
 	handleMemoryChanged(m_mem, m_variant->getBCSCTL2());
+}
+
+void SMCLK::handleFrequencyChanged(Oscillator *oscillator) {
+	clockChanged();
+}
+
+void SMCLK::setSource(Oscillator *source) {
+	if (m_source == source) {
+		return;
+	}
+
 	if (m_source) {
 		m_source->removeHandler(this);
+		m_source->removeWatcher(this);
 	}
-	m_source = m_dco;
-// 	m_source->addHandler(this);
-}
 
+	m_source = source;
+	m_source->addWatcher(this);
+	if (m_running) {
+		m_source->addHandler(this, m_divider);
+	}
+}
 
 void SMCLK::handleMemoryChanged(::Memory *memory, uint16_t address) {
-	uint16_t ctl2 = m_mem->getBigEndian(m_variant->getBCSCTL2());
+	uint16_t ctl2 = m_mem->getWord(m_variant->getBCSCTL2());
 
 	// Choose divider - DIVSx
 	switch((ctl2 >> 1) & 3) {
@@ -126,19 +141,20 @@ void SMCLK::handleMemoryChanged(::Memory *memory, uint16_t address) {
 		default: break;
 	}
 
-	m_counter = m_divider;
-
-	if (m_source) {
-		m_source->removeHandler(this);
-	}
 	// Choose source - SELSx
 	switch ((ctl2 >> 3) & 1) {
-		case 0: m_source = m_dco; break;
-		case 1: m_source = m_xt2; break;
+		case 0: setSource(m_dco); break;
+		case 1: setSource(m_xt2); break;
 		default:
 			break;
 	}
-	m_source->addHandler(this);
+
+	// Restart the divider with the new value
+	if (m_running) {
+		m_source->addHandler(this, m_divider);
+	}
+
+	clockChanged();
 }
 
 }
@@ -35,13 +35,15 @@ class DCO;
 class XT2;
 class Oscillator;
 
-class SMCLK : public Clock, public OscillatorHandler, public MemoryWatcher {
+class SMCLK : public Clock, public OscillatorHandler, public OscillatorWatcher, public MemoryWatcher {
 	public:
 		SMCLK(Memory *mem, Variant *variant, DCO *dco, XT2 *xt2);
 		virtual ~SMCLK();
 
 		void handleMemoryChanged(::Memory *memory, uint16_t address);
 
+		void handleFrequencyChanged(Oscillator *oscillator);
+
 		void reset();
 
 		void tickRising();
@@ -52,17 +54,21 @@ class SMCLK : public Clock, public OscillatorHandler, public MemoryWatcher {
 
 		unsigned long getFrequency();
 
+		SimulationTime getStep();
+
 		std::string getSourceName();
 
 	private:
+		SimulationTime getNextRisingEdge();
+
+		void setSource(Oscillator *source);
+
 		Memory *m_mem;
 		Variant *m_variant;
 		Oscillator *m_source;
 		DCO *m_dco;
 		XT2 *m_xt2;
 		uint8_t m_divider;
-		uint8_t m_counter;
-		bool m_rising;
 		bool m_running;
 };
 
@@ -0,0 +1,56 @@
+/**
+ * QSimKit - MSP430 simulator
+ * Copyright (C) 2013 Jan "HanzZ" Kaluza (hanzz.k@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#pragma once
+
+#include <stdint.h>
+
+#include "Peripherals/SimulationTime.h"
+
+namespace MSP430 {
+
+class TimedEventHandler {
+	public:
+		virtual void handleTimedEvent() = 0;
+};
+
+/// Source of the simulation time for the clocks which are modelled
+/// analytically instead of by their edges. Peripherals counting such
+/// clocks schedule only the events they really have to generate.
+class Scheduler {
+	public:
+		virtual ~Scheduler() {}
+
+		/// Returns the current simulation time.
+		virtual SimulationTime getTime() = 0;
+
+		/// Calls handler->handleTimedEvent() at the time t. The event scheduled
+		/// by the handler before is replaced, so every handler has at most one
+		/// pending event.
+		virtual void schedule(TimedEventHandler *handler, SimulationTime t) = 0;
+
+		/// Cancels the pending event of the handler, if there is any.
+		virtual void cancel(TimedEventHandler *handler) = 0;
+
+		/// Returns the time of the first pending event, or
+		/// SIMULATION_TIME_MAX when there is none.
+		virtual SimulationTime getNextEventTime() = 0;
+};
+
+}
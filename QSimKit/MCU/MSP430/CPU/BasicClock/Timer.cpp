@@ -36,15 +36,18 @@
 namespace MSP430 {
 
 Timer::Timer(Type type, PinManager *pinManager, InterruptManager *intManager, Memory *mem, Variant *variant,
-			 ACLK *aclk, SMCLK *smclk, uint16_t tactl, uint16_t tar,
+			 ACLK *aclk, SMCLK *smclk, Scheduler *scheduler, uint16_t tactl, uint16_t tar,
 			 uint16_t taiv, uint16_t intvect0, uint16_t intvect1) :
 m_pinManager(pinManager), m_intManager(intManager), m_mem(mem), m_variant(variant), m_source(0),
-m_divider(1), m_aclk(aclk), m_smclk(smclk), m_up(true), m_tactl(tactl),
+m_scheduler(scheduler), m_divider(1), m_aclk(aclk), m_smclk(smclk), m_up(true), m_tactl(tactl),
 m_tar(tar), m_taiv(taiv), m_intvect0(intvect0), m_intvect1(intvect1),
-m_type(type), m_counterMax(0xffff), m_counter(0) {
+m_type(type), m_counterMax(0xffff), m_counter(0), m_tarValue(0), m_lazy(false),
+m_syncing(false), m_mode(0), m_nextTick(0), m_eventCycle(0) {
 
 	m_mem->addWatcher(tactl, this);
 	m_mem->addWatcher(taiv, this, MemoryWatcher::Read);
+	// TAR is computed when it is read if the timer is counted analytically
+	m_mem->addWatcher(tar, this, MemoryWatcher::ReadWrite);
 
 	m_intManager->addWatcher(m_intvect0, this);
 	m_intManager->addWatcher(m_intvect1, this);
@@ -73,6 +76,7 @@ void Timer::addCCR(const std::string &taName, const std::string &cciaName, const
 	ccr.capturePending = false;
 	ccr.ccrRead = true;
 	ccr.ccis = 0;
+	ccr.tbcl = 0;
 
 	mpxs = m_pinManager->addPinHandler(cciaName, this);
 	ccr.cciaMpx = mpxs.empty() ? 0 : mpxs[0];
@@ -156,7 +160,7 @@ void Timer::doOutput(CCR &ccr, uint16_t tacctl, bool ccr0_interrupt) {
 void Timer::checkCCRInterrupts(uint16_t tar) {
 	// If timer changes its value to CCR0, fire CCR0 interrupt if
 	// enabled.
-	uint16_t tacctl = m_mem->getBigEndian(m_ccr[0].tacctl);
+	uint16_t tacctl = m_mem->getWord(m_ccr[0].tacctl);
 	bool ccr0_interrupt_enabled = tacctl & 16;
 	bool ccr0_interrupt = false;
 	uint16_t ccr0 = m_ccr[0].tbcl;
@@ -177,7 +181,7 @@ void Timer::checkCCRInterrupts(uint16_t tar) {
 
 	// Set CCIFG if TAR == CCR and CCIE is enabled
 	for (int i = 1; i < m_ccr.size(); ++i) {
-		tacctl = m_mem->getBigEndian(m_ccr[i].tacctl);
+		tacctl = m_mem->getWord(m_ccr[i].tacctl);
 		uint16_t ccr = m_ccr[i].tbcl;
 		bool interrupt_enabled = tacctl & 16;
 		if (ccr == tar) {
@@ -207,7 +211,7 @@ void Timer::finishPendingCaptures(uint16_t tar) {
 			if (m_mem->isBitSet(ccr.tacctl, 16)) {
 				// interrupts enabled
 				if (ccr.ccrRead) {
-					m_mem->setBigEndian(ccr.taccr, tar, false);
+					m_mem->setWord(ccr.taccr, tar, false);
 					m_mem->setBit(m_ccr[i].tacctl, 1, true);
 					if (i == 0) {
 						m_intManager->queueInterrupt(m_intvect0);
@@ -230,23 +234,23 @@ void Timer::finishPendingCaptures(uint16_t tar) {
 void Timer::latchTBCL(uint16_t tar, bool direction_changed) {
 	for (int i = 0; i < m_ccr.size(); ++i) {
 		CCR &ccr = m_ccr[i];
-		uint16_t tacctl = m_mem->getBigEndian(ccr.tacctl, false);
+		uint16_t tacctl = m_mem->getWord(ccr.tacctl, false);
 		switch((tacctl >> 9) & 3) {
 			case 0:
 				break;
 			case 1:
 				if (tar == 0) {
-					ccr.tbcl = m_mem->getBigEndian(ccr.taccr, false);
+					ccr.tbcl = m_mem->getWord(ccr.taccr, false);
 				}
 				break;
 			case 2:
 				if (tar == 0 || direction_changed) {
-					ccr.tbcl = m_mem->getBigEndian(ccr.taccr, false);
+					ccr.tbcl = m_mem->getWord(ccr.taccr, false);
 				}
 				break;
 			case 3:
 				if (tar == ccr.tbcl) {
-					ccr.tbcl = m_mem->getBigEndian(ccr.taccr, false);
+					ccr.tbcl = m_mem->getWord(ccr.taccr, false);
 				}
 				break;
 		}
@@ -255,7 +259,7 @@ void Timer::latchTBCL(uint16_t tar, bool direction_changed) {
 
 void Timer::changeTAR(uint8_t mode) {
 	uint16_t ccr0;
-	uint16_t tar = m_mem->getBigEndian(m_tar, false);
+	uint16_t tar = m_mem->getWord(m_tar, false);
 	bool taifg_interrupt_enabled = m_mem->isBitSet(m_tactl, 2);
 	bool direction_changed = false;
 
@@ -272,7 +276,7 @@ void Timer::changeTAR(uint8_t mode) {
 
 			if (tar == ccr0) {
 				// Timer overflows, fire TAIFG interrupt if it's enabled
-				m_mem->setBigEndian(m_tar, 0);
+				setTAR(0);
 				if (taifg_interrupt_enabled) {
 					m_mem->setBit(m_tactl, 1, true);
 					m_intManager->queueInterrupt(m_intvect1);
@@ -281,7 +285,7 @@ void Timer::changeTAR(uint8_t mode) {
 			}
 			else {
 				tar += 1;
-				m_mem->setBigEndian(m_tar, tar);
+				setTAR(tar);
 			}
 
 			finishPendingCaptures(tar);
@@ -296,7 +300,7 @@ void Timer::changeTAR(uint8_t mode) {
 		case TIMER_CONTINUOUS:
 			if (tar == m_counterMax) {
 				// Timer overflows, fire TAIFG interrupt if it's enabled
-				m_mem->setBigEndian(m_tar, 0);
+				setTAR(0);
 				if (taifg_interrupt_enabled) {
 					m_mem->setBit(m_tactl, 1, true);
 					m_intManager->queueInterrupt(m_intvect1);
@@ -305,7 +309,7 @@ void Timer::changeTAR(uint8_t mode) {
 			}
 			else {
 				tar += 1;
-				m_mem->setBigEndian(m_tar, tar);
+				setTAR(tar);
 			}
 
 			finishPendingCaptures(tar);
@@ -327,7 +331,7 @@ void Timer::changeTAR(uint8_t mode) {
 
 			if (tar == 1 && !m_up) {
 				// we are counting from 1 -> 0, so fire TAIFG interrupt
-				m_mem->setBigEndian(m_tar, 0);
+				setTAR(0);
 				if (taifg_interrupt_enabled) {
 					m_mem->setBit(m_tactl, 1, true);
 					m_intManager->queueInterrupt(m_intvect1);
@@ -351,7 +355,7 @@ void Timer::changeTAR(uint8_t mode) {
 					m_up = false;
 					direction_changed = true;
 				}
-				m_mem->setBigEndian(m_tar, tar);
+				setTAR(tar);
 			}
 
 			finishPendingCaptures(tar);
@@ -374,11 +378,213 @@ void Timer::tickRising() {
 }
 
 void Timer::reset() {
+	m_up = true;
+	m_tarValue = m_mem->getWord(m_tar, false);
+	setSource(m_aclk);
+	handleMemoryChanged(m_mem, m_tactl);
+}
+
+void Timer::setTAR(uint16_t tar) {
+	m_tarValue = tar;
+	m_mem->setWord(m_tar, tar, false);
+}
+
+void Timer::setSource(Clock *source) {
 	if (m_source) {
 		m_source->removeHandler(this);
+		m_source->removeWatcher(this);
+	}
+
+	m_source = source;
+	m_source->addWatcher(this);
+
+	m_lazy = m_scheduler && m_source->isAnalytic();
+	if (m_lazy) {
+		m_nextTick = m_source->getCycle(m_scheduler->getTime()) + 1;
+	}
+	else {
+		if (m_scheduler) {
+			m_scheduler->cancel(this);
+		}
+		m_source->addHandler(this, Clock::Rising);
+	}
+}
+
+uint32_t Timer::getTicksToEvent(uint16_t tar) {
+	if (m_ccr.empty()) {
+		return 0;
+	}
+
+	// Pending captures are finished with the next tick
+	for (int i = 0; i < m_ccr.size(); ++i) {
+		if (m_ccr[i].capturePending) {
+			return 1;
+		}
+	}
+
+	// Every tick which sets TAR to the value of some TBCLx/CCRx or to zero
+	// is an event. Ticks in between only increment or decrement TAR.
+	uint16_t ccr0 = m_ccr[0].tbcl;
+	uint16_t limit;
+	uint32_t ticks;
+	switch (m_mode) {
+		case TIMER_UP:
+			// CCR0 is 0, so timer is stopped
+			if (ccr0 == 0) {
+				return 0;
+			}
+			limit = tar <= ccr0 ? ccr0 : 0xffff;
+			break;
+		case TIMER_CONTINUOUS:
+			limit = tar <= m_counterMax ? m_counterMax : 0xffff;
+			break;
+		case TIMER_UPDOWN:
+			// CCR0 is 0, so timer is stopped
+			if (ccr0 == 0) {
+				return 0;
+			}
+
+			if (!m_up) {
+				// TAR can be 0 only when it has been written by the firmware
+				if (tar == 0) {
+					return 1;
+				}
+
+				ticks = tar;
+				for (int i = 0; i < m_ccr.size(); ++i) {
+					uint16_t ccr = m_ccr[i].tbcl;
+					if (ccr < tar && (uint32_t) (tar - ccr) < ticks) {
+						ticks = tar - ccr;
+					}
+				}
+				return ticks;
+			}
+			limit = tar < ccr0 ? ccr0 : 0xffff;
+			break;
+		default:
+			return 0;
+	}
+
+	// Counting up, the tick after the limit sets TAR to 0
+	ticks = (uint32_t) limit - tar + 1;
+	for (int i = 0; i < m_ccr.size(); ++i) {
+		uint16_t ccr = m_ccr[i].tbcl;
+		if (ccr > tar && ccr <= limit && (uint32_t) (ccr - tar) < ticks) {
+			ticks = ccr - tar;
+		}
+	}
+	return ticks;
+}
+
+void Timer::advance(uint64_t ticks) {
+	bool down = m_mode == TIMER_UPDOWN && !m_up;
+	while (ticks != 0) {
+		uint16_t tar = m_mem->getWord(m_tar, false);
+		uint32_t toEvent = getTicksToEvent(tar);
+
+		// Timer is stopped, TAR does not change
+		if (toEvent == 0) {
+			break;
+		}
+
+		if (ticks < toEvent) {
+			setTAR(down ? tar - ticks : tar + ticks);
+			break;
+		}
+
+		// Ticks before the event only change TAR, the event itself is
+		// handled the same way as when the timer is ticked by the clock.
+		toEvent -= 1;
+		setTAR(down ? tar - toEvent : tar + toEvent);
+		changeTAR(m_mode);
+		ticks -= toEvent + 1;
+		down = m_mode == TIMER_UPDOWN && !m_up;
+	}
+}
+
+void Timer::sync() {
+	if (!m_lazy) {
+		return;
+	}
+
+	syncTo(m_source->getCycle(m_scheduler->getTime()));
+}
+
+void Timer::syncTo(uint64_t cycle) {
+	// Events generated during the sync can change the registers, which
+	// would sync the timer again.
+	if (m_syncing || cycle < m_nextTick) {
+		return;
+	}
+
+	uint64_t ticks = 1 + (cycle - m_nextTick) / m_divider;
+	m_nextTick += ticks * m_divider;
+
+	m_syncing = true;
+	advance(ticks);
+	m_syncing = false;
+
+	scheduleNextEvent();
+}
+
+void Timer::scheduleNextEvent() {
+	if (!m_lazy || m_syncing) {
+		return;
+	}
+
+	uint32_t ticks = getTicksToEvent(m_mem->getWord(m_tar, false));
+	if (ticks == 0) {
+		m_scheduler->cancel(this);
+		return;
+	}
+
+	m_eventCycle = m_nextTick + (uint64_t) (ticks - 1) * m_divider;
+	SimulationTime t = m_source->getCycleTime(m_eventCycle);
+	if (t == SIMULATION_TIME_MAX) {
+		// Clock is stopped, the event is scheduled once it runs again
+		m_scheduler->cancel(this);
+		return;
+	}
+
+	m_scheduler->schedule(this, t);
+}
+
+void Timer::handleTimedEvent() {
+	// The event is due even when the time of its cycle has been rounded
+	// down, so at least the event cycle is reached.
+	uint64_t cycle = m_source->getCycle(m_scheduler->getTime());
+	syncTo(cycle > m_eventCycle ? cycle : m_eventCycle);
+	scheduleNextEvent();
+}
+
+void Timer::handleClockChanged(Clock *clock) {
+	if (clock != m_source) {
+		return;
+	}
+
+	bool lazy = m_scheduler && m_source->isAnalytic();
+	if (lazy == m_lazy) {
+		// Cycles counted so far do not change, but their times do
+		sync();
+		scheduleNextEvent();
+		return;
+	}
+
+	// Clock has been switched between the oscillator with known frequency
+	// and the external one.
+	if (lazy) {
+		m_source->removeHandler(this);
+		m_nextTick = m_source->getCycle(m_scheduler->getTime()) + 1;
+	}
+	else {
+		sync();
+		m_scheduler->cancel(this);
+		m_counter = m_divider;
+		m_source->addHandler(this, Clock::Rising);
 	}
-	m_source = m_aclk;
-	m_source->addHandler(this, Clock::Rising);
+
+	m_lazy = lazy;
+	scheduleNextEvent();
 }
 
 void Timer::generateOutput(CCR &ccr, bool value) {
@@ -390,13 +596,29 @@ void Timer::generateOutput(CCR &ccr, bool value) {
 }
 
 void Timer::handleMemoryChanged(::Memory *memory, uint16_t address) {
-	uint16_t val = memory->getBigEndian(address, false);
+	if (address == m_tar) {
+		// Ticks before the write are counted from the old value, which
+		// has been overwritten already.
+		uint16_t value = m_mem->getWord(m_tar, false);
+		if (m_lazy && !m_syncing) {
+			m_mem->setWord(m_tar, m_tarValue, false);
+			sync();
+		}
+		setTAR(value);
+		scheduleNextEvent();
+		return;
+	}
+
+	// Count the ticks up to now with the old configuration
+	sync();
+
+	uint16_t val = m_mem->getWord(address, false);
 
 	if (address == m_tactl) {
 		// TACLR
 		if (val & 4) {
 			memory->setBit(m_tactl, 4, false);
-			memory->setBigEndian(m_tar, 0);
+			setTAR(0);
 			m_up = true;
 			m_divider = 1;
 		}
@@ -415,24 +637,18 @@ void Timer::handleMemoryChanged(::Memory *memory, uint16_t address) {
 		// Choose source
 		switch((val >> 8) & 3) {
 			case 0: break;
-			case 1:
-				if (m_source) {
-					m_source->removeHandler(this);
-				}
-				m_source = m_aclk;
-				m_source->addHandler(this, Clock::Rising);
-				break;
-			case 2:
-				if (m_source) {
-					m_source->removeHandler(this);
-				}
-				m_source = m_smclk;
-				m_source->addHandler(this, Clock::Rising);
-				break;
+			case 1: setSource(m_aclk); break;
+			case 2: setSource(m_smclk); break;
 			case 3: break;
 			default: break;
 		}
 
+		// The first tick comes with the next edge of the source
+		if (m_lazy) {
+			m_nextTick = m_source->getCycle(m_scheduler->getTime()) + 1;
+		}
+		m_mode = (val >> 4) & 3;
+
 		if (m_type == TimerB) {
 			// Choose source
 			switch((val >> 11) & 3) {
@@ -498,7 +714,7 @@ void Timer::handleMemoryChanged(::Memory *memory, uint16_t address) {
 					ccr.tbcl = val;
 				}
 				else {
-					uint16_t tacctl = memory->getBigEndian(ccr.tacctl, false);
+					uint16_t tacctl = m_mem->getWord(ccr.tacctl, false);
 					switch((tacctl >> 9) & 3) {
 						case 0:
 							// TBCTL loads on write
@@ -513,9 +729,13 @@ void Timer::handleMemoryChanged(::Memory *memory, uint16_t address) {
 			}
 		}
 	}
+
+	scheduleNextEvent();
 }
 
 void Timer::handleInterruptFinished(InterruptManager *intManager, int vector) {
+	sync();
+
 	if (vector == m_intvect0) {
 		// We have to reset CCR0 CCIFG after interrupt routine
 		m_mem->setBit(m_ccr[0].tacctl, 1, false);
@@ -539,7 +759,13 @@ void Timer::handleInterruptFinished(InterruptManager *intManager, int vector) {
 }
 
 void Timer::handleMemoryRead(::Memory *memory, uint16_t address, uint16_t &value) {
-	if (address == m_taiv) {
+	// Flags and captured values have to be up to date as well as TAR
+	sync();
+
+	if (address == m_tar) {
+		value = m_mem->getWord(m_tar, false);
+	}
+	else if (address == m_taiv) {
 		// Check what interrupts we have queued and set 'value' to the one
 		// with highest priority. TAIV will remain 0.
 		for (int i = 1; i < m_ccr.size(); ++i) {
@@ -570,6 +796,13 @@ void Timer::handleMemoryRead(::Memory *memory, uint16_t address, uint16_t &value
 	}
 }
 
+void Timer::handleMemoryRead(::Memory *memory, uint16_t address, uint8_t &value) {
+	if (address == m_tar) {
+		sync();
+		value = m_mem->getByte(m_tar, false);
+	}
+}
+
 void Timer::doCapture(CCR &ccr, int ccrIndex, uint16_t tacctl) {
 	if (tacctl & (1 << 11)) {
 		// SCS is 1, so we are in sync mode, therefore just set
@@ -581,7 +814,7 @@ void Timer::doCapture(CCR &ccr, int ccrIndex, uint16_t tacctl) {
 		// the interrupt.
 		if (ccr.ccrRead) {
 			m_mem->setBit(ccr.tacctl, 1, true);
-			m_mem->setBigEndian(ccr.taccr, m_mem->getBigEndian(m_tar, false), false);
+			m_mem->setWord(ccr.taccr, m_mem->getWord(m_tar, false), false);
 			if (ccrIndex == 0) {
 				m_intManager->queueInterrupt(m_intvect0);
 			}
@@ -603,7 +836,7 @@ void Timer::handlePinInput(CCR &ccr, int ccrIndex, const std::string &name, doub
 		return;
 	}
 
-	uint16_t tacctl = m_mem->getBigEndian(ccr.tacctl, false);
+	uint16_t tacctl = m_mem->getWord(ccr.tacctl, false);
 	bool old_value = tacctl & 8;
 
 	// Set CCI bit
@@ -674,8 +907,14 @@ void Timer::handlePinInput(const std::string &name, double value) {
 		return;
 	}
 
+	// Capture has to see TAR of the current time
+	sync();
+
 	CCR &ccr = m_ccr[it->second];
 	handlePinInput(ccr, it->second, name, value);
+
+	// Synchronous capture is finished with the next tick
+	scheduleNextEvent();
 }
 
 void Timer::handlePinActivated(const std::string &name) {
@@ -20,6 +20,7 @@
 #pragma once
 
 #include "Clock.h"
+#include "Scheduler.h"
 
 #include <stdint.h>
 #include <string>
@@ -39,17 +40,29 @@ class InterruptManager;
 class PinManager;
 class PinMultiplexer;
 
-class Timer : public ClockHandler, public MemoryWatcher, public InterruptWatcher, public PinHandler {
+/// Timer_A and Timer_B. When the timer clock is analytic and the scheduler
+/// is available, the timer does not handle the clock edges. It computes
+/// the next tick which does something more than incrementing TAR, like
+/// compare match, overflow, turnaround or pending capture, and schedules
+/// only that tick. TAR is computed lazily when it is read. Otherwise the
+/// timer is ticked by every edge of its clock.
+class Timer : public ClockHandler, public ClockWatcher, public TimedEventHandler,
+			  public MemoryWatcher, public InterruptWatcher, public PinHandler {
 	public:
 		typedef enum { TimerA, TimerB } Type;
 
 		Timer(Type type, PinManager *pinManager, InterruptManager *intManager, Memory *mem, Variant *variant,
-			  ACLK *aclk, SMCLK *smclk, uint16_t tactl, uint16_t tar,
+			  ACLK *aclk, SMCLK *smclk, Scheduler *scheduler, uint16_t tactl, uint16_t tar,
 			  uint16_t taiv, uint16_t intvect0, uint16_t intvect1);
 		virtual ~Timer();
 
 		void handleMemoryChanged(::Memory *memory, uint16_t address);
 		void handleMemoryRead(::Memory *memory, uint16_t address, uint16_t &value);
+		void handleMemoryRead(::Memory *memory, uint16_t address, uint8_t &value);
+
+		void handleClockChanged(Clock *clock);
+
+		void handleTimedEvent();
 
 		void handleInterruptFinished(InterruptManager *intManager, int vector);
 
@@ -95,12 +108,20 @@ class Timer : public ClockHandler, public MemoryWatcher, public InterruptWatcher
 		void doOutput(CCR &ccr, uint16_t tacctl, bool ccr0_interrupt);
 		void handlePinInput(CCR &ccr, int ccrIndex, const std::string &name, double value);
 		void latchTBCL(uint16_t tar, bool direction_changed);
+		void setTAR(uint16_t tar);
+		void setSource(Clock *source);
+		uint32_t getTicksToEvent(uint16_t tar);
+		void advance(uint64_t ticks);
+		void sync();
+		void syncTo(uint64_t cycle);
+		void scheduleNextEvent();
 
 		PinManager *m_pinManager;
 		InterruptManager *m_intManager;
 		Memory *m_mem;
 		Variant *m_variant;
 		Clock *m_source;
+		Scheduler *m_scheduler;
 		uint8_t m_divider;
 		ACLK *m_aclk;
 		SMCLK *m_smclk;
@@ -115,6 +136,17 @@ class Timer : public ClockHandler, public MemoryWatcher, public InterruptWatcher
 		Type m_type;
 		uint16_t m_counterMax;
 		uint8_t m_counter;
+		// TAR as written by the timer the last time
+		uint16_t m_tarValue;
+		// The timer is counted analytically
+		bool m_lazy;
+		bool m_syncing;
+		// MCx bits used to count the ticks up to the current time
+		uint8_t m_mode;
+		// Cycle of the source clock with the next timer tick
+		uint64_t m_nextTick;
+		// Cycle of the source clock with the scheduled event
+		uint64_t m_eventCycle;
 };
 
 }
@@ -33,12 +33,19 @@ class DCO;
 class VLO;
 class LFXT1;
 class PinManager;
+class Scheduler;
 
 class TimerFactory {
 	public:
 		virtual ~TimerFactory() {}
 		virtual DCO *createDCO(Memory *mem, Variant *variant) = 0;
 		virtual VLO *createVLO() = 0;
+
+		/// Creates the source of the simulation time for the clocks. Returns
+		/// 0 when the oscillators are ticked manually without any time.
+		virtual Scheduler *createScheduler(DCO *dco) {
+			return 0;
+		}
 };
 
 }
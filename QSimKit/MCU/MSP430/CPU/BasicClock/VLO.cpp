@@ -25,7 +25,7 @@
 
 namespace MSP430 {
 
-VLO::VLO() : Oscillator("VLO"), m_freq(12000), m_step(1.0/12000) {
+VLO::VLO() : Oscillator("VLO"), m_freq(12000), m_step(frequencyToPeriod(12000)) {
 }
 
 VLO::~VLO() {
@@ -36,7 +36,7 @@ unsigned long VLO::getFrequency() {
 	return m_freq;
 }
 
-double VLO::getStep() {
+SimulationTime VLO::getStep() {
 	return m_step;
 }
 
@@ -37,11 +37,11 @@ class VLO : public Oscillator {
 		void reset();
 		unsigned long getFrequency();
 
-		double getStep();
+		SimulationTime getStep();
 
 	private:
 		unsigned long m_freq;
-		double m_step;
+		SimulationTime m_step;
 };
 
 }
@@ -44,7 +44,7 @@ class XT2 : public Oscillator, public MemoryWatcher, public PinHandler {
 			return 0;
 		}
 
-		double getStep() {
+		SimulationTime getStep() {
 			return 0;
 		}
 
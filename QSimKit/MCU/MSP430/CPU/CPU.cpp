@@ -31,7 +31,7 @@
 namespace MSP430 {
 
 CPU::CPU() : m_cycles(0), m_instructionCycles(0),
-	m_mem(new Memory(512000)), m_reg(new RegisterSet()),
+	m_mem(new Memory(MEMORY_ADDRESS_SPACE)), m_reg(new RegisterSet()),
 	m_decoder(new InstructionDecoder(m_reg, m_mem)),
 	m_instruction(new Instruction) {
 
@@ -43,7 +43,9 @@ CPU::~CPU() {
 }
 
 bool CPU::loadA43(const std::string &data) {
-	return m_mem->loadA43(data, m_reg);
+	bool ret = m_mem->loadA43(data, m_reg);
+	m_decoder->invalidateCache();
+	return ret;
 }
 
 void CPU::delta_int() {
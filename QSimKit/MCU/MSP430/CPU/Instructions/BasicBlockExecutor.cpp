@@ -0,0 +1,407 @@
+/**
+ * QSimKit - MSP430 simulator
+ * Copyright (C) 2013 Jan "HanzZ" Kaluza (hanzz.k@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#include "CPU/Instructions/BasicBlockExecutor.h"
+#include "CPU/Instructions/InstructionDecoder.h"
+#include "CPU/Instructions/Instruction.h"
+#include "CPU/Interrupts/InterruptManager.h"
+#include "CPU/Memory/RegisterSet.h"
+#include "CPU/Memory/Register.h"
+#include "CPU/Memory/Memory.h"
+#include "CPU/Profiler/Profiler.h"
+
+#include <iostream>
+#include <string.h>
+
+namespace MSP430 {
+
+// Maximum number of instructions in single basic block
+#define MAX_BLOCK_SIZE 32
+
+// Number of block executions before it is compiled to native code
+#define JIT_THRESHOLD 64
+
+// Memory compared in the JIT validation mode. Word access at 0xffff
+// touches one byte more.
+#define VALIDATED_MEMORY 0x10001
+
+BasicBlockExecutor::BasicBlockExecutor(RegisterSet *reg, Memory *mem, InstructionDecoder *decoder, InterruptManager *intManager) :
+m_reg(reg), m_mem(mem), m_decoder(decoder), m_intManager(intManager), m_jit(0),
+m_validateJIT(false), m_jitErrors(0), m_profiler(0) {
+	m_blocks.resize(32768);
+	m_fusedCount.resize(FusedPatternCount);
+	setJIT(true);
+}
+
+BasicBlockExecutor::~BasicBlockExecutor() {
+	for (std::vector<BasicBlock *>::iterator it = m_blocks.begin(); it != m_blocks.end(); ++it) {
+		delete *it;
+	}
+	delete m_jit;
+}
+
+void BasicBlockExecutor::setJIT(bool enable) {
+	for (std::vector<BasicBlock *>::iterator it = m_blocks.begin(); it != m_blocks.end(); ++it) {
+		if (*it) {
+			(*it)->jit = 0;
+			(*it)->executions = 0;
+		}
+	}
+
+	delete m_jit;
+	m_jit = 0;
+	if (enable && JITCompiler::isSupported()) {
+		m_jit = new JITCompiler();
+		// Executable memory can be forbidden by the system
+		if (!m_jit->isAvailable()) {
+			delete m_jit;
+			m_jit = 0;
+		}
+	}
+}
+
+static bool endsBlock(const DecodedInstruction &d) {
+	switch (d.type) {
+		case InstructionCond:
+			return true;
+		case Instruction1:
+			// call, reti
+			if (d.opcode == 5 || d.opcode == 6) {
+				return true;
+			}
+			// Operand of single operand instruction is stored as source
+			return d.srcType == DecodedInstruction::ArgRegister && (d.srcReg == 0 || d.srcReg == 2);
+		case Instruction2:
+			// Changing PC or SR (GIE, CPU_OFF, ...)
+			return d.dstType == DecodedInstruction::ArgRegister && (d.dstReg == 0 || d.dstReg == 2);
+		default:
+			return true;
+	}
+}
+
+void BasicBlockExecutor::buildBlock(uint16_t pc, BasicBlock *block) {
+	block->entries.clear();
+	block->generation = m_decoder->getGeneration();
+	block->executions = 0;
+	block->jit = 0;
+
+	while (block->entries.size() < MAX_BLOCK_SIZE) {
+		const DecodedInstruction &d = m_decoder->decode(pc);
+
+		SpecializedCallback handler = getSpecializedInstruction(d);
+		if (!handler) {
+			break;
+		}
+
+		// Peripherals have to be accessed by single-stepped instructions
+		if ((d.srcType == DecodedInstruction::ArgAbsolute && d.srcValue < MEMORY_PERIPHERALS_END) ||
+			(d.dstType == DecodedInstruction::ArgAbsolute && d.dstValue < MEMORY_PERIPHERALS_END)) {
+			break;
+		}
+
+		BasicBlock::Entry entry;
+		entry.pc = pc;
+		entry.decoded = &d;
+		entry.handler = handler;
+		entry.fused = 0;
+		entry.pattern = 0;
+		block->entries.push_back(entry);
+
+		if (endsBlock(d)) {
+			break;
+		}
+
+		pc += d.length;
+	}
+
+	fuseBlock(block);
+}
+
+void BasicBlockExecutor::fuseBlock(BasicBlock *block) {
+	for (unsigned int i = 0; i + 1 < block->entries.size(); ++i) {
+		BasicBlock::Entry &entry = block->entries[i];
+		entry.fused = getFusedInstruction(*entry.decoded, *block->entries[i + 1].decoded, entry.pattern);
+		if (entry.fused) {
+			// Pairs must not overlap
+			++i;
+		}
+	}
+}
+
+BasicBlock *BasicBlockExecutor::getBlock(uint16_t pc) {
+	BasicBlock *&block = m_blocks[pc >> 1];
+	if (!block) {
+		block = new BasicBlock();
+		buildBlock(pc, block);
+	}
+	else if (block->generation != m_decoder->getGeneration()) {
+		// Some code has been changed, so this block can be outdated.
+		buildBlock(pc, block);
+	}
+
+	return block;
+}
+
+bool BasicBlockExecutor::isWatched(uint16_t address, bool bw, bool write) {
+	MemoryWatcher::Mode mode = write ? MemoryWatcher::ReadWrite : MemoryWatcher::Read;
+	if (address < MEMORY_PERIPHERALS_END || m_mem->isWatched(address, mode)) {
+		return true;
+	}
+
+	if (bw) {
+		return false;
+	}
+
+	address += 1;
+	return address < MEMORY_PERIPHERALS_END || m_mem->isWatched(address, mode);
+}
+
+bool BasicBlockExecutor::accessesWatchedMemory(const DecodedInstruction &d, uint16_t pc) {
+	uint16_t src = 0;
+	uint16_t increment = 0;
+
+	switch (d.srcType) {
+		case DecodedInstruction::ArgAbsolute:
+			src = d.srcValue;
+			break;
+		case DecodedInstruction::ArgIndexed:
+			src = (d.srcReg == 0 ? pc : m_reg->getp(d.srcReg)->getBigEndian()) + d.srcValue;
+			break;
+		case DecodedInstruction::ArgIndirectAutoincrement:
+			src = m_reg->getp(d.srcReg)->getBigEndian();
+			increment = d.bw ? 1 : 2;
+			break;
+		default:
+			break;
+	}
+
+	if (d.srcType >= DecodedInstruction::ArgAbsolute) {
+		// Single operand instructions except push/call write to their operand
+		bool write = d.type == Instruction1 && d.opcode < 4;
+		if (isWatched(src, d.bw, write)) {
+			return true;
+		}
+	}
+
+	uint16_t dst = 0;
+	switch (d.dstType) {
+		case DecodedInstruction::ArgAbsolute:
+			dst = d.dstValue;
+			break;
+		case DecodedInstruction::ArgIndexed:
+			dst = (d.dstReg == 0 ? pc : m_reg->getp(d.dstReg)->getBigEndian()) + d.dstValue;
+			// The handlers read the destination before the source and
+			// write it after, so with the same register the destination is
+			// read before the source autoincrement and written after it.
+			if (d.srcType == DecodedInstruction::ArgIndirectAutoincrement && d.srcReg == d.dstReg) {
+				if (isWatched(dst, d.bw, false)) {
+					return true;
+				}
+				dst += increment;
+			}
+			break;
+		default:
+			break;
+	}
+
+	if (d.dstType >= DecodedInstruction::ArgAbsolute) {
+		if (isWatched(dst, d.bw, true)) {
+			return true;
+		}
+	}
+
+	if (d.type == Instruction1) {
+		uint16_t sp = m_reg->getp(1)->getBigEndian();
+		switch (d.opcode) {
+			// push, call
+			case 4: case 5:
+				return isWatched(sp - 2, false, true);
+			// reti
+			case 6:
+				return isWatched(sp, false, false) || isWatched(sp + 2, false, false);
+			default:
+				break;
+		}
+	}
+
+	return false;
+}
+
+void BasicBlockExecutor::compileBlock(BasicBlock *block) {
+	std::vector<const DecodedInstruction *> instructions;
+	for (std::vector<BasicBlock::Entry>::const_iterator it = block->entries.begin(); it != block->entries.end(); ++it) {
+		instructions.push_back(it->decoded);
+	}
+
+	block->jit = m_jit->compile(instructions, block->entries[0].pc);
+	if (!m_jit->isAvailable()) {
+		// The code buffer is gone, so continue with the interpreter only
+		setJIT(false);
+		return;
+	}
+
+	if (!block->jit && m_jit->isFull()) {
+		// Drop all the code. Blocks which are still hot will be compiled
+		// again.
+		m_jit->flush();
+		for (std::vector<BasicBlock *>::iterator it = m_blocks.begin(); it != m_blocks.end(); ++it) {
+			if (*it) {
+				(*it)->jit = 0;
+				(*it)->executions = 0;
+			}
+		}
+		block->jit = m_jit->compile(instructions, block->entries[0].pc);
+	}
+}
+
+int BasicBlockExecutor::runValidated(BasicBlock *block) {
+	RegisterFile *file = m_reg->getRegisterFile();
+	uint8_t *data = m_mem->getData();
+	RegisterFile before = *file;
+	std::vector<uint8_t> memoryBefore(data, data + VALIDATED_MEMORY);
+
+	int executed = block->jit(file, data, m_mem->getWatchedMask());
+	RegisterFile compiled = *file;
+	std::vector<uint8_t> compiledMemory(data, data + VALIDATED_MEMORY);
+
+	// Execute the same instructions again using the interpreter
+	*file = before;
+	memcpy(data, &memoryBefore[0], VALIDATED_MEMORY);
+	for (int i = 0; i < executed; ++i) {
+		const BasicBlock::Entry &entry = block->entries[i];
+		file->values[0] = entry.pc + entry.decoded->length;
+		entry.handler(m_reg, m_mem, *entry.decoded);
+	}
+
+	// Compiled code does not change PC
+	compiled.values[0] = file->values[0];
+	bool equal = compiled.getSR() == file->getSR();
+	for (int r = 0; r < 16 && equal; ++r) {
+		equal = compiled.values[r] == file->values[r];
+	}
+	equal = equal && memcmp(&compiledMemory[0], data, VALIDATED_MEMORY) == 0;
+
+	if (!equal) {
+		m_jitErrors++;
+		std::cerr << "JIT: compiled block at 0x" << std::hex << block->entries[0].pc << std::dec
+			<< " differs from the interpreter\n";
+	}
+
+	return executed;
+}
+
+int BasicBlockExecutor::runCompiled(BasicBlock *block) {
+	if (block->entries.empty()) {
+		return 0;
+	}
+
+	if (!block->jit) {
+		if (++block->executions != JIT_THRESHOLD) {
+			return 0;
+		}
+
+		compileBlock(block);
+		if (!block->jit) {
+			return 0;
+		}
+	}
+
+	if (m_validateJIT) {
+		return runValidated(block);
+	}
+
+	return block->jit(m_reg->getRegisterFile(), m_mem->getData(), m_mem->getWatchedMask());
+}
+
+int BasicBlockExecutor::run(Instruction *instruction) {
+	// Breakpoints are implemented using register watchers, so the
+	// instructions have to be executed one by one to stop at right place.
+	if (m_reg->hasWatchers()) {
+		return 0;
+	}
+
+	uint16_t pc = m_reg->getp(0)->getBigEndian();
+	if (pc & 1) {
+		return 0;
+	}
+
+	BasicBlock *block = getBlock(pc);
+
+	int cycles = 0;
+	std::vector<BasicBlock::Entry>::const_iterator it = block->entries.begin();
+	if (m_jit) {
+		// Compiled code stops before the instruction accessing peripheral
+		// or watched memory, the rest is interpreted.
+		RegisterFile *file = m_reg->getRegisterFile();
+		int executed = runCompiled(block);
+		for (int i = 0; i < executed; ++i, ++it) {
+			cycles += it->decoded->cycles;
+			file->values[0] = it->pc + it->decoded->length;
+			if (m_profiler) {
+				m_profiler->addInstruction(it->pc, *it->decoded);
+			}
+		}
+	}
+
+	for (; it != block->entries.end(); ++it) {
+		const DecodedInstruction &d = *it->decoded;
+		uint16_t next = it->pc + d.length;
+		if (accessesWatchedMemory(d, next)) {
+			break;
+		}
+
+		if (it->fused) {
+			const BasicBlock::Entry &second = *(it + 1);
+			// Only push and call write to memory in the second instruction
+			// and they do so below SP already decreased by the first push.
+			uint16_t sp = m_reg->getRegisterFile()->values[1];
+			if (second.decoded->type != Instruction1 || !isWatched(sp - 4, false, true)) {
+				m_reg->getp(0)->setBigEndian(second.pc + second.decoded->length);
+				it->fused(m_reg, m_mem, d, *second.decoded);
+				m_fusedCount[it->pattern]++;
+				if (m_profiler) {
+					m_profiler->addInstruction(it->pc, d);
+					m_profiler->addInstruction(second.pc, *second.decoded);
+				}
+				cycles += d.cycles + second.decoded->cycles;
+				++it;
+				continue;
+			}
+		}
+
+		m_reg->getp(0)->setBigEndian(next);
+		it->handler(m_reg, m_mem, d);
+
+		if (m_profiler) {
+			m_profiler->addInstruction(it->pc, d);
+		}
+
+		// reti finishes the running interrupt
+		if (d.type == Instruction1 && d.opcode == 6) {
+			m_decoder->bindInstruction(it->pc, d, instruction);
+			m_intManager->handleInstruction(instruction);
+		}
+
+		cycles += d.cycles;
+	}
+
+	return cycles;
+}
+
+}
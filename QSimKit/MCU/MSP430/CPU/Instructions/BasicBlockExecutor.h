@@ -0,0 +1,134 @@
+/**
+ * QSimKit - MSP430 simulator
+ * Copyright (C) 2013 Jan "HanzZ" Kaluza (hanzz.k@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "CPU/Instructions/SpecializedInstructions.h"
+#include "CPU/Instructions/JITCompiler.h"
+
+namespace MSP430 {
+
+class RegisterSet;
+class Memory;
+class Instruction;
+class InstructionDecoder;
+class InterruptManager;
+class DecodedInstruction;
+class Profiler;
+
+/// Straight-line run of instructions with already resolved handlers.
+class BasicBlock {
+	public:
+		class Entry {
+			public:
+				uint16_t pc;
+				const DecodedInstruction *decoded;
+				SpecializedCallback handler;
+				/// Handler executing this and the next entry at once, or 0.
+				FusedCallback fused;
+				/// FusedPattern of the fused handler.
+				int pattern;
+		};
+
+		BasicBlock() : generation(0), executions(0), jit(0) {}
+
+		unsigned int generation;
+		/// Number of executions since the block has been built or the
+		/// compiled code has been dropped.
+		unsigned int executions;
+		/// Compiled code of the beginning of the block, or 0.
+		JITFunction jit;
+		std::vector<Entry> entries;
+};
+
+/// Executes basic blocks of the instructions at once.
+///
+/// Block ends with the first instruction changing PC or SR. Instructions
+/// accessing peripherals or memory with registered MemoryWatcher are never
+/// executed as part of the block. They have to be executed one by one with
+/// executeInstruction() to keep the peripherals cycle accurate.
+class BasicBlockExecutor {
+	public:
+		BasicBlockExecutor(RegisterSet *reg, Memory *mem, InstructionDecoder *decoder, InterruptManager *intManager);
+		virtual ~BasicBlockExecutor();
+
+		/// Executes basic block starting at current PC. Execution stops before
+		/// instruction which would access peripheral or watched memory.
+		/// Returns number of cycles of executed instructions or 0 if nothing
+		/// has been executed.
+		int run(Instruction *instruction);
+
+		/// Executes often executed blocks using JITCompiler if it is
+		/// supported. Enabled by default.
+		void setJIT(bool enable);
+
+		/// Executes every compiled block also using the interpreter and
+		/// compares the registers and memory. The interpreter results are
+		/// used and differences are reported to stderr.
+		void setJITValidation(bool validate) {
+			m_validateJIT = validate;
+		}
+
+		/// Returns number of compiled block executions which did not match
+		/// the interpreter in validation mode.
+		unsigned int getJITErrors() {
+			return m_jitErrors;
+		}
+
+		/// Reports every executed instruction to the profiler. Pass 0 to
+		/// disable the profiling.
+		void setProfiler(Profiler *profiler) {
+			m_profiler = profiler;
+		}
+
+		/// Returns how many times the instructions have been executed using
+		/// fused handler of given FusedPattern.
+		unsigned int getFusedCount(int pattern) {
+			return m_fusedCount[pattern];
+		}
+
+	private:
+		BasicBlock *getBlock(uint16_t pc);
+		void buildBlock(uint16_t pc, BasicBlock *block);
+		void fuseBlock(BasicBlock *block);
+		bool accessesWatchedMemory(const DecodedInstruction &d, uint16_t pc);
+		bool isWatched(uint16_t address, bool bw, bool write);
+		int runCompiled(BasicBlock *block);
+		int runValidated(BasicBlock *block);
+		void compileBlock(BasicBlock *block);
+
+	private:
+		RegisterSet *m_reg;
+		Memory *m_mem;
+		InstructionDecoder *m_decoder;
+		InterruptManager *m_intManager;
+		// Basic blocks indexed by PC / 2
+		std::vector<BasicBlock *> m_blocks;
+		JITCompiler *m_jit;
+		bool m_validateJIT;
+		unsigned int m_jitErrors;
+		std::vector<unsigned int> m_fusedCount;
+		Profiler *m_profiler;
+};
+
+}
@@ -29,36 +29,27 @@ ConstantArgument::~ConstantArgument() {
 }
 
 uint16_t ConstantArgument::get() {
-	return m_value;
+	return (m_value >> 8) | (m_value << 8);
 }
 
 uint16_t ConstantArgument::getBigEndian() {
-	uint16_t w;
-	uint8_t *ptr = (uint8_t *) &w;
-	uint8_t *ptr2 = (uint8_t *) &m_value;
-	*ptr++ = *(ptr2 + 1);
-	*ptr++ = *ptr2;
-	return w;
+	return m_value;
 }
 
 void ConstantArgument::set(uint16_t value) {
-	m_value = value;
+	m_value = (value >> 8) | (value << 8);
 }
 
 void ConstantArgument::setBigEndian(uint16_t value) {
-	uint8_t *ptr = (uint8_t *) &m_value;
-	uint8_t *ptr2 = (uint8_t *) &value;
-	*ptr++ = *(ptr2 + 1);
-	*ptr++ = *ptr2;
+	m_value = value;
 }
 
 uint8_t ConstantArgument::getByte() {
-	return (uint8_t) getBigEndian();
+	return (uint8_t) m_value;
 }
 
 void ConstantArgument::setByte(uint8_t value) {
-	uint8_t *ptr = (uint8_t *) &m_value;
-	*ptr = value;
+	m_value = (m_value & 0xff00) | value;
 }
 
 }
@@ -0,0 +1,393 @@
+/**
+ * QSimKit - MSP430 simulator
+ * Copyright (C) 2013 Jan "HanzZ" Kaluza (hanzz.k@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+
+#include "CPU/Instructions/IdleLoopExecutor.h"
+#include "CPU/Instructions/InstructionDecoder.h"
+#include "CPU/Instructions/Instruction.h"
+#include "CPU/Interrupts/InterruptManager.h"
+#include "CPU/Memory/RegisterSet.h"
+#include "CPU/Memory/Register.h"
+#include "CPU/Memory/Memory.h"
+
+namespace MSP430 {
+
+// Maximum number of instructions in single idle loop
+#define MAX_LOOP_SIZE 8
+
+IdleLoopExecutor::IdleLoopExecutor(RegisterSet *reg, Memory *mem, InstructionDecoder *decoder, InterruptManager *intManager) :
+m_reg(reg), m_mem(mem), m_decoder(decoder), m_intManager(intManager), m_loop(0),
+m_counterStart(0), m_counterStep(0), m_iterations(0), m_iteration(0), m_index(0),
+m_elapsed(0), m_period(0) {
+	m_loops.resize(32768);
+}
+
+IdleLoopExecutor::~IdleLoopExecutor() {
+	for (std::vector<IdleLoop *>::iterator it = m_loops.begin(); it != m_loops.end(); ++it) {
+		delete *it;
+	}
+}
+
+// cmp and bit change only the flags
+static bool isPollingInstruction(const DecodedInstruction &d) {
+	return d.type == Instruction2 && (d.opcode == 9 || d.opcode == 11) &&
+		d.srcType != DecodedInstruction::ArgIndirectAutoincrement;
+}
+
+// add #const, Rn and sub #const, Rn
+static bool isCounterInstruction(const DecodedInstruction &d) {
+	return d.type == Instruction2 && (d.opcode == 5 || d.opcode == 8) && !d.bw &&
+		d.srcType == DecodedInstruction::ArgConstant &&
+		d.dstType == DecodedInstruction::ArgRegister && d.dstReg >= 4;
+}
+
+void IdleLoopExecutor::buildLoop(uint16_t pc, IdleLoop *loop) {
+	uint16_t start = pc;
+
+	loop->entries.clear();
+	loop->generation = m_decoder->getGeneration();
+	loop->valid = false;
+	loop->counter = -1;
+
+	while (loop->entries.size() < MAX_LOOP_SIZE) {
+		const DecodedInstruction &d = m_decoder->decode(pc);
+
+		SpecializedCallback handler = getSpecializedInstruction(d);
+		if (!handler) {
+			return;
+		}
+
+		IdleLoop::Entry entry;
+		entry.pc = pc;
+		entry.decoded = &d;
+		entry.handler = handler;
+		loop->entries.push_back(entry);
+
+		pc += d.length;
+		if (d.type == InstructionCond) {
+			// Only the jump back to the start of the loop is allowed
+			if ((uint16_t) (pc + d.offset) != start) {
+				return;
+			}
+			break;
+		}
+
+		if (!isPollingInstruction(d) && !isCounterInstruction(d)) {
+			return;
+		}
+	}
+
+	if (loop->entries.back().decoded->type != InstructionCond) {
+		return;
+	}
+
+	// Delay loop has to be "dec Rn; jnz $-2" or similar
+	if (loop->entries.size() == 2 && isCounterInstruction(*loop->entries[0].decoded)) {
+		if (loop->entries[1].decoded->opcode != 0) {
+			return;
+		}
+		loop->counter = loop->entries[0].decoded->dstReg;
+		loop->valid = true;
+		return;
+	}
+
+	for (unsigned int i = 0; i < loop->entries.size() - 1; ++i) {
+		if (!isPollingInstruction(*loop->entries[i].decoded)) {
+			return;
+		}
+	}
+
+	loop->valid = true;
+}
+
+IdleLoop *IdleLoopExecutor::getLoop(uint16_t pc) {
+	IdleLoop *&loop = m_loops[pc >> 1];
+	if (!loop) {
+		loop = new IdleLoop();
+		buildLoop(pc, loop);
+	}
+	else if (loop->generation != m_decoder->getGeneration()) {
+		// Some code has been changed, so this loop can be outdated.
+		buildLoop(pc, loop);
+	}
+
+	return loop;
+}
+
+void IdleLoopExecutor::restore(const RegisterFile &state) {
+	RegisterFile *file = m_reg->getRegisterFile();
+	uint16_t watched = file->watched;
+	*file = state;
+	file->watched = watched;
+}
+
+bool IdleLoopExecutor::runIteration(std::vector<RegisterFile> &states) {
+	RegisterFile *file = m_reg->getRegisterFile();
+
+	states.clear();
+	for (std::vector<IdleLoop::Entry>::const_iterator it = m_loop->entries.begin(); it != m_loop->entries.end(); ++it) {
+		states.push_back(*file);
+		file->values[0] = it->pc + it->decoded->length;
+		it->handler(m_reg, m_mem, *it->decoded);
+	}
+	states.push_back(*file);
+
+	return file->values[0] == m_loop->entries[0].pc;
+}
+
+static bool sameState(RegisterFile a, RegisterFile b) {
+	if (a.getSR() != b.getSR()) {
+		return false;
+	}
+
+	for (int i = 0; i < 16; ++i) {
+		if (i != 2 && a.values[i] != b.values[i]) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool IdleLoopExecutor::enter() {
+	// Watched registers need the loop to be executed, see
+	// BasicBlockExecutor::run().
+	if (m_reg->hasWatchers() || m_intManager->hasQueuedInterrupts()) {
+		return false;
+	}
+
+	uint16_t pc = m_reg->getp(0)->getBigEndian();
+	if (pc & 1) {
+		return false;
+	}
+
+	IdleLoop *loop = getLoop(pc);
+	if (!loop->valid) {
+		return false;
+	}
+
+	// Remember the polled memory. Reading memory with read watcher can
+	// have side effects or return different value every time.
+	m_reads.clear();
+	m_readIndex.clear();
+	for (std::vector<IdleLoop::Entry>::const_iterator it = loop->entries.begin(); it != loop->entries.end(); ++it) {
+		const DecodedInstruction &d = *it->decoded;
+		m_readIndex.push_back(m_reads.size());
+
+		for (int arg = 0; arg < 2; ++arg) {
+			uint8_t type = arg == 0 ? d.srcType : d.dstType;
+			uint8_t reg = arg == 0 ? d.srcReg : d.dstReg;
+			uint16_t value = arg == 0 ? d.srcValue : d.dstValue;
+
+			uint16_t address;
+			if (type == DecodedInstruction::ArgAbsolute) {
+				address = value;
+			}
+			else if (type == DecodedInstruction::ArgIndexed) {
+				address = (reg == 0 ? it->pc + d.length : m_reg->getp(reg)->getBigEndian()) + value;
+			}
+			else {
+				continue;
+			}
+
+			for (int i = 0; i < (d.bw ? 1 : 2); ++i) {
+				if (m_mem->isWatched(address + i, MemoryWatcher::Read)) {
+					return false;
+				}
+				m_reads.push_back(std::make_pair(address + i, m_mem->getByte(address + i, false)));
+			}
+		}
+	}
+	m_readIndex.push_back(m_reads.size());
+
+	// Execute two iterations to find out how the registers change and
+	// restore the original state then.
+	m_loop = loop;
+	bool valid = runIteration(m_first) && runIteration(m_next);
+	restore(m_first[0]);
+
+	if (valid && loop->counter == -1) {
+		// Polling loop has to end in the same state in every iteration
+		valid = sameState(m_first.back(), m_next.back());
+		m_iterations = (unsigned int) -1;
+	}
+	else if (valid) {
+		// Delay loop ends when the jnz is not taken. It is executed
+		// in the normal way then.
+		m_counterStart = m_first[0].values[loop->counter];
+		m_counterStep = m_first.back().values[loop->counter] - m_counterStart;
+		m_iterations = (unsigned int) -1;
+
+		uint16_t counter = m_counterStart;
+		for (unsigned int i = 0; i < 65536; ++i) {
+			counter += m_counterStep;
+			if (counter == 0) {
+				m_iterations = i;
+				break;
+			}
+		}
+	}
+
+	if (!valid || m_iterations == 0) {
+		m_loop = 0;
+		return false;
+	}
+
+	m_iteration = 0;
+	m_index = 0;
+	m_elapsed = 0;
+	m_period = 0;
+	for (std::vector<IdleLoop::Entry>::const_iterator it = loop->entries.begin(); it != loop->entries.end(); ++it) {
+		m_period += it->decoded->cycles;
+	}
+	return true;
+}
+
+bool IdleLoopExecutor::polledMemoryChanged(unsigned int index) {
+	for (unsigned int i = m_readIndex[index]; i < m_readIndex[index + 1]; ++i) {
+		if (m_mem->getByte(m_reads[i].first, false) != m_reads[i].second) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void IdleLoopExecutor::restoreState(unsigned int iteration, unsigned int index) {
+	// Registers of the polling loop are the same in every iteration except
+	// the first one, which can start with different flags.
+	if (m_loop->counter == -1) {
+		restore(iteration == 0 ? m_first[index] : m_next[index]);
+		return;
+	}
+
+	// Only the counter and flags of delay loop change, so compute them by
+	// executing the counter instruction with the right counter value.
+	restore(m_first[0]);
+	if (iteration == 0 && index == 0) {
+		return;
+	}
+
+	const IdleLoop::Entry &entry = m_loop->entries[0];
+	unsigned int executed = index == 0 ? iteration - 1 : iteration;
+	RegisterFile *file = m_reg->getRegisterFile();
+	file->values[m_loop->counter] = m_counterStart + executed * m_counterStep;
+	file->values[0] = entry.pc + entry.decoded->length;
+	entry.handler(m_reg, m_mem, *entry.decoded);
+	if (index == 0) {
+		file->values[0] = entry.pc;
+	}
+}
+
+IdleLoopExecutor::Result IdleLoopExecutor::tick() {
+	const IdleLoop::Entry &entry = m_loop->entries[m_index];
+	if (++m_elapsed < entry.decoded->cycles) {
+		return Running;
+	}
+
+	// The instruction would be executed in this cycle, so it has to be
+	// really executed if the memory it reads has changed.
+	if (polledMemoryChanged(m_index)) {
+		restoreState(m_iteration, m_index);
+		m_elapsed = entry.decoded->cycles - 1;
+		m_loop = 0;
+		return Execute;
+	}
+
+	m_elapsed = 0;
+	if (++m_index == m_loop->entries.size()) {
+		m_index = 0;
+		// Only the first iteration of polling loop differs from the others
+		if (m_loop->counter != -1 || m_iteration == 0) {
+			m_iteration++;
+		}
+
+		// Let the last iteration of delay loop execute normally
+		if (m_iteration == m_iterations) {
+			restoreState(m_iteration, 0);
+			m_loop = 0;
+			return Resume;
+		}
+	}
+
+	if (m_intManager->hasQueuedInterrupts()) {
+		restoreState(m_iteration, m_index);
+		m_loop = 0;
+		return Resume;
+	}
+
+	return Running;
+}
+
+uint64_t IdleLoopExecutor::getPosition() {
+	uint64_t position = (uint64_t) m_iteration * m_period + m_elapsed;
+	for (unsigned int i = 0; i < m_index; ++i) {
+		position += m_loop->entries[i].decoded->cycles;
+	}
+	return position;
+}
+
+uint64_t IdleLoopExecutor::getSkippableCycles() {
+	// The loop is left within the next iteration
+	if (m_intManager->hasQueuedInterrupts()) {
+		return 0;
+	}
+	for (unsigned int i = 0; i < m_loop->entries.size(); ++i) {
+		if (polledMemoryChanged(i)) {
+			return 0;
+		}
+	}
+
+	if (m_loop->counter == -1) {
+		return (uint64_t) -1;
+	}
+
+	// The last cycle of the iteration before the last one returns Resume
+	return (uint64_t) m_iterations * m_period - getPosition() - 1;
+}
+
+void IdleLoopExecutor::skip(uint64_t cycles) {
+	uint64_t position = getPosition() + cycles;
+
+	// Only the first iteration of polling loop differs from the others
+	uint64_t iteration = position / m_period;
+	if (m_loop->counter == -1 && iteration > 1) {
+		iteration = 1;
+	}
+	m_iteration = iteration;
+
+	unsigned int elapsed = position % m_period;
+	m_index = 0;
+	while (elapsed >= (unsigned int) m_loop->entries[m_index].decoded->cycles) {
+		elapsed -= m_loop->entries[m_index].decoded->cycles;
+		m_index++;
+	}
+	m_elapsed = elapsed;
+}
+
+int IdleLoopExecutor::leave() {
+	if (!m_loop) {
+		return 0;
+	}
+
+	restoreState(m_iteration, m_index);
+	m_loop = 0;
+	return m_elapsed;
+}
+
+}
@@ -0,0 +1,155 @@
+/**
+ * QSimKit - MSP430 simulator
+ * Copyright (C) 2013 Jan "HanzZ" Kaluza (hanzz.k@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "CPU/Instructions/SpecializedInstructions.h"
+#include "CPU/Memory/RegisterFile.h"
+
+namespace MSP430 {
+
+class RegisterSet;
+class Memory;
+class InstructionDecoder;
+class InterruptManager;
+class DecodedInstruction;
+
+/// Loop which does not change anything except the flags and optionally
+/// a single counter register.
+class IdleLoop {
+	public:
+		class Entry {
+			public:
+				uint16_t pc;
+				const DecodedInstruction *decoded;
+				SpecializedCallback handler;
+		};
+
+		IdleLoop() : generation(0), valid(false), counter(-1) {}
+
+		unsigned int generation;
+		bool valid;
+		/// Register decremented or incremented by the delay loop, or -1
+		/// for the polling loops.
+		int counter;
+		std::vector<Entry> entries;
+};
+
+/// Skips the idle loops, like "jmp $", polling loops "bit #X, &IFG; jz $-4"
+/// or delay loops "dec r15; jnz $-2".
+///
+/// When the current PC is the start of such loop, enter() verifies the loop
+/// and stops executing its instructions. tick() is then called every MCLK
+/// cycle and only counts the cycles of the skipped instructions. When
+/// nothing can change the polled memory or queue an interrupt for some
+/// time, skip() counts all the cycles of that time at once. Registers
+/// are restored to the exact state once the loop is left, which happens
+/// when an interrupt is queued, the polled memory changes, the delay loop
+/// counter is about to reach zero, or leave() is called.
+class IdleLoopExecutor {
+	public:
+		typedef enum {
+			/// Loop is still being skipped.
+			Running,
+			/// Registers are restored to the state before the instruction at
+			/// PC, which has to be decoded and executed in this cycle.
+			/// getElapsedCycles() cycles of the instruction already passed.
+			Execute,
+			/// Registers are restored to the state after the instruction
+			/// executed in this cycle. Interrupts have to be handled and the
+			/// next instruction decoded.
+			Resume,
+		} Result;
+
+		IdleLoopExecutor(RegisterSet *reg, Memory *mem, InstructionDecoder *decoder, InterruptManager *intManager);
+		virtual ~IdleLoopExecutor();
+
+		/// Starts skipping the loop starting at current PC. Returns false
+		/// if there is no idle loop at current PC.
+		bool enter();
+
+		bool isActive() {
+			return m_loop != 0;
+		}
+
+		/// Advances the skipped loop by one cycle.
+		Result tick();
+
+		/// Returns the number of following cycles for which tick() returns
+		/// Running if nothing changes in the meantime, or (uint64_t) -1 when
+		/// the loop runs until it is left. Returns 0 when the polled memory
+		/// has already changed or an interrupt is queued.
+		uint64_t getSkippableCycles();
+
+		/// Advances the skipped loop by the given number of cycles at once.
+		/// The caller has to make sure that the polled memory has not changed
+		/// and no interrupt has been queued in these cycles, and that there
+		/// are at most getSkippableCycles() of them.
+		void skip(uint64_t cycles);
+
+		/// Stops skipping the loop and restores the registers to the state
+		/// before the instruction at PC. Returns number of cycles of this
+		/// instruction which already passed.
+		int leave();
+
+		int getElapsedCycles() {
+			return m_elapsed;
+		}
+
+	private:
+		IdleLoop *getLoop(uint16_t pc);
+		void buildLoop(uint16_t pc, IdleLoop *loop);
+		bool runIteration(std::vector<RegisterFile> &states);
+		bool polledMemoryChanged(unsigned int index);
+		void restore(const RegisterFile &state);
+		void restoreState(unsigned int iteration, unsigned int index);
+		uint64_t getPosition();
+
+	private:
+		RegisterSet *m_reg;
+		Memory *m_mem;
+		InstructionDecoder *m_decoder;
+		InterruptManager *m_intManager;
+		// Loops indexed by PC / 2
+		std::vector<IdleLoop *> m_loops;
+		// Loop which is being skipped
+		IdleLoop *m_loop;
+		// Registers before each instruction in the first and later iterations
+		std::vector<RegisterFile> m_first;
+		std::vector<RegisterFile> m_next;
+		// Polled memory as (address, value) pairs and index of the first
+		// pair read by each instruction
+		std::vector<std::pair<uint16_t, uint8_t> > m_reads;
+		std::vector<unsigned int> m_readIndex;
+		uint16_t m_counterStart;
+		uint16_t m_counterStep;
+		unsigned int m_iterations;
+		unsigned int m_iteration;
+		unsigned int m_index;
+		int m_elapsed;
+		// Cycles of one iteration
+		unsigned int m_period;
+};
+
+}
@@ -35,7 +35,7 @@ uint16_t IndexedArgument::get() {
 }
 
 uint16_t IndexedArgument::getBigEndian() {
-	return m_mem->getBigEndian(m_reg->getBigEndian() + m_offset);
+	return m_mem->getWord(m_reg->getBigEndian() + m_offset);
 }
 
 void IndexedArgument::set(uint16_t value) {
@@ -43,7 +43,7 @@ void IndexedArgument::set(uint16_t value) {
 }
 
 void IndexedArgument::setBigEndian(uint16_t value) {
-	m_mem->setBigEndian(m_reg->getBigEndian() + m_offset, value);
+	m_mem->setWord(m_reg->getBigEndian() + m_offset, value);
 }
 
 uint8_t IndexedArgument::getByte() {
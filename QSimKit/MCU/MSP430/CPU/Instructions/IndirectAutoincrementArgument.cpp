@@ -40,7 +40,7 @@ uint16_t IndirectAutoincrementArgument::get() {
 }
 
 uint16_t IndirectAutoincrementArgument::getBigEndian() {
-	uint16_t r = m_mem->getBigEndian(m_reg->getBigEndian());
+	uint16_t r = m_mem->getWord(m_reg->getBigEndian());
 	m_reg->setBigEndian(m_reg->getBigEndian() + (m_bw ? 1 : 2));
 	return r;
 }
@@ -43,16 +43,25 @@ namespace MSP430 {
 #define IS_INSTRUCTION_COND(X) (X & INSTRUCTION_COND_MASK == INSTRUCTION_COND_MAGIC)
 
 InstructionDecoder::InstructionDecoder(RegisterSet *reg, Memory *mem) :
-m_reg(reg), m_mem(mem) {
+m_reg(reg), m_mem(mem), m_generation(0) {
 	m_srcMemArg = new MemoryArgument(mem, 0);
 	m_srcConstArg = new ConstantArgument(0);
 	m_srcIndexedArg = new IndexedArgument(mem, 0, 0);
 	m_srcIndirectAutoArg = new IndirectAutoincrementArgument(mem, 0, 0);
 	m_dstMemArg = new MemoryArgument(mem, 0);
 	m_dstIndexedArg = new IndexedArgument(mem, 0, 0);
+
+	m_cache.resize(32768);
+	m_watched.resize(65536);
 }
 
 InstructionDecoder::~InstructionDecoder() {
+	for (unsigned int address = 0; address < m_watched.size(); ++address) {
+		if (m_watched[address]) {
+			m_mem->removeWatcher(address, this, MemoryWatcher::Write);
+		}
+	}
+
 	delete m_srcMemArg;
 	delete m_srcConstArg;
 	delete m_srcIndexedArg;
@@ -61,57 +70,84 @@ InstructionDecoder::~InstructionDecoder() {
 	delete m_dstIndexedArg;
 }
 
-InstructionArgument *InstructionDecoder::getSourceArg(int &cycles, uint16_t &pc, bool bw, uint8_t as, uint8_t source_reg) {
-	InstructionArgument *arg = 0;
+void InstructionDecoder::invalidateCache() {
+	for (std::vector<DecodedInstruction>::iterator it = m_cache.begin(); it != m_cache.end(); ++it) {
+		it->valid = false;
+	}
+	m_generation++;
+}
+
+void InstructionDecoder::handleMemoryChanged(::Memory *memory, uint16_t address) {
+	// Instruction has at most 3 words, so the write can modify instruction
+	// starting at this word or at one of two previous words.
+	int word = address >> 1;
+	for (int i = word; i >= 0 && i > word - 3; --i) {
+		DecodedInstruction &d = m_cache[i];
+		if (d.valid && (i << 1) + d.length > address) {
+			d.valid = false;
+			m_generation++;
+		}
+	}
+}
+
+void InstructionDecoder::watchInstruction(uint16_t pc, uint8_t length) {
+	for (unsigned int address = pc; address < (unsigned int) pc + length && address < m_watched.size(); ++address) {
+		if (!m_watched[address]) {
+			m_mem->addWatcher(address, this, MemoryWatcher::Write);
+			m_watched[address] = true;
+		}
+	}
+}
+
+void InstructionDecoder::decodeSourceArg(DecodedInstruction &d, uint16_t &pc, uint8_t as, uint8_t source_reg) {
+	d.srcType = DecodedInstruction::ArgNone;
+	d.srcReg = source_reg;
 
 	if (source_reg == 2) {
 		switch (as) {
 			// Normal access
 			case 0:
-				arg = m_reg->getp(2);
+				d.srcType = DecodedInstruction::ArgRegister;
 				break;
 			// Absolute mode
 			case 1:
-				arg = m_srcMemArg;
-				m_srcMemArg->reinitialize(m_mem->getBigEndian(pc));
+				d.srcType = DecodedInstruction::ArgAbsolute;
+				d.srcValue = m_mem->getWord(pc);
 				pc += 2;
-				cycles += 2; // fetch + read from memory
+				d.cycles += 2; // fetch + read from memory
 				break;
 			// Const 4
 			case 2:
-				arg = m_srcConstArg;
-				m_srcConstArg->reinitialize(0x0400);
+				d.srcType = DecodedInstruction::ArgConstant;
+				d.srcValue = 4;
 				break;
 			// Const 8
 			case 3:
-				arg = m_srcConstArg;
-				m_srcConstArg->reinitialize(0x0800);
+				d.srcType = DecodedInstruction::ArgConstant;
+				d.srcValue = 8;
 				break;
 			default:
 				break;
 		}
 	}
 	else if (source_reg == 3) {
+		d.srcType = DecodedInstruction::ArgConstant;
 		switch (as) {
 			// Const 0
 			case 0:
-				arg = m_srcConstArg;
-				m_srcConstArg->reinitialize(0);
+				d.srcValue = 0;
 				break;
 			// Const 1
 			case 1:
-				arg = m_srcConstArg;
-				m_srcConstArg->reinitialize(0x0100);
+				d.srcValue = 1;
 				break;
 			// Const 2
 			case 2:
-				arg = m_srcConstArg;
-				m_srcConstArg->reinitialize(0x0200);
+				d.srcValue = 2;
 				break;
 			// Const -1
 			case 3:
-				arg = m_srcConstArg;
-				m_srcConstArg->reinitialize(0xffff);
+				d.srcValue = 0xffff;
 				break;
 			default:
 				break;
@@ -121,107 +157,138 @@ InstructionArgument *InstructionDecoder::getSourceArg(int &cycles, uint16_t &pc,
 		switch (as) {
 			// Register direct
 			case 0:
-				arg = m_reg->getp(source_reg);
+				d.srcType = DecodedInstruction::ArgRegister;
 				break;
 			// Indexed mode
 			case 1:
-				arg = m_srcIndexedArg;
-				m_srcIndexedArg->reinitialize(m_reg->getp(source_reg), m_mem->getBigEndian(pc));
+				d.srcType = DecodedInstruction::ArgIndexed;
+				d.srcValue = m_mem->getWord(pc);
 				pc += 2;
-				cycles += 2; // fetch + read
+				d.cycles += 2; // fetch + read
 				break;
 			// Indirect
 			case 2:
 				// simulate Indirect with indexed with offset 0
-				arg = m_srcIndexedArg;
-				m_srcIndexedArg->reinitialize(m_reg->getp(source_reg), 0);
-				cycles += 1; // target mem read
+				d.srcType = DecodedInstruction::ArgIndexed;
+				d.srcValue = 0;
+				d.cycles += 1; // target mem read
 				break;
 			case 3:
 				if (source_reg == 0) {
 					// Immediate mode
-					arg = m_srcConstArg;
-					m_srcConstArg->reinitialize(m_mem->get(pc));
+					d.srcType = DecodedInstruction::ArgConstant;
+					d.srcValue = m_mem->getWord(pc);
 					pc += 2;
-					cycles += 1; // fetch
+					d.cycles += 1; // fetch
 				}
 				else {
 					// Indirect autoincrement
-					arg = m_srcIndirectAutoArg;
-					m_srcIndirectAutoArg->reinitialize(m_reg->getp(source_reg), bw);
-					cycles += 1; // read
+					d.srcType = DecodedInstruction::ArgIndirectAutoincrement;
+					d.cycles += 1; // read
 				}
 				break;
 			default:
 				break;
 		}
 	}
-
-	return arg;
 }
 
-InstructionArgument *InstructionDecoder::getDestArg(int &cycles, uint16_t &pc, bool bw, uint8_t ad, uint8_t dest_reg) {
-	InstructionArgument *arg = 0;
+void InstructionDecoder::decodeDestArg(DecodedInstruction &d, uint16_t &pc, uint8_t ad, uint8_t dest_reg) {
+	d.dstReg = dest_reg;
 
 	if (ad == 0) {
-		arg = m_reg->getp(dest_reg);
+		d.dstType = DecodedInstruction::ArgRegister;
 		if (dest_reg == 0) {
-			cycles += 1; // Modifying PC needs 1 more cycle
+			d.cycles += 1; // Modifying PC needs 1 more cycle
 		}
 	}
 	else {
 		if (dest_reg == 2) {
 			// Absolute address
-			arg = m_dstMemArg;
-			m_dstMemArg->reinitialize(m_mem->getBigEndian(pc));
+			d.dstType = DecodedInstruction::ArgAbsolute;
+			d.dstValue = m_mem->getWord(pc);
 			pc += 2;
-			cycles += 3; // fetch, read from memory, write back
+			d.cycles += 3; // fetch, read from memory, write back
 		}
 		else {
 			// Indexed
-			arg = m_dstIndexedArg;
-			m_dstIndexedArg->reinitialize(m_reg->getp(dest_reg), m_mem->getBigEndian(pc));
+			d.dstType = DecodedInstruction::ArgIndexed;
+			d.dstValue = m_mem->getWord(pc);
 			pc += 2;
-			cycles += 3; // fetch, read from memory, write back
+			d.cycles += 3; // fetch, read from memory, write back
 		}
 	}
+}
 
-	return arg;
+InstructionArgument *InstructionDecoder::getSourceArg(const DecodedInstruction &d) {
+	switch (d.srcType) {
+		case DecodedInstruction::ArgRegister:
+			return m_reg->getp(d.srcReg);
+		case DecodedInstruction::ArgConstant:
+			m_srcConstArg->reinitialize(d.srcValue);
+			return m_srcConstArg;
+		case DecodedInstruction::ArgAbsolute:
+			m_srcMemArg->reinitialize(d.srcValue);
+			return m_srcMemArg;
+		case DecodedInstruction::ArgIndexed:
+			m_srcIndexedArg->reinitialize(m_reg->getp(d.srcReg), d.srcValue);
+			return m_srcIndexedArg;
+		case DecodedInstruction::ArgIndirectAutoincrement:
+			m_srcIndirectAutoArg->reinitialize(m_reg->getp(d.srcReg), d.bw);
+			return m_srcIndirectAutoArg;
+		default:
+			return 0;
+	}
 }
 
-int InstructionDecoder::decodeCurrentInstruction(Instruction *instruction) {
-	Register *pc_reg = m_reg->getp(0);
-	uint16_t pc = pc_reg->getBigEndian();
-	instruction->original_pc = pc;
+InstructionArgument *InstructionDecoder::getDestArg(const DecodedInstruction &d) {
+	switch (d.dstType) {
+		case DecodedInstruction::ArgRegister:
+			return m_reg->getp(d.dstReg);
+		case DecodedInstruction::ArgAbsolute:
+			m_dstMemArg->reinitialize(d.dstValue);
+			return m_dstMemArg;
+		case DecodedInstruction::ArgIndexed:
+			m_dstIndexedArg->reinitialize(m_reg->getp(d.dstReg), d.dstValue);
+			return m_dstIndexedArg;
+		default:
+			return 0;
+	}
+}
 
-	uint16_t data = m_mem->getBigEndian(pc);
-	int cycles = 1; // instruction fetch
+void InstructionDecoder::decodeInstruction(uint16_t pc, DecodedInstruction &d) {
+	uint16_t start = pc;
+	uint16_t data = m_mem->getWord(pc);
+	d.cycles = 1; // instruction fetch
+	d.srcType = DecodedInstruction::ArgNone;
+	d.dstType = DecodedInstruction::ArgNone;
+	d.offset = 0;
+	d.bw = false;
 	pc += 2;
 
 	if ((data & 0xf000) == 0x1000) {
 		// Single operand instructions
-		instruction->type = Instruction1;
-		instruction->opcode = (data >>7) & 7;
+		d.type = Instruction1;
+		d.opcode = (data >>7) & 7;
 		uint8_t dest_reg = data & 15;
 		uint8_t ad = (data >> 4) & 3;
-		bool bw = (data >> 6) & 1;
+		d.bw = (data >> 6) & 1;
 
-		InstructionArgument *dst = getSourceArg(cycles, pc, bw, ad, dest_reg);
-		instruction->setDst(dst);
+		// Single operand can use all the source addressing modes,
+		// so decode it as source and use it as destination later.
+		decodeSourceArg(d, pc, ad, dest_reg);
 
-		switch (instruction->opcode) {
-			case 4: cycles += 3; break;
-			case 5: cycles += 3; break;
-			case 6: cycles += 4; break;
+		switch (d.opcode) {
+			case 4: d.cycles += 3; break;
+			case 5: d.cycles += 3; break;
+			case 6: d.cycles += 4; break;
 			default: break;
 		}
-
-		instruction->bw = bw;
 	}
 	else if ((data & 0xe000) == 0x2000) {
 		// Jump instructions
-		instruction->type = InstructionCond;
-		instruction->opcode = (data >>10) & 7;
+		d.type = InstructionCond;
+		d.opcode = (data >>10) & 7;
 
 		int16_t offset = ((data & 0x3ff) << 1); // PC offset * 2
 		// negative offset
@@ -229,32 +296,76 @@ int InstructionDecoder::decodeCurrentInstruction(Instruction *instruction) {
 			offset = -((~offset + 1) & 0x7ff);
 		}
 
-		instruction->offset = offset; // + 2; // PC_new = PC_old + offset * 2 + 2
-		cycles += 1;
+		d.offset = offset; // + 2; // PC_new = PC_old + offset * 2 + 2
+		d.cycles += 1;
 	}
 	else {
 		// Two operand instructions
-		instruction->type = Instruction2;
-		instruction->opcode = data >>12;
+		d.type = Instruction2;
+		d.opcode = data >>12;
 		uint8_t dest_reg = data & 15;
 		uint8_t source_reg = (data >> 8) & 15;
 
 		uint8_t as = (data >> 4) & 3;
 		uint8_t ad = (data >> 7) & 1;
-		bool bw = (data >> 6) & 1;
+		d.bw = (data >> 6) & 1;
 
-		InstructionArgument *src = getSourceArg(cycles, pc, bw, as, source_reg);
-		instruction->setSrc(src);
+		decodeSourceArg(d, pc, as, source_reg);
+		decodeDestArg(d, pc, ad, dest_reg);
+	}
 
-		InstructionArgument *dst = getDestArg(cycles, pc, bw, ad, dest_reg);
-		instruction->setDst(dst);
+	d.length = pc - start;
+	d.valid = true;
+}
 
-		instruction->bw = bw;
+const DecodedInstruction &InstructionDecoder::decode(uint16_t pc) {
+	DecodedInstruction &d = m_cache[pc >> 1];
+	if (!d.valid) {
+		decodeInstruction(pc, d);
+		watchInstruction(pc, d.length);
 	}
+	return d;
+}
 
-	instruction->pc = pc;
+void InstructionDecoder::bindInstruction(uint16_t pc, const DecodedInstruction &d, Instruction *instruction) {
+	instruction->original_pc = pc;
+	instruction->type = (InstructionType) d.type;
+	instruction->opcode = d.opcode;
+	instruction->bw = d.bw;
+
+	switch (d.type) {
+		case Instruction1:
+			instruction->setDst(getSourceArg(d));
+			break;
+		case InstructionCond:
+			instruction->offset = d.offset;
+			break;
+		case Instruction2:
+			instruction->setSrc(getSourceArg(d));
+			instruction->setDst(getDestArg(d));
+			break;
+		default:
+			break;
+	}
+
+	instruction->pc = pc + d.length;
+}
+
+int InstructionDecoder::decodeCurrentInstruction(Instruction *instruction) {
+	uint16_t pc = m_reg->getp(0)->getBigEndian();
+
+	if (pc & 1) {
+		// Instructions are always word aligned, do not cache this
+		// invalid one.
+		DecodedInstruction d;
+		decodeInstruction(pc, d);
+		bindInstruction(pc, d, instruction);
+		return d.cycles;
+	}
 
-	return cycles;
+	const DecodedInstruction &d = decode(pc);
+	bindInstruction(pc, d, instruction);
+	return d.cycles;
 }
 
 }
@@ -24,6 +24,7 @@
 #include <vector>
 
 #include "CPU/Instructions/InstructionManager.h"
+#include "CPU/Memory/Memory.h"
 
 namespace MSP430 {
 
@@ -36,20 +37,82 @@ class ConstantArgument;
 class IndexedArgument;
 class IndirectAutoincrementArgument;
 
-class InstructionDecoder {
+/// Instruction decoded from the memory. It stores everything needed to
+/// construct the Instruction again without reading the opcode words.
+class DecodedInstruction {
+	public:
+		typedef enum {
+			ArgNone,
+			ArgRegister,
+			ArgConstant,
+			ArgAbsolute,
+			ArgIndexed,
+			ArgIndirectAutoincrement,
+		} ArgumentType;
+
+		DecodedInstruction() : valid(false) {}
+
+		bool valid;
+		uint8_t type;
+		uint8_t opcode;
+		bool bw;
+		uint8_t length;
+		uint8_t cycles;
+		uint8_t srcType;
+		uint8_t srcReg;
+		uint8_t dstType;
+		uint8_t dstReg;
+		int16_t offset;
+		uint16_t srcValue;
+		uint16_t dstValue;
+};
+
+class InstructionDecoder : public MemoryWatcher {
 	public:
 		InstructionDecoder(RegisterSet *reg, Memory *mem);
 		virtual ~InstructionDecoder();
 
 		int decodeCurrentInstruction(Instruction *instruction);
 
+		/// Returns cached decoded instruction for given even PC. It is decoded
+		/// first if it is not cached yet.
+		const DecodedInstruction &decode(uint16_t pc);
+
+		/// Initializes Instruction from the decoded instruction located at PC.
+		void bindInstruction(uint16_t pc, const DecodedInstruction &d, Instruction *instruction);
+
+		/// Returns number increased every time a cached instruction is
+		/// invalidated.
+		unsigned int getGeneration() {
+			return m_generation;
+		}
+
+		/// Drops all cached instructions. Has to be called when the code
+		/// is loaded without using the watched Memory methods.
+		void invalidateCache();
+
+		void handleMemoryChanged(::Memory *memory, uint16_t address);
+
+		/// Decodes the instruction at PC without caching it, so the memory
+		/// is not watched. Used to disassemble the code.
+		void decodeInstruction(uint16_t pc, DecodedInstruction &d);
+
 	private:
-		InstructionArgument *getSourceArg(int &cycles, uint16_t &pc, bool bw, uint8_t as, uint8_t source_reg);
-		InstructionArgument *getDestArg(int &cycles, uint16_t &pc, bool bw, uint8_t ad, uint8_t dest_reg);
+		void decodeSourceArg(DecodedInstruction &d, uint16_t &pc, uint8_t as, uint8_t source_reg);
+		void decodeDestArg(DecodedInstruction &d, uint16_t &pc, uint8_t ad, uint8_t dest_reg);
+		void watchInstruction(uint16_t pc, uint8_t length);
+
+		InstructionArgument *getSourceArg(const DecodedInstruction &d);
+		InstructionArgument *getDestArg(const DecodedInstruction &d);
 
 	private:
 		RegisterSet *m_reg;
 		Memory *m_mem;
+		// Decoded instructions indexed by PC / 2
+		std::vector<DecodedInstruction> m_cache;
+		// Addresses we have registered MemoryWatcher for
+		std::vector<bool> m_watched;
+		unsigned int m_generation;
 		MemoryArgument *m_srcMemArg;
 		ConstantArgument *m_srcConstArg;
 		IndexedArgument *m_srcIndexedArg;
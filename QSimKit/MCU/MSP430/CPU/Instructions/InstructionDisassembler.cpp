@@ -0,0 +1,224 @@
+/**
+ * QSimKit - MSP430 simulator
+ * Copyright (C) 2013 Jan "HanzZ" Kaluza (hanzz.k@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#include "CPU/Instructions/InstructionDisassembler.h"
+#include "CPU/Instructions/InstructionDecoder.h"
+#include "CPU/Instructions/InstructionManager.h"
+#include "CPU/Memory/Memory.h"
+
+#include <stdio.h>
+
+namespace MSP430 {
+
+static std::string hex(uint16_t value) {
+	char buf[8];
+	snprintf(buf, sizeof(buf), "0x%04x", value);
+	return buf;
+}
+
+static std::string reg(uint8_t r) {
+	char buf[4];
+	snprintf(buf, sizeof(buf), "r%d", r);
+	return buf;
+}
+
+static std::string constant(uint16_t value) {
+	if (value == 0xffff) {
+		return "#-1";
+	}
+	if (value < 10) {
+		char buf[4];
+		snprintf(buf, sizeof(buf), "#%d", value);
+		return buf;
+	}
+	return "#" + hex(value);
+}
+
+static std::string indexed(uint16_t offset, uint8_t r) {
+	char buf[16];
+	snprintf(buf, sizeof(buf), "%d(r%d)", (int16_t) offset, r);
+	return buf;
+}
+
+static std::string suffix(const char *name, bool bw) {
+	return bw ? std::string(name) + ".b" : std::string(name);
+}
+
+InstructionDisassembler::InstructionDisassembler(Memory *mem, InstructionDecoder *decoder) :
+m_mem(mem), m_decoder(decoder) {
+}
+
+std::string InstructionDisassembler::getSource(const DecodedInstruction &d, uint16_t word, uint16_t extension) {
+	uint8_t as = (word >> 4) & 3;
+	switch (d.srcType) {
+		case DecodedInstruction::ArgRegister:
+			return reg(d.srcReg);
+		case DecodedInstruction::ArgConstant:
+			return constant(d.srcValue);
+		case DecodedInstruction::ArgAbsolute:
+			return "&" + hex(d.srcValue);
+		case DecodedInstruction::ArgIndexed:
+			// Indirect register mode is decoded as indexed with zero offset
+			if (as == 2) {
+				return "@" + reg(d.srcReg);
+			}
+			// Symbolic mode is relative to the extension word
+			if (d.srcReg == 0) {
+				return hex(extension + d.srcValue);
+			}
+			return indexed(d.srcValue, d.srcReg);
+		case DecodedInstruction::ArgIndirectAutoincrement:
+			return "@" + reg(d.srcReg) + "+";
+		default:
+			return "";
+	}
+}
+
+std::string InstructionDisassembler::getDestination(const DecodedInstruction &d, uint16_t extension) {
+	switch (d.dstType) {
+		case DecodedInstruction::ArgRegister:
+			return reg(d.dstReg);
+		case DecodedInstruction::ArgAbsolute:
+			return "&" + hex(d.dstValue);
+		case DecodedInstruction::ArgIndexed:
+			if (d.dstReg == 0) {
+				return hex(extension + d.dstValue);
+			}
+			return indexed(d.dstValue, d.dstReg);
+		default:
+			return "";
+	}
+}
+
+const char *InstructionDisassembler::getEmulated(const DecodedInstruction &d, bool &operand) {
+	class Emulated {
+		public:
+			uint8_t opcode;
+			uint16_t value;
+			const char *name;
+	};
+
+	// Two operand instructions with constant source and the same destination
+	static const Emulated constants[] = {
+		{4, 0, "clr"}, {5, 1, "inc"}, {5, 2, "incd"}, {6, 0, "adc"}, {7, 0, "sbc"},
+		{8, 1, "dec"}, {8, 2, "decd"}, {9, 0, "tst"}, {14, 0xffff, "inv"},
+	};
+
+	// bic and bis with constant source and SR as destination
+	static const Emulated flags[] = {
+		{12, 1, "clrc"}, {12, 2, "clrz"}, {12, 4, "clrn"}, {12, 8, "dint"},
+		{13, 1, "setc"}, {13, 2, "setz"}, {13, 4, "setn"}, {13, 8, "eint"},
+	};
+
+	bool dstRegister = d.dstType == DecodedInstruction::ArgRegister;
+	operand = false;
+	if (d.opcode == 4 && d.srcType == DecodedInstruction::ArgIndirectAutoincrement && d.srcReg == 1) {
+		operand = !dstRegister || d.dstReg != 0;
+		return operand ? "pop" : "ret";
+	}
+
+	if (d.srcType == DecodedInstruction::ArgConstant) {
+		if (d.opcode == 4 && d.srcValue == 0 && dstRegister && d.dstReg == 3) {
+			return "nop";
+		}
+
+		if (dstRegister && d.dstReg == 2 && !d.bw) {
+			for (unsigned int i = 0; i < sizeof(flags) / sizeof(flags[0]); ++i) {
+				if (flags[i].opcode == d.opcode && flags[i].value == d.srcValue) {
+					return flags[i].name;
+				}
+			}
+		}
+
+		operand = true;
+		for (unsigned int i = 0; i < sizeof(constants) / sizeof(constants[0]); ++i) {
+			if (constants[i].opcode == d.opcode && constants[i].value == d.srcValue) {
+				return constants[i].name;
+			}
+		}
+	}
+
+	// add and addc of the register to itself
+	operand = true;
+	if (d.srcType == DecodedInstruction::ArgRegister && dstRegister && d.srcReg == d.dstReg) {
+		if (d.opcode == 5) {
+			return "rla";
+		}
+		if (d.opcode == 6) {
+			return "rlc";
+		}
+	}
+
+	return 0;
+}
+
+std::string InstructionDisassembler::disassemble(uint16_t pc, uint8_t &length) {
+	DecodedInstruction d;
+	m_decoder->decodeInstruction(pc, d);
+	uint16_t word = m_mem->getWord(pc, false);
+
+	_msp430_instruction *instruction = getInstruction((InstructionType) d.type, d.opcode);
+	if (!instruction) {
+		length = 2;
+		return ".word " + hex(word);
+	}
+
+	length = d.length;
+	switch (d.type) {
+		case InstructionCond:
+			return std::string(instruction->name) + " " + hex(pc + 2 + d.offset);
+		case Instruction1:
+			if (d.opcode == 6) {
+				return instruction->name;
+			}
+			return suffix(instruction->name, d.bw) + " " + getSource(d, word, pc + 2);
+		default:
+			break;
+	}
+
+	// Extension word of the destination follows the one of the source
+	bool srcExtension = d.length - 2 > (d.dstType == DecodedInstruction::ArgRegister ? 0 : 2);
+	std::string src = getSource(d, word, pc + 2);
+	std::string dst = getDestination(d, pc + (srcExtension ? 4 : 2));
+
+	bool operand;
+	const char *emulated = getEmulated(d, operand);
+	if (emulated) {
+		return operand ? suffix(emulated, d.bw) + " " + dst : std::string(emulated);
+	}
+
+	// mov src, pc
+	if (d.opcode == 4 && d.dstType == DecodedInstruction::ArgRegister && d.dstReg == 0) {
+		return "br " + src;
+	}
+
+	return suffix(instruction->name, d.bw) + " " + src + ", " + dst;
+}
+
+uint8_t InstructionDisassembler::getLength(uint16_t pc) {
+	DecodedInstruction d;
+	m_decoder->decodeInstruction(pc, d);
+	if (!getInstruction((InstructionType) d.type, d.opcode)) {
+		return 2;
+	}
+
+	return d.length;
+}
+
+}
@@ -0,0 +1,61 @@
+/**
+ * QSimKit - MSP430 simulator
+ * Copyright (C) 2013 Jan "HanzZ" Kaluza (hanzz.k@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+namespace MSP430 {
+
+class Memory;
+class InstructionDecoder;
+class DecodedInstruction;
+
+/// Converts the instructions in the memory to the assembler text. Operands
+/// are decoded by the InstructionDecoder and the mnemonics are taken from
+/// the instructions registered in the InstructionManager. Emulated
+/// instructions like "ret", "clr" or "inc" are shown the way msp430-objdump
+/// shows them.
+class InstructionDisassembler {
+	public:
+		InstructionDisassembler(Memory *mem, InstructionDecoder *decoder);
+
+		/// Returns the text of the instruction at pc and sets length to its
+		/// size in bytes. Unknown opcodes are shown as ".word" of length 2.
+		std::string disassemble(uint16_t pc, uint8_t &length);
+
+		/// Returns the size of the instruction at pc in bytes without
+		/// building its text.
+		uint8_t getLength(uint16_t pc);
+
+	private:
+		std::string getSource(const DecodedInstruction &d, uint16_t word, uint16_t extension);
+		std::string getDestination(const DecodedInstruction &d, uint16_t extension);
+
+		/// Returns the name of the emulated two operand instruction or 0.
+		/// operand is set to false if the instruction has no operand.
+		const char *getEmulated(const DecodedInstruction &d, bool &operand);
+
+	private:
+		Memory *m_mem;
+		InstructionDecoder *m_decoder;
+};
+
+}
@@ -44,9 +44,15 @@ void addInstruction(InstructionType type, unsigned int opcode, _msp430_instructi
 	std::cout << "Loaded instruction: " << (*instructions)[((int) type) * TYPE_OFFSET + opcode]->name << "\n";
 }
 
+_msp430_instruction *getInstruction(InstructionType type, unsigned int opcode) {
+	return (*instructions)[((int) type) * TYPE_OFFSET + opcode];
+}
+
 int executeInstruction(RegisterSet *reg, Memory *mem, Instruction *i) {
-	_msp430_instruction *instruction = (*instructions)[((int) i->type) * TYPE_OFFSET + i->opcode];
+	return executeInstruction(reg, mem, i, getInstruction(i->type, i->opcode));
+}
 
+int executeInstruction(RegisterSet *reg, Memory *mem, Instruction *i, _msp430_instruction *instruction) {
 	if (!instruction) {
 		return -1;
 	}
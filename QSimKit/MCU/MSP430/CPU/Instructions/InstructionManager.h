@@ -38,6 +38,12 @@ void addInstruction(InstructionType type, unsigned int opcode, _msp430_instructi
 
 int executeInstruction(RegisterSet *reg, Memory *mem, Instruction *instruction);
 
+/// Executes the instruction using already resolved handler.
+int executeInstruction(RegisterSet *reg, Memory *mem, Instruction *instruction, _msp430_instruction *handler);
+
+/// Returns handler of the instruction or 0 if the instruction is unknown.
+_msp430_instruction *getInstruction(InstructionType type, unsigned int opcode);
+
 class _msp430_instruction {
 	public:
 		_msp430_instruction(const char *name, InstructionType type, unsigned int opcode, InstructionCallback callback);
@@ -0,0 +1,640 @@
+/**
+ * QSimKit - MSP430 simulator
+ * Copyright (C) 2013 Jan "HanzZ" Kaluza (hanzz.k@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#include "CPU/Instructions/JITCompiler.h"
+#include "CPU/Instructions/InstructionDecoder.h"
+#include "CPU/Instructions/InstructionManager.h"
+#include "CPU/Memory/Memory.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#ifdef JIT_SUPPORTED
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace MSP430 {
+
+#ifdef JIT_SUPPORTED
+
+// x86-64 registers. Generated function gets RegisterFile in RDI, memory in
+// RSI and watched mask in RDX. Only caller-saved registers are used.
+#define RAX 0
+#define RCX 1
+#define RDX 2
+#define RSI 6
+#define RDI 7
+#define R8 8
+#define R9 9
+#define R10 10
+#define R11 11
+#define NO_INDEX -1
+
+// Registers holding the operands of the currently compiled instruction
+#define SRC_VALUE RCX
+#define SRC_ADDRESS R11
+#define DST_VALUE R8
+#define DST_ADDRESS R9
+#define RESULT R10
+
+// Opcodes of reg, reg instructions
+#define OP_ADD 0x01
+#define OP_OR 0x09
+#define OP_AND 0x21
+#define OP_XOR 0x31
+#define OP_MOV 0x89
+
+// Opcode extensions of reg, imm32 instructions
+#define EXT_ADD 0
+#define EXT_AND 4
+#define EXT_CMP 7
+
+// Condition codes of jcc
+#define CC_B 0x2
+#define CC_NZ 0x5
+
+#define VALUES(R) ((int32_t) (offsetof(RegisterFile, values) + 2 * (R)))
+
+/// Minimal x86-64 assembler emitting only the instructions used by JIT.
+class Assembler {
+	public:
+		void byte(uint8_t b) {
+			code.push_back(b);
+		}
+
+		void dword(uint32_t d) {
+			for (int i = 0; i < 4; ++i) {
+				code.push_back(d >> (8 * i));
+			}
+		}
+
+		void rex(bool w, int reg, int base, int index, bool force = false) {
+			uint8_t r = 0x40 | (w ? 8 : 0) | (reg & 8 ? 4 : 0) |
+				(index != NO_INDEX && (index & 8) ? 2 : 0) | (base & 8 ? 1 : 0);
+			if (r != 0x40 || force) {
+				byte(r);
+			}
+		}
+
+		// Emits ModRM for [base + index + disp] memory operand.
+		void modrm(int reg, int base, int index, int32_t disp) {
+			int mod = 2;
+			if (disp == 0 && (base & 7) != 5) {
+				mod = 0;
+			}
+			else if (disp >= -128 && disp <= 127) {
+				mod = 1;
+			}
+
+			if (index == NO_INDEX) {
+				byte(mod << 6 | (reg & 7) << 3 | (base & 7));
+				if ((base & 7) == 4) {
+					byte(0x24);
+				}
+			}
+			else {
+				byte(mod << 6 | (reg & 7) << 3 | 4);
+				byte((index & 7) << 3 | (base & 7));
+			}
+
+			if (mod == 1) {
+				byte(disp);
+			}
+			else if (mod == 2) {
+				dword(disp);
+			}
+		}
+
+		// Zero-extending load of 1, 2 or 4 bytes.
+		void load(int reg, int size, int base, int index, int32_t disp) {
+			rex(false, reg, base, index);
+			if (size == 4) {
+				byte(0x8b);
+			}
+			else {
+				byte(0x0f);
+				byte(size == 1 ? 0xb6 : 0xb7);
+			}
+			modrm(reg, base, index, disp);
+		}
+
+		void store(int reg, int size, int base, int index, int32_t disp) {
+			if (size == 2) {
+				byte(0x66);
+			}
+			// REX is needed to access low byte of RSI or RDI
+			rex(false, reg, base, index, size == 1);
+			byte(size == 1 ? 0x88 : 0x89);
+			modrm(reg, base, index, disp);
+		}
+
+		void storeImm8(int base, int32_t disp, uint8_t imm) {
+			rex(false, 0, base, NO_INDEX);
+			byte(0xc6);
+			modrm(0, base, NO_INDEX, disp);
+			byte(imm);
+		}
+
+		void testImm8(int base, int index, int32_t disp, uint8_t imm) {
+			rex(false, 0, base, index);
+			byte(0xf6);
+			modrm(0, base, index, disp);
+			byte(imm);
+		}
+
+		void movImm(int reg, uint32_t imm) {
+			rex(false, 0, reg, NO_INDEX);
+			byte(0xb8 + (reg & 7));
+			dword(imm);
+		}
+
+		void alu(uint8_t op, int dst, int src) {
+			rex(false, src, dst, NO_INDEX);
+			byte(op);
+			byte(0xc0 | (src & 7) << 3 | (dst & 7));
+		}
+
+		void aluImm(int ext, int reg, uint32_t imm) {
+			rex(false, 0, reg, NO_INDEX);
+			byte(0x81);
+			byte(0xc0 | ext << 3 | (reg & 7));
+			dword(imm);
+		}
+
+		void notReg(int reg) {
+			rex(false, 0, reg, NO_INDEX);
+			byte(0xf7);
+			byte(0xc0 | 2 << 3 | (reg & 7));
+		}
+
+		// rol r16, 8
+		void swapBytes(int reg) {
+			byte(0x66);
+			rex(false, 0, reg, NO_INDEX);
+			byte(0xc1);
+			byte(0xc0 | (reg & 7));
+			byte(8);
+		}
+
+		// Emits jcc rel32 and returns the position of rel32 to be patched.
+		unsigned int jcc(int cc) {
+			byte(0x0f);
+			byte(0x80 | cc);
+			dword(0);
+			return code.size() - 4;
+		}
+
+		void ret() {
+			byte(0xc3);
+		}
+
+		void patch(unsigned int pos, unsigned int target) {
+			uint32_t rel = target - (pos + 4);
+			memcpy(&code[pos], &rel, 4);
+		}
+
+		std::vector<uint8_t> code;
+};
+
+/// Compiles single basic block.
+class BlockCompiler {
+	public:
+		BlockCompiler(Assembler &a) : m_a(a) {}
+
+		void compile(const DecodedInstruction &d, uint16_t pc) {
+			m_exits.push_back(std::vector<unsigned int>());
+			m_next = pc + d.length;
+			m_size = d.bw ? 1 : 2;
+
+			if (d.type == Instruction2) {
+				compileTwoOperand(d);
+			}
+			else if (d.opcode == 1) {
+				compileSwpb(d);
+			}
+			else {
+				compilePush(d);
+			}
+		}
+
+		void finish() {
+			m_a.movImm(RAX, m_exits.size());
+			m_a.ret();
+
+			// Exits before the instruction which would access peripheral
+			// or watched memory.
+			for (unsigned int i = 0; i < m_exits.size(); ++i) {
+				if (m_exits[i].empty()) {
+					continue;
+				}
+
+				for (std::vector<unsigned int>::iterator it = m_exits[i].begin(); it != m_exits[i].end(); ++it) {
+					m_a.patch(*it, m_a.code.size());
+				}
+				m_a.movImm(RAX, i);
+				m_a.ret();
+			}
+		}
+
+	private:
+		void exitIf(int cc) {
+			m_exits.back().push_back(m_a.jcc(cc));
+		}
+
+		// Leaves the block if the memory at address in reg is peripheral
+		// or has a watcher of given type.
+		void guard(int reg, int size, uint8_t watched) {
+			m_a.aluImm(EXT_CMP, reg, MEMORY_PERIPHERALS_END);
+			exitIf(CC_B);
+			m_a.testImm8(RDX, reg, 0, watched);
+			exitIf(CC_NZ);
+			if (size == 2) {
+				m_a.testImm8(RDX, reg, 1, watched);
+				exitIf(CC_NZ);
+			}
+		}
+
+		// Loads the 16-bit address of memory operand to reg.
+		void address(int reg, int type, uint8_t r, uint16_t value) {
+			if (type == DecodedInstruction::ArgAbsolute) {
+				m_a.movImm(reg, value);
+			}
+			else if (type == DecodedInstruction::ArgIndexed && r == 0) {
+				// PC is already set to the next instruction in the interpreter
+				m_a.movImm(reg, (uint16_t) (m_next + value));
+			}
+			else {
+				m_a.load(reg, 2, RDI, NO_INDEX, VALUES(r));
+				if (type == DecodedInstruction::ArgIndexed) {
+					m_a.aluImm(EXT_ADD, reg, value);
+					m_a.aluImm(EXT_AND, reg, 0xffff);
+				}
+			}
+		}
+
+		// Loads the source operand to SRC_VALUE. Address has to be already
+		// loaded in SRC_ADDRESS for the memory operands.
+		void loadSource(const DecodedInstruction &d) {
+			uint16_t mask = d.bw ? 0xff : 0xffff;
+			switch (d.srcType) {
+				case DecodedInstruction::ArgRegister:
+					if (d.srcReg == 0) {
+						m_a.movImm(SRC_VALUE, m_next & mask);
+					}
+					else {
+						m_a.load(SRC_VALUE, m_size, RDI, NO_INDEX, VALUES(d.srcReg));
+					}
+					break;
+				case DecodedInstruction::ArgConstant:
+					m_a.movImm(SRC_VALUE, d.srcValue & mask);
+					break;
+				case DecodedInstruction::ArgIndirectAutoincrement:
+					m_a.load(SRC_VALUE, m_size, RSI, SRC_ADDRESS, 0);
+					m_a.alu(OP_MOV, RAX, SRC_ADDRESS);
+					m_a.aluImm(EXT_ADD, RAX, m_size);
+					m_a.store(RAX, 2, RDI, NO_INDEX, VALUES(d.srcReg));
+					break;
+				default:
+					m_a.load(SRC_VALUE, m_size, RSI, SRC_ADDRESS, 0);
+					break;
+			}
+		}
+
+		static bool isMemory(int type) {
+			return type == DecodedInstruction::ArgAbsolute ||
+				type == DecodedInstruction::ArgIndexed ||
+				type == DecodedInstruction::ArgIndirectAutoincrement;
+		}
+
+		void setFlags(FlagsOperation op, bool bw) {
+			m_a.storeImm8(RDI, offsetof(RegisterFile, flagsOp), op);
+			m_a.storeImm8(RDI, offsetof(RegisterFile, flagsBw), bw);
+			m_a.store(DST_VALUE, 2, RDI, NO_INDEX, offsetof(RegisterFile, flagsDst));
+			m_a.store(SRC_VALUE, 2, RDI, NO_INDEX, offsetof(RegisterFile, flagsSrc));
+			m_a.store(RESULT, 4, RDI, NO_INDEX, offsetof(RegisterFile, flagsResult));
+		}
+
+		void compileTwoOperand(const DecodedInstruction &d) {
+			bool readsDst = d.opcode != 4;
+			bool writesDst = d.opcode != 9 && d.opcode != 11;
+
+			// All the checks have to be done before anything is changed.
+			if (isMemory(d.srcType)) {
+				address(SRC_ADDRESS, d.srcType, d.srcReg, d.srcValue);
+				guard(SRC_ADDRESS, m_size, MEMORY_READ_WATCHED);
+			}
+			if (isMemory(d.dstType)) {
+				address(DST_ADDRESS, d.dstType, d.dstReg, d.dstValue);
+				guard(DST_ADDRESS, m_size, (readsDst ? MEMORY_READ_WATCHED : 0) |
+					(writesDst ? MEMORY_WRITE_WATCHED : 0));
+			}
+
+			loadSource(d);
+			if (readsDst) {
+				if (d.dstType == DecodedInstruction::ArgRegister) {
+					m_a.load(DST_VALUE, m_size, RDI, NO_INDEX, VALUES(d.dstReg));
+				}
+				else {
+					m_a.load(DST_VALUE, m_size, RSI, DST_ADDRESS, 0);
+				}
+			}
+
+			switch (d.opcode) {
+				// mov
+				case 4:
+					m_a.alu(OP_MOV, RESULT, SRC_VALUE);
+					break;
+				// add
+				case 5:
+					m_a.alu(OP_MOV, RESULT, DST_VALUE);
+					m_a.alu(OP_ADD, RESULT, SRC_VALUE);
+					setFlags(FlagsAdd, d.bw);
+					break;
+				// sub, cmp
+				case 8:
+				case 9:
+					m_a.alu(OP_MOV, RAX, SRC_VALUE);
+					m_a.notReg(RAX);
+					m_a.aluImm(EXT_AND, RAX, d.bw ? 0xff : 0xffff);
+					m_a.alu(OP_MOV, RESULT, DST_VALUE);
+					m_a.alu(OP_ADD, RESULT, RAX);
+					m_a.aluImm(EXT_ADD, RESULT, 1);
+					setFlags(FlagsSub, d.bw);
+					break;
+				// bit
+				case 11:
+					m_a.alu(OP_MOV, RESULT, DST_VALUE);
+					m_a.alu(OP_AND, RESULT, SRC_VALUE);
+					setFlags(FlagsBit, d.bw);
+					break;
+				// bic
+				case 12:
+					m_a.alu(OP_MOV, RAX, SRC_VALUE);
+					m_a.notReg(RAX);
+					m_a.alu(OP_MOV, RESULT, DST_VALUE);
+					m_a.alu(OP_AND, RESULT, RAX);
+					break;
+				// bis
+				case 13:
+					m_a.alu(OP_MOV, RESULT, DST_VALUE);
+					m_a.alu(OP_OR, RESULT, SRC_VALUE);
+					break;
+				// xor, and
+				case 14:
+				case 15:
+					m_a.alu(OP_MOV, RESULT, DST_VALUE);
+					m_a.alu(d.opcode == 14 ? OP_XOR : OP_AND, RESULT, SRC_VALUE);
+					setFlags(FlagsLogic, d.bw);
+					break;
+				default:
+					break;
+			}
+
+			if (!writesDst) {
+				return;
+			}
+
+			if (d.dstType == DecodedInstruction::ArgRegister) {
+				// Byte instructions keep the high byte of the register
+				m_a.store(RESULT, m_size, RDI, NO_INDEX, VALUES(d.dstReg));
+			}
+			else {
+				m_a.store(RESULT, m_size, RSI, DST_ADDRESS, 0);
+			}
+		}
+
+		void compileSwpb(const DecodedInstruction &d) {
+			if (d.srcType == DecodedInstruction::ArgRegister) {
+				m_a.load(RESULT, 2, RDI, NO_INDEX, VALUES(d.srcReg));
+				m_a.swapBytes(RESULT);
+				m_a.store(RESULT, 2, RDI, NO_INDEX, VALUES(d.srcReg));
+				return;
+			}
+
+			address(SRC_ADDRESS, d.srcType, d.srcReg, d.srcValue);
+			guard(SRC_ADDRESS, 2, MEMORY_READ_WATCHED | MEMORY_WRITE_WATCHED);
+			m_a.load(RESULT, 2, RSI, SRC_ADDRESS, 0);
+			m_a.swapBytes(RESULT);
+			m_a.store(RESULT, 2, RSI, SRC_ADDRESS, 0);
+		}
+
+		void compilePush(const DecodedInstruction &d) {
+			m_a.load(DST_ADDRESS, 2, RDI, NO_INDEX, VALUES(1));
+			m_a.aluImm(EXT_ADD, DST_ADDRESS, (uint32_t) -2);
+			m_a.aluImm(EXT_AND, DST_ADDRESS, 0xffff);
+			if (isMemory(d.srcType)) {
+				address(SRC_ADDRESS, d.srcType, d.srcReg, d.srcValue);
+				guard(SRC_ADDRESS, 2, MEMORY_READ_WATCHED);
+			}
+			guard(DST_ADDRESS, 2, MEMORY_WRITE_WATCHED);
+
+			m_a.store(DST_ADDRESS, 2, RDI, NO_INDEX, VALUES(1));
+			loadSource(d);
+			m_a.store(SRC_VALUE, 2, RSI, DST_ADDRESS, 0);
+		}
+
+	private:
+		Assembler &m_a;
+		uint16_t m_next;
+		int m_size;
+		// Positions of jumps leaving the block before given instruction
+		std::vector<std::vector<unsigned int> > m_exits;
+};
+
+#endif
+
+JITCompiler::JITCompiler(unsigned int size) : m_code(0), m_size(size), m_used(0), m_full(false) {
+#ifdef JIT_SUPPORTED
+	// The buffer is never writable and executable at once. Pages are made
+	// writable only while the code is copied into them.
+	void *code = mmap(0, m_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (code != MAP_FAILED) {
+		m_code = (uint8_t *) code;
+	}
+#endif
+}
+
+JITCompiler::~JITCompiler() {
+	release();
+}
+
+void JITCompiler::release() {
+#ifdef JIT_SUPPORTED
+	if (m_code) {
+		munmap(m_code, m_size);
+		m_code = 0;
+	}
+#endif
+}
+
+bool JITCompiler::protect(unsigned int offset, unsigned int size, bool executable) {
+#ifdef JIT_SUPPORTED
+	unsigned int page = sysconf(_SC_PAGESIZE);
+	unsigned int start = offset & ~(page - 1);
+	unsigned int end = (offset + size + page - 1) & ~(page - 1);
+	if (end > m_size) {
+		end = m_size;
+	}
+
+	int prot = executable ? PROT_READ | PROT_EXEC : PROT_READ | PROT_WRITE;
+	return mprotect(m_code + start, end - start, prot) == 0;
+#else
+	return false;
+#endif
+}
+
+bool JITCompiler::isSupported() {
+#ifdef JIT_SUPPORTED
+	return true;
+#else
+	return false;
+#endif
+}
+
+static bool canCompileSource(const DecodedInstruction &d) {
+	switch (d.srcType) {
+		case DecodedInstruction::ArgRegister:
+			// Reading SR needs the flags to be computed
+			return d.srcReg != 2;
+		case DecodedInstruction::ArgConstant:
+			return true;
+		case DecodedInstruction::ArgAbsolute:
+			return d.srcValue >= MEMORY_PERIPHERALS_END;
+		case DecodedInstruction::ArgIndexed:
+			return d.srcReg != 2 && d.srcReg != 3;
+		case DecodedInstruction::ArgIndirectAutoincrement:
+			return d.srcReg != 0 && d.srcReg != 2 && d.srcReg != 3;
+		default:
+			return false;
+	}
+}
+
+static bool canCompileDestination(const DecodedInstruction &d) {
+	switch (d.dstType) {
+		case DecodedInstruction::ArgRegister:
+			// Changes of PC and SR end the block
+			return d.dstReg != 0 && d.dstReg != 2;
+		case DecodedInstruction::ArgAbsolute:
+			return d.dstValue >= MEMORY_PERIPHERALS_END;
+		case DecodedInstruction::ArgIndexed:
+			// Autoincremented register is used by the destination
+			if (d.srcType == DecodedInstruction::ArgIndirectAutoincrement && d.srcReg == d.dstReg) {
+				return false;
+			}
+			return d.dstReg != 2 && d.dstReg != 3;
+		default:
+			return false;
+	}
+}
+
+bool JITCompiler::canCompile(const DecodedInstruction &d) {
+	if (!d.valid || !canCompileSource(d)) {
+		return false;
+	}
+
+	switch (d.type) {
+		case Instruction1:
+			// push, swpb
+			if (d.bw || (d.opcode != 1 && d.opcode != 4)) {
+				return false;
+			}
+			if (d.opcode == 1) {
+				return d.srcType != DecodedInstruction::ArgConstant &&
+					d.srcType != DecodedInstruction::ArgIndirectAutoincrement &&
+					d.srcReg != 0;
+			}
+			// push changes SP before the operand is read
+			return d.srcReg != 1 || d.srcType == DecodedInstruction::ArgConstant;
+		case Instruction2:
+			switch (d.opcode) {
+				// addc and subc need the flags to be computed
+				case 4: case 5: case 8: case 9: case 11:
+				case 12: case 13: case 14: case 15:
+					break;
+				default:
+					return false;
+			}
+			if (d.dstType == DecodedInstruction::ArgRegister &&
+				d.srcType == DecodedInstruction::ArgIndirectAutoincrement && d.srcReg == d.dstReg) {
+				return false;
+			}
+			return canCompileDestination(d);
+		default:
+			return false;
+	}
+}
+
+JITFunction JITCompiler::compile(const std::vector<const DecodedInstruction *> &instructions, uint16_t pc) {
+	m_full = false;
+#ifdef JIT_SUPPORTED
+	if (!m_code) {
+		return 0;
+	}
+
+	Assembler a;
+	BlockCompiler compiler(a);
+	int count = 0;
+	for (std::vector<const DecodedInstruction *>::const_iterator it = instructions.begin(); it != instructions.end(); ++it) {
+		if (!canCompile(**it)) {
+			break;
+		}
+		compiler.compile(**it, pc);
+		count++;
+		pc += (*it)->length;
+	}
+
+	if (count == 0) {
+		return 0;
+	}
+
+	compiler.finish();
+
+	if (m_used + a.code.size() > m_size) {
+		m_full = true;
+		return 0;
+	}
+
+	// The page can hold the functions compiled before, so when it cannot
+	// be made executable again, none of them can be called anymore.
+	uint8_t *code = m_code + m_used;
+	if (!protect(m_used, a.code.size(), false)) {
+		release();
+		return 0;
+	}
+	memcpy(code, &a.code[0], a.code.size());
+	if (!protect(m_used, a.code.size(), true)) {
+		release();
+		return 0;
+	}
+
+	// Keep the functions aligned
+	m_used += (a.code.size() + 15) & ~15;
+	return (JITFunction) code;
+#else
+	return 0;
+#endif
+}
+
+void JITCompiler::flush() {
+	m_used = 0;
+	m_full = false;
+}
+
+}
@@ -0,0 +1,97 @@
+/**
+ * QSimKit - MSP430 simulator
+ * Copyright (C) 2013 Jan "HanzZ" Kaluza (hanzz.k@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "CPU/Memory/RegisterFile.h"
+
+// JIT is compiled in only when requested by the ENABLE_JIT build option
+// and only for Linux on x86-64.
+#if defined(WITH_JIT) && defined(__x86_64__) && defined(__linux__)
+#define JIT_SUPPORTED 1
+#endif
+
+namespace MSP430 {
+
+class DecodedInstruction;
+
+/// Compiled code of a basic block. Returns number of instructions which
+/// have been executed. Execution stops before the first instruction which
+/// would access peripheral or watched memory.
+typedef int (*JITFunction)(RegisterFile *file, uint8_t *mem, const uint8_t *watchedMask);
+
+/// Translates straight-line MSP430 code into x86-64 machine code.
+///
+/// Generated code works directly with the RegisterFile and the raw memory
+/// content. Every memory access is guarded by a check of peripheral address
+/// range and Memory::getWatchedMask(), so the interpreter can execute the
+/// instruction with peripherals and watchers in the right cycle. PC is
+/// not changed by the generated code.
+class JITCompiler {
+	public:
+		JITCompiler(unsigned int size = 4 * 1024 * 1024);
+		virtual ~JITCompiler();
+
+		/// Returns true if the JIT is compiled in and works on this host.
+		static bool isSupported();
+
+		/// Returns false if the code buffer could not be mapped or its
+		/// protection changed. Nothing is compiled then and previously
+		/// returned functions must not be called anymore.
+		bool isAvailable() {
+			return m_code != 0;
+		}
+
+		/// Returns true if the instruction can be compiled. Block can be
+		/// compiled only up to the first unsupported instruction.
+		static bool canCompile(const DecodedInstruction &d);
+
+		/// Compiles instructions starting at pc. Returns 0 if the first
+		/// instruction cannot be compiled or there is not enough space
+		/// for the code. In that case isFull() and isAvailable() tell
+		/// which one happened.
+		JITFunction compile(const std::vector<const DecodedInstruction *> &instructions, uint16_t pc);
+
+		/// Returns true if the last compile() failed because the code
+		/// buffer is full.
+		bool isFull() {
+			return m_full;
+		}
+
+		/// Drops all compiled code. Previously returned functions must not
+		/// be called anymore.
+		void flush();
+
+	private:
+		/// Makes the pages with given part of the code buffer either
+		/// writable or executable.
+		bool protect(unsigned int offset, unsigned int size, bool executable);
+		void release();
+
+		uint8_t *m_code;
+		unsigned int m_size;
+		unsigned int m_used;
+		bool m_full;
+};
+
+}
@@ -37,7 +37,7 @@ uint16_t MemoryArgument::get() {
 }
 
 uint16_t MemoryArgument::getBigEndian() {
-	return m_mem->getBigEndian(m_address);
+	return m_mem->getWord(m_address);
 }
 
 void MemoryArgument::set(uint16_t value) {
@@ -45,7 +45,7 @@ void MemoryArgument::set(uint16_t value) {
 }
 
 void MemoryArgument::setBigEndian(uint16_t value) {
-	m_mem->setBigEndian(m_address, value);
+	m_mem->setWord(m_address, value);
 }
 
 uint8_t MemoryArgument::getByte() {
@@ -141,7 +141,7 @@ static int execPUSH(RegisterSet *reg, Memory *mem, Instruction *i) {
 		mem->set(sp, i->getDst()->getByte());
 	}
 	else {
-		mem->setBigEndian(sp, i->getDst()->getBigEndian());
+		mem->setWord(sp, i->getDst()->getBigEndian());
 	}
 
 	reg->get(1)->callWatchers();
@@ -153,7 +153,7 @@ static int execCALL(RegisterSet *reg, Memory *mem, Instruction *i) {
 	// Decrease SP, Store current PC, change PC
 	uint16_t sp = reg->get(1)->getBigEndian();
 	sp -= 2;
-	mem->setBigEndian(sp, reg->get(0)->getBigEndian());
+	mem->setWord(sp, reg->get(0)->getBigEndian());
 	reg->get(1)->setBigEndian(sp);
 	reg->get(1)->callWatchers();
 	reg->get(0)->setBigEndian(i->getDst()->getBigEndian());
@@ -164,12 +164,12 @@ static int execRETI(RegisterSet *reg, Memory *mem, Instruction *i) {
 	uint16_t sp = reg->get(1)->getBigEndian();
 
 	// POP SR from stack
-	reg->get(2)->setBigEndian(mem->getBigEndian(sp));
+	reg->get(2)->setBigEndian(mem->getWord(sp));
 	reg->get(2)->callWatchers();
 	sp += 2;
 
 	// POP PC from stack
-	reg->get(0)->setBigEndian(mem->getBigEndian(sp));
+	reg->get(0)->setBigEndian(mem->getWord(sp));
 	sp += 2;
 
 	reg->get(1)->setBigEndian(sp);
@@ -0,0 +1,552 @@
+/**
+ * QSimKit - MSP430 simulator
+ * Copyright (C) 2013 Jan "HanzZ" Kaluza (hanzz.k@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#include "CPU/Instructions/SpecializedInstructions.h"
+#include "CPU/Instructions/InstructionDecoder.h"
+#include "CPU/Instructions/InstructionManager.h"
+#include "CPU/Memory/RegisterSet.h"
+#include "CPU/Memory/Register.h"
+#include "CPU/Memory/Memory.h"
+
+namespace MSP430 {
+
+// Operand access specialized for single addressing mode. Every method
+// behaves the same way as the matching InstructionArgument class.
+template<int MODE, bool BW> class Operand;
+
+template<bool BW> class Operand<DecodedInstruction::ArgRegister, BW> {
+	public:
+		static inline uint16_t get(RegisterFile *file, Memory *mem, uint8_t r, uint16_t value) {
+			return BW ? (uint8_t) file->get(r) : file->get(r);
+		}
+
+		static inline void set(RegisterFile *file, Memory *mem, uint8_t r, uint16_t value, uint16_t result) {
+			if (BW) {
+				file->set(r, (file->get(r) & 0xff00) | (uint8_t) result);
+			}
+			else {
+				file->set(r, result);
+			}
+		}
+
+		static inline void callWatchers(RegisterSet *reg, uint8_t r) {
+			if (reg->getRegisterFile()->watched & (1 << r)) {
+				reg->getp(r)->callWatchers();
+			}
+		}
+};
+
+template<bool BW> class Operand<DecodedInstruction::ArgConstant, BW> {
+	public:
+		static inline uint16_t get(RegisterFile *file, Memory *mem, uint8_t r, uint16_t value) {
+			return BW ? (uint8_t) value : value;
+		}
+
+		static inline void set(RegisterFile *file, Memory *mem, uint8_t r, uint16_t value, uint16_t result) {}
+
+		static inline void callWatchers(RegisterSet *reg, uint8_t r) {}
+};
+
+template<bool BW> class Operand<DecodedInstruction::ArgAbsolute, BW> {
+	public:
+		static inline uint16_t get(RegisterFile *file, Memory *mem, uint8_t r, uint16_t value) {
+			return BW ? mem->Memory::getByte(value) : mem->getWord(value);
+		}
+
+		static inline void set(RegisterFile *file, Memory *mem, uint8_t r, uint16_t value, uint16_t result) {
+			if (BW) {
+				mem->Memory::setByte(value, result);
+			}
+			else {
+				mem->setWord(value, result);
+			}
+		}
+
+		static inline void callWatchers(RegisterSet *reg, uint8_t r) {}
+};
+
+template<bool BW> class Operand<DecodedInstruction::ArgIndexed, BW> {
+	public:
+		static inline uint16_t get(RegisterFile *file, Memory *mem, uint8_t r, uint16_t value) {
+			uint16_t address = file->get(r) + value;
+			return BW ? mem->Memory::getByte(address) : mem->getWord(address);
+		}
+
+		static inline void set(RegisterFile *file, Memory *mem, uint8_t r, uint16_t value, uint16_t result) {
+			uint16_t address = file->get(r) + value;
+			if (BW) {
+				mem->Memory::setByte(address, result);
+			}
+			else {
+				mem->setWord(address, result);
+			}
+		}
+
+		static inline void callWatchers(RegisterSet *reg, uint8_t r) {}
+};
+
+template<bool BW> class Operand<DecodedInstruction::ArgIndirectAutoincrement, BW> {
+	public:
+		static inline uint16_t get(RegisterFile *file, Memory *mem, uint8_t r, uint16_t value) {
+			uint16_t address = file->get(r);
+			uint16_t result = BW ? mem->Memory::getByte(address) : mem->getWord(address);
+			file->set(r, address + (BW ? 1 : 2));
+			return result;
+		}
+
+		static inline void set(RegisterFile *file, Memory *mem, uint8_t r, uint16_t value, uint16_t result) {}
+
+		static inline void callWatchers(RegisterSet *reg, uint8_t r) {}
+};
+
+typedef Operand<DecodedInstruction::ArgRegister, false> RegisterOperand;
+
+// Replaces the N, Z, C and V bits selected by mask.
+static inline void setFlags(RegisterFile *file, uint16_t mask, uint16_t flags) {
+	file->set(2, (file->getSR() & ~mask) | flags);
+}
+
+#define FLAG(COND, BIT) ((COND) ? BIT : 0)
+
+template<int OPCODE, int SRC, int DST, bool BW>
+static int execTwoOperand(RegisterSet *reg, Memory *mem, const DecodedInstruction &i) {
+	typedef Operand<SRC, BW> Src;
+	typedef Operand<DST, BW> Dst;
+	RegisterFile *file = reg->getRegisterFile();
+	int32_t d, s, r, c;
+
+	switch (OPCODE) {
+		// mov
+		case 4:
+			Dst::set(file, mem, i.dstReg, i.dstValue, Src::get(file, mem, i.srcReg, i.srcValue));
+			Dst::callWatchers(reg, i.dstReg);
+			break;
+		// add, addc
+		case 5:
+		case 6:
+			d = Dst::get(file, mem, i.dstReg, i.dstValue);
+			s = Src::get(file, mem, i.srcReg, i.srcValue);
+			c = OPCODE == 6 ? file->isFlagSet(SR_C) : 0;
+			r = d + s + c;
+			Dst::set(file, mem, i.dstReg, i.dstValue, r);
+			Dst::callWatchers(reg, i.dstReg);
+
+			file->setFlags(FlagsAdd, BW, d, s, r);
+			RegisterOperand::callWatchers(reg, 2);
+			break;
+		// subc, sub, cmp
+		case 7:
+		case 8:
+		case 9:
+			d = Dst::get(file, mem, i.dstReg, i.dstValue);
+			s = Src::get(file, mem, i.srcReg, i.srcValue);
+			c = OPCODE == 7 ? file->isFlagSet(SR_C) : 1;
+			r = d + ((~s) & (BW ? 0xff : 0xffff)) + c;
+			if (OPCODE != 9) {
+				Dst::set(file, mem, i.dstReg, i.dstValue, r);
+				Dst::callWatchers(reg, i.dstReg);
+			}
+
+			file->setFlags(FlagsSub, BW, d, s, r);
+			RegisterOperand::callWatchers(reg, 2);
+			break;
+		// bit
+		case 11:
+			d = Dst::get(file, mem, i.dstReg, i.dstValue);
+			s = Src::get(file, mem, i.srcReg, i.srcValue);
+			r = d & s;
+
+			file->setFlags(FlagsBit, BW, d, s, r);
+			RegisterOperand::callWatchers(reg, 2);
+			break;
+		// bic, bis
+		case 12:
+		case 13:
+			d = Dst::get(file, mem, i.dstReg, i.dstValue);
+			s = Src::get(file, mem, i.srcReg, i.srcValue);
+			r = OPCODE == 12 ? d & ~s : d | s;
+			Dst::set(file, mem, i.dstReg, i.dstValue, r);
+			Dst::callWatchers(reg, i.dstReg);
+			break;
+		// xor, and
+		case 14:
+		case 15:
+			d = Dst::get(file, mem, i.dstReg, i.dstValue);
+			s = Src::get(file, mem, i.srcReg, i.srcValue);
+			r = OPCODE == 14 ? d ^ s : d & s;
+			Dst::set(file, mem, i.dstReg, i.dstValue, r);
+			Dst::callWatchers(reg, i.dstReg);
+
+			file->setFlags(FlagsLogic, BW, d, s, r);
+			RegisterOperand::callWatchers(reg, 2);
+			break;
+		default:
+			break;
+	}
+
+	return 0;
+}
+
+template<int OPCODE, int MODE, bool BW>
+static int execSingleOperand(RegisterSet *reg, Memory *mem, const DecodedInstruction &i) {
+	// Operand of single operand instruction is decoded as source.
+	typedef Operand<MODE, BW> Dst;
+	RegisterFile *file = reg->getRegisterFile();
+	const int32_t B = BW ? 0x80 : 0x8000;
+	const int32_t M = BW ? 0xff : 0xffff;
+	int32_t d, r;
+	uint16_t sp;
+
+	switch (OPCODE) {
+		// rrc, rra
+		case 0:
+		case 2:
+			d = Dst::get(file, mem, i.srcReg, i.srcValue);
+			if (OPCODE == 0) {
+				r = (file->isFlagSet(SR_C) ? B : 0) | ((d >> 1) & (M >> 1));
+			}
+			else {
+				r = (d & B) | ((d >> 1) & (M >> 1));
+			}
+			Dst::set(file, mem, i.srcReg, i.srcValue, r);
+			Dst::callWatchers(reg, i.srcReg);
+
+			setFlags(file, SR_FLAGS,
+				FLAG(r & B, SR_N) | FLAG((r & M) == 0, SR_Z) | FLAG(d & 1, SR_C));
+			break;
+		// swpb
+		case 1:
+			if (BW) {
+				break;
+			}
+			d = Dst::get(file, mem, i.srcReg, i.srcValue);
+			r = ((d & 0xff00) >> 8) | ((d & 0x00ff) << 8);
+			Dst::set(file, mem, i.srcReg, i.srcValue, r);
+			Dst::callWatchers(reg, i.srcReg);
+			break;
+		// sxt
+		case 3:
+			if (BW) {
+				break;
+			}
+			d = Dst::get(file, mem, i.srcReg, i.srcValue);
+			r = d & 0xff;
+			if (d & 0x80) {
+				r |= 0xff00;
+			}
+			Dst::set(file, mem, i.srcReg, i.srcValue, r);
+			Dst::callWatchers(reg, i.srcReg);
+
+			setFlags(file, SR_FLAGS,
+				FLAG(r & 0x8000, SR_N) | FLAG((r & 0xffff) == 0, SR_Z) | FLAG((r & 0xffff) != 0, SR_C));
+			break;
+		// push
+		case 4:
+			sp = file->values[1] - 2;
+			file->values[1] = sp;
+			if (BW) {
+				mem->Memory::set(sp, Dst::get(file, mem, i.srcReg, i.srcValue));
+			}
+			else {
+				mem->setWord(sp, Dst::get(file, mem, i.srcReg, i.srcValue));
+			}
+			RegisterOperand::callWatchers(reg, 1);
+			break;
+		// call
+		case 5:
+			sp = file->values[1] - 2;
+			mem->setWord(sp, file->values[0]);
+			file->values[1] = sp;
+			RegisterOperand::callWatchers(reg, 1);
+			file->values[0] = Operand<MODE, false>::get(file, mem, i.srcReg, i.srcValue);
+			if (BW && MODE == DecodedInstruction::ArgIndirectAutoincrement) {
+				// call.b reads the whole word, but increments the register by 1
+				file->set(i.srcReg, file->get(i.srcReg) - 1);
+			}
+			break;
+		// reti
+		case 6:
+			sp = file->values[1];
+			file->set(2, mem->getWord(sp));
+			RegisterOperand::callWatchers(reg, 2);
+			file->values[0] = mem->getWord(sp + 2);
+			file->values[1] = sp + 4;
+			RegisterOperand::callWatchers(reg, 1);
+			break;
+		default:
+			break;
+	}
+
+	return 0;
+}
+
+template<int OPCODE>
+static int execCond(RegisterSet *reg, Memory *mem, const DecodedInstruction &i) {
+	RegisterFile *file = reg->getRegisterFile();
+	bool jump;
+	switch (OPCODE) {
+		case 0: jump = !file->isFlagSet(SR_Z); break;
+		case 1: jump = file->isFlagSet(SR_Z); break;
+		case 2: jump = !file->isFlagSet(SR_C); break;
+		case 3: jump = file->isFlagSet(SR_C); break;
+		case 4: jump = file->isFlagSet(SR_N); break;
+		case 5: jump = !(file->isFlagSet(SR_N) ^ file->isFlagSet(SR_V)); break;
+		case 6: jump = file->isFlagSet(SR_N) ^ file->isFlagSet(SR_V); break;
+		default: jump = true; break;
+	}
+
+	if (jump) {
+		file->values[0] += i.offset;
+	}
+	return 0;
+}
+
+// Arithmetic instruction followed by conditional jump which depends only
+// on its result. The flags are stored just once and the jump condition is
+// evaluated directly from the result instead of computing the SR.
+template<int OPCODE, int SRC, bool BW, int COND>
+static int execArithmeticJump(RegisterSet *reg, Memory *mem, const DecodedInstruction &i, const DecodedInstruction &j) {
+	typedef Operand<SRC, BW> Src;
+	typedef Operand<DecodedInstruction::ArgRegister, BW> Dst;
+	RegisterFile *file = reg->getRegisterFile();
+	const int32_t M = BW ? 0xff : 0xffff;
+
+	int32_t d = Dst::get(file, mem, i.dstReg, i.dstValue);
+	int32_t s = Src::get(file, mem, i.srcReg, i.srcValue);
+	int32_t r = OPCODE == 5 ? d + s : d + ((~s) & M) + 1;
+	if (OPCODE != 9) {
+		Dst::set(file, mem, i.dstReg, i.dstValue, r);
+		Dst::callWatchers(reg, i.dstReg);
+	}
+
+	file->setFlags(OPCODE == 5 ? FlagsAdd : FlagsSub, BW, d, s, r);
+	RegisterOperand::callWatchers(reg, 2);
+
+	// Result is never negative, so the carry is set only on overflow
+	bool jump;
+	switch (COND) {
+		case 0: jump = (r & M) != 0; break;
+		case 1: jump = (r & M) == 0; break;
+		case 2: jump = r <= M; break;
+		default: jump = r > M; break;
+	}
+
+	if (jump) {
+		file->values[0] += j.offset;
+	}
+	return 0;
+}
+
+// Pairs executed by the specialized handlers with single dispatch.
+template<int FIRST, int SECOND>
+static int execPushPush(RegisterSet *reg, Memory *mem, const DecodedInstruction &i, const DecodedInstruction &j) {
+	execSingleOperand<4, FIRST, false>(reg, mem, i);
+	return execSingleOperand<4, SECOND, false>(reg, mem, j);
+}
+
+// Handlers indexed by [opcode][source mode][destination mode][bw]
+static SpecializedCallback two_operand[16][6][6][2];
+// Handlers indexed by [opcode][operand mode][bw]
+static SpecializedCallback single_operand[8][6][2];
+// Handlers indexed by [opcode]
+static SpecializedCallback cond[8];
+// Handlers indexed by [add, sub, cmp][source is constant][bw][cond opcode]
+static FusedCallback arithmetic_jump[3][2][2][4];
+// Handlers indexed by [first source is constant][second source is constant]
+static FusedCallback push_push[2][2];
+
+template<int OPCODE, int SRC, int DST>
+static void addTwoOperand() {
+	two_operand[OPCODE][SRC][DST][0] = &execTwoOperand<OPCODE, SRC, DST, false>;
+	two_operand[OPCODE][SRC][DST][1] = &execTwoOperand<OPCODE, SRC, DST, true>;
+}
+
+template<int OPCODE, int SRC>
+static void addTwoOperand() {
+	addTwoOperand<OPCODE, SRC, DecodedInstruction::ArgRegister>();
+	addTwoOperand<OPCODE, SRC, DecodedInstruction::ArgAbsolute>();
+	addTwoOperand<OPCODE, SRC, DecodedInstruction::ArgIndexed>();
+}
+
+template<int OPCODE>
+static void addTwoOperand() {
+	addTwoOperand<OPCODE, DecodedInstruction::ArgRegister>();
+	addTwoOperand<OPCODE, DecodedInstruction::ArgConstant>();
+	addTwoOperand<OPCODE, DecodedInstruction::ArgAbsolute>();
+	addTwoOperand<OPCODE, DecodedInstruction::ArgIndexed>();
+	addTwoOperand<OPCODE, DecodedInstruction::ArgIndirectAutoincrement>();
+}
+
+template<int OPCODE, int MODE>
+static void addSingleOperand() {
+	single_operand[OPCODE][MODE][0] = &execSingleOperand<OPCODE, MODE, false>;
+	single_operand[OPCODE][MODE][1] = &execSingleOperand<OPCODE, MODE, true>;
+}
+
+template<int OPCODE>
+static void addSingleOperand() {
+	addSingleOperand<OPCODE, DecodedInstruction::ArgRegister>();
+	addSingleOperand<OPCODE, DecodedInstruction::ArgConstant>();
+	addSingleOperand<OPCODE, DecodedInstruction::ArgAbsolute>();
+	addSingleOperand<OPCODE, DecodedInstruction::ArgIndexed>();
+	addSingleOperand<OPCODE, DecodedInstruction::ArgIndirectAutoincrement>();
+}
+
+template<int INDEX, int OPCODE, int SRC, bool BW>
+static void addArithmeticJump() {
+	const int constant = SRC == DecodedInstruction::ArgConstant;
+	arithmetic_jump[INDEX][constant][BW][0] = &execArithmeticJump<OPCODE, SRC, BW, 0>;
+	arithmetic_jump[INDEX][constant][BW][1] = &execArithmeticJump<OPCODE, SRC, BW, 1>;
+	arithmetic_jump[INDEX][constant][BW][2] = &execArithmeticJump<OPCODE, SRC, BW, 2>;
+	arithmetic_jump[INDEX][constant][BW][3] = &execArithmeticJump<OPCODE, SRC, BW, 3>;
+}
+
+template<int INDEX, int OPCODE>
+static void addArithmeticJump() {
+	addArithmeticJump<INDEX, OPCODE, DecodedInstruction::ArgRegister, false>();
+	addArithmeticJump<INDEX, OPCODE, DecodedInstruction::ArgRegister, true>();
+	addArithmeticJump<INDEX, OPCODE, DecodedInstruction::ArgConstant, false>();
+	addArithmeticJump<INDEX, OPCODE, DecodedInstruction::ArgConstant, true>();
+}
+
+class _specialized_instructions {
+	public:
+		_specialized_instructions() {
+			// Same instructions as registered by MSP430_INSTRUCTION
+			addTwoOperand<4>();
+			addTwoOperand<5>();
+			addTwoOperand<6>();
+			addTwoOperand<7>();
+			addTwoOperand<8>();
+			addTwoOperand<9>();
+			addTwoOperand<11>();
+			addTwoOperand<12>();
+			addTwoOperand<13>();
+			addTwoOperand<14>();
+			addTwoOperand<15>();
+
+			addSingleOperand<0>();
+			addSingleOperand<1>();
+			addSingleOperand<2>();
+			addSingleOperand<3>();
+			addSingleOperand<4>();
+			addSingleOperand<5>();
+			addSingleOperand<6>();
+
+			cond[0] = &execCond<0>;
+			cond[1] = &execCond<1>;
+			cond[2] = &execCond<2>;
+			cond[3] = &execCond<3>;
+			cond[4] = &execCond<4>;
+			cond[5] = &execCond<5>;
+			cond[6] = &execCond<6>;
+			cond[7] = &execCond<7>;
+
+			addArithmeticJump<0, 5>();
+			addArithmeticJump<1, 8>();
+			addArithmeticJump<2, 9>();
+
+			push_push[0][0] = &execPushPush<DecodedInstruction::ArgRegister, DecodedInstruction::ArgRegister>;
+			push_push[0][1] = &execPushPush<DecodedInstruction::ArgRegister, DecodedInstruction::ArgConstant>;
+			push_push[1][0] = &execPushPush<DecodedInstruction::ArgConstant, DecodedInstruction::ArgRegister>;
+			push_push[1][1] = &execPushPush<DecodedInstruction::ArgConstant, DecodedInstruction::ArgConstant>;
+		}
+};
+
+static _specialized_instructions specialized_instructions;
+
+SpecializedCallback getSpecializedInstruction(const DecodedInstruction &d) {
+	if (!d.valid || d.srcType > DecodedInstruction::ArgIndirectAutoincrement ||
+		d.dstType > DecodedInstruction::ArgIndirectAutoincrement) {
+		return 0;
+	}
+
+	switch (d.type) {
+		case Instruction1:
+			return single_operand[d.opcode & 7][d.srcType][d.bw];
+		case InstructionCond:
+			return cond[d.opcode & 7];
+		case Instruction2:
+			return two_operand[d.opcode & 15][d.srcType][d.dstType][d.bw];
+		default:
+			return 0;
+	}
+}
+
+// Returns true for the register or constant operand which does not depend
+// on PC. Fused instructions are executed with PC already pointing after
+// the second instruction.
+static bool isSimpleSource(const DecodedInstruction &d) {
+	return d.srcType == DecodedInstruction::ArgConstant ||
+		(d.srcType == DecodedInstruction::ArgRegister && d.srcReg != 0);
+}
+
+static bool isRegisterDestination(const DecodedInstruction &d) {
+	return d.dstType == DecodedInstruction::ArgRegister && d.dstReg != 0 && d.dstReg != 2;
+}
+
+static bool isPush(const DecodedInstruction &d) {
+	return d.type == Instruction1 && d.opcode == 4 && !d.bw && isSimpleSource(d);
+}
+
+FusedCallback getFusedInstruction(const DecodedInstruction &first, const DecodedInstruction &second, int &pattern) {
+	if (!first.valid || !second.valid) {
+		return 0;
+	}
+
+	if (first.type == Instruction2 && second.type == InstructionCond && second.opcode < 4 &&
+		isSimpleSource(first) && isRegisterDestination(first)) {
+		const bool constant = first.srcType == DecodedInstruction::ArgConstant;
+		switch (first.opcode) {
+			case 5:
+				pattern = FusedArithmeticJump;
+				return arithmetic_jump[0][constant][first.bw][second.opcode];
+			case 8:
+				pattern = FusedArithmeticJump;
+				return arithmetic_jump[1][constant][first.bw][second.opcode];
+			case 9:
+				pattern = FusedCompareJump;
+				return arithmetic_jump[2][constant][first.bw][second.opcode];
+			default:
+				return 0;
+		}
+	}
+
+	if (isPush(first) && isPush(second)) {
+		pattern = FusedPushPush;
+		return push_push[first.srcType == DecodedInstruction::ArgConstant][second.srcType == DecodedInstruction::ArgConstant];
+	}
+
+	return 0;
+}
+
+const char *getFusedPatternName(int pattern) {
+	switch (pattern) {
+		case FusedArithmeticJump:
+			return "add/sub + conditional jump";
+		case FusedCompareJump:
+			return "cmp + conditional jump";
+		case FusedPushPush:
+			return "push + push";
+		default:
+			return "unknown";
+	}
+}
+
+}
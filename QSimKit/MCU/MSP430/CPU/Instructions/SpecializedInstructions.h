@@ -0,0 +1,63 @@
+/**
+ * QSimKit - MSP430 simulator
+ * Copyright (C) 2013 Jan "HanzZ" Kaluza (hanzz.k@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#pragma once
+
+#include <stdint.h>
+
+namespace MSP430 {
+
+class RegisterSet;
+class Memory;
+class DecodedInstruction;
+
+/// Executes the decoded instruction. PC has to be already set to the address
+/// of the next instruction, as executeInstruction() does.
+typedef int (*SpecializedCallback) (RegisterSet *reg, Memory *mem, const DecodedInstruction &d);
+
+/// Returns handler specialized at compile time for the opcode, addressing
+/// modes and byte/word access of the decoded instruction, or 0 if there is
+/// no such handler. Specialized handlers access the operands directly
+/// instead of using virtual InstructionArgument methods.
+SpecializedCallback getSpecializedInstruction(const DecodedInstruction &d);
+
+/// Executes two consecutive decoded instructions at once. PC has to be
+/// already set to the address following the second instruction.
+typedef int (*FusedCallback) (RegisterSet *reg, Memory *mem, const DecodedInstruction &first, const DecodedInstruction &second);
+
+/// Pairs of instructions which can be executed by single FusedCallback.
+typedef enum {
+	/// add/sub to register followed by jz, jnz, jc or jnc, like
+	/// "dec r15; jnz loop"
+	FusedArithmeticJump,
+	/// cmp followed by jz, jnz, jc or jnc, like "cmp #5, r15; jeq label"
+	FusedCompareJump,
+	/// "push r11; push r10"
+	FusedPushPush,
+	FusedPatternCount,
+} FusedPattern;
+
+/// Returns handler executing both instructions or 0 if they do not form
+/// any FusedPattern. The matched pattern is stored in pattern.
+FusedCallback getFusedInstruction(const DecodedInstruction &first, const DecodedInstruction &second, int &pattern);
+
+/// Returns human readable name of the FusedPattern.
+const char *getFusedPatternName(int pattern);
+
+}
@@ -41,14 +41,6 @@ static int execMOV(RegisterSet *reg, Memory *mem, Instruction *i) {
 	return 0;
 }
 
-#define SET_ADD_OVERFLOW(REG, R, D, S, B) \
-	REG->getp(2)->setBit(SR_V, (!(R & B) && (S & B) && (D & B)) ||\
-	((R & B) && !(S & B) && !(D & B)));
-
-#define SET_N(REG, R, B) REG->getp(2)->setBit(SR_N, R & B);
-#define SET_Z(REG, R, B) REG->getp(2)->setBit(SR_Z, (R & B) == 0);
-#define SET_C(REG, R, B) REG->getp(2)->setBit(SR_C, R < 0 || R > B);
-
 static int add(RegisterSet *reg, Memory *mem, Instruction *i, bool carry) {
 	if (i->bw) {
 		int32_t d, s, r, c;
@@ -60,10 +52,7 @@ static int add(RegisterSet *reg, Memory *mem, Instruction *i, bool carry) {
 		i->getDst()->setByte(r);
 		i->getDst()->callWatchers();
 
-		SET_ADD_OVERFLOW(reg, r, d, s, 0x80);
-		SET_N(reg, r, 0x80);
-		SET_Z(reg, r, 0xff);
-		SET_C(reg, r, 0xff);
+		reg->getRegisterFile()->setFlags(FlagsAdd, true, d, s, r);
 		reg->getp(2)->callWatchers();
 	}
 	else {
@@ -75,10 +64,7 @@ static int add(RegisterSet *reg, Memory *mem, Instruction *i, bool carry) {
 		i->getDst()->setBigEndian(r);
 		i->getDst()->callWatchers();
 
-		SET_ADD_OVERFLOW(reg, r, d, s, 0x8000);
-		SET_N(reg, r, 0x8000);
-		SET_Z(reg, r, 0xffff);
-		SET_C(reg, r, 0xffff);
+		reg->getRegisterFile()->setFlags(FlagsAdd, false, d, s, r);
 		reg->getp(2)->callWatchers();
 	}
 	return 0;	
@@ -92,12 +78,6 @@ static int execADDC(RegisterSet *reg, Memory *mem, Instruction *i) {
 	return add(reg, mem, i, true);
 }
 
-#define SET_SUB_OVERFLOW(REG, R, D, S, B) \
-	REG->getp(2)->setBit(SR_V, !(R & B) && !(S & B) && (D & B) ||\
-	((R & B) && (S & B) && !(D & B)));
-
-#define SET_SUB_C(REG, R, B) REG->getp(2)->setBit(SR_C, !(R < 0 || R > B));
-
 static int sub(RegisterSet *reg, Memory *mem, Instruction *i, bool store, bool carry) {
 	if (i->bw) {
 		int32_t d, s, r, c;
@@ -110,10 +90,7 @@ static int sub(RegisterSet *reg, Memory *mem, Instruction *i, bool store, bool c
 			i->getDst()->callWatchers();
 		}
 
-		SET_SUB_OVERFLOW(reg, r, d, s, 0x80);
-		SET_N(reg, r, 0x80);
-		SET_Z(reg, r, 0xff);
-		SET_C(reg, r, 0xff);
+		reg->getRegisterFile()->setFlags(FlagsSub, true, d, s, r);
 		reg->getp(2)->callWatchers();
 	}
 	else {
@@ -128,10 +105,7 @@ static int sub(RegisterSet *reg, Memory *mem, Instruction *i, bool store, bool c
 		}
 
 
-		SET_SUB_OVERFLOW(reg, r, d, s, 0x8000);
-		SET_N(reg, r, 0x8000);
-		SET_Z(reg, r, 0xffff);
-		SET_C(reg, r, 0xffff);
+		reg->getRegisterFile()->setFlags(FlagsSub, false, d, s, r);
 		reg->getp(2)->callWatchers();
 	}
 	return 0;
@@ -156,10 +130,7 @@ static int execBIT(RegisterSet *reg, Memory *mem, Instruction *i) {
 		s = (int32_t) i->getSrc()->getByte();
 		r = d & s;
 
-		SET_N(reg, r, 0x80);
-		SET_Z(reg, r, 0xff);
-		SET_C(reg, r, 0xff);
-		reg->getp(2)->setBit(SR_V, 0);
+		reg->getRegisterFile()->setFlags(FlagsBit, true, d, s, r);
 		reg->getp(2)->callWatchers();
 	}
 	else {
@@ -168,10 +139,7 @@ static int execBIT(RegisterSet *reg, Memory *mem, Instruction *i) {
 		s = (int32_t) i->getSrc()->getBigEndian();
 		r = d & s;
 
-		SET_N(reg, r, 0x8000);
-		SET_Z(reg, r, 0xffff);
-		SET_C(reg, r, 0xffff);
-		reg->getp(2)->setBit(SR_V, 0);
+		reg->getRegisterFile()->setFlags(FlagsBit, false, d, s, r);
 		reg->getp(2)->callWatchers();
 	}
 	return 0;
@@ -226,10 +194,7 @@ static int execXOR(RegisterSet *reg, Memory *mem, Instruction *i) {
 		i->getDst()->setByte(r);
 		i->getDst()->callWatchers();
 
-		SET_N(reg, r, 0x80);
-		SET_Z(reg, r, 0xff);
-		reg->getp(2)->setBit(SR_V, d < 0 && s < 0);
-		reg->getp(2)->setBit(SR_C, r != 0);
+		reg->getRegisterFile()->setFlags(FlagsLogic, true, d, s, r);
 		reg->getp(2)->callWatchers();
 	}
 	else {
@@ -240,10 +205,7 @@ static int execXOR(RegisterSet *reg, Memory *mem, Instruction *i) {
 		i->getDst()->setBigEndian(r);
 		i->getDst()->callWatchers();
 
-		SET_N(reg, r, 0x8000);
-		SET_Z(reg, r, 0xffff);
-		reg->getp(2)->setBit(SR_V, d < 0 && s < 0);
-		reg->getp(2)->setBit(SR_C, r != 0);
+		reg->getRegisterFile()->setFlags(FlagsLogic, false, d, s, r);
 		reg->getp(2)->callWatchers();
 	}
 	return 0;
@@ -258,10 +220,7 @@ static int execAND(RegisterSet *reg, Memory *mem, Instruction *i) {
 		i->getDst()->setByte(r);
 		i->getDst()->callWatchers();
 
-		SET_N(reg, r, 0x80);
-		SET_Z(reg, r, 0xff);
-		reg->getp(2)->setBit(SR_V, 0);
-		reg->getp(2)->setBit(SR_C, r != 0);
+		reg->getRegisterFile()->setFlags(FlagsLogic, true, d, s, r);
 		reg->getp(2)->callWatchers();
 	}
 	else {
@@ -272,10 +231,7 @@ static int execAND(RegisterSet *reg, Memory *mem, Instruction *i) {
 		i->getDst()->setBigEndian(r);
 		i->getDst()->callWatchers();
 
-		SET_N(reg, r, 0x8000);
-		SET_Z(reg, r, 0xffff);
-		reg->getp(2)->setBit(SR_V, 0);
-		reg->getp(2)->setBit(SR_C, r != 0);
+		reg->getRegisterFile()->setFlags(FlagsLogic, false, d, s, r);
 		reg->getp(2)->callWatchers();
 	}
 	return 0;
@@ -22,6 +22,7 @@
 #include "CPU/Memory/Memory.h"
 #include "CPU/Memory/RegisterSet.h"
 #include "CPU/Memory/Register.h"
+#include "CPU/Memory/RegisterFile.h"
 #include "CPU/Instructions/Instruction.h"
 #include <iostream>
 #include <algorithm>
@@ -29,7 +30,7 @@
 namespace MSP430 {
 
 InterruptManager::InterruptManager(RegisterSet *reg, Memory *mem, Variant *variant)
-: m_reg(reg), m_mem(mem), m_variant(variant) {
+: m_reg(reg), m_mem(mem), m_variant(variant), m_queueWatcher(0) {
 
 }
 
@@ -42,6 +43,10 @@ void InterruptManager::queueInterrupt(int vector) {
 		m_interrupts.push_back(vector);
 		std::sort(m_interrupts.begin(), m_interrupts.end());
 	}
+
+	if (m_queueWatcher) {
+		m_queueWatcher->handleInterruptQueued(this, vector);
+	}
 }
 
 void InterruptManager::handleInstruction(Instruction *instruction) {
@@ -66,12 +71,12 @@ void InterruptManager::runInterrupt(int vector) {
 	// Push PC on stack
 	v = sp->getBigEndian() - 2;
 	sp->setBigEndian(v);
-	m_mem->setBigEndian(v, m_reg->get(0)->getBigEndian());
+	m_mem->setWord(v, m_reg->get(0)->getBigEndian());
 
 	// Push SR on stack
 	v = sp->getBigEndian() - 2;
 	sp->setBigEndian(v);
-	m_mem->setBigEndian(v, m_reg->get(2)->getBigEndian());
+	m_mem->setWord(v, m_reg->get(2)->getBigEndian());
 
 	// TODO: clear interrupt request flags for single-source interrupts.
 	// We don't handle any interrupt like that yet
@@ -81,7 +86,7 @@ void InterruptManager::runInterrupt(int vector) {
 	m_reg->get(2)->callWatchers();
 
 	// Load content of interrupt vector to PC
-	m_reg->get(0)->setBigEndian(m_mem->getBigEndian(m_variant->getINTVECT() + vector));
+	m_reg->get(0)->setBigEndian(m_mem->getWord(m_variant->getINTVECT() + vector));
 	m_reg->getp(0)->callWatchers();
 
 	m_runningInterrupts.push_back(vector);
@@ -103,6 +108,14 @@ bool InterruptManager::hasQueuedInterrupts() {
 	return !m_interrupts.empty();
 }
 
+bool InterruptManager::isAccepted(int vector) {
+	if (m_variant->getINTVECT() + vector >= 0xfffc) {
+		return true;
+	}
+
+	return m_reg->getRegisterFile()->values[2] & SR_GIE;
+}
+
 void InterruptManager::clearQueuedInterrupts() {
 	m_interrupts.clear();
 }
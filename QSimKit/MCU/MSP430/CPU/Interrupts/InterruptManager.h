@@ -37,6 +37,13 @@ class InterruptWatcher {
 		virtual void handleInterruptFinished(InterruptManager *intManager, int vector) = 0;
 };
 
+/// Watches for newly queued interrupts. Used to wake up the CPU from
+/// low-power mode.
+class InterruptQueueWatcher {
+	public:
+		virtual void handleInterruptQueued(InterruptManager *intManager, int vector) = 0;
+};
+
 class InterruptManager {
 	public:
 		InterruptManager(RegisterSet *reg, Memory *mem, Variant *variant);
@@ -52,10 +59,25 @@ class InterruptManager {
 
 		bool hasQueuedInterrupts();
 
+		/// Returns true when the interrupt can wake up the CPU. Maskable
+		/// interrupts need GIE set, NMI and reset at the top of the vector
+		/// table always wake it up.
+		bool isAccepted(int vector);
+
+		/// Returns vector of the interrupt which is being handled right now,
+		/// or -1 when no interrupt is running.
+		int getRunningInterrupt() {
+			return m_runningInterrupts.empty() ? -1 : m_runningInterrupts.back();
+		}
+
 		void clearQueuedInterrupts();
 
 		void addWatcher(int vector, InterruptWatcher *watcher);
 
+		void setQueueWatcher(InterruptQueueWatcher *watcher) {
+			m_queueWatcher = watcher;
+		}
+
 		void reset();
 
 	private:
@@ -65,6 +87,7 @@ class InterruptManager {
 		std::vector<int> m_interrupts;
 		std::vector<int> m_runningInterrupts;
 		std::map<int, std::vector<InterruptWatcher *> > m_watchers;
+		InterruptQueueWatcher *m_queueWatcher;
 };
 
 }
@@ -22,22 +22,55 @@
 #include "CPU/Memory/Register.h"
 
 #include <iostream>
-#include <sstream>
 #include <algorithm>
+#include <string.h>
 
 namespace MSP430 {
 
-static unsigned int hexToInt(const std::string &str) {
-	unsigned int x;
-	std::stringstream ss;
-	ss << std::hex << str;
-	ss >> x;
-	return x;
+/// Value of every hex digit character, -1 for the other characters.
+class HexDigits {
+	public:
+		HexDigits() {
+			memset(values, -1, sizeof(values));
+			for (int i = 0; i < 10; ++i) {
+				values['0' + i] = i;
+			}
+			for (int i = 0; i < 6; ++i) {
+				values['a' + i] = 10 + i;
+				values['A' + i] = 10 + i;
+			}
+		}
+
+		int8_t values[256];
+};
+
+static const HexDigits hexDigits;
+
+// Reads the byte written as two hex digits and adds it to the checksum
+static inline bool readHexByte(const char *&it, const char *end, uint8_t &byte, uint8_t &checksum) {
+	if (end - it < 2) {
+		return false;
+	}
+
+	int high = hexDigits.values[(uint8_t) it[0]];
+	int low = hexDigits.values[(uint8_t) it[1]];
+	if ((high | low) < 0) {
+		return false;
+	}
+
+	byte = high << 4 | low;
+	checksum += byte;
+	it += 2;
+	return true;
 }
 
-Memory::Memory(unsigned int size) : m_size(size) {
-	m_watchers.resize(m_size);
-	m_readWatchers.resize(m_size);
+Memory::Memory(unsigned int size) : m_hasEntryPoint(false), m_entryPoint(0), m_size(std::min(size, (unsigned int) MEMORY_ADDRESS_SPACE)) {
+	// Word access at the last address touches one byte more
+	m_watchedMask.resize(m_size + 1);
+	m_pages.resize(MEMORY_PAGES);
+	m_peripheralWatchers.resize(MEMORY_PERIPHERALS_END);
+	m_peripheralReadWatchers.resize(MEMORY_PERIPHERALS_END);
+	m_image.resize(m_size + 1);
 
 	reset();
 }
@@ -46,149 +79,258 @@ Memory::~Memory() {
 }
 
 void Memory::reset() {
-	m_memory.clear();
-	m_memory.resize(m_size);
-
-	for (int i = 0; i < m_size; ++i) {
-		m_memory[i] = 0;
-	}
+	m_memory = m_image;
 }
 
-
-#define LOAD_DIGIT \
-		if (++it == data.end()) { return false; } \
-		if (*it < '0' || (*it > '9' && *it < 'A' && *it > 'F' && *it < 'a' && *it > 'f')) { return false; } \
-		byte += *it;
-
-#define LOAD_BYTE(X) \
-		byte = "";\
-		LOAD_DIGIT; \
-		LOAD_DIGIT; \
-		X = hexToInt(byte);
-
-#define LOAD_2BYTES(X) \
-		byte = "";\
-		LOAD_DIGIT; \
-		LOAD_DIGIT; \
-		LOAD_DIGIT; \
-		LOAD_DIGIT; \
-		X = hexToInt(byte);
-
 bool Memory::loadA43(const std::string &data, RegisterSet *reg) {
-	unsigned int byte_count;
-	unsigned int address;
-	unsigned int record_type;
-	unsigned int checksum;
-	unsigned int default_ip;
-	std::string byte;
-	for (std::string::const_iterator it = data.begin(); it != data.end(); ++it) {
+	// The program is parsed to the new image, so the memory is not changed
+	// when the data are not valid.
+	std::vector<uint8_t> image(m_size + 1, 0);
+	std::vector<Span> spans;
+	bool hasEntryPoint = false;
+	uint16_t entryPoint = 0;
+
+	const char *it = data.data();
+	const char *end = it + data.size();
+	while (it != end) {
 		if (*it == '\n' || *it == '\r') {
+			++it;
 			continue;
 		}
 
-		if (*it != ':') {
+		if (*it++ != ':') {
 			return false;
 		}
 
-		LOAD_BYTE(byte_count);
-		LOAD_2BYTES(address);
-		LOAD_BYTE(record_type);
+		uint8_t checksum = 0;
+		uint8_t byte_count, address_high, address_low, record_type, byte;
+		if (!readHexByte(it, end, byte_count, checksum) ||
+			!readHexByte(it, end, address_high, checksum) ||
+			!readHexByte(it, end, address_low, checksum) ||
+			!readHexByte(it, end, record_type, checksum)) {
+			return false;
+		}
+
+		unsigned int address = address_high << 8 | address_low;
 		switch (record_type) {
 			case 0:
-				for (int i = 0; i < byte_count; i++, address++) {
-					LOAD_BYTE(m_memory[address]);
+				if (address + byte_count > m_size) {
+					return false;
+				}
+				for (int i = 0; i < byte_count; ++i) {
+					if (!readHexByte(it, end, image[address + i], checksum)) {
+						return false;
+					}
+				}
+
+				// Records are usually continuous, so keep them in one span
+				if (!spans.empty() && spans.back().end == address) {
+					spans.back().end += byte_count;
+				}
+				else {
+					spans.push_back(Span(address, address + byte_count));
 				}
 				break;
 			case 3:
 				if (byte_count != 4) {
 					return false;
 				}
-				LOAD_2BYTES(default_ip);
-				LOAD_2BYTES(default_ip);
-
-				// Default PC is stored as big endian
-				reg->get(0)->setBigEndian(default_ip);
+				// CS:IP, only IP is used as the default PC
+				for (int i = 0; i < 4; ++i) {
+					if (!readHexByte(it, end, byte, checksum)) {
+						return false;
+					}
+					entryPoint = entryPoint << 8 | byte;
+				}
+				hasEntryPoint = true;
 				break;
-			case 1:
-				// We have reached End of File
-				return true;
 			default:
+				for (int i = 0; i < byte_count; ++i) {
+					if (!readHexByte(it, end, byte, checksum)) {
+						return false;
+					}
+				}
 				break;
 		}
-		LOAD_BYTE(checksum);
+
+		// Sum of all the record bytes including the checksum is zero
+		if (!readHexByte(it, end, byte, checksum) || checksum != 0) {
+			return false;
+		}
+
+		if (record_type == 1) {
+			// We have reached End of File
+			loadImage(image, spans, hasEntryPoint, entryPoint, reg);
+			return true;
+		}
 	}
 
 	return false;
 }
 
+static inline uint16_t readELF16(const uint8_t *data) {
+	return data[0] | data[1] << 8;
+}
+
+static inline uint32_t readELF32(const uint8_t *data) {
+	return data[0] | data[1] << 8 | data[2] << 16 | (uint32_t) data[3] << 24;
+}
+
+#define ELF_HEADER_SIZE 52
+#define ELF_PROGRAM_HEADER_SIZE 32
+#define ELF_PT_LOAD 1
+#define ELF_EM_MSP430 105
+#define ELF_EM_MSP430_OLD 0x1059
+
+bool Memory::loadELF(const std::string &data, RegisterSet *reg) {
+	const uint8_t *elf = (const uint8_t *) data.data();
+	if (data.size() < ELF_HEADER_SIZE || memcmp(elf, "\x7f" "ELF", 4) != 0) {
+		return false;
+	}
+
+	// 32-bit little endian MSP430 executable
+	uint16_t machine = readELF16(&elf[18]);
+	if (elf[4] != 1 || elf[5] != 1 ||
+		(machine != ELF_EM_MSP430 && machine != ELF_EM_MSP430_OLD)) {
+		return false;
+	}
+
+	uint32_t phoff = readELF32(&elf[28]);
+	uint16_t phentsize = readELF16(&elf[42]);
+	uint16_t phnum = readELF16(&elf[44]);
+	if (phentsize < ELF_PROGRAM_HEADER_SIZE ||
+		phoff > data.size() || (data.size() - phoff) / phentsize < phnum) {
+		return false;
+	}
+
+	std::vector<uint8_t> image(m_size + 1, 0);
+	std::vector<Span> spans;
+	for (int i = 0; i < phnum; ++i) {
+		const uint8_t *ph = &elf[phoff + i * phentsize];
+		uint32_t offset = readELF32(&ph[4]);
+		// Segments are loaded to their physical (load) address, so the
+		// initialized data are stored in flash like msp430-objcopy does
+		uint32_t address = readELF32(&ph[12]);
+		uint32_t size = readELF32(&ph[16]);
+		if (readELF32(&ph[0]) != ELF_PT_LOAD || size == 0) {
+			continue;
+		}
+
+		if (offset > data.size() || size > data.size() - offset ||
+			address > m_size || size > m_size - address) {
+			return false;
+		}
+
+		memcpy(&image[address], &elf[offset], size);
+		spans.push_back(Span(address, address + size));
+	}
+
+	loadImage(image, spans, true, readELF32(&elf[24]) & 0xffff, reg);
+	return true;
+}
+
+void Memory::loadImage(std::vector<uint8_t> &image, const std::vector<Span> &spans, bool hasEntryPoint, uint16_t entryPoint, RegisterSet *reg) {
+	for (std::vector<Span>::const_iterator s = spans.begin(); s != spans.end(); ++s) {
+		memcpy(&m_memory[s->start], &image[s->start], s->end - s->start);
+	}
+	m_image.swap(image);
+	m_hasEntryPoint = hasEntryPoint;
+	m_entryPoint = entryPoint;
+	m_spans = spans;
+	loadEntryPoint(reg);
+}
+
+bool Memory::loadEntryPoint(RegisterSet *reg) {
+	if (!m_hasEntryPoint) {
+		return false;
+	}
+
+	// Default PC is stored as big endian
+	reg->get(0)->setBigEndian(m_entryPoint);
+	return true;
+}
+
 uint16_t Memory::get(uint16_t address) {
-	uint16_t w;
-	uint8_t *ptr = (uint8_t *) &w;
-	*ptr++ = m_memory[address + 1];
-	*ptr++ = m_memory[address];
-	callReadWatcher(address, w);
-	return w;
+	uint16_t w = getWord(address);
+	return (w >> 8) | (w << 8);
 }
 
 uint16_t Memory::getBigEndian(uint16_t address, bool watchers) {
-	uint16_t w;
-	uint8_t *ptr = (uint8_t *) &w;
-	*ptr++ = m_memory[address];
-	*ptr++ = m_memory[address + 1];
-	if (watchers) {
-		callReadWatcher(address, w);
+	return getWord(address, watchers);
+}
+
+bool Memory::isWatched(uint16_t address, MemoryWatcher::Mode mode) {
+	switch (mode) {
+		case MemoryWatcher::Read:
+			return m_watchedMask[address] & MEMORY_READ_WATCHED;
+		case MemoryWatcher::Write:
+			return m_watchedMask[address] & MEMORY_WRITE_WATCHED;
+		case MemoryWatcher::ReadWrite:
+			return m_watchedMask[address] != 0;
+	}
+	return false;
+}
+
+Memory::Watchers *Memory::findWatchers(uint16_t address, bool read) {
+	if (address < MEMORY_PERIPHERALS_END) {
+		return read ? &m_peripheralReadWatchers[address] : &m_peripheralWatchers[address];
 	}
-	return w;
+
+	WatcherMap &map = read ? m_readWatchers : m_watchers;
+	WatcherMap::iterator it = map.find(address);
+	return it == map.end() ? 0 : &it->second;
 }
 
 void Memory::callWatcher(uint16_t address) {
-	std::vector<MemoryWatcher *> &watchers = m_watchers[address];
-	if (watchers.empty())
+	if (!m_pages[address >> MEMORY_PAGE_SHIFT].watched || !(m_watchedMask[address] & MEMORY_WRITE_WATCHED))
+		return;
+
+	Watchers *watchers = findWatchers(address, false);
+	if (!watchers)
 		return;
 
-	for (std::vector<MemoryWatcher *>::const_iterator it = watchers.begin(); it != watchers.end(); ++it) {
+	for (Watchers::const_iterator it = watchers->begin(); it != watchers->end(); ++it) {
 		(*it)->handleMemoryChanged(this, address);
 	}
 }
 
 void Memory::callReadWatcher(uint16_t address, uint16_t &value) {
-	std::vector<MemoryWatcher *> &watchers = m_readWatchers[address];
-	if (watchers.empty())
+	if (!m_pages[address >> MEMORY_PAGE_SHIFT].readWatched)
 		return;
 
-	for (std::vector<MemoryWatcher *>::const_iterator it = watchers.begin(); it != watchers.end(); ++it) {
+	Watchers *watchers = findWatchers(address, true);
+	if (!watchers)
+		return;
+
+	for (Watchers::const_iterator it = watchers->begin(); it != watchers->end(); ++it) {
 		(*it)->handleMemoryRead(this, address, value);
 	}
 }
 
 void Memory::callReadWatcher(uint16_t address, uint8_t &value) {
-	std::vector<MemoryWatcher *> &watchers = m_readWatchers[address];
-	if (watchers.empty())
+	if (!m_pages[address >> MEMORY_PAGE_SHIFT].readWatched)
+		return;
+
+	Watchers *watchers = findWatchers(address, true);
+	if (!watchers)
 		return;
 
-	for (std::vector<MemoryWatcher *>::const_iterator it = watchers.begin(); it != watchers.end(); ++it) {
+	for (Watchers::const_iterator it = watchers->begin(); it != watchers->end(); ++it) {
 		(*it)->handleMemoryRead(this, address, value);
 	}
 }
 
 void Memory::set(uint16_t address, uint16_t value) {
-	uint8_t *ptr2 = (uint8_t *) &value;
-	m_memory[address] = *(ptr2 + 1);
-	m_memory[address + 1] = *ptr2;
-
-	callWatcher(address);
-	callWatcher(address + 1);
+	setWord(address, (value >> 8) | (value << 8));
 }
 
 void Memory::setBigEndian(uint16_t address, uint16_t value, bool watchers) {
-	uint8_t *ptr2 = (uint8_t *) &value;
-	m_memory[address] = *(ptr2);
-	m_memory[address + 1] = *(ptr2 + 1);
+	setWord(address, value, watchers);
+}
 
-	if (watchers) {
-		callWatcher(address);
-		callWatcher(address + 1);
-	}
+void Memory::callWordWatchers(uint16_t address) {
+	callWatcher(address);
+	callWatcher(address + 1);
 }
 
 uint8_t Memory::getByte(uint16_t address, bool watchers) {
@@ -206,48 +348,82 @@ void Memory::setByte(uint16_t address, uint8_t value, bool watchers) {
 	}
 }
 
+void Memory::addToList(uint16_t address, bool read, MemoryWatcher *watcher) {
+	if (address < MEMORY_PERIPHERALS_END) {
+		findWatchers(address, read)->push_back(watcher);
+	}
+	else {
+		(read ? m_readWatchers : m_watchers)[address].push_back(watcher);
+	}
+}
+
+void Memory::removeFromList(uint16_t address, bool read, MemoryWatcher *watcher) {
+	Watchers *watchers = findWatchers(address, read);
+	if (!watchers) {
+		return;
+	}
+
+	Watchers::iterator it = std::find(watchers->begin(), watchers->end(), watcher);
+	if (it != watchers->end()) {
+		watchers->erase(it);
+	}
+
+	if (watchers->empty() && address >= MEMORY_PERIPHERALS_END) {
+		(read ? m_readWatchers : m_watchers).erase(address);
+	}
+}
+
 void Memory::addWatcher(uint16_t address, MemoryWatcher *watcher, MemoryWatcher::Mode mode) {
 	switch (mode) {
 		case MemoryWatcher::Read:
-			m_readWatchers[address].push_back(watcher);
+			addToList(address, true, watcher);
 			break;
 		case MemoryWatcher::Write:
-			m_watchers[address].push_back(watcher);
+			addToList(address, false, watcher);
 			break;
 		case MemoryWatcher::ReadWrite:
-			m_readWatchers[address].push_back(watcher);
-			m_watchers[address].push_back(watcher);
+			addToList(address, true, watcher);
+			addToList(address, false, watcher);
 			break;
 	}
+
+	updateWatchedMask(address);
 }
 
 void Memory::removeWatcher(uint16_t address, MemoryWatcher *watcher, MemoryWatcher::Mode mode) {
-	std::vector<MemoryWatcher *>::iterator it;
 	switch (mode) {
 		case MemoryWatcher::Read:
-			it = std::find(m_readWatchers[address].begin(), m_readWatchers[address].end(), watcher);
-			if (it != m_readWatchers[address].end()) {
-				m_readWatchers[address].erase(it);
-			}
+			removeFromList(address, true, watcher);
 			break;
 		case MemoryWatcher::Write:
-			it = std::find(m_watchers[address].begin(), m_watchers[address].end(), watcher);
-			if (it != m_watchers[address].end()) {
-				m_watchers[address].erase(it);
-			}
+			removeFromList(address, false, watcher);
 			break;
 		case MemoryWatcher::ReadWrite:
-			it = std::find(m_readWatchers[address].begin(), m_readWatchers[address].end(), watcher);
-			if (it != m_readWatchers[address].end()) {
-				m_readWatchers[address].erase(it);
-			}
-
-			it = std::find(m_watchers[address].begin(), m_watchers[address].end(), watcher);
-			if (it != m_watchers[address].end()) {
-				m_watchers[address].erase(it);
-			}
+			removeFromList(address, true, watcher);
+			removeFromList(address, false, watcher);
 			break;
 	}
+
+	updateWatchedMask(address);
+}
+
+void Memory::updateWatchedMask(uint16_t address) {
+	Watchers *read = findWatchers(address, true);
+	Watchers *write = findWatchers(address, false);
+	uint8_t mask = (read && !read->empty() ? MEMORY_READ_WATCHED : 0) |
+		(write && !write->empty() ? MEMORY_WRITE_WATCHED : 0);
+
+	// Keep the number of watched addresses in the page up to date
+	Page &page = m_pages[address >> MEMORY_PAGE_SHIFT];
+	uint8_t changed = mask ^ m_watchedMask[address];
+	if (changed & MEMORY_READ_WATCHED) {
+		page.readWatched += (mask & MEMORY_READ_WATCHED) ? 1 : -1;
+	}
+	if (changed & MEMORY_WRITE_WATCHED) {
+		page.watched += (mask & MEMORY_WRITE_WATCHED) ? 1 : -1;
+	}
+
+	m_watchedMask[address] = mask;
 }
 
 bool Memory::isBitSet(uint16_t address, uint16_t bit) {
@@ -20,6 +20,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <string.h>
 #include <string>
 #include <vector>
 #include <map>
@@ -30,13 +31,71 @@ namespace MSP430 {
 
 class RegisterSet;
 
+#define MEMORY_READ_WATCHED 1
+#define MEMORY_WRITE_WATCHED 2
+
+/// Size of the 16-bit address space
+#define MEMORY_ADDRESS_SPACE 0x10000
+
+/// Memory map is divided into pages of 512 bytes. The first page contains
+/// special function registers and peripherals, the rest is RAM and flash.
+#define MEMORY_PAGE_SHIFT 9
+#define MEMORY_PAGES (MEMORY_ADDRESS_SPACE >> MEMORY_PAGE_SHIFT)
+#define MEMORY_PAGE_MASK ((1 << MEMORY_PAGE_SHIFT) - 1)
+#define MEMORY_PERIPHERALS_END 0x0200
+
 class Memory : public ::Memory {
 	public:
+		/// Range of the image loaded from the program records.
+		class Span {
+			public:
+				Span(unsigned int start, unsigned int end) : start(start), end(end) {}
+
+				unsigned int start;
+				unsigned int end;
+		};
+
+		/// Size larger than the 16-bit address space is limited to it.
 		Memory(unsigned int size);
 		virtual ~Memory();
 
+		/// Loads the program in Intel HEX (A43) format. Records are validated
+		/// against their checksums and the program is kept as an image which
+		/// is restored by reset(). Returns false if the data are not valid,
+		/// the memory is not changed in that case.
 		bool loadA43(const std::string &data, RegisterSet *reg);
 
+		/// Loads PT_LOAD segments of the ELF32 executable to their load
+		/// addresses and sets PC to its entry point. The program is kept as
+		/// an image the same way as by loadA43().
+		bool loadELF(const std::string &data, RegisterSet *reg);
+
+		/// Sets PC to the start address of the loaded program. Returns false
+		/// if the program does not have any.
+		bool loadEntryPoint(RegisterSet *reg);
+
+		/// Returns the word at the address in the host byte order, which is
+		/// the MSP430 byte order on little-endian hosts. This is the fast
+		/// path used by the CPU and peripherals: the word is loaded at once
+		/// and the watchers are looked for only when its page has some.
+		uint16_t getWord(uint16_t address, bool watchers = true) {
+			uint16_t w;
+			memcpy(&w, &m_memory[address], sizeof(w));
+			if (watchers && m_pages[address >> MEMORY_PAGE_SHIFT].readWatched) {
+				callReadWatcher(address, w);
+			}
+			return w;
+		}
+
+		/// Stores the word in the host byte order. Watchers of both bytes
+		/// are called when any of them is watched.
+		void setWord(uint16_t address, uint16_t value, bool watchers = true) {
+			memcpy(&m_memory[address], &value, sizeof(value));
+			if (watchers && isWordWatched(address)) {
+				callWordWatchers(address);
+			}
+		}
+
 		uint16_t get(uint16_t address);
 		uint16_t getBigEndian(uint16_t address, bool watchers = true);
 		void set(uint16_t address, uint16_t value);
@@ -48,6 +107,24 @@ class Memory : public ::Memory {
 		void addWatcher(uint16_t address, MemoryWatcher *watcher, MemoryWatcher::Mode mode = MemoryWatcher::Write);
 		void removeWatcher(uint16_t address, MemoryWatcher *watcher, MemoryWatcher::Mode mode = MemoryWatcher::ReadWrite);
 
+		/// Returns true if there is any watcher with given mode registered
+		/// for the address.
+		bool isWatched(uint16_t address, MemoryWatcher::Mode mode = MemoryWatcher::ReadWrite);
+
+		/// Returns watched flags for every address and one byte more, so
+		/// the word at the last address can be checked. MEMORY_READ_WATCHED bit
+		/// is set if the address has a read watcher and MEMORY_WRITE_WATCHED
+		/// if it has a write watcher.
+		const uint8_t *getWatchedMask() {
+			return &m_watchedMask[0];
+		}
+
+		/// Returns the raw memory content. Accessing the memory using it
+		/// does not call any watchers.
+		uint8_t *getData() {
+			return &m_memory[0];
+		}
+
 		void callWatcher(uint16_t address);
 		void callReadWatcher(uint16_t address, uint16_t &value);
 		void callReadWatcher(uint16_t address, uint8_t &value);
@@ -56,12 +133,64 @@ class Memory : public ::Memory {
 		void setBit(uint16_t address, uint16_t bit, bool value);
 		void setBitWatcher(uint16_t address, uint16_t bit, bool value);
 
+		/// Restores the memory to the loaded program image.
 		void reset();
 
+		/// Returns the address ranges of the loaded program.
+		const std::vector<Span> &getLoadedSpans() {
+			return m_spans;
+		}
+
+	private:
+		typedef std::vector<MemoryWatcher *> Watchers;
+		typedef std::map<uint16_t, Watchers> WatcherMap;
+
+		/// Number of watched addresses in the page. Accesses to the pages
+		/// without watchers do not look for the watchers at all.
+		class Page {
+			public:
+				Page() : watched(0), readWatched(0) {}
+
+				unsigned int watched;
+				unsigned int readWatched;
+		};
+
+		bool isWordWatched(uint16_t address) {
+			// Only the word at the last address of a page spans two pages
+			bool pageWatched = m_pages[address >> MEMORY_PAGE_SHIFT].watched ||
+				((address & MEMORY_PAGE_MASK) == MEMORY_PAGE_MASK &&
+				m_pages[(uint16_t) (address + 1) >> MEMORY_PAGE_SHIFT].watched);
+
+			// Pages with the code have the decoded instructions watched, so
+			// the stores to the other bytes of these pages are filtered
+			// by the per-address mask
+			return pageWatched && ((m_watchedMask[address] | m_watchedMask[address + 1]) & MEMORY_WRITE_WATCHED);
+		}
+
+		void callWordWatchers(uint16_t address);
+		void loadImage(std::vector<uint8_t> &image, const std::vector<Span> &spans, bool hasEntryPoint, uint16_t entryPoint, RegisterSet *reg);
+		Watchers *findWatchers(uint16_t address, bool read);
+		void addToList(uint16_t address, bool read, MemoryWatcher *watcher);
+		void removeFromList(uint16_t address, bool read, MemoryWatcher *watcher);
+		void updateWatchedMask(uint16_t address);
+
 	private:
 		std::vector<uint8_t> m_memory;
-		std::vector<std::vector<MemoryWatcher *> > m_watchers;
-		std::vector<std::vector<MemoryWatcher *> > m_readWatchers;
+		// Memory content after reset, zeroes and the loaded program
+		std::vector<uint8_t> m_image;
+		bool m_hasEntryPoint;
+		uint16_t m_entryPoint;
+		std::vector<Span> m_spans;
+		// Watched flags of every address, used by isWatched() and the JIT
+		std::vector<uint8_t> m_watchedMask;
+		std::vector<Page> m_pages;
+		// Handlers of the peripheral registers indexed by address
+		std::vector<Watchers> m_peripheralWatchers;
+		std::vector<Watchers> m_peripheralReadWatchers;
+		// RAM and flash are watched only by few breakpoints or tracked
+		// variables
+		WatcherMap m_watchers;
+		WatcherMap m_readWatchers;
 		unsigned int m_size;
 };
 
@@ -22,51 +22,32 @@
 
 namespace MSP430 {
 
-Register::Register(int id, const std::string &name, uint16_t value, const std::string &desc) :
-	m_id(id), m_value(value), m_name(name), m_desc(desc) { }
+Register::Register(RegisterFile *file, int id, const std::string &name, uint16_t value, const std::string &desc) :
+	m_file(file), m_id(id), m_name(name), m_desc(desc) {
+	m_file->set(m_id, value);
+}
 
 Register::~Register() {
 
 }
 
 uint16_t Register::get() {
-// 	return m_value;
+	uint16_t value = getBigEndian();
 	uint16_t w;
 	uint8_t *ptr = (uint8_t *) &w;
-	uint8_t *ptr2 = (uint8_t *) &m_value;
+	uint8_t *ptr2 = (uint8_t *) &value;
 	*ptr++ = *(ptr2 + 1);
 	*ptr++ = *ptr2;
 	return w;
 }
 
-uint16_t Register::getBigEndian() {
-	return m_value;
-// 	uint16_t w;
-// 	uint8_t *ptr = (uint8_t *) &w;
-// 	uint8_t *ptr2 = (uint8_t *) &m_value;
-// 	*ptr++ = *(ptr2 + 1);
-// 	*ptr++ = *ptr2;
-// 	return w;
-}
-
 void Register::set(uint16_t value) {
-	uint8_t *ptr = (uint8_t *) &m_value;
+	uint16_t w;
+	uint8_t *ptr = (uint8_t *) &w;
 	uint8_t *ptr2 = (uint8_t *) &value;
 	*ptr++ = *(ptr2 + 1);
 	*ptr++ = *ptr2;
-}
-
-void Register::setBigEndian(uint16_t value) {
-	m_value = value;
-}
-
-uint8_t Register::getByte() {
-	return (uint8_t) m_value;
-}
-
-void Register::setByte(uint8_t value) {
-	uint8_t *ptr = (uint8_t *) &m_value;
-	*ptr = value;
+	setBigEndian(w);
 }
 
 bool Register::isBitSet(uint16_t bit) {
@@ -89,6 +70,7 @@ bool Register::setBit(uint16_t bit, bool value) {
 void Register::addWatcher(RegisterWatcher *watcher) {
 	if (std::find(m_watchers.begin(), m_watchers.end(), watcher) == m_watchers.end()) {
 		m_watchers.push_back(watcher);
+		m_file->watched |= 1 << m_id;
 	}
 }
 
@@ -97,9 +79,10 @@ void Register::callWatchers() {
 		return;
 
 	std::vector<RegisterWatcher *> toRemove;
+	uint16_t value = getBigEndian();
 
 	for (std::vector<RegisterWatcher *>::const_iterator it = m_watchers.begin(); it != m_watchers.end(); ++it) {
-		if (!(*it)->handleRegisterChanged(this, m_id, m_value)) {
+		if (!(*it)->handleRegisterChanged(this, m_id, value)) {
 			toRemove.push_back(*it);
 		}
 	}
@@ -115,6 +98,10 @@ void Register::removeWatcher(RegisterWatcher *watcher) {
 	if (it != m_watchers.end()) {
 		m_watchers.erase(it);
 	}
+
+	if (m_watchers.empty()) {
+		m_file->watched &= ~(1 << m_id);
+	}
 }
 
 }
@@ -24,22 +24,12 @@
 #include <vector>
 
 #include "CPU/Instructions/InstructionArgument.h"
+#include "CPU/Memory/RegisterFile.h"
 
 #include "QSimKit/MCU/Register.h"
 
 namespace MSP430 {
 
-/// Status register bits
-#define SR_V 256
-#define SR_SCG1 128
-#define SR_SCG0 64
-#define SR_OSC_OFF 32
-#define SR_CPU_OFF 16
-#define SR_GIE 8
-#define SR_N 4
-#define SR_Z 2
-#define SR_C 1
-
 class Register;
 
 // class RegisterWatcher {
@@ -49,30 +39,40 @@ class Register;
 
 class Register : public InstructionArgument, public ::Register {
 	public:
-		Register(int id, const std::string &name, uint16_t value, const std::string &desc = "");
+		Register(RegisterFile *file, int id, const std::string &name, uint16_t value, const std::string &desc = "");
 		virtual ~Register();
 
 		uint16_t get();
-		uint16_t getBigEndian();
+		uint16_t getBigEndian() {
+			return m_file->get(m_id);
+		}
 		void set(uint16_t value);
-		void setBigEndian(uint16_t value);
+		void setBigEndian(uint16_t value) {
+			m_file->set(m_id, value);
+		}
 
-		uint8_t getByte();
-		void setByte(uint8_t value);
+		uint8_t getByte() {
+			return (uint8_t) m_file->get(m_id);
+		}
+		void setByte(uint8_t value) {
+			m_file->set(m_id, (m_file->get(m_id) & 0xff00) | value);
+		}
 
 		bool isBitSet(uint16_t bit);
 		bool setBit(uint16_t bit, bool value = true);
 
 		void addWatcher(RegisterWatcher *watcher);
 		void callWatchers();
+		bool hasWatchers() {
+			return m_file->watched & (1 << m_id);
+		}
 		void removeWatcher(RegisterWatcher *watcher);
 
 	private:
+		RegisterFile *m_file;
 		int m_id;
-		uint16_t m_value;
 		std::string m_name;
 		std::string m_desc;
 		std::vector<RegisterWatcher *> m_watchers;
 };
-
 }
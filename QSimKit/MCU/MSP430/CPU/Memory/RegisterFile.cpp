@@ -0,0 +1,75 @@
+/**
+ * QSimKit - MSP430 simulator
+ * Copyright (C) 2013 Jan "HanzZ" Kaluza (hanzz.k@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#include "CPU/Memory/RegisterFile.h"
+
+namespace MSP430 {
+
+void RegisterFile::computeFlags() {
+	int32_t b = flagsBw ? 0x80 : 0x8000;
+	int32_t m = flagsBw ? 0xff : 0xffff;
+	int32_t r = flagsResult;
+	int32_t d = flagsDst;
+	int32_t s = flagsSrc;
+	uint16_t sr = values[2] & ~SR_FLAGS;
+
+	if (r & b) {
+		sr |= SR_N;
+	}
+
+	if ((r & m) == 0) {
+		sr |= SR_Z;
+	}
+
+	switch (flagsOp) {
+		case FlagsAdd:
+			if ((!(r & b) && (s & b) && (d & b)) || ((r & b) && !(s & b) && !(d & b))) {
+				sr |= SR_V;
+			}
+			if (r < 0 || r > m) {
+				sr |= SR_C;
+			}
+			break;
+		case FlagsSub:
+			if ((!(r & b) && !(s & b) && (d & b)) || ((r & b) && (s & b) && !(d & b))) {
+				sr |= SR_V;
+			}
+			if (r < 0 || r > m) {
+				sr |= SR_C;
+			}
+			break;
+		case FlagsBit:
+			if (r < 0 || r > m) {
+				sr |= SR_C;
+			}
+			break;
+		case FlagsLogic:
+			if (r != 0) {
+				sr |= SR_C;
+			}
+			break;
+		default:
+			break;
+	}
+
+	values[2] = sr;
+	flagsOp = FlagsNone;
+}
+
+}
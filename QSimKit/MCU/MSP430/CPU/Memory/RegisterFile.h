@@ -0,0 +1,114 @@
+/**
+ * QSimKit - MSP430 simulator
+ * Copyright (C) 2013 Jan "HanzZ" Kaluza (hanzz.k@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+namespace MSP430 {
+
+/// Status register bits
+#define SR_V 256
+#define SR_SCG1 128
+#define SR_SCG0 64
+#define SR_OSC_OFF 32
+#define SR_CPU_OFF 16
+#define SR_GIE 8
+#define SR_N 4
+#define SR_Z 2
+#define SR_C 1
+
+#define SR_FLAGS (SR_V | SR_N | SR_Z | SR_C)
+
+/// Operation which has set the N, Z, C and V flags last time.
+typedef enum {
+	FlagsNone,
+	FlagsAdd,
+	FlagsSub,
+	FlagsBit,
+	FlagsLogic,
+} FlagsOperation;
+
+/// Values of all CPU registers stored as plain data, so they fit in single
+/// cache line. The N, Z, C and V flags are not computed by the instructions.
+/// Only the operands and result of the last operation are stored and the
+/// flags are computed when the status register is read.
+class RegisterFile {
+	public:
+		RegisterFile() {
+			memset(values, 0, sizeof(values));
+			watched = 0;
+			flagsOp = FlagsNone;
+			flagsBw = false;
+			flagsDst = 0;
+			flagsSrc = 0;
+			flagsResult = 0;
+		}
+
+		uint16_t get(unsigned int reg) {
+			if (reg == 2) {
+				return getSR();
+			}
+			return values[reg];
+		}
+
+		void set(unsigned int reg, uint16_t value) {
+			if (reg == 2) {
+				flagsOp = FlagsNone;
+			}
+			values[reg] = value;
+		}
+
+		uint16_t getSR() {
+			if (flagsOp != FlagsNone) {
+				computeFlags();
+			}
+			return values[2];
+		}
+
+		bool isFlagSet(uint16_t flag) {
+			return getSR() & flag;
+		}
+
+		/// Stores the operands and result of the operation, so the flags
+		/// can be computed later.
+		void setFlags(FlagsOperation op, bool bw, uint16_t dst, uint16_t src, int32_t result) {
+			flagsOp = op;
+			flagsBw = bw;
+			flagsDst = dst;
+			flagsSrc = src;
+			flagsResult = result;
+		}
+
+		/// Computes N, Z, C and V flags from the last operation and stores
+		/// them in the status register.
+		void computeFlags();
+
+		uint16_t values[16];
+		/// Bitmask of registers which have a RegisterWatcher
+		uint16_t watched;
+		uint8_t flagsOp;
+		bool flagsBw;
+		uint16_t flagsDst;
+		uint16_t flagsSrc;
+		int32_t flagsResult;
+};
+
+}
@@ -33,7 +33,12 @@ RegisterSet::~RegisterSet() {
 }
 
 void RegisterSet::addRegister(const std::string &name, uint16_t value, const std::string &desc) {
-	Register *reg = new Register(m_registers.size(), name, value, desc);
+	// RegisterFile has place only for the CPU registers
+	if (m_registers.size() == 16) {
+		return;
+	}
+
+	Register *reg = new Register(&m_file, m_registers.size(), name, value, desc);
 	m_registers.push_back(reg);
 }
 
@@ -64,8 +69,4 @@ void RegisterSet::addDefaultRegisters() {
 	return m_registers[reg];
 }
 
-Register *RegisterSet::getp(unsigned int reg) {
-	return m_registers[reg];
-}
-
 }
@@ -24,6 +24,7 @@
 #include <vector>
 
 #include "QSimKit/MCU/RegisterSet.h"
+#include "CPU/Memory/RegisterFile.h"
 
 namespace MSP430 {
 
@@ -44,9 +45,23 @@ class RegisterSet : public ::RegisterSet {
 		::Register *get(unsigned int reg);
 		::Register *operator[](unsigned int reg);
 
-		Register *getp(unsigned int reg);
+		Register *getp(unsigned int reg) {
+			return m_registers[reg];
+		}
+
+		/// Returns true if any register has a watcher.
+		bool hasWatchers() {
+			return m_file.watched != 0;
+		}
+
+		/// Returns values of the registers. Instructions should access
+		/// the registers directly using it instead of using Register.
+		RegisterFile *getRegisterFile() {
+			return &m_file;
+		}
 
 	private:
+		RegisterFile m_file;
 		std::vector<Register *> m_registers;
 };
 
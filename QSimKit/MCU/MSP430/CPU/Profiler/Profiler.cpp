@@ -0,0 +1,141 @@
+/**
+ * QSimKit - MSP430 simulator
+ * Copyright (C) 2013 Jan "HanzZ" Kaluza (hanzz.k@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+
+#include "CPU/Profiler/Profiler.h"
+#include "CPU/Instructions/InstructionDecoder.h"
+#include "CPU/Interrupts/InterruptManager.h"
+#include "CPU/Memory/RegisterSet.h"
+#include "CPU/Memory/RegisterFile.h"
+
+#include <algorithm>
+
+namespace MSP430 {
+
+// Deeper calls are not tracked, their cycles are still counted per PC
+#define MAX_FRAMES 256
+
+Profiler::Profiler(RegisterSet *reg, InterruptManager *intManager) :
+m_reg(reg), m_intManager(intManager), m_totalCycles(0) {
+	m_cycles.resize(32768);
+	m_instructions.resize(32768);
+}
+
+Profiler::~Profiler() {
+
+}
+
+void Profiler::reset() {
+	std::fill(m_cycles.begin(), m_cycles.end(), 0);
+	std::fill(m_instructions.begin(), m_instructions.end(), 0);
+	m_totalCycles = 0;
+	m_frames.clear();
+	m_calls.clear();
+	m_interrupts.clear();
+}
+
+void Profiler::push(uint16_t entry, int vector, uint64_t start) {
+	if (m_frames.size() == MAX_FRAMES) {
+		return;
+	}
+
+	Frame frame;
+	frame.entry = entry;
+	frame.caller = m_frames.empty() ? 0 : m_frames.back().entry;
+	frame.sp = m_reg->getRegisterFile()->values[1];
+	frame.vector = vector;
+	frame.start = start;
+	m_frames.push_back(frame);
+}
+
+void Profiler::popFrames(uint16_t sp) {
+	// Every frame above the current stack pointer has been returned from,
+	// even when the code returned from more functions at once.
+	while (!m_frames.empty() && m_frames.back().sp < sp) {
+		const Frame &frame = m_frames.back();
+		ProfilerCall *call;
+		if (frame.vector == -1) {
+			call = &m_calls[frame.caller << 16 | frame.entry];
+			call->caller = frame.caller;
+		}
+		else {
+			call = &m_interrupts[frame.vector];
+		}
+		call->callee = frame.entry;
+		call->calls++;
+		call->cycles += m_totalCycles - frame.start;
+		m_frames.pop_back();
+	}
+}
+
+void Profiler::addInstruction(uint16_t pc, const DecodedInstruction &d) {
+	m_cycles[pc >> 1] += d.cycles;
+	m_instructions[pc >> 1]++;
+	m_totalCycles += d.cycles;
+
+	RegisterFile *file = m_reg->getRegisterFile();
+	if (d.type == Instruction1) {
+		switch (d.opcode) {
+			// call
+			case 5:
+				push(file->values[0], -1, m_totalCycles);
+				break;
+			// reti
+			case 6:
+				popFrames(file->values[1]);
+				break;
+			default:
+				break;
+		}
+	}
+	// ret, emulated as mov @sp+, pc
+	else if (d.type == Instruction2 && d.opcode == 4 &&
+		d.srcType == DecodedInstruction::ArgIndirectAutoincrement && d.srcReg == 1 &&
+		d.dstType == DecodedInstruction::ArgRegister && d.dstReg == 0) {
+		popFrames(file->values[1]);
+	}
+}
+
+void Profiler::addCycles(uint16_t pc, unsigned int cycles) {
+	m_cycles[pc >> 1] += cycles;
+	m_totalCycles += cycles;
+}
+
+void Profiler::removeCycles(uint16_t pc, unsigned int cycles) {
+	uint64_t removed = std::min((uint64_t) cycles, m_cycles[pc >> 1]);
+	m_cycles[pc >> 1] -= removed;
+	m_totalCycles -= removed;
+}
+
+void Profiler::addInterrupt(unsigned int cycles) {
+	uint16_t pc = m_reg->getRegisterFile()->values[0];
+	uint64_t start = m_totalCycles;
+	addCycles(pc, cycles);
+	push(pc, m_intManager->getRunningInterrupt(), start);
+}
+
+std::vector<ProfilerCall> Profiler::getCalls() {
+	std::vector<ProfilerCall> calls;
+	for (std::map<uint32_t, ProfilerCall>::const_iterator it = m_calls.begin(); it != m_calls.end(); ++it) {
+		calls.push_back(it->second);
+	}
+	return calls;
+}
+
+}
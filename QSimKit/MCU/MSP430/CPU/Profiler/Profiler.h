@@ -0,0 +1,124 @@
+/**
+ * QSimKit - MSP430 simulator
+ * Copyright (C) 2013 Jan "HanzZ" Kaluza (hanzz.k@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+
+#pragma once
+
+#include <stdint.h>
+#include <map>
+#include <vector>
+
+namespace MSP430 {
+
+class RegisterSet;
+class InterruptManager;
+class DecodedInstruction;
+
+/// Calls from one function to another or runs of single interrupt handler.
+class ProfilerCall {
+	public:
+		ProfilerCall() : caller(0), callee(0), calls(0), cycles(0) {}
+
+		/// Entry point of the calling function, 0 for calls done outside
+		/// of any profiled function or for interrupts.
+		uint16_t caller;
+		/// Entry point of the called function or interrupt handler.
+		uint16_t callee;
+		uint64_t calls;
+		/// Cycles spent in the callee including its own calls.
+		uint64_t cycles;
+};
+
+/// Counts executed instructions and MCLK cycles per PC and tracks calls,
+/// returns and interrupts to measure the inclusive time of functions.
+///
+/// Profiler knows only the entry points of the functions. Mapping of the
+/// PCs to the named functions is done later using the debug data.
+class Profiler {
+	public:
+		Profiler(RegisterSet *reg, InterruptManager *intManager);
+		virtual ~Profiler();
+
+		/// Has to be called after the instruction at PC has been executed.
+		void addInstruction(uint16_t pc, const DecodedInstruction &d);
+
+		/// Adds cycles which are not part of any executed instruction,
+		/// for example cycles of the skipped idle loops.
+		void addCycles(uint16_t pc, unsigned int cycles);
+
+		/// Takes back cycles added by addCycles() before, when they are
+		/// going to be counted again by the executed instruction. Counters
+		/// never go below zero.
+		void removeCycles(uint16_t pc, unsigned int cycles);
+
+		/// Has to be called after the interrupt has been started. Cycles
+		/// are the cycles needed to enter the interrupt handler.
+		void addInterrupt(unsigned int cycles);
+
+		void reset();
+
+		uint64_t getTotalCycles() {
+			return m_totalCycles;
+		}
+
+		uint64_t getCycles(uint16_t pc) {
+			return m_cycles[pc >> 1];
+		}
+
+		uint64_t getInstructions(uint16_t pc) {
+			return m_instructions[pc >> 1];
+		}
+
+		/// Returns calls between the functions.
+		std::vector<ProfilerCall> getCalls();
+
+		/// Returns runs of interrupt handlers indexed by the vector.
+		const std::map<int, ProfilerCall> &getInterrupts() {
+			return m_interrupts;
+		}
+
+	private:
+		class Frame {
+			public:
+				uint16_t entry;
+				uint16_t caller;
+				/// SP after the return address has been pushed
+				uint16_t sp;
+				/// Interrupt vector or -1 for calls
+				int vector;
+				uint64_t start;
+		};
+
+		void push(uint16_t entry, int vector, uint64_t start);
+		void popFrames(uint16_t sp);
+
+	private:
+		RegisterSet *m_reg;
+		InterruptManager *m_intManager;
+		// Counters indexed by PC / 2
+		std::vector<uint64_t> m_cycles;
+		std::vector<uint64_t> m_instructions;
+		uint64_t m_totalCycles;
+		std::vector<Frame> m_frames;
+		// Calls indexed by caller << 16 | callee
+		std::map<uint32_t, ProfilerCall> m_calls;
+		std::map<int, ProfilerCall> m_interrupts;
+};
+
+}
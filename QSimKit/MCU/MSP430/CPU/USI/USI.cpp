@@ -54,7 +54,7 @@ USI::~USI() {
 
 void USI::doSPICapture(uint8_t usictl0, uint8_t usictl1, uint8_t usicnt) {
 // 	std::cout << "capture\n";
-	uint16_t usisr = m_mem->getBigEndian(m_usisr, false);
+	uint16_t usisr = m_mem->getWord(m_usisr, false);
 	if (usictl0 & (1 << 4)) {
 		// LSB mode -> shift right
 		usisr = usisr >> 1;
@@ -107,7 +107,7 @@ void USI::doSPICapture(uint8_t usictl0, uint8_t usictl1, uint8_t usicnt) {
 
 void USI::doSPIOutput(uint8_t usictl0, uint8_t usictl1, uint8_t usicnt) {
 // 	std::cout << "output\n";
-	uint16_t usisr = m_mem->getBigEndian(m_usisr, false);
+	uint16_t usisr = m_mem->getWord(m_usisr, false);
 	// Check LSB vs. MSB
 	if (usictl0 & (1 << 4)) {
 		// Load LSB bit
@@ -18,225 +18,120 @@
  **/
 
 #include "CodeUtil.h"
-#include "ui/PathDialog.h"
 
-#include <QFile>
-#include <QProcess>
-#include <QDir>
-#include <QDebug>
-#include <QSettings>
+#include <QMap>
+#include <QPair>
 
+#include "CPU/Memory/Memory.h"
+#include "CPU/Instructions/InstructionDisassembler.h"
 #include "QSimKit/Dwarf/DwarfLoader.h"
+#include "QSimKit/Dwarf/DwarfCache.h"
+#include "QSimKit/Dwarf/DwarfDebugData.h"
+#include "QSimKit/Dwarf/ElfFile.h"
 
 namespace CodeUtil {
-	
-static void parseCode(DisassembledFiles &df, QString &code, QString &error) {
-	QString file;
-	DisassembledLine pendingSection;
-	int num = 0;
-
-	QStringList lines = code.split("\n", QString::SkipEmptyParts);
-	for (int i = 0; i < lines.size(); ++i) {
-		QString &line = lines[i];
-		if (line[0] == ' ') {
-			if (line.startsWith("   ") && line[8] == ':') {
-				QString l = line.simplified();
-
-				QString addr = l.left(l.indexOf(':'));
-				int x;
-				int c = 0;
-				for (x = l.indexOf(':') + 1; x < l.size(); ++x) {
-					if (!l[x].isNumber() && !l[x].isSpace() || (l[x].isSpace() && c > 2)) {
-						if (l[x] >= 'a' && l[x] <= 'f') {
-							c++;
-							continue;
-						}
-						if (!l[x - 1].isSpace() && !l[x - 1].isNumber()) {
-							x -= c;
-						}
-						break;
-					}
-					c = 0;
-				}
-				QString inst = l.mid(x);
-
-				if (inst.isEmpty()) {
-					continue;
-				}
-
-				df[file].append(DisassembledLine(addr.toInt(0, 16), num, DisassembledLine::Instruction, inst));
-			}
-			else {
-				df[file].append(DisassembledLine(0, num, DisassembledLine::Code, line));
-			}
-		}
-		else if (line[0] == '0') {
-			QString addr = line.left(8).right(4);
-			pendingSection = DisassembledLine(addr.toInt(0, 16), num, DisassembledLine::Section, line.mid(9));
-		}
-#ifdef Q_OS_WIN
-		else if (line[1] == ':' && line[2] == '\\') {
-			file = line.left(line.lastIndexOf(':'));
-			num = line.mid(line.lastIndexOf(':') + 1).toInt();
-			if (pendingSection.getAddr()) {
-				df[file].append(pendingSection);
-				pendingSection = DisassembledLine();
-			}
-		}
-#else
-		else if (line.startsWith("+<")) {
-			file = line.mid(6, line.indexOf(':') - 6);
-			num = line.mid(line.indexOf(':') + 1).toInt();
-			if (pendingSection.getAddr()) {
-				df[file].append(pendingSection);
-				pendingSection = DisassembledLine();
-			}
-		}
-#endif
-// 		else if (i > 2) {
-// 			df[file].append(DisassembledLine(0, 0, DisassembledLine::Code, line));
-// 		}
-	}
-}
 
-DisassembledFiles disassemble(const QByteArray &elf, const QString &a43, QString &error) {
-	DisassembledFiles df;
+typedef QList<QPair<uint32_t, uint32_t> > Ranges;
 
-	bool hasELF = true;
-	QByteArray code = elf;
-	if (code.isEmpty()) {
-		hasELF = false;
-		code = a43.toAscii();
+static bool loadELFRanges(const QByteArray &elf, Ranges &ranges, QMap<uint32_t, QString> &labels, QString &error) {
+	ElfFile f;
+	if (!f.load(elf, error)) {
+		return false;
 	}
 
-	QString f_in = QDir::tempPath() + "/test.dump";
-	QFile file(f_in);
-	if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
-		error = QString("Cannot open '%1' for writing.").arg(f_in);
-		return df;
-	}
+	const QList<ElfFile::Section> &sections = f.getSections();
+	for (int i = 0; i < sections.size(); ++i) {
+		const ElfFile::Section &s = sections[i];
+		if (!(s.flags & ElfFile::SectionAlloc) || !(s.flags & ElfFile::SectionExec)) {
+			continue;
+		}
 
-	file.write(code);
-	file.close();
-
-	QProcess objdump;
-	QSettings settings("QSimKit", "MSP430");
-	if (hasELF) {
-#ifdef Q_OS_LINUX
-		objdump.start(settings.value("objdump", "msp430-objdump").toString(), QStringList() << "-dSl" << "--prefix=+<FILE" << f_in);
-#else
-		objdump.start(settings.value("objdump", "msp430-objdump").toString(), QStringList() << "-dSl" << f_in);
-#endif
-	}
-	else {
-		objdump.start(settings.value("objdump", "msp430-objdump").toString(), QStringList() << "-D" << "-m" << "msp430:430" << f_in);
-	}
-	
-	if (!objdump.waitForStarted()) {
-		error = QString("'msp430-objdump' cannot be started. Is msp430-gcc installed and is msp430-objdump in PATH?");
-		return df;
-	}
+		if (s.size == 0 || s.address + s.size > 0x10000) {
+			continue;
+		}
 
-	if (!objdump.waitForFinished()) {
-		error = QString("'msp430-objdump' did not finish properly.");
-		return df;
+		ranges.append(qMakePair(s.address, s.address + s.size));
 	}
 
-	QString result = QString(objdump.readAll());
-	parseCode(df, result, error);
+	// Functions take precedence over the plain labels at the same address
+	foreach(const ElfFile::Symbol &s, f.getSymbols()) {
+		if (s.name.isEmpty() || s.name.startsWith(".") || s.section >= sections.size()) {
+			continue;
+		}
 
-	return df;
-}
+		if (!(sections[s.section].flags & ElfFile::SectionExec)) {
+			continue;
+		}
 
-DebugData *getDebugData(const QByteArray &code, QString &error) {
-	QString f_in = QDir::tempPath() + "/test.dump";
-	QFile file(f_in);
-	if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
-		error = QString("Cannot open '%1' for writing.").arg(f_in);
-		return 0;
+		if (s.type == ElfFile::SymbolFunction) {
+			labels[s.value] = s.name;
+		}
+		else if (s.type == ElfFile::SymbolNone && !labels.contains(s.value)) {
+			labels[s.value] = s.name;
+		}
 	}
 
-	file.write(code);
-	file.close();
-
-	QSettings settings("QSimKit", "MSP430");
-	DwarfLoader dl(settings.value("objdump", "msp430-objdump").toString());
-	DebugData *dd = dl.load(f_in, error);
-
-	return dd;
+	return true;
 }
 
-QString ELFToA43(const QByteArray &elf, QString &error) {
-// 	error = "4";
-	QString f_in = QDir::tempPath() + "/test.dump";
-	QString f_out = QDir::tempPath() + "/test.a43";
-	QFile file(f_in);
-	if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
-		error = QString("Cannot open '%1' for writting.").arg(f_in);
-		return "";
-	}
+DisassembledFiles disassemble(const QByteArray &elf, MSP430::Memory *mem,
+	MSP430::InstructionDecoder *decoder, DebugData *dd, QString &error,
+	const QString &cacheDir) {
+	DisassembledFiles df;
 
-	file.write(elf);
-	file.close();
-
-	QProcess objdump;
-	QSettings settings("QSimKit", "MSP430");
-	objdump.start(settings.value("objcopy", "msp430-objcopy").toString(), QStringList() << "-O" << "ihex" << f_in << f_out);
-	if (!objdump.waitForStarted()) {
-		error = QString("'msp430-objcopy' cannot be started. Is msp430-gcc installed and is msp430-objcopy in PATH?");
-		return "";
- 	}
- 
-	if (!objdump.waitForFinished()) {
-		error = QString("'msp430-objcopy' did not finish properly.");
-		return "";
+	DwarfCache cache(elf, cacheDir);
+	if (cache.loadDisassembledCode(df)) {
+		return df;
 	}
 
-	QFile file2(f_out);
-	if (!file2.open(QIODevice::ReadOnly | QIODevice::Text)) {
-		error = QString("Cannot open '%1' for reading.").arg(f_out);
-		return "";
+	Ranges ranges;
+	QMap<uint32_t, QString> labels;
+	if (!elf.isEmpty()) {
+		if (!loadELFRanges(elf, ranges, labels, error)) {
+			return df;
+		}
+	}
+	else {
+		const std::vector<MSP430::Memory::Span> &spans = mem->getLoadedSpans();
+		for (unsigned int i = 0; i < spans.size(); ++i) {
+			ranges.append(qMakePair((uint32_t) spans[i].start, (uint32_t) spans[i].end));
+		}
 	}
 
-	return file2.readAll();
-}
+	MSP430::InstructionDisassembler dis(mem, decoder);
+	for (int i = 0; i < ranges.size(); ++i) {
+		uint32_t pc = ranges[i].first;
+		while (pc < ranges[i].second) {
+			QString file;
+			int line = 0;
+			if (dd) {
+				line = dd->getLine(pc, file);
+			}
 
-bool hasObjdump() {
-	QProcess objdump;
-	QSettings settings("QSimKit", "MSP430");
-	objdump.start(settings.value("objdump", "msp430-objdump").toString(), QStringList() << "-v");
-	if (!objdump.waitForStarted()) {
-		return false;
-	}
-	objdump.waitForFinished();
- 
-	return true;
-}
+			if (labels.contains(pc)) {
+				df[file].append(DisassembledLine(pc, line, DisassembledLine::Section, "<" + labels[pc] + ">:"));
+			}
 
-bool hasObjcopy() {
-	QProcess objdump;
-	QSettings settings("QSimKit", "MSP430");
-	objdump.start(settings.value("objcopy", "msp430-objcopy").toString(), QStringList() << "-v");
-	if (!objdump.waitForStarted()) {
-		return false;
+			df[file].append(DisassembledLine(pc, line, DisassembledLine::Instruction));
+			pc += dis.getLength(pc);
+		}
 	}
-	objdump.waitForFinished();
- 
-	return true;
+
+	cache.saveDisassembledCode(df);
+	return df;
 }
 
-void checkPaths() {
-	if (hasObjdump() && hasObjcopy()) {
-		return;
+DebugData *getDebugData(const QByteArray &code, QString &error) {
+	DwarfCache cache(code);
+	DwarfDebugData *dd = cache.loadDebugData();
+	if (dd) {
+		return dd;
 	}
 
-	QSettings settings("QSimKit", "MSP430");
-	PathDialog p(settings.value("objcopy", "msp430-objcopy").toString(),
-		settings.value("objdump", "msp430-objdump").toString());
-	if (p.exec() == QDialog::Accepted) {
-		settings.setValue("objdump", p.getObjdump());
-		settings.setValue("objcopy", p.getObjcopy());
-	}
+	DwarfLoader dl;
+	dd = dl.load(code, error);
+	cache.saveDebugData(dd);
+	return dd;
 }
 
-}
\ No newline at end of file
+}
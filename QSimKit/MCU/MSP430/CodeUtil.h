@@ -24,19 +24,23 @@
 
 #include "MCU/MCU.h"
 
+namespace MSP430 {
+	class Memory;
+	class InstructionDecoder;
+}
+
 namespace CodeUtil {
 
-	DisassembledFiles disassemble(const QByteArray &elf, const QString &a43, QString &error);
+	/// Splits the code loaded in the memory to instructions and assigns
+	/// them to the source files using the line table from dd. Text of the
+	/// instructions is left empty; it is generated by MCU::disassemble()
+	/// only for the file which is shown. If the elf is empty, the spans
+	/// loaded from the A43 file are disassembled. The result is cached in
+	/// the cacheDir, or in the user's cache directory when it is empty.
+	DisassembledFiles disassemble(const QByteArray &elf, MSP430::Memory *mem,
+		MSP430::InstructionDecoder *decoder, DebugData *dd, QString &error,
+		const QString &cacheDir = QString());
 
 	DebugData *getDebugData(const QByteArray &elf, QString &error);
 
-	QString ELFToA43(const QByteArray &elf, QString &error);
-
-	bool hasObjdump();
-
-	bool hasObjcopy();
-
-	void checkPaths();
-
 }
-
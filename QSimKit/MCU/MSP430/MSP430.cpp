@@ -22,9 +22,14 @@
 #include "CPU/Memory/Memory.h"
 #include "CPU/Memory/RegisterSet.h"
 #include "CPU/Memory/Register.h"
+#include "CPU/Memory/RegisterFile.h"
 #include "CPU/Instructions/Instruction.h"
 #include "CPU/Instructions/InstructionDecoder.h"
+#include "CPU/Instructions/InstructionDisassembler.h"
 #include "CPU/Instructions/InstructionManager.h"
+#include "CPU/Instructions/BasicBlockExecutor.h"
+#include "CPU/Instructions/IdleLoopExecutor.h"
+#include "CPU/Profiler/Profiler.h"
 #include "CPU/Variants/Variant.h"
 #include "CPU/Variants/VariantManager.h"
 #include "CPU/Pins/PinManager.h"
@@ -41,6 +46,8 @@
 #include "CodeUtil.h"
 #include "SimulationObjects/Timer/AdevsTimerFactory.h"
 #include "SimulationObjects/Timer/DCO.h"
+#include "SimulationObjects/Timer/IdleLoopSkipper.h"
+#include "SimulationObjects/Timer/Scheduler.h"
 #include "SimulationObjects/Timer/VLO.h"
 #include "PeripheralItem/MSP430PeripheralItem.h"
 
@@ -54,13 +61,20 @@
 #include <QDomDocument>
 #include <QFileDialog>
 #include <QMessageBox>
+#include <QMap>
 #include <QtCore/qplugin.h>
 
+#include <set>
+
 MCU_MSP430::MCU_MSP430(const QString &variant) :
-m_time(0), m_instructionCycles(0),
+m_instructionCycles(0),
 m_mem(0), m_reg(0), m_decoder(0), m_pinManager(0), m_intManager(0),
-m_instruction(new MSP430::Instruction), m_variant(0),
-m_timerFactory(new AdevsTimerFactory()), m_ignoreNextStep(false), m_counter(-1),
+m_instruction(new MSP430::Instruction), m_blockExecutor(0),
+m_idleLoopExecutor(0), m_profiler(0), m_blockPending(false),
+m_idleLoopSkipper(0),
+m_singleStepping(false), m_lowPowerMode(0), m_variant(0),
+m_timerFactory(new AdevsTimerFactory()), m_ignoreNextStep(false),
+m_quantum(1), m_outputDelay(0), m_counter(-1),
 m_syncing(0) {
 
 	m_variantStr = variant;
@@ -74,11 +88,12 @@ m_syncing(0) {
 
 	m_name = "MSP430";
 
-	m_mem = new MSP430::Memory(512000);
+	m_mem = new MSP430::Memory(MEMORY_ADDRESS_SPACE);
 	m_reg = new MSP430::RegisterSet();
 	m_reg->addDefaultRegisters();
 
 	m_intManager = new MSP430::InterruptManager(m_reg, m_mem, m_variant);
+	m_intManager->setQueueWatcher(this);
 	m_pinManager = new MSP430::PinManager(m_mem, m_intManager, m_variant);
 	m_pinManager->setWatcher(this);
 
@@ -87,6 +102,7 @@ m_syncing(0) {
 
 	m_basicClock = new MSP430::BasicClock(m_mem, m_variant, m_intManager, m_pinManager, m_timerFactory);
 	m_basicClock->getMCLK()->addHandler(this, MSP430::Clock::Rising);
+	m_idleLoopSkipper = new IdleLoopSkipper(m_basicClock);
 
 	m_usi = 0;
 	if (m_variant->getUSICTL() != 0) {
@@ -148,10 +164,15 @@ void MCU_MSP430::handleFileChanged(const QString &path) {
 }
 
 void MCU_MSP430::reset() {
+	leaveIdleLoop();
+	delete m_idleLoopExecutor;
+	delete m_blockExecutor;
 	delete m_decoder;
 
 	m_mem->reset();
 	//m_reg->reset(); TODO
+	m_reg->get(2)->setBigEndian(0);
+	m_lowPowerMode = 0;
 	m_intManager->reset();
 	m_pinManager->reset();
 	m_basicClock->reset();
@@ -160,16 +181,28 @@ void MCU_MSP430::reset() {
 	if (m_usi) m_usi->reset();
 
 	m_decoder = new MSP430::InstructionDecoder(m_reg, m_mem);
-
-	if (!m_code.isEmpty()) {
-		m_mem->loadA43(m_code.toStdString(), m_reg);
+	m_blockExecutor = new MSP430::BasicBlockExecutor(m_reg, m_mem, m_decoder, m_intManager);
+	// Lock-step comparison of the JIT compiled code with the interpreter
+	if (!qgetenv("QSIMKIT_JIT_VALIDATE").isEmpty()) {
+		m_blockExecutor->setJITValidation(true);
 	}
+	m_blockExecutor->setProfiler(m_profiler);
+	if (m_profiler) {
+		m_profiler->reset();
+	}
+	m_idleLoopExecutor = new MSP430::IdleLoopExecutor(m_reg, m_mem, m_decoder, m_intManager);
+	m_blockPending = false;
+
+	// Memory::reset() has already restored the loaded program
+	m_mem->loadEntryPoint(m_reg);
 
 	 m_counter = 0;
 	 m_instructionCycles = m_decoder->decodeCurrentInstruction(m_instruction);
 }
 
 RegisterSet *MCU_MSP430::getRegisterSet() {
+	// Registers are not updated while the idle loop is skipped.
+	leaveIdleLoop();
 	return m_reg;
 }
 
@@ -199,6 +232,12 @@ void MCU_MSP430::handlePinChanged(int id, double value) {
 	bool reschedule = m_output.empty();
 	m_output.insert(SimulationEvent(id, value));
 	if (reschedule && m_wrapper) {
+		// When the DCO executes ticks ahead of the simulation time, the
+		// output has to be generated at the time of the tick which caused
+		// it and the rest of the quantum is postponed after the output.
+		DCO *dco = dynamic_cast<DCO *>(m_basicClock->getDCO());
+		m_outputDelay = dco->getLocalTime();
+		dco->synchronize();
 		m_wrapper->setContext(m_instruction->original_pc);
 		m_wrapper->reschedule();
 	}
@@ -207,12 +246,144 @@ void MCU_MSP430::handlePinChanged(int id, double value) {
 }
 
 
+void MCU_MSP430::setQuantum(int cycles) {
+	m_quantum = cycles < 1 ? 1 : cycles;
+	dynamic_cast<DCO *>(m_basicClock->getDCO())->setQuantum(m_quantum);
+}
+
+QStringList MCU_MSP430::getStatistics() {
+	QStringList stats;
+	for (int pattern = 0; pattern < MSP430::FusedPatternCount; ++pattern) {
+		stats << QString("Fused %1: %2").arg(MSP430::getFusedPatternName(pattern))
+			.arg(m_blockExecutor->getFusedCount(pattern));
+	}
+	return stats;
+}
+
+void MCU_MSP430::setProfiling(bool enabled) {
+	leaveIdleLoop();
+	delete m_profiler;
+	m_profiler = enabled ? new MSP430::Profiler(m_reg, m_intManager) : 0;
+	m_blockExecutor->setProfiler(m_profiler);
+}
+
+// Returns entry point of the function containing PC. Without the debug data
+// the nearest lower called address is used.
+static uint16_t findFunction(DebugData *dd, const std::set<uint16_t> &entries, uint16_t pc, QString &name) {
+	Subprogram *s = dd ? dd->getSubprogram(pc) : 0;
+	if (s) {
+		name = s->getName();
+		return s->getPCLow();
+	}
+
+	std::set<uint16_t>::const_iterator it = entries.upper_bound(pc);
+	if (it == entries.begin()) {
+		name = "<unknown>";
+		return 0;
+	}
+
+	--it;
+	name = QString("0x%1").arg(*it, 4, 16, QChar('0'));
+	return *it;
+}
+
+Profile MCU_MSP430::getProfile(DebugData *dd) {
+	Profile profile;
+	if (!m_profiler) {
+		return profile;
+	}
+
+	leaveIdleLoop();
+
+	std::vector<MSP430::ProfilerCall> calls = m_profiler->getCalls();
+	const std::map<int, MSP430::ProfilerCall> &interrupts = m_profiler->getInterrupts();
+
+	std::set<uint16_t> entries;
+	for (std::vector<MSP430::ProfilerCall>::const_iterator it = calls.begin(); it != calls.end(); ++it) {
+		entries.insert(it->callee);
+	}
+	for (std::map<int, MSP430::ProfilerCall>::const_iterator it = interrupts.begin(); it != interrupts.end(); ++it) {
+		entries.insert(it->second.callee);
+	}
+
+	QString name;
+	QMap<uint16_t, ProfiledFunction> functions;
+	for (int pc = 0; pc < 0x10000; pc += 2) {
+		uint64_t cycles = m_profiler->getCycles(pc);
+		uint64_t instructions = m_profiler->getInstructions(pc);
+		if (cycles == 0 && instructions == 0) {
+			continue;
+		}
+
+		uint16_t address = findFunction(dd, entries, pc, name);
+		ProfiledFunction &f = functions[address];
+		f.name = name;
+		f.address = address;
+		f.selfCycles += cycles;
+		f.instructions += instructions;
+	}
+
+	QMap<uint16_t, QMap<uint16_t, ProfiledCall> > callees;
+	for (std::vector<MSP430::ProfilerCall>::const_iterator it = calls.begin(); it != calls.end(); ++it) {
+		uint16_t callee = findFunction(dd, entries, it->callee, name);
+		ProfiledFunction &f = functions[callee];
+		f.name = name;
+		f.address = callee;
+		f.calls += it->calls;
+		f.inclusiveCycles += it->cycles;
+
+		// Called from the code which has not been called by anyone
+		if (it->caller == 0) {
+			continue;
+		}
+
+		ProfiledCall &call = callees[findFunction(dd, entries, it->caller, name)][callee];
+		call.name = f.name;
+		call.calls += it->calls;
+		call.cycles += it->cycles;
+	}
+
+	for (std::map<int, MSP430::ProfilerCall>::const_iterator it = interrupts.begin(); it != interrupts.end(); ++it) {
+		uint16_t address = findFunction(dd, entries, it->second.callee, name);
+		ProfiledFunction &f = functions[address];
+		f.name = name;
+		f.address = address;
+		f.calls += it->second.calls;
+		f.inclusiveCycles += it->second.cycles;
+
+		ProfiledFunction handler(QString("%1 (vector %2)").arg(name).arg(it->first), address);
+		handler.calls = it->second.calls;
+		handler.inclusiveCycles = it->second.cycles;
+		handler.callees = callees.value(address).values();
+		profile.interrupts.append(handler);
+	}
+
+	for (QMap<uint16_t, ProfiledFunction>::iterator it = functions.begin(); it != functions.end(); ++it) {
+		// Code which is never called, like main() entered by jump, runs
+		// only its own instructions as far as we know.
+		if (it->calls == 0) {
+			it->inclusiveCycles = it->selfCycles;
+		}
+		it->callees = callees.value(it.key()).values();
+	}
+
+	profile.functions = functions.values();
+	profile.totalCycles = m_profiler->getTotalCycles();
+	profile.sort();
+	return profile;
+}
+
 void MCU_MSP430::getInternalSimulationObjects(std::vector<SimulationObject *> &objects) {
 	objects.push_back(dynamic_cast<DCO *>(m_basicClock->getDCO()));
 	objects.push_back(dynamic_cast<VLO *>(m_basicClock->getVLO()));
+	objects.push_back(dynamic_cast<Scheduler *>(m_basicClock->getScheduler()));
 }
 
-void MCU_MSP430::externalEvent(double t, const SimulationEventList &events) {
+void MCU_MSP430::externalEvent(SimulationTime t, const SimulationEventList &events) {
+	// Input can change the polled memory or queue an interrupt, so the
+	// cycles after it have to be ticked again.
+	stopSkippingIdleLoop();
+
 	int i = 0;
 	for (SimulationEventList::const_iterator it = events.begin(); i != events.size(); ++it, ++i) {
 		SimulationEvent &ev = *it;
@@ -227,28 +398,173 @@ void MCU_MSP430::externalEvent(double t, const SimulationEventList &events) {
 void MCU_MSP430::output(SimulationEventList &output) {
 	if (!m_output.empty()) {
 		output.swap(m_output);
+		m_outputDelay = 0;
+	}
+}
+
+void MCU_MSP430::updateLowPowerMode() {
+	uint16_t mode = m_reg->getRegisterFile()->values[2] & (SR_CPU_OFF | SR_OSC_OFF | SR_SCG0 | SR_SCG1);
+	if (mode == m_lowPowerMode) {
+		return;
+	}
+
+	m_lowPowerMode = mode;
+	m_basicClock->setLowPowerMode(mode);
+
+	// MCLK is paused now, so we will not get any tick until an interrupt
+	// wakes us up. The next tick then only runs the queued interrupt
+	// instead of executing the instruction decoded before sleeping.
+	if (m_lowPowerMode & SR_CPU_OFF) {
+		m_counter = 0;
+		m_instructionCycles = 1;
+		m_blockPending = true;
+	}
+}
+
+void MCU_MSP430::handleInterruptQueued(MSP430::InterruptManager *intManager, int vector) {
+	stopSkippingIdleLoop();
+
+	if (!(m_lowPowerMode & SR_CPU_OFF) || !intManager->isAccepted(vector)) {
+		return;
+	}
+
+	// Running the interrupt clears the status register, so start all the
+	// clocks. If the CPU has to sleep again after reti, updateLowPowerMode()
+	// pauses them again.
+	m_lowPowerMode = 0;
+	m_basicClock->setLowPowerMode(0);
+}
+
+void MCU_MSP430::countSkippedCycles(uint64_t cycles) {
+	// Profiled the same way as the cycles ticked in tickRising()
+	if (m_profiler) {
+		m_profiler->addCycles(m_reg->getRegisterFile()->values[0], cycles);
+	}
+	m_idleLoopExecutor->skip(cycles);
+}
+
+void MCU_MSP430::skipIdleLoop() {
+	// The DCO cannot skip the cycles outside of the simulation
+	if (m_wrapper) {
+		m_idleLoopSkipper->start(m_idleLoopExecutor);
+	}
+}
+
+void MCU_MSP430::stopSkippingIdleLoop() {
+	if (!m_idleLoopSkipper || !m_idleLoopSkipper->isSkipping()) {
+		return;
 	}
+
+	countSkippedCycles(m_idleLoopSkipper->stop());
+}
+
+void MCU_MSP430::leaveIdleLoop() {
+	if (!m_idleLoopExecutor || !m_idleLoopExecutor->isActive()) {
+		return;
+	}
+
+	stopSkippingIdleLoop();
+
+	uint16_t pc = m_reg->getRegisterFile()->values[0];
+	int elapsed = m_idleLoopExecutor->leave();
+	m_instructionCycles = m_decoder->decodeCurrentInstruction(m_instruction);
+	m_counter = elapsed;
+
+	// Elapsed cycles are profiled again with the executed instruction
+	if (m_profiler) {
+		m_profiler->removeCycles(pc, elapsed);
+	}
+	m_blockPending = false;
 }
 
 void MCU_MSP430::tickRising() {
-	if (++m_counter == m_instructionCycles) {
-		int error = executeInstruction(m_reg, m_mem, m_instruction);
-		if (error == -1) {
-			qDebug() << "ERROR: Unknown instruction" << "type" << m_instruction->type << "opcode" << m_instruction->opcode;
-			m_instructionCycles = DBL_MAX;
-			return;
+	if (m_idleLoopExecutor->isActive()) {
+		// DCO has skipped the cycles before this one
+		if (m_idleLoopSkipper->isSkipping()) {
+			countSkippedCycles(m_idleLoopSkipper->takeSkippedCycles());
 		}
 
-		m_intManager->handleInstruction(m_instruction);
+		// Skipped instructions are profiled as cycles of the loop start
+		uint16_t pc = m_reg->getRegisterFile()->values[0];
+		switch (m_idleLoopExecutor->tick()) {
+			case MSP430::IdleLoopExecutor::Running:
+				if (m_profiler) {
+					m_profiler->addCycles(pc, 1);
+				}
+				skipIdleLoop();
+				return;
+			case MSP430::IdleLoopExecutor::Execute:
+				m_instructionCycles = m_decoder->decodeCurrentInstruction(m_instruction);
+				m_counter = m_idleLoopExecutor->getElapsedCycles();
+				m_blockPending = false;
+				if (m_profiler) {
+					m_profiler->removeCycles(pc, m_counter);
+				}
+				break;
+			case MSP430::IdleLoopExecutor::Resume:
+				if (m_profiler) {
+					m_profiler->addCycles(pc, 1);
+				}
+				// Handle interrupts and decode next instruction right now
+				m_instructionCycles = 1;
+				m_counter = 0;
+				m_blockPending = true;
+				break;
+		}
+	}
 
+	if (++m_counter == m_instructionCycles) {
 		m_counter = 0;
+
+		if (!m_blockPending) {
+			int error = executeInstruction(m_reg, m_mem, m_instruction);
+			if (error == -1) {
+				qDebug() << "ERROR: Unknown instruction" << "type" << m_instruction->type << "opcode" << m_instruction->opcode;
+				m_instructionCycles = DBL_MAX;
+				return;
+			}
+
+			if (m_profiler) {
+				uint16_t pc = m_instruction->original_pc;
+				m_profiler->addInstruction(pc, m_decoder->decode(pc));
+			}
+
+			m_intManager->handleInstruction(m_instruction);
+
+			// Execute the rest of the basic block at once and wait for the
+			// cycles it would take before handling interrupts and decoding
+			// the next instruction.
+			if (!m_singleStepping && !m_intManager->hasQueuedInterrupts() &&
+				!(m_reg->getRegisterFile()->values[2] & SR_CPU_OFF)) {
+				int cycles = m_blockExecutor->run(m_instruction);
+				if (cycles != 0) {
+					m_instructionCycles = cycles;
+					m_blockPending = true;
+					return;
+				}
+			}
+		}
+
+		m_blockPending = false;
 		if (m_intManager->runQueuedInterrupts()) {
 			m_instructionCycles = m_decoder->decodeCurrentInstruction(m_instruction);
 			m_instructionCycles += 5;
+			if (m_profiler) {
+				m_profiler->addInterrupt(5);
+			}
 		}
 		else {
 			m_instructionCycles = m_decoder->decodeCurrentInstruction(m_instruction);
+
+			// Skip the idle loop if we are at its start. Interrupt or change
+			// of the polled memory ends the skipping.
+			if (!m_singleStepping && !(m_reg->getRegisterFile()->values[2] & SR_CPU_OFF) &&
+				m_idleLoopExecutor->enter()) {
+				skipIdleLoop();
+			}
 		}
+
+		updateLowPowerMode();
 	}
 }
 
@@ -256,14 +572,14 @@ void MCU_MSP430::internalTransition() {
 	return;
 }
 
-double MCU_MSP430::timeAdvance() {
+SimulationTime MCU_MSP430::timeAdvance() {
 	if (!m_output.empty()) {
 // 		qDebug() << "MCU_MSP430 ta=" << 0;
 		m_ignoreNextStep = true;
-		return 0;
+		return m_outputDelay;
 	}
 // 	qDebug() << "MCU_MSP430 ta=" << m_instructionCycles;
-	return 365;
+	return SIMULATION_TIME_MAX;
 }
 
 void MCU_MSP430::executeOption(int option) {
@@ -286,6 +602,7 @@ void MCU_MSP430::save(QTextStream &stream) {
 	stream << "<a43path>" << m_a43Path << "</a43path>\n";
 	stream << "<elfpath>" << m_elfPath << "</elfpath>\n";
 	stream << "<elf>" << m_elf.toBase64() << "</elf>\n";
+	stream << "<quantum>" << m_quantum << "</quantum>\n";
 }
 
 bool MCU_MSP430::loadPackage(QString &variant, QString &error) {
@@ -310,12 +627,13 @@ void MCU_MSP430::load(QDomElement &object, QString &error) {
 		return;
 	}
 
-	CodeUtil::checkPaths();
-
 	loadA43(object.firstChildElement("code").text());
 	loadELF(QByteArray::fromBase64(object.firstChildElement("elf").text().toAscii()));
 	m_a43Path = object.firstChildElement("a43path").text().toAscii();
 	m_elfPath = object.firstChildElement("elfpath").text().toAscii();
+	if (!object.firstChildElement("quantum").isNull()) {
+		setQuantum(object.firstChildElement("quantum").text().toInt());
+	}
 
 	// Check if the ELF/A43 file changed in the meantime and try to reload it
 	if (!m_elfPath.isEmpty()) {
@@ -404,7 +722,7 @@ void MCU_MSP430::paint(QWidget *screen) {
 		return;
 	}
 
-	if (m_code.isEmpty()) {
+	if (m_code.isEmpty() && m_elf.isEmpty()) {
 		QPen pen(Qt::black, 1, Qt::SolidLine);
 		qp.setPen(pen);
 		if (width() < 200) {
@@ -422,6 +740,7 @@ bool MCU_MSP430::loadA43(const QString &data) {
 	m_code = data;
 
 	bool ret =  m_mem->loadA43(data.toStdString(), m_reg);
+	m_decoder->invalidateCache();
 	if (ret) {
 		onCodeLoaded();
 	}
@@ -441,8 +760,6 @@ void MCU_MSP430::loadA43Option(const QString &f) {
 	if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
 		return;
 
-	CodeUtil::checkPaths();
-
 	m_elf.clear();
 	loadA43(file.readAll().data());
 
@@ -457,13 +774,14 @@ void MCU_MSP430::loadELF(const QByteArray &elf) {
 	m_elf = elf;
 
 	if (!m_elf.isEmpty()) {
-		QString error;
-		QString a43 = CodeUtil::ELFToA43(elf, error);
-		if (!error.isEmpty()) {
-			QMessageBox::critical(0, tr("Loading error"), error);
+		m_code.clear();
+		bool ret = m_mem->loadELF(std::string(elf.constData(), elf.size()), m_reg);
+		m_decoder->invalidateCache();
+		if (!ret) {
+			QMessageBox::critical(0, tr("Loading error"), tr("Loaded file is not a valid MSP430 ELF executable."));
 			return;
 		}
-		loadA43(a43);
+		onCodeLoaded();
 	}
 }
 
@@ -480,8 +798,6 @@ void MCU_MSP430::loadELFOption(const QString &f) {
 	if (!file.open(QIODevice::ReadOnly))
 		return;
 
-	CodeUtil::checkPaths();
-
 	loadELF(file.readAll());
 
 	m_fileWatcher->removePath(m_elfPath);
@@ -491,14 +807,14 @@ void MCU_MSP430::loadELFOption(const QString &f) {
 	m_a43Path = "";
 }
 
-DisassembledFiles MCU_MSP430::getDisassembledCode() {
+DisassembledFiles MCU_MSP430::getDisassembledCode(DebugData *dd) {
 	QString error;
-	DisassembledFiles files = CodeUtil::disassemble(m_elf, m_code, error);
+	DisassembledFiles files = CodeUtil::disassemble(m_elf, m_mem, m_decoder, dd, error);
 	if (!error.isEmpty()) {
 		QMessageBox::critical(0, tr("Loading error"), error);
 	}
 
-	if (m_basicClock->getMCLK()->getStep() > 1) {
+	if (m_basicClock->getMCLK()->getStep() > TIME_UNITS_PER_SECOND) {
 		QMessageBox::critical(0, tr("MSP430 Variant error"),
 			tr("One MCLK tick for this variant takes more than 1 second which is suspicious. Variant is not implemented properly.")
 		);
@@ -507,6 +823,12 @@ DisassembledFiles MCU_MSP430::getDisassembledCode() {
 	return files;
 }
 
+QString MCU_MSP430::disassemble(uint16_t addr) {
+	MSP430::InstructionDisassembler dis(m_mem, m_decoder);
+	uint8_t length;
+	return QString::fromStdString(dis.disassemble(addr, length));
+}
+
 DebugData *MCU_MSP430::getDebugData() {
 	QString error;
 	DebugData *dd = CodeUtil::getDebugData(m_elf, error);
@@ -30,6 +30,7 @@
 #include "MCU/MCUInterface.h"
 #include "CPU/Pins/PinManager.h"
 #include "CPU/BasicClock/Clock.h"
+#include "CPU/Interrupts/InterruptManager.h"
 
 namespace MSP430 {
 
@@ -37,7 +38,9 @@ class Memory;
 class RegisterSet;
 class InstructionDecoder;
 class Instruction;
-class InterruptManager;
+class BasicBlockExecutor;
+class IdleLoopExecutor;
+class Profiler;
 class BasicClock;
 class USI;
 class USCIModules;
@@ -47,6 +50,7 @@ class USARTModules;
 
 class Timer;
 class AdevsTimerFactory;
+class IdleLoopSkipper;
 
 class Variant;
 
@@ -59,7 +63,8 @@ class PinAddr {
 		uint8_t bit;
 };
 
-class MCU_MSP430 : public MCU, public MSP430::PinWatcher, public MSP430::ClockHandler
+class MCU_MSP430 : public MCU, public MSP430::PinWatcher, public MSP430::ClockHandler,
+				   public MSP430::InterruptQueueWatcher
 {
 	Q_OBJECT
 
@@ -77,19 +82,40 @@ class MCU_MSP430 : public MCU, public MSP430::PinWatcher, public MSP430::ClockHa
 
 		void internalTransition();
 
-		void externalEvent(double t, const SimulationEventList &);
+		void externalEvent(SimulationTime t, const SimulationEventList &);
 
 		void output(SimulationEventList &output);
 
-		double timeAdvance();
+		SimulationTime timeAdvance();
 
 		QString getFeatures();
 
 		void tickRising();
 		void tickFalling() {}
 
+		void handleInterruptQueued(MSP430::InterruptManager *intManager, int vector);
+
 		void reset();
 
+		void setSingleStepping(bool singleStepping) {
+			m_singleStepping = singleStepping;
+			if (m_singleStepping) {
+				leaveIdleLoop();
+			}
+		}
+
+		void setQuantum(int cycles);
+
+		QStringList getStatistics();
+
+		void setProfiling(bool enabled);
+
+		bool isProfiling() {
+			return m_profiler != 0;
+		}
+
+		Profile getProfile(DebugData *dd);
+
 		PeripheralItem *getPeripheralItem() {
 			return m_peripheralItem;
 		}
@@ -118,7 +144,9 @@ class MCU_MSP430 : public MCU, public MSP430::PinWatcher, public MSP430::ClockHa
 
 		void loadELF(const QByteArray &elf);
 
-		DisassembledFiles getDisassembledCode();
+		DisassembledFiles getDisassembledCode(DebugData *dd);
+
+		QString disassemble(uint16_t addr);
 
 		DebugData *getDebugData();
 
@@ -133,19 +161,30 @@ class MCU_MSP430 : public MCU, public MSP430::PinWatcher, public MSP430::ClockHa
 		void loadELFOption(const QString &filename = "");
 		void loadA43Option(const QString &filename = "");
 		bool loadPackage(QString &variant, QString &error);
+		void updateLowPowerMode();
+		void leaveIdleLoop();
+		void skipIdleLoop();
+		void stopSkippingIdleLoop();
+		void countSkippedCycles(uint64_t cycles);
 
 	private:
 		std::map<int, QChar> m_sides;
 		PinList m_pins;
 		std::vector<PinAddr> m_pin2addr;
 
-		double m_time;
 		double m_instructionCycles;
 
 		MSP430::Memory *m_mem;
 		MSP430::RegisterSet *m_reg;
 		MSP430::InstructionDecoder *m_decoder;
 		MSP430::Instruction *m_instruction;
+		MSP430::BasicBlockExecutor *m_blockExecutor;
+		MSP430::IdleLoopExecutor *m_idleLoopExecutor;
+		MSP430::Profiler *m_profiler;
+		bool m_blockPending;
+		IdleLoopSkipper *m_idleLoopSkipper;
+		bool m_singleStepping;
+		uint16_t m_lowPowerMode;
 		Variant *m_variant;
 		MSP430::PinManager *m_pinManager;
 		MSP430::InterruptManager *m_intManager;
@@ -158,9 +197,11 @@ class MCU_MSP430 : public MCU, public MSP430::PinWatcher, public MSP430::ClockHa
 		SimulationEventList m_output;
 		QStringList m_options;
 		bool m_ignoreNextStep;
+		int m_quantum;
+		SimulationTime m_outputDelay;
 		QByteArray m_elf;
 		PeripheralItem *m_peripheralItem;
-		int8_t m_counter;
+		int m_counter;
 		bool m_syncing;
 		QString m_variantStr;
 		QString m_a43Path;
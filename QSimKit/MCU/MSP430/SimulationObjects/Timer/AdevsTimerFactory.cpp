@@ -24,6 +24,7 @@
 #include "CPU/Pins/PinManager.h"
 #include "DCO.h"
 #include "VLO.h"
+#include "Scheduler.h"
 #include <iostream>
 
 #include "CPU/BasicClock/ACLK.h"
@@ -37,3 +38,7 @@ MSP430::DCO *AdevsTimerFactory::createDCO(MSP430::Memory *mem, Variant *variant)
 MSP430::VLO *AdevsTimerFactory::createVLO() {
 	return new VLO();
 }
+
+MSP430::Scheduler *AdevsTimerFactory::createScheduler(MSP430::DCO *dco) {
+	return new Scheduler(dynamic_cast<DCO *>(dco));
+}
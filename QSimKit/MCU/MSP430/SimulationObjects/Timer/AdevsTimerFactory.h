@@ -32,6 +32,7 @@ namespace MSP430 {
 class DCO;
 class VLO;
 class LFXT1;
+class Scheduler;
 
 }
 
@@ -42,4 +43,5 @@ class AdevsTimerFactory : public MSP430::TimerFactory {
 
 		MSP430::DCO *createDCO(MSP430::Memory *mem, Variant *variant);
 		MSP430::VLO *createVLO();
+		MSP430::Scheduler *createScheduler(MSP430::DCO *dco);
 };
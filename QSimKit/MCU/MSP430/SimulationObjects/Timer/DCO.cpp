@@ -18,10 +18,13 @@
  **/
 
 #include "DCO.h"
+#include "Scheduler.h"
 #include <QDebug>
 
 DCO::DCO(MSP430::Memory *mem, Variant *variant) : MSP430::DCO(mem, variant),
-m_paused(false) {
+m_paused(false), m_quantum(2), m_scheduler(0), m_time(0), m_localTime(getStep() / 2),
+m_inTransition(false), m_synchronize(false), m_skipStart(0), m_skipEnd(0),
+m_skipping(false) {
 	
 }
 
@@ -29,11 +32,68 @@ DCO::~DCO() {
 
 }
 
+void DCO::setQuantum(int cycles) {
+	// Every clock period consists of the rising and falling tick.
+	m_quantum = cycles < 1 ? 2 : cycles * 2;
+}
+
 void DCO::internalTransition() {
-	tick();
+	// Execute up to m_quantum ticks ahead of the simulation time. Ticks are
+	// executed as if they happened at their local time, so the quantum
+	// has to end once the MCU generates an output or the DCO is paused.
+	// It also ends before the period in which the next Scheduler event
+	// happens, because lock-step executes that period after the event.
+	m_inTransition = true;
+	m_synchronize = false;
+	m_time = m_wrapper->getTime();
+	m_localTime = 0;
+
+	// Dividers of the handlers count the skipped periods now
+	if (m_skipping) {
+		skip((m_skipEnd - m_skipStart) / getStep());
+		m_skipping = false;
+		m_skipEnd = 0;
+	}
+
+	for (int i = 0; i < m_quantum; ++i) {
+		if (i != 0 && isRising() && m_scheduler &&
+			m_wrapper->getTime() + m_localTime >= m_scheduler->getNextEventTime()) {
+			break;
+		}
+
+		tick();
+		// Oscillator has to tick 2x faster, because it has to rise up and fall down.
+		m_localTime += getStep() / 2;
+
+		// Skipping starts once the current period ends
+		if (m_skipEnd != 0 && isRising()) {
+			m_skipStart = m_wrapper->getTime() + m_localTime;
+			m_skipping = true;
+			m_localTime = m_skipEnd - m_wrapper->getTime();
+			break;
+		}
+
+		if (m_synchronize || m_paused) {
+			break;
+		}
+	}
+	m_inTransition = false;
+}
+
+void DCO::skipUntil(SimulationTime t) {
+	m_skipEnd = t;
+	if (!m_skipping) {
+		return;
+	}
+
+	// The DCO is waiting for the end of the skipped periods, so move its
+	// next transition to the new end.
+	m_time = m_wrapper->getTime();
+	m_localTime = t - m_time;
+	m_wrapper->reschedule();
 }
 
-void DCO::externalEvent(double t, const SimulationEventList &) {
+void DCO::externalEvent(SimulationTime t, const SimulationEventList &) {
 
 }
 
@@ -41,20 +101,44 @@ void DCO::output(SimulationEventList &output) {
 
 }
 
-double DCO::timeAdvance() {
+SimulationTime DCO::timeAdvance() {
 	if (m_paused)
-		return 999;
-	// Oscillator has to tick 2x faster, because it has to rise up and fall down.
-	return getStep() / 2;
+		return SIMULATION_TIME_MAX;
+	// Next quantum starts right after the last executed tick.
+	return m_localTime;
 }
 
 void DCO::start() {
 	m_paused = false;
+	if (!m_inTransition) {
+		m_localTime = getStep() / 2;
+		if (m_wrapper) {
+			m_time = m_wrapper->getTime();
+		}
+	}
 	if (m_wrapper) {
 		m_wrapper->reschedule();
 	}
 }
 
+SimulationTime DCO::getNextTickTime() {
+	if (!m_wrapper) {
+		return SIMULATION_TIME_MAX;
+	}
+
+	if (m_inTransition) {
+		return m_wrapper->getTime() + m_localTime + getStep() / 2;
+	}
+
+	// Stopped DCO is started by the first handler and ticks half of the
+	// period after that.
+	if (m_paused || !hasHandlers()) {
+		return m_wrapper->getTime() + getStep() / 2;
+	}
+
+	return m_time + m_localTime;
+}
+
 void DCO::pause() {
 	m_paused = true;
 }
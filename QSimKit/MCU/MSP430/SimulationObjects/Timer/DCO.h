@@ -29,6 +29,8 @@
 #include "Peripherals/SimulationObject.h"
 #include "CPU/BasicClock/DCO.h"
 
+class Scheduler;
+
 class DCO : public SimulationObject, public MSP430::DCO {
 	public:
 		DCO(MSP430::Memory *mem, Variant *variant);
@@ -36,15 +38,58 @@ class DCO : public SimulationObject, public MSP430::DCO {
 
 		void internalTransition();
 
-		void externalEvent(double t, const SimulationEventList &);
+		void externalEvent(SimulationTime t, const SimulationEventList &);
 
 		void output(SimulationEventList &output);
 
-		double timeAdvance();
+		SimulationTime timeAdvance();
 
 		void start();
 		void pause();
 
+		/// Sets the number of clock periods executed in one internal
+		/// transition. Default is 1, which keeps the DCO in lock-step with
+		/// the rest of the simulation.
+		void setQuantum(int cycles);
+
+		/// Sets the Scheduler whose next event ends the quantum, so the
+		/// events of the peripherals with analytic clocks happen between
+		/// the same ticks as in the lock-step mode.
+		void setScheduler(Scheduler *scheduler) {
+			m_scheduler = scheduler;
+		}
+
+		/// Returns the time offset of the currently executed tick from
+		/// the current simulation time.
+		SimulationTime getLocalTime() {
+			return m_inTransition ? m_localTime : 0;
+		}
+
+		/// Stops the current quantum after the currently executed tick.
+		void synchronize() {
+			m_synchronize = true;
+		}
+
+		/// Skips the periods following the current one without ticking,
+		/// so the next tick is the rising tick at the time t. This is used
+		/// when the only handler of the DCO does not need these ticks.
+		/// Calling it again while skipping moves the next tick to the time t,
+		/// which has to be the start of one of the skipped periods.
+		void skipUntil(SimulationTime t);
+
+		SimulationTime getNextTickTime();
+
 	private:
 		bool m_paused;
+		int m_quantum;
+		Scheduler *m_scheduler;
+		// Time of the last transition, time advance is relative to it
+		SimulationTime m_time;
+		SimulationTime m_localTime;
+		bool m_inTransition;
+		bool m_synchronize;
+		// Start of the first skipped period and the end of the last one
+		SimulationTime m_skipStart;
+		SimulationTime m_skipEnd;
+		bool m_skipping;
 };
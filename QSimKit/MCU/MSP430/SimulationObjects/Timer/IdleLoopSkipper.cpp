@@ -0,0 +1,89 @@
+/**
+ * QSimKit - MSP430 simulator
+ * Copyright (C) 2013 Jan "HanzZ" Kaluza (hanzz.k@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#include "IdleLoopSkipper.h"
+#include "DCO.h"
+#include "CPU/BasicClock/BasicClock.h"
+#include "CPU/BasicClock/MCLK.h"
+#include "CPU/BasicClock/VLO.h"
+#include "CPU/BasicClock/Scheduler.h"
+#include "CPU/Instructions/IdleLoopExecutor.h"
+
+#include <algorithm>
+
+// Maximum number of MCLK cycles skipped at once by the DCO
+#define MAX_SKIPPED_CYCLES 1000000000
+
+IdleLoopSkipper::IdleLoopSkipper(MSP430::BasicClock *basicClock) :
+m_basicClock(basicClock), m_start(0), m_cycles(0) {
+
+}
+
+void IdleLoopSkipper::start(MSP430::IdleLoopExecutor *executor) {
+	// The DCO does not tick while skipping, so it has to clock only the
+	// MCU. Oscillators driven by the pins are fine, because the pin input
+	// stops the skipping, but the VLO ticks on its own.
+	MSP430::MCLK *mclk = m_basicClock->getMCLK();
+	MSP430::Oscillator *dco = m_basicClock->getDCO();
+	if (mclk->getSource() != dco || !dco->hasOnlyHandler(mclk) ||
+		m_basicClock->getVLO()->hasHandlers()) {
+		return;
+	}
+
+	// Skip the cycles before the next event of the peripherals with
+	// analytic clocks. Nothing else can change the polled memory.
+	MSP430::Scheduler *scheduler = m_basicClock->getScheduler();
+	SimulationTime now = scheduler->getTime();
+	SimulationTime next = scheduler->getNextEventTime();
+	SimulationTime step = mclk->getStep();
+	uint64_t cycles = std::min(executor->getSkippableCycles(), (uint64_t) MAX_SKIPPED_CYCLES);
+	if (next != SIMULATION_TIME_MAX) {
+		cycles = std::min(cycles, next > now ? (uint64_t) ((next - now - 1) / step) : 0);
+	}
+
+	if (cycles == 0) {
+		return;
+	}
+
+	m_start = now;
+	m_cycles = cycles;
+	dynamic_cast<DCO *>(dco)->skipUntil(now + (cycles + 1) * step);
+}
+
+uint64_t IdleLoopSkipper::stop() {
+	if (m_cycles == 0) {
+		return 0;
+	}
+
+	// Cycles before the current time are skipped, the DCO ticks again from
+	// the first cycle at the current time or after it.
+	SimulationTime now = m_basicClock->getScheduler()->getTime();
+	SimulationTime step = m_basicClock->getMCLK()->getStep();
+	uint64_t cycles = now > m_start ? std::min(m_cycles, (uint64_t) ((now - m_start - 1) / step)) : 0;
+	dynamic_cast<DCO *>(m_basicClock->getDCO())->skipUntil(m_start + (cycles + 1) * step);
+
+	m_cycles = 0;
+	return cycles;
+}
+
+uint64_t IdleLoopSkipper::takeSkippedCycles() {
+	uint64_t cycles = m_cycles;
+	m_cycles = 0;
+	return cycles;
+}
@@ -0,0 +1,69 @@
+/**
+ * QSimKit - MSP430 simulator
+ * Copyright (C) 2013 Jan "HanzZ" Kaluza (hanzz.k@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#pragma once
+
+#include <stdint.h>
+
+#include "Peripherals/SimulationTime.h"
+
+namespace MSP430 {
+
+class BasicClock;
+class IdleLoopExecutor;
+
+}
+
+/// Lets the DCO jump over the MCLK cycles of the idle loop skipped by the
+/// IdleLoopExecutor, so they are not simulated one by one.
+///
+/// start() is called in every cycle in which the loop is skipped. The
+/// cycles skipped by the DCO are handed over with takeSkippedCycles() at
+/// the next rising tick of MCLK. stop() ends the skipping early when
+/// something can change the polled memory or queue an interrupt.
+class IdleLoopSkipper {
+	public:
+		IdleLoopSkipper(MSP430::BasicClock *basicClock);
+
+		/// Skips the cycles following the current one until the loop would
+		/// end by itself or until the next event of the peripherals with
+		/// analytic clocks. Does nothing when the DCO clocks anything else
+		/// than MCLK or when the VLO is used.
+		void start(MSP430::IdleLoopExecutor *executor);
+
+		/// Stops skipping at the first cycle at the current time or after
+		/// it, from which the DCO ticks again. Returns the number of skipped
+		/// cycles before the current time, which the caller has to count.
+		uint64_t stop();
+
+		/// Returns the number of cycles skipped before the current one and
+		/// forgets them.
+		uint64_t takeSkippedCycles();
+
+		bool isSkipping() {
+			return m_cycles != 0;
+		}
+
+	private:
+		MSP430::BasicClock *m_basicClock;
+		// Time of the cycle which started the skipping and the number of
+		// the following cycles skipped by the DCO.
+		SimulationTime m_start;
+		uint64_t m_cycles;
+};
@@ -0,0 +1,136 @@
+/**
+ * QSimKit - MSP430 simulator
+ * Copyright (C) 2013 Jan "HanzZ" Kaluza (hanzz.k@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#include "Scheduler.h"
+#include "DCO.h"
+
+Scheduler::Scheduler(DCO *dco) : m_dco(dco), m_time(0), m_inTransition(false) {
+	m_dco->setScheduler(this);
+
+}
+
+Scheduler::~Scheduler() {
+
+}
+
+void Scheduler::internalTransition() {
+	m_inTransition = true;
+	m_time = m_wrapper->getTime();
+
+	// Handlers can schedule or cancel events, so the vector is searched
+	// again after every handler.
+	bool fired = true;
+	while (fired) {
+		fired = false;
+		for (std::vector<Event>::iterator it = m_events.begin(); it != m_events.end(); ++it) {
+			if (it->time <= m_time) {
+				MSP430::TimedEventHandler *handler = it->handler;
+				m_events.erase(it);
+				handler->handleTimedEvent();
+				fired = true;
+				break;
+			}
+		}
+	}
+
+	m_inTransition = false;
+}
+
+void Scheduler::externalEvent(SimulationTime t, const SimulationEventList &) {
+
+}
+
+void Scheduler::output(SimulationEventList &output) {
+
+}
+
+SimulationTime Scheduler::timeAdvance() {
+	SimulationTime next = getNextEventTime();
+	if (next == SIMULATION_TIME_MAX) {
+		return SIMULATION_TIME_MAX;
+	}
+
+	// Events scheduled from the ticks executed ahead of the simulation
+	// time can be in the past already.
+	return next > m_time ? next - m_time : 0;
+}
+
+SimulationTime Scheduler::getNextEventTime() {
+	SimulationTime next = SIMULATION_TIME_MAX;
+	for (std::vector<Event>::const_iterator it = m_events.begin(); it != m_events.end(); ++it) {
+		if (it->time < next) {
+			next = it->time;
+		}
+	}
+	return next;
+}
+
+SimulationTime Scheduler::getTime() {
+	if (!m_wrapper) {
+		return 0;
+	}
+
+	// The DCO can execute ticks ahead of the simulation time, so the time
+	// of the currently executed tick is the simulation time plus its offset.
+	return m_wrapper->getTime() + m_dco->getLocalTime();
+}
+
+void Scheduler::schedule(MSP430::TimedEventHandler *handler, SimulationTime t) {
+	std::vector<Event>::iterator it = m_events.begin();
+	for (; it != m_events.end(); ++it) {
+		if (it->handler == handler) {
+			break;
+		}
+	}
+
+	if (it == m_events.end()) {
+		Event event;
+		event.handler = handler;
+		event.time = t;
+		m_events.push_back(event);
+	}
+	else if (it->time == t) {
+		return;
+	}
+	else {
+		it->time = t;
+	}
+
+	reschedule();
+}
+
+void Scheduler::cancel(MSP430::TimedEventHandler *handler) {
+	for (std::vector<Event>::iterator it = m_events.begin(); it != m_events.end(); ++it) {
+		if (it->handler == handler) {
+			m_events.erase(it);
+			reschedule();
+			return;
+		}
+	}
+}
+
+void Scheduler::reschedule() {
+	// Time advance is computed once the transition finishes
+	if (m_inTransition || !m_wrapper) {
+		return;
+	}
+
+	m_time = m_wrapper->getTime();
+	m_wrapper->reschedule();
+}
@@ -0,0 +1,66 @@
+/**
+ * QSimKit - MSP430 simulator
+ * Copyright (C) 2013 Jan "HanzZ" Kaluza (hanzz.k@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#pragma once
+
+#include "Peripherals/SimulationObject.h"
+#include "CPU/BasicClock/Scheduler.h"
+
+#include <vector>
+
+class DCO;
+
+/// Generates the events scheduled by the peripherals with analytic clocks.
+/// There are only few such peripherals, so the pending events are kept in
+/// a plain vector.
+class Scheduler : public SimulationObject, public MSP430::Scheduler {
+	public:
+		Scheduler(DCO *dco);
+		~Scheduler();
+
+		void internalTransition();
+
+		void externalEvent(SimulationTime t, const SimulationEventList &);
+
+		void output(SimulationEventList &output);
+
+		SimulationTime timeAdvance();
+
+		SimulationTime getTime();
+
+		void schedule(MSP430::TimedEventHandler *handler, SimulationTime t);
+
+		void cancel(MSP430::TimedEventHandler *handler);
+
+		SimulationTime getNextEventTime();
+
+	private:
+		typedef struct {
+			MSP430::TimedEventHandler *handler;
+			SimulationTime time;
+		} Event;
+
+		void reschedule();
+
+		DCO *m_dco;
+		std::vector<Event> m_events;
+		// Time of the last transition, time advance is relative to it
+		SimulationTime m_time;
+		bool m_inTransition;
+};
@@ -20,7 +20,7 @@
 #include "VLO.h"
 #include <QDebug>
 
-VLO::VLO() : m_paused(false) {
+VLO::VLO() : m_paused(false), m_time(0), m_inTransition(false) {
 	
 }
 
@@ -29,10 +29,13 @@ VLO::~VLO() {
 }
 
 void VLO::internalTransition() {
+	m_inTransition = true;
+	m_time = m_wrapper->getTime();
 	tick();
+	m_inTransition = false;
 }
 
-void VLO::externalEvent(double t, const SimulationEventList &) {
+void VLO::externalEvent(SimulationTime t, const SimulationEventList &) {
 
 }
 
@@ -40,7 +43,9 @@ void VLO::output(SimulationEventList &output) {
 
 }
 
-double VLO::timeAdvance() {
+SimulationTime VLO::timeAdvance() {
+	if (m_paused)
+		return SIMULATION_TIME_MAX;
 	// Oscillator has to tick 2x faster, because it has to rise up and fall down.
 	return getStep() / 2;
 }
@@ -48,10 +53,27 @@ double VLO::timeAdvance() {
 void VLO::start() {
 	m_paused = false;
 	if (m_wrapper) {
+		if (!m_inTransition) {
+			m_time = m_wrapper->getTime();
+		}
 		m_wrapper->reschedule();
 	}
 }
 
+SimulationTime VLO::getNextTickTime() {
+	if (!m_wrapper) {
+		return SIMULATION_TIME_MAX;
+	}
+
+	// Stopped VLO is started by the first handler and ticks half of the
+	// period after that.
+	if (m_inTransition || m_paused || !hasHandlers()) {
+		return m_wrapper->getTime() + getStep() / 2;
+	}
+
+	return m_time + getStep() / 2;
+}
+
 void VLO::pause() {
 	m_paused = true;
 }
@@ -36,14 +36,19 @@ class VLO : public SimulationObject, public MSP430::VLO {
 
 		void internalTransition();
 
-		void externalEvent(double t, const SimulationEventList &);
+		void externalEvent(SimulationTime t, const SimulationEventList &);
 
 		void output(SimulationEventList &output);
 
-		double timeAdvance();
+		SimulationTime timeAdvance();
 		void start();
 		void pause();
 
+		SimulationTime getNextTickTime();
+
 	private:
 		bool m_paused;
+		// Time of the last transition, time advance is relative to it
+		SimulationTime m_time;
+		bool m_inTransition;
 };
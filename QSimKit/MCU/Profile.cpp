@@ -0,0 +1,135 @@
+/**
+ * QSimKit - MSP430 simulator
+ * Copyright (C) 2013 Jan "HanzZ" Kaluza (hanzz.k@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+
+#include "Profile.h"
+
+#include <QtAlgorithms>
+#include <QStringList>
+
+static bool bySelfCycles(const ProfiledFunction &a, const ProfiledFunction &b) {
+	return a.selfCycles > b.selfCycles;
+}
+
+static bool byInclusiveCycles(const ProfiledFunction &a, const ProfiledFunction &b) {
+	return a.inclusiveCycles > b.inclusiveCycles;
+}
+
+static bool byCycles(const ProfiledCall &a, const ProfiledCall &b) {
+	return a.cycles > b.cycles;
+}
+
+static QString percent(quint64 cycles, quint64 total) {
+	return QString::number(total ? 100.0 * cycles / total : 0.0, 'f', 2);
+}
+
+static QString escape(const QString &str) {
+	QString ret = "\"";
+	for (int i = 0; i < str.size(); ++i) {
+		QChar c = str[i];
+		if (c == '\\' || c == '"') {
+			ret += '\\';
+			ret += c;
+		}
+		else if (c.unicode() < 0x20) {
+			// Control characters are not allowed in JSON strings
+			ret += QString("\\u%1").arg(c.unicode(), 4, 16, QChar('0'));
+		}
+		else {
+			ret += c;
+		}
+	}
+	return ret + "\"";
+}
+
+static QString callsToJSON(const QList<ProfiledCall> &calls) {
+	QStringList items;
+	foreach(const ProfiledCall &call, calls) {
+		items << QString("{\"name\": %1, \"calls\": %2, \"cycles\": %3}")
+			.arg(escape(call.name)).arg(call.calls).arg(call.cycles);
+	}
+	return "[" + items.join(", ") + "]";
+}
+
+static QString functionsToJSON(const QList<ProfiledFunction> &functions) {
+	QStringList items;
+	foreach(const ProfiledFunction &f, functions) {
+		items << QString("    {\"name\": %1, \"address\": %2, \"instructions\": %3, "
+			"\"self_cycles\": %4, \"inclusive_cycles\": %5, \"calls\": %6, \"callees\": %7}")
+			.arg(escape(f.name)).arg(f.address).arg(f.instructions).arg(f.selfCycles)
+			.arg(f.inclusiveCycles).arg(f.calls).arg(callsToJSON(f.callees));
+	}
+	return "[\n" + items.join(",\n") + "\n  ]";
+}
+
+void Profile::sort() {
+	qSort(functions.begin(), functions.end(), bySelfCycles);
+	qSort(interrupts.begin(), interrupts.end(), byInclusiveCycles);
+	for (QList<ProfiledFunction>::iterator it = functions.begin(); it != functions.end(); ++it) {
+		qSort(it->callees.begin(), it->callees.end(), byCycles);
+	}
+	for (QList<ProfiledFunction>::iterator it = interrupts.begin(); it != interrupts.end(); ++it) {
+		qSort(it->callees.begin(), it->callees.end(), byCycles);
+	}
+}
+
+QString Profile::toText() const {
+	QString out;
+	out += QString("Flat profile, %1 cycles total:\n").arg(totalCycles);
+	out += QString("%1 %2 %3 %4 %5  %6\n")
+		.arg("self %", 8).arg("self", 12).arg("inclusive", 12)
+		.arg("calls", 10).arg("instructions", 12).arg("function");
+	foreach(const ProfiledFunction &f, functions) {
+		out += QString("%1 %2 %3 %4 %5  %6\n")
+			.arg(percent(f.selfCycles, totalCycles), 8).arg(f.selfCycles, 12)
+			.arg(f.inclusiveCycles, 12).arg(f.calls, 10).arg(f.instructions, 12)
+			.arg(f.name);
+	}
+
+	out += "\nCall graph:\n";
+	foreach(const ProfiledFunction &f, functions) {
+		if (f.callees.isEmpty()) {
+			continue;
+		}
+
+		out += f.name + "\n";
+		foreach(const ProfiledCall &call, f.callees) {
+			out += QString("    -> %1: %2 calls, %3 cycles\n")
+				.arg(call.name).arg(call.calls).arg(call.cycles);
+		}
+	}
+
+	out += "\nInterrupts:\n";
+	foreach(const ProfiledFunction &f, interrupts) {
+		out += QString("%1: %2 runs, %3 cycles (%4 %)\n")
+			.arg(f.name).arg(f.calls).arg(f.inclusiveCycles)
+			.arg(percent(f.inclusiveCycles, totalCycles));
+		foreach(const ProfiledCall &call, f.callees) {
+			out += QString("    -> %1: %2 calls, %3 cycles\n")
+				.arg(call.name).arg(call.calls).arg(call.cycles);
+		}
+	}
+
+	return out;
+}
+
+QString Profile::toJSON() const {
+	return QString("{\n  \"total_cycles\": %1,\n  \"functions\": %2,\n  \"interrupts\": %3\n}\n")
+		.arg(totalCycles).arg(functionsToJSON(functions)).arg(functionsToJSON(interrupts));
+}
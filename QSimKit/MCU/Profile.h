@@ -0,0 +1,78 @@
+/**
+ * QSimKit - MSP430 simulator
+ * Copyright (C) 2013 Jan "HanzZ" Kaluza (hanzz.k@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+
+#pragma once
+
+#include <QString>
+#include <QList>
+#include <stdint.h>
+
+/// Calls from one profiled function to another.
+class ProfiledCall {
+	public:
+		ProfiledCall(const QString &name = "", quint64 calls = 0, quint64 cycles = 0) :
+			name(name), calls(calls), cycles(cycles) {}
+
+		QString name;
+		quint64 calls;
+		/// Cycles spent in the called function including its own calls.
+		quint64 cycles;
+};
+
+/// Cycles spent in single function or interrupt handler.
+class ProfiledFunction {
+	public:
+		ProfiledFunction(const QString &name = "", uint16_t address = 0) :
+			name(name), address(address), instructions(0), selfCycles(0),
+			inclusiveCycles(0), calls(0) {}
+
+		QString name;
+		uint16_t address;
+		quint64 instructions;
+		/// Cycles of the instructions of this function.
+		quint64 selfCycles;
+		/// Cycles between entering and leaving the function, including the
+		/// functions called from it. Recursive calls are counted repeatedly.
+		quint64 inclusiveCycles;
+		/// Number of calls or, for interrupt handlers, number of runs.
+		quint64 calls;
+		QList<ProfiledCall> callees;
+};
+
+/// Result of the firmware profiling done by the MCU.
+class Profile {
+	public:
+		Profile() : totalCycles(0) {}
+
+		/// Functions sorted by the self cycles.
+		QList<ProfiledFunction> functions;
+		/// Interrupt handlers. Only the calls, inclusive cycles and callees
+		/// are set.
+		QList<ProfiledFunction> interrupts;
+		quint64 totalCycles;
+
+		/// Sorts functions by the self cycles and callees by the cycles.
+		void sort();
+
+		/// Returns flat profile followed by the call graph.
+		QString toText() const;
+
+		QString toJSON() const;
+};
@@ -31,7 +31,7 @@ Oscillator::Oscillator() : m_state(false) {
 	m_pins.push_back(Pin(QRect(24, 12, 10, 10), "XOUT", 0));
 
 	m_freq = 7372800;
-	m_step = 1.0 / m_freq / 2;
+	m_step = frequencyToPeriod(m_freq) / 2;
 
 	m_options << "Set frequency";
 }
@@ -46,7 +46,7 @@ const QStringList &Oscillator::getOptions() {
 
 void Oscillator::executeOption(int option) {
 	m_freq = QInputDialog::getInt(0, "Set frequency", "Frequency (Hz):", m_freq);
-	m_step = 1.0 / m_freq / 2;
+	m_step = frequencyToPeriod(m_freq) / 2;
 }
 
 void Oscillator::save(QTextStream &stream) {
@@ -58,7 +58,7 @@ void Oscillator::save(QTextStream &stream) {
 
 void Oscillator::load(QDomElement &object, QString &error) {
 	m_freq = object.firstChildElement("frequency").text().toInt();
-	m_step = 1.0 / m_freq / 2;
+	m_step = frequencyToPeriod(m_freq) / 2;
 }
 
 void Oscillator::internalTransition() {
@@ -74,7 +74,7 @@ void Oscillator::internalTransition() {
 	}
 }
 
-void Oscillator::externalEvent(double e, const SimulationEventList &events) {
+void Oscillator::externalEvent(SimulationTime e, const SimulationEventList &events) {
 
 }
 
@@ -84,7 +84,7 @@ void Oscillator::output(SimulationEventList &output) {
 	}
 }
 
-double Oscillator::timeAdvance() {
+SimulationTime Oscillator::timeAdvance() {
 	return m_step;
 }
 
@@ -31,11 +31,11 @@ class Oscillator : public Peripheral
 
 		void internalTransition();
 
-		void externalEvent(double e, const SimulationEventList &);
+		void externalEvent(SimulationTime e, const SimulationEventList &);
 
 		void output(SimulationEventList &output);
 
-		double timeAdvance();
+		SimulationTime timeAdvance();
 
 		void reset();
 
@@ -56,7 +56,7 @@ class Oscillator : public Peripheral
 		PinList m_pins;
 		bool m_state;
 		unsigned long m_freq;
-		double m_step;
+		SimulationTime m_step;
 		SimulationEventList m_output;
 		QStringList m_options;
 
@@ -47,7 +47,7 @@ void PythonPeripheral::internalTransition() {
 	m_script->call("internalTransition");
 }
 
-void PythonPeripheral::externalEvent(double t, const SimulationEventList &events) {
+void PythonPeripheral::externalEvent(SimulationTime t, const SimulationEventList &events) {
 	int i = 0;
 	for (SimulationEventList::const_iterator it = events.begin(); i != events.size(); ++it, ++i) {
 		m_script->call("externalEvent", QVariantList() << (*it).port << (*it).value);
@@ -62,8 +62,9 @@ void PythonPeripheral::output(SimulationEventList &output) {
 	}
 }
 
-double PythonPeripheral::timeAdvance() {
-	return m_script->call("timeAdvance").toDouble();
+SimulationTime PythonPeripheral::timeAdvance() {
+	// Scripts work with the time in seconds
+	return secondsToTime(m_script->call("timeAdvance").toDouble());
 }
 
 void PythonPeripheral::objectMoved(int x, int y) {
@@ -36,11 +36,11 @@ class PythonPeripheral : public Peripheral {
 
 		void internalTransition();
 
-		void externalEvent(double t, const SimulationEventList &);
+		void externalEvent(SimulationTime t, const SimulationEventList &);
 
 		void output(SimulationEventList &output);
 
-		double timeAdvance();
+		SimulationTime timeAdvance();
 
 		void reset();
 
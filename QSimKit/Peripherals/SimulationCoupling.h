@@ -0,0 +1,61 @@
+/**
+ * QSimKit - MSP430 simulator
+ * Copyright (C) 2013 Jan "HanzZ" Kaluza (hanzz.k@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#pragma once
+
+#include <vector>
+
+#include "adevs.h"
+#include "SimulationEvent.h"
+#include "SimulationTime.h"
+
+/// Atomic model whose output pins are coupled to the input pins of other
+/// models. Every output pin has a preallocated slot with the event for the
+/// coupled model, so routing the output does not allocate any memory.
+class SimulationCoupling : public adevs::Atomic<SimulationEvent, SimulationTime> {
+	public:
+		typedef adevs::Event<SimulationEvent, SimulationTime> Target;
+
+		SimulationCoupling(int pins = 100) : m_targets(pins) {}
+
+		/// Couples the output pin out with the input pin in of the model c.
+		void couple(int out, adevs::Devs<SimulationEvent, SimulationTime> *c, int in) {
+			m_targets[out].model = c;
+			m_targets[out].value.port = in;
+		}
+
+		/// Puts the event for the model coupled with the pin of the output
+		/// x into r. Nothing is routed when the pin is not coupled.
+		void route(const SimulationEvent &x, adevs::Bag<Target> &r) {
+			if (x.port < 0 || x.port >= (int) m_targets.size()) {
+				return;
+			}
+
+			Target &target = m_targets[x.port];
+			if (!target.model) {
+				return;
+			}
+
+			target.value.value = x.value;
+			r.insert(target);
+		}
+
+	private:
+		std::vector<Target> m_targets;
+};
@@ -19,28 +19,9 @@
 
 #pragma once
 
-#include <QDialog>
-#include <QString>
-#include <QTimer>
-#include <QLineEdit>
+#include "adevs.h"
 
-#include "ui_PathDialog.h"
-
-class PathDialog : public QDialog, public Ui::PathDialog
-{
-	Q_OBJECT
-
-	public:
-		PathDialog(const QString &objcopy, const QString &objdump, QWidget *parent = 0);
-
-		QString getObjdump();
-
-		QString getObjcopy();
-
-	private slots:
-		void browse(QLineEdit *line);
-		void browseObjdump(bool checked = false);
-		void browseObjcopy(bool checked = false);
-
-};
+/// Change of the value on the pin, the port is the number of the pin.
+typedef adevs::PortValue<double> SimulationEvent;
 
+typedef adevs::Bag<SimulationEvent> SimulationEventList;
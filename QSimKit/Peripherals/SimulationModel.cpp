@@ -19,8 +19,6 @@
 
 #include "SimulationModel.h"
 
-#include <QDebug>
-
 
 void SimulationModel::add(Component* model)
 {
@@ -36,19 +34,10 @@ void SimulationModel::getComponents(adevs::Set<Component*>& c)
 
 void SimulationModel::
 route(const SimulationEvent& x, Component* model, 
-adevs::Bag<adevs::Event<SimulationEvent, double> >& r)
+adevs::Bag<adevs::Event<SimulationEvent, SimulationTime> >& r)
 {
-	SimulationObjectWrapper *obj = static_cast<SimulationObjectWrapper *>(model);
-
-	adevs::Event<SimulationEvent> event;
-	event.model = obj->getTarget(x.port, event.value.port);
-	if (!event.model) {
-		return;
-	}
-
-	event.value.value = x.value;
-	r.insert(event);
-
+	// The event goes right into the preallocated slot of the coupled pin
+	static_cast<SimulationCoupling *>(model)->route(x, r);
 }
 
 SimulationModel::~SimulationModel()
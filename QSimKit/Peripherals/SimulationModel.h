@@ -23,26 +23,27 @@
 #include <map>
 #include <set>
 #include <cstdlib>
-#include "SimulationObject.h"
+#include "SimulationCoupling.h"
 
 class SimulationModel: 
-public adevs::Network<SimulationEvent, double>
+public adevs::Network<SimulationEvent, SimulationTime>
 {
 	public:
-		typedef adevs::Devs<SimulationEvent, double> Component;
+		typedef adevs::Devs<SimulationEvent, SimulationTime> Component;
 
 		/// Construct a network with no components.
 		SimulationModel():
-		adevs::Network<SimulationEvent, double>()
+		adevs::Network<SimulationEvent, SimulationTime>()
 		{
 		}
 		/// Add a model to the network.
 		void add(Component* model);
 		/// Puts the network's components into to c
 		void getComponents(adevs::Set<Component*>& c);
-		/// Route an event based on the coupling information.
+		/// Route an event based on the coupling information. The components
+		/// have to be SimulationCoupling models.
 		void route(const SimulationEvent& x, Component* model, 
-		adevs::Bag<adevs::Event<SimulationEvent, double> >& r);
+		adevs::Bag<adevs::Event<SimulationEvent, SimulationTime> >& r);
 		/// Destructor.  Destroys all of the component models.
 		~SimulationModel();
 
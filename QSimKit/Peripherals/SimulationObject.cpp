@@ -36,8 +36,6 @@ m_obj(obj), m_monitoredPins(monitoredPins.toVector()), m_context(0) {
 			m_history[m_monitoredPins[i]] = new PinHistory(m_monitoredPins[i]);
 		}
 	}
-
-	m_conns.resize(100);
 }
 
 SimulationObjectWrapper::~SimulationObjectWrapper() {
@@ -63,7 +61,7 @@ void SimulationObjectWrapper::addChangeToHistory(int pin, double value) {
 	h->addEvent(m_sim->nextEventTime(), value, m_context);
 }
 
-void SimulationObjectWrapper::delta_ext(double e, const SimulationEventList& xb) {
+void SimulationObjectWrapper::delta_ext(SimulationTime e, const SimulationEventList& xb) {
 	m_obj->externalEvent(e, xb);
 
 	if (!m_monitoredPins.empty()) {
@@ -75,7 +73,7 @@ void SimulationObjectWrapper::delta_ext(double e, const SimulationEventList& xb)
 
 void SimulationObjectWrapper::delta_conf(const SimulationEventList& xb) {
 	delta_int();
-	delta_ext(0.0, xb);
+	delta_ext(0, xb);
 }
 
 void SimulationObjectWrapper::output_func(SimulationEventList& yb) {
@@ -88,24 +86,10 @@ void SimulationObjectWrapper::output_func(SimulationEventList& yb) {
 	}
 }
 
-double SimulationObjectWrapper::ta() {
+SimulationTime SimulationObjectWrapper::ta() {
 	return m_obj->timeAdvance();
 }
 
 void SimulationObjectWrapper::gc_output(SimulationEventList& g) {
 
 }
-
-void SimulationObjectWrapper::couple(int out, adevs::Devs<SimulationEvent, double> *c, int in) {
-	node n;
-	n.c = c;
-	n.port = in;
-	m_conns[out] = n;
-}
-
-adevs::Devs<SimulationEvent, double> *SimulationObjectWrapper::getTarget(int in, int &out) {
-	node &n = m_conns[in];
-
-	out = n.port;
-	return n.c;
-}
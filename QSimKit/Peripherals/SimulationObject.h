@@ -28,14 +28,22 @@
 #include <map>
 
 #include "adevs.h"
+#include "SimulationTime.h"
+#include "SimulationEvent.h"
+#include "SimulationCoupling.h"
 #include <stdint.h>
 #include <float.h>
 
 class PinHistory;
 
-typedef adevs::PortValue<double> SimulationEvent;
-
-typedef adevs::Bag<SimulationEvent> SimulationEventList;
+/// Simulator running the models. The binary heap of adevs is faster than
+/// the timing wheel for the few models of the usual project, the wheel can
+/// be chosen with -DENABLE_TIMING_WHEEL=ON for projects with hundreds of them.
+#ifdef WITH_TIMING_WHEEL
+typedef adevs::Simulator<SimulationEvent, SimulationTime, adevs::TimingWheel<SimulationEvent, SimulationTime> > SimulationKernel;
+#else
+typedef adevs::Simulator<SimulationEvent, SimulationTime> SimulationKernel;
+#endif
 
 class SimulationObjectWrapper;
 
@@ -48,11 +56,11 @@ class SimulationObject {
 
 		virtual void internalTransition() = 0;
 
-		virtual void externalEvent(double t, const SimulationEventList &) = 0;
+		virtual void externalEvent(SimulationTime t, const SimulationEventList &) = 0;
 
 		virtual void output(SimulationEventList &output) = 0;
 
-		virtual double timeAdvance() = 0;
+		virtual SimulationTime timeAdvance() = 0;
 
 		virtual void getInternalSimulationObjects(std::vector<SimulationObject *> &) {}
 
@@ -64,7 +72,7 @@ class SimulationObject {
 		SimulationObjectWrapper *m_wrapper;
 };
 
-class SimulationObjectWrapper : public adevs::Atomic<SimulationEvent> {
+class SimulationObjectWrapper : public SimulationCoupling {
 	public:
 		SimulationObjectWrapper(SimulationObject *obj, const QList<int> &monitoredPins = QList<int>());
 		~SimulationObjectWrapper();
@@ -73,7 +81,7 @@ class SimulationObjectWrapper : public adevs::Atomic<SimulationEvent> {
 		void delta_int();
 
 		/// Handles external changes (change on PINs or interrupts)
-		void delta_ext(double e, const SimulationEventList &xb);
+		void delta_ext(SimulationTime e, const SimulationEventList &xb);
 
 		/// Confluent transition function.
 		void delta_conf(const SimulationEventList &xb);
@@ -82,20 +90,22 @@ class SimulationObjectWrapper : public adevs::Atomic<SimulationEvent> {
 		void output_func(SimulationEventList &yb);
 
 		/// Time advance function.
-		double ta();
+		SimulationTime ta();
 
 		/// Output value garbage collection.
 		void gc_output(SimulationEventList& g);
 
-		void setSimulator(adevs::Simulator<SimulationEvent> *sim) {
+		void setSimulator(SimulationKernel *sim) {
 			m_sim = sim;
 		}
 
+		/// Moves the model in the schedule after its time advance changed
+		/// outside of its own transition.
 		void reschedule() {
-			m_sim->addModel(this);
+			m_sim->timeAdvanceChanged(this);
 		}
 
-		double getTime() {
+		SimulationTime getTime() {
 			return m_sim->nextEventTime();
 		}
 
@@ -107,10 +117,6 @@ class SimulationObjectWrapper : public adevs::Atomic<SimulationEvent> {
 			m_context = context;
 		}
 
-		adevs::Devs<SimulationEvent, double> *getTarget(int in, int &out);
-
-		void couple(int out, adevs::Devs<SimulationEvent, double> *c, int in);
-
 		SimulationObject *getObject() {
 			return m_obj;
 		}
@@ -119,18 +125,10 @@ class SimulationObjectWrapper : public adevs::Atomic<SimulationEvent> {
 		void addChangeToHistory(int pin, double value);
 
 	private:
-		adevs::Simulator<SimulationEvent> *m_sim;
+		SimulationKernel *m_sim;
 		SimulationObject *m_obj;
 		QVector<int> m_monitoredPins;
 		QVector<PinHistory *> m_history;
 		uint16_t m_context;
-
-		class node {
-			public:
-			node() : c(0), port(0) {}
-			adevs::Devs<SimulationEvent, double> *c;
-			int port;
-		};
-		std::vector<node> m_conns;
 };
 
@@ -0,0 +1,72 @@
+/**
+ * QSimKit - MSP430 simulator
+ * Copyright (C) 2013 Jan "HanzZ" Kaluza (hanzz.k@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ **/
+
+#pragma once
+
+#include <stdint.h>
+#include <limits>
+
+#include "adevs_time.h"
+
+/// Simulation time in picoseconds. Integer time keeps the ordering of the
+/// events exact and does not accumulate rounding errors over long runs.
+/// 64 bits are enough for more than 100 days of simulated time.
+typedef int64_t SimulationTime;
+
+/// Number of SimulationTime units in one second
+#define TIME_UNITS_PER_SECOND 1000000000000LL
+
+/// Time of the event which never happens
+#define SIMULATION_TIME_MAX std::numeric_limits<SimulationTime>::max()
+
+/// Converts the time in seconds to SimulationTime.
+inline SimulationTime secondsToTime(double seconds) {
+	if (seconds >= (double) SIMULATION_TIME_MAX / TIME_UNITS_PER_SECOND) {
+		return SIMULATION_TIME_MAX;
+	}
+	return (SimulationTime) (seconds * TIME_UNITS_PER_SECOND + 0.5);
+}
+
+/// Converts the SimulationTime to seconds.
+inline double timeToSeconds(SimulationTime t) {
+	return (double) t / TIME_UNITS_PER_SECOND;
+}
+
+/// Returns the period of the clock with the given frequency in Hz. The
+/// period is rounded to an even number of time units, so the rising and
+/// the falling half of the period take the same time.
+inline SimulationTime frequencyToPeriod(double frequency) {
+	// Oscillator with zero frequency never ticks
+	if (frequency <= 2.0 * TIME_UNITS_PER_SECOND / SIMULATION_TIME_MAX) {
+		return SIMULATION_TIME_MAX;
+	}
+	return 2 * (SimulationTime) (TIME_UNITS_PER_SECOND / frequency / 2 + 0.5);
+}
+
+template <> inline SimulationTime adevs_inf() {
+	return SIMULATION_TIME_MAX;
+}
+
+template <> inline SimulationTime adevs_zero() {
+	return 0;
+}
+
+template <> inline SimulationTime adevs_sentinel() {
+	return -1;
+}
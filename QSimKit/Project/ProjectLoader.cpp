@@ -89,9 +89,10 @@ bool ProjectLoader::load(QDomDocument &doc, QString &error) {
 	return true;
 }
 
-adevs::Simulator<SimulationEvent> *ProjectLoader::prepareSimulation(QDomDocument &doc, SimulationModel *model) {
+SimulationKernel *ProjectLoader::prepareSimulation(QDomDocument &doc, SimulationModel *model) {
 	// Stores object -> wrapper mapping
 	std::map<ScreenObject *, SimulationObjectWrapper *> wrappers;
+	std::vector<SimulationObjectWrapper *> internalWrappers;
 
 	// Iterate over all peripherals to create wrappers
 	for (int i = 0; i < m_objects.size(); ++i) {
@@ -115,6 +116,8 @@ adevs::Simulator<SimulationEvent> *ProjectLoader::prepareSimulation(QDomDocument
 			for (int x = 0; x < internalObjects.size(); ++x) {
 				SimulationObjectWrapper *wrapper = new SimulationObjectWrapper(internalObjects[x]);
 				model->add(wrapper);
+				internalObjects[x]->setWrapper(wrapper);
+				internalWrappers.push_back(wrapper);
 			}
 		}
 	}
@@ -137,12 +140,18 @@ adevs::Simulator<SimulationEvent> *ProjectLoader::prepareSimulation(QDomDocument
 	}
 
 	// Create Simulation object
-	adevs::Simulator<SimulationEvent> *simulator = new adevs::Simulator<SimulationEvent>(model);
+	SimulationKernel *simulator = new SimulationKernel(model);
 
 	// Pair simulator with wrapper objects
 	for (std::map<ScreenObject *, SimulationObjectWrapper *>::iterator it = wrappers.begin(); it != wrappers.end(); ++it) {
 		it->second->setSimulator(simulator);
 	}
-	
+
+	// Internal objects like DCO have to be able to reschedule themselves
+	// when they are started again.
+	for (std::vector<SimulationObjectWrapper *>::iterator it = internalWrappers.begin(); it != internalWrappers.end(); ++it) {
+		(*it)->setSimulator(simulator);
+	}
+
 	return simulator;
 }
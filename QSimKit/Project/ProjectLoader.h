@@ -40,7 +40,7 @@ class ProjectLoader : public QObject {
 
 		bool load(QDomDocument &doc, QString &error);
 
-		adevs::Simulator<SimulationEvent> *prepareSimulation(QDomDocument &doc, SimulationModel *model);
+		SimulationKernel *prepareSimulation(QDomDocument &doc, SimulationModel *model);
 
 		MCU *getMCU() {
 			return m_mcu;
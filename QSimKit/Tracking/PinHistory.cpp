@@ -27,7 +27,7 @@ PinHistory::~PinHistory() {
 
 }
 
-void PinHistory::addEvent(double t, double v, uint16_t context) {
+void PinHistory::addEvent(SimulationTime t, double v, uint16_t context) {
 	PinEvent e;
 	e.t = t;
 	e.v = v;
@@ -22,8 +22,10 @@
 #include <stdint.h>
 #include <QLinkedList>
 
+#include "Peripherals/SimulationTime.h"
+
 typedef struct {
-	double t;
+	SimulationTime t;
 	double v;
 	uint16_t context;
 } PinEvent;
@@ -33,7 +35,7 @@ class PinHistory {
 		PinHistory(int pin);
 		~PinHistory();
 
-		void addEvent(double t, double value, uint16_t context);
+		void addEvent(SimulationTime t, double value, uint16_t context);
 
 		QLinkedList<PinEvent> &getEvents() {
 			return m_events;
@@ -144,7 +144,7 @@ void Plot::paintPin(QPainter &p, const QString &name, PinHistory *pin, int slot,
 	// Skip all events which happend before current 'x'
 	QLinkedList<PinEvent>::iterator it = pin->getEvents().begin();
 	for (; it != pin->getEvents().end(); ++it) {
-		if ((*it).t < m_minX) {
+		if (timeToSeconds((*it).t) < m_minX) {
 			continue;
 		}
 
@@ -159,12 +159,12 @@ void Plot::paintPin(QPainter &p, const QString &name, PinHistory *pin, int slot,
 
 	for (; it != pin->getEvents().end(); ++it) {
 		// Do not paint pins which are out of boundaries
-		if ((*it).t > m_maxX) {
+		if (timeToSeconds((*it).t) > m_maxX) {
 			break;
 		}
 
 		// Get the coordinates of the next point to which we will draw to line to
-		toX = ((*it).t / (m_maxX - m_minX)) * (PLOT_WIDTH) + PLOT_SPACE_LEFT - (m_minX / (m_maxX - m_minX)) * (PLOT_WIDTH);
+		toX = (timeToSeconds((*it).t) / (m_maxX - m_minX)) * (PLOT_WIDTH) + PLOT_SPACE_LEFT - (m_minX / (m_maxX - m_minX)) * (PLOT_WIDTH);
 		toY = PLOT_HEIGHT + slot * (PLOT_HEIGHT + PLOT_SPACE_BETWEEN) - ((*it).v / m_maxY) * (PLOT_HEIGHT);
 
 		if (toX <= PLOT_SPACE_LEFT) {
@@ -193,7 +193,7 @@ void Plot::paintPin(QPainter &p, const QString &name, PinHistory *pin, int slot,
 
 		if (it + 1 != pin->getEvents().end()) {
 			// Get the 'x' coordinate of the next point we will draw vertical line to
-			int toX2 = ((*(it + 1)).t / (m_maxX - m_minX)) * (PLOT_WIDTH) + PLOT_SPACE_LEFT - (m_minX / (m_maxX - m_minX)) * (PLOT_WIDTH);
+			int toX2 = (timeToSeconds((*(it + 1)).t) / (m_maxX - m_minX)) * (PLOT_WIDTH) + PLOT_SPACE_LEFT - (m_minX / (m_maxX - m_minX)) * (PLOT_WIDTH);
 
 			// If the next 'x' coordinate is close to this 'x' coordinate,
 			// show only vertical dashed line on this place. Otherwise
@@ -220,7 +220,7 @@ void Plot::paintPin(QPainter &p, const QString &name, PinHistory *pin, int slot,
 			p.setPen(QPen(QColor(0, 0, 0), 1, Qt::SolidLine));
 			if (!draw && m_pos.x() > toX - 5 && m_pos.x() < toX + 5) {
 				p.drawRect(toX - 4, toY - 4, 8, 8);
-				QString label = QString("t=") + QString::number((*it).t) + " s, v=" + QString::number((*it).v) + " V";
+				QString label = QString("t=") + QString::number(timeToSeconds((*it).t)) + " s, v=" + QString::number((*it).v) + " V";
 // 				if (m_pos.x() > m_fromX && m_pos.x() < m_toX) {
 					label += ", delta t=" + QString::number(m_toT - m_fromT) + " s";
 // 				}
@@ -308,15 +308,15 @@ int Plot::correctX(int x, int y, double &t) {
 
 	QLinkedList<PinEvent>::iterator it = pin->getEvents().begin();
 	for (; it != pin->getEvents().end(); ++it) {
-		if ((*it).t < m_minX) {
+		if (timeToSeconds((*it).t) < m_minX) {
 			continue;
 		}
-		if ((*it).t > m_maxX) {
+		if (timeToSeconds((*it).t) > m_maxX) {
 			break;
 		}
-		double toX = ((*it).t / (m_maxX - m_minX)) * (PLOT_WIDTH) + PLOT_SPACE_LEFT - (m_minX / (m_maxX - m_minX)) * (PLOT_WIDTH);
+		double toX = (timeToSeconds((*it).t) / (m_maxX - m_minX)) * (PLOT_WIDTH) + PLOT_SPACE_LEFT - (m_minX / (m_maxX - m_minX)) * (PLOT_WIDTH);
 		if (x > toX - 5 && x < toX + 5) {
-			t = (*it).t;
+			t = timeToSeconds((*it).t);
 			m_context = (*it).context;
 			return toX;
 		}
@@ -60,7 +60,7 @@ void Table::populate() {
 
 	int c = 0;
 	while (true) {
-		double lowest = DBL_MAX;
+		SimulationTime lowest = SIMULATION_TIME_MAX;
 		QLinkedList<PinEvent>::iterator *it;
 		for (int i = 0; i < m_pins.size(); ++i) {
 			if (indexes[i] != ends[i] && indexes[i]->t < lowest) {
@@ -69,11 +69,11 @@ void Table::populate() {
 			}
 		}
 
-		if (lowest == DBL_MAX) {
+		if (lowest == SIMULATION_TIME_MAX) {
 			break;
 		}
 
-		QTableWidgetItem *item = new QTableWidgetItem(QString::number(lowest));
+		QTableWidgetItem *item = new QTableWidgetItem(QString::number(timeToSeconds(lowest)));
 		table->setVerticalHeaderItem(c, item);
 		for (int i = 0; i < m_pins.size(); ++i) {
 			item = new QTableWidgetItem(QString::number(indexes[i]->v));
@@ -20,6 +20,8 @@
 #include <QtCore/QCoreApplication>
 #include <QDebug>
 #include <QFile>
+#include <QTextStream>
+#include <QStringList>
 #include <QTime>
 #include <QDomDocument>
 
@@ -38,9 +40,23 @@ int main(int argc, char *argv[])
 {
 	QCoreApplication a(argc, argv);
 
-	if (argc != 3) {
-		qDebug() << "Usage:" << argv[0] << "<input.qsp>" << "<max_simulation_time_in_seconds>";
-		qDebug() << "Example:" << argv[0] << "mmc.qsp" << "0.05";
+	// Split the options from the positional arguments
+	QStringList args;
+	QString profileFile;
+	for (int i = 1; i < argc; ++i) {
+		QString arg(argv[i]);
+		if (arg == "--profile" && i + 1 < argc) {
+			profileFile = argv[++i];
+		}
+		else {
+			args << arg;
+		}
+	}
+
+	if (args.size() != 2 && args.size() != 3) {
+		qDebug() << "Usage:" << argv[0] << "<input.qsp>" << "<max_simulation_time_in_seconds>" << "[quantum_in_cycles]"
+			<< "[--profile <report.txt|report.json>]";
+		qDebug() << "Example:" << argv[0] << "mmc.qsp" << "0.05" << "100" << "--profile" << "mmc.json";
 		return -2;
 	}
 
@@ -55,7 +71,7 @@ int main(int argc, char *argv[])
 	// Load XML file with saved project
 	int errorLine, errorColumn;
 	QString errorMsg;
-	QString f(argv[1]);
+	QString f(args[0]);
 	QFile modelFile(f);
 	QDomDocument document;
 	if (!document.setContent(&modelFile, &errorMsg, &errorLine, &errorColumn)) {
@@ -72,29 +88,40 @@ int main(int argc, char *argv[])
 		return -3;
 	}
 
+	// Let the MCU run ahead of the rest of the simulation
+	if (args.size() == 3) {
+		p.getMCU()->setQuantum(args[2].toInt());
+	}
+
 	// Create simulation model
 	SimulationModel *model = new SimulationModel();
 
 	// Create Simulation object and prepare the simulation
-	adevs::Simulator<SimulationEvent> *simulator = p.prepareSimulation(document, model);
+	SimulationKernel *simulator = p.prepareSimulation(document, model);
 
 	// get debugging data from ELF binary
 	DebugData *dd = p.getMCU()->getDebugData();
 
+	// Count cycles spent in the firmware functions
+	if (!profileFile.isEmpty()) {
+		p.getMCU()->setProfiling(true);
+	}
+
 	// Run simulation events until 'until' seconds
-	double until = QString(argv[2]).toDouble();
+	double until = args[1].toDouble();
 	qDebug() << "Starting simulation until" << until;
+	SimulationTime untilTime = secondsToTime(until);
 	long eventCount = 0;
 	unsigned long totalEventCount = 0;
 	QTime simStart;
 	simStart.start();
 // 	CALLGRIND_ZERO_STATS;
-	while (simulator->nextEventTime() <= until) {
+	while (simulator->nextEventTime() <= untilTime) {
 		simulator->execNextEvent();
 		if (++eventCount > 65000) {
 			totalEventCount += eventCount;
 			// Print some useful info... just to show how to access MCU internals
-			qDebug() << "Time:" << simulator->nextEventTime();
+			qDebug() << "Time:" << timeToSeconds(simulator->nextEventTime());
 
 			uint16_t pc = p.getMCU()->getRegisterSet()->get(0)->getBigEndian();
 			qDebug() << "Small register dump:"
@@ -111,9 +138,39 @@ int main(int argc, char *argv[])
 	}
 
 	totalEventCount += eventCount;
-	qDebug() << "Simulation paused. Simulation lasted" << simStart.elapsed() << "ms.";
+	int elapsed = simStart.elapsed();
+	qDebug() << "Simulation paused. Simulation lasted" << elapsed << "ms.";
 	qDebug() << "Executed" << totalEventCount << "simulation events.";
 
+	// Builds with -DENABLE_TIMING_WHEEL=ON can be compared with the
+	// default one by running the same project in both.
+#ifdef WITH_TIMING_WHEEL
+	qDebug() << "Scheduler: timing wheel";
+#else
+	qDebug() << "Scheduler: binary heap";
+#endif
+	if (elapsed > 0) {
+		qDebug() << "Events per second:" << (qint64) (totalEventCount * 1000.0 / elapsed);
+	}
+
+	QStringList stats = p.getMCU()->getStatistics();
+	for (QStringList::iterator it = stats.begin(); it != stats.end(); ++it) {
+		qDebug() << qPrintable(*it);
+	}
+
+	if (!profileFile.isEmpty()) {
+		Profile profile = p.getMCU()->getProfile(dd);
+		QFile file(profileFile);
+		if (file.open(QFile::WriteOnly | QFile::Truncate | QIODevice::Text)) {
+			QTextStream stream(&file);
+			stream << (profileFile.endsWith(".json") ? profile.toJSON() : profile.toText());
+			qDebug() << "Profile written to" << profileFile;
+		}
+		else {
+			qDebug() << "Cannot write profile to" << profileFile;
+		}
+	}
+
 // 	return a.exec();
 
 	delete simulator;
@@ -24,7 +24,7 @@
 
 ConnectionNode::ConnectionNode() {
 	m_type = "ConnectionNode";
-	m_advance = 365;
+	m_advance = SIMULATION_TIME_MAX;
 	m_width = 36;
 	m_height = 36;
 
@@ -40,7 +40,7 @@ ConnectionNode::~ConnectionNode() {
 
 void ConnectionNode::internalTransition() {}
 
-void ConnectionNode::externalEvent(double t, const SimulationEventList &events) {
+void ConnectionNode::externalEvent(SimulationTime t, const SimulationEventList &events) {
 	for (SimulationEventList::const_iterator it = events.begin(); it != events.end(); ++it) {
 		for (std::map<int, Connection *>::iterator it2 = m_conns.begin(); it2 != m_conns.end(); ++it2) {
 			if (it2->first != (*it).port) {
@@ -54,14 +54,15 @@ void ConnectionNode::externalEvent(double t, const SimulationEventList &events)
 void ConnectionNode::output(SimulationEventList &output) {
 	if (!m_output.empty()) {
 // 		qDebug() << "node output";
-		output = m_output;
-		m_output.clear();
+		// Swapping keeps both buffers for the next events, while copying
+		// the bag would allocate a new one every time.
+		output.swap(m_output);
 	}
 }
 
-double ConnectionNode::timeAdvance() {
-	double r = m_advance;
-	m_advance = 365;
+SimulationTime ConnectionNode::timeAdvance() {
+	SimulationTime r = m_advance;
+	m_advance = SIMULATION_TIME_MAX;
 // 	qDebug() << "node ta=" << r;
 	return r;
 }
@@ -69,11 +69,11 @@ class ConnectionNode : public Peripheral
 
 		void internalTransition();
 
-		void externalEvent(double t, const SimulationEventList &);
+		void externalEvent(SimulationTime t, const SimulationEventList &);
 
 		void output(SimulationEventList &output);
 
-		double timeAdvance();
+		SimulationTime timeAdvance();
 
 		void reset();
 
@@ -82,7 +82,7 @@ class ConnectionNode : public Peripheral
 		std::map<int, Connection *> m_conns;
 		QStringList m_options;
 		SimulationEventList m_output;
-		double m_advance;
+		SimulationTime m_advance;
 
 };
 
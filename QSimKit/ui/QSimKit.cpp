@@ -30,6 +30,7 @@
 
 #include "DockWidgets/Disassembler/Disassembler.h"
 #include "DockWidgets/Peripherals/Peripherals.h"
+#include "DockWidgets/Profiler/Profiler.h"
 #include "Breakpoints/BreakpointManager.h"
 
 #include "Tracking/TrackedPins.h"
@@ -88,6 +89,10 @@ m_dig(0), m_sim(0), m_logicalSteps(0), m_instPerCycle(2500), m_stopped(true) {
 	m_trackedPins = new TrackedPins(this, this);
 	QMainWindow::addDockWidget(Qt::BottomDockWidgetArea, m_trackedPins);
 
+	m_profiler = new Profiler(this);
+	addDockWidget(m_profiler, Qt::BottomDockWidgetArea);
+	tabifyDockWidget(m_trackedPins, m_profiler);
+
 	setDockWidgetsEnabled(false);
 
 	readSettings();
@@ -169,7 +174,7 @@ void QSimKit::refreshDockWidgets() {
 		m_dockWidgets[i]->refresh();
 	}
 
-	statusbar->showMessage(QString::number(m_sim->nextEventTime()));
+	statusbar->showMessage(QString::number(timeToSeconds(m_sim->nextEventTime())));
 }
 
 void QSimKit::setDockWidgetsEnabled(bool enabled) {
@@ -190,16 +195,13 @@ void QSimKit::setDockWidgetsMCU(MCU *mcu) {
 
 void QSimKit::doSingleAssemblerStep() {
 	uint16_t pc = screen->getMCU()->getRegisterSet()->get(0)->getBigEndian();
-	double start_t = m_sim->nextEventTime();
+	SimulationTime start_t = m_sim->nextEventTime();
 	do {
-		double t = m_sim->nextEventTime();
-
-		do {
-			m_sim->execNextEvent();
-		}
-		while (t == m_sim->nextEventTime());
+		// Execute all the events happening at the same time
+		SimulationTime t = m_sim->nextEventTime();
+		m_sim->execUntil(t);
 
-		if (t - start_t > 0.01) {
+		if (t - start_t > secondsToTime(0.01)) {
 			QMessageBox::warning(this, tr("Instruction takes too long"),
 						tr("Single instruction takes more than 10ms. Possible loop detected."));
 			break;
@@ -210,16 +212,13 @@ void QSimKit::doSingleAssemblerStep() {
 
 void QSimKit::doSingleCStep() {
 	uint16_t pc = screen->getMCU()->getRegisterSet()->get(0)->getBigEndian();
-	double start_t = m_sim->nextEventTime();
+	SimulationTime start_t = m_sim->nextEventTime();
 	do {
 		do {
-			double t = m_sim->nextEventTime();
+			SimulationTime t = m_sim->nextEventTime();
+			m_sim->execUntil(t);
 
-			do {
-				m_sim->execNextEvent();
-			}
-			while (t == m_sim->nextEventTime());
-			if (t - start_t > 0.01) {
+			if (t - start_t > secondsToTime(0.01)) {
 				pc = 0; // to get from outer loop
 				QMessageBox::warning(this, tr("C command takes too long"),
 							tr("Single C command takes more than 10ms. Possible loop detected."));
@@ -238,6 +237,8 @@ void QSimKit::singleStep() {
 		m_stopped = false;
 	}
 
+	screen->getMCU()->setSingleStepping(true);
+
 	switch(getStepMode()) {
 		case SimulationStep:
 			m_sim->execNextEvent();
@@ -252,20 +253,22 @@ void QSimKit::singleStep() {
 			break;
 	}
 
+	screen->getMCU()->setSingleStepping(false);
+
 	refreshDockWidgets();
 
-	onSimulationStep(m_sim->nextEventTime());
+	onSimulationStep(timeToSeconds(m_sim->nextEventTime()));
 }
 
 void QSimKit::simulationStep() {
 	QTime perf;
 	perf.start();
-	double until = m_runUntil->text().toDouble();
+	SimulationTime until = secondsToTime(m_runUntil->text().toDouble());
 	for (int i = 0; i < m_instPerCycle; ++i) {
 		m_sim->execNextEvent();
 		if (m_breakpointManager->shouldBreak()) {
 			m_instCounter += m_instPerCycle;
-			onSimulationStep(m_sim->nextEventTime());
+			onSimulationStep(timeToSeconds(m_sim->nextEventTime()));
 			m_pauseAction->setChecked(true);
 			pauseSimulation(true);
 			return;
@@ -274,7 +277,7 @@ void QSimKit::simulationStep() {
 		if (m_sim->nextEventTime() >= until) {
 			m_instCounter += m_instPerCycle;
 			refreshDockWidgets();
-			onSimulationStep(m_sim->nextEventTime());
+			onSimulationStep(timeToSeconds(m_sim->nextEventTime()));
 			pauseSimulation(true);
 			return;
 		}
@@ -283,8 +286,8 @@ void QSimKit::simulationStep() {
 	m_logicalSteps++;
 	if (m_logicalSteps == 2) {
 		m_logicalSteps = 0;
-		statusbar->showMessage(QString("Simulation Time: ") + QString::number(m_sim->nextEventTime()) + ", " + QString::number(m_instPerCycle * 20) + " simulation events per second");
-		onSimulationStep(m_sim->nextEventTime());
+		statusbar->showMessage(QString("Simulation Time: ") + QString::number(timeToSeconds(m_sim->nextEventTime())) + ", " + QString::number(m_instPerCycle * 20) + " simulation events per second");
+		onSimulationStep(timeToSeconds(m_sim->nextEventTime()));
 	}
 
 	
@@ -305,7 +308,7 @@ void QSimKit::resetSimulation() {
 
 	m_dig = new SimulationModel();
 	screen->prepareSimulation(m_dig);
-	m_sim = new adevs::Simulator<SimulationEvent>(m_dig);
+	m_sim = new SimulationKernel(m_dig);
 	screen->setSimulator(m_sim);
 	
 }
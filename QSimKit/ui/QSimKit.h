@@ -40,6 +40,7 @@ class BreakpointManager;
 class DockWidget;
 class Peripherals;
 class TrackedPins;
+class Profiler;
 
 typedef enum {
 	SimulationStep,
@@ -108,7 +109,7 @@ class QSimKit : public QMainWindow, public Ui::QSimKit
 
 	private:
 		SimulationModel *m_dig;
-		adevs::Simulator<SimulationEvent> *m_sim;
+		SimulationKernel *m_sim;
 		QTimer *m_timer;
 		PeripheralManager *m_peripherals;
 		QString m_filename;
@@ -119,6 +120,7 @@ class QSimKit : public QMainWindow, public Ui::QSimKit
 		Peripherals *m_peripheralsWidget;
 		MCUManager *m_mcuManager;
 		TrackedPins *m_trackedPins;
+		Profiler *m_profiler;
 		int m_logicalSteps;
 		int m_instPerCycle;
 		unsigned long m_instCounter;
@@ -60,6 +60,7 @@ Screen::Screen(QWidget *parent) : QWidget(parent) {
 
 void Screen::prepareSimulation(SimulationModel *dig) {
 	m_wrappers.clear();
+	m_internalWrappers.clear();
 	for (int i = 0; i < m_objects.size(); ++i) {
 		Peripheral *p = dynamic_cast<Peripheral *>(m_objects[i]);
 		if (p) {
@@ -76,6 +77,8 @@ void Screen::prepareSimulation(SimulationModel *dig) {
 			for (int x = 0; x < internalObjects.size(); ++x) {
 				SimulationObjectWrapper *wrapper = new SimulationObjectWrapper(internalObjects[x]);
 				dig->add(wrapper);
+				internalObjects[x]->setWrapper(wrapper);
+				m_internalWrappers.append(wrapper);
 			}
 		}
 	}
@@ -83,10 +86,16 @@ void Screen::prepareSimulation(SimulationModel *dig) {
 	m_conns->prepareSimulation(dig, m_wrappers);
 }
 
-void Screen::setSimulator(adevs::Simulator<SimulationEvent> *sim) {
+void Screen::setSimulator(SimulationKernel *sim) {
 	for (std::map<ScreenObject *, SimulationObjectWrapper *>::iterator it = m_wrappers.begin(); it != m_wrappers.end(); ++it) {
 		it->second->setSimulator(sim);
 	}
+
+	// Internal objects like DCO have to be able to reschedule themselves
+	// when they are started again.
+	for (int i = 0; i < m_internalWrappers.size(); ++i) {
+		m_internalWrappers[i]->setSimulator(sim);
+	}
 }
 
 void Screen::setMCU(MCU *mcu) {
@@ -67,7 +67,7 @@ class Screen : public QWidget
 		bool load(QDomDocument &doc);
 
 		void prepareSimulation(SimulationModel *dig);
-		void setSimulator(adevs::Simulator<SimulationEvent> *sim);
+		void setSimulator(SimulationKernel *sim);
 
 		ScreenObject *getObject(int x, int y);
 		int getPin(ScreenObject *object, int x, int y);
@@ -116,6 +116,7 @@ class Screen : public QWidget
 		PeripheralManager *m_peripherals;
 		MCUManager *m_mcuManager;
 		std::map<ScreenObject *, SimulationObjectWrapper *> m_wrappers;
+		QList<SimulationObjectWrapper *> m_internalWrappers;
 		std::map<ScreenObject *, QList<int> > m_trackedPins;
 };
 
@@ -0,0 +1,209 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "adevs.h"
+#include "Peripherals/SimulationModel.h"
+
+#include <cstdlib>
+#include <new>
+
+static bool countAllocations = false;
+static int allocations = 0;
+
+void *operator new(std::size_t size) {
+	if (countAllocations) {
+		allocations++;
+	}
+
+	void *p = std::malloc(size ? size : 1);
+	if (!p) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void operator delete(void *p) {
+	std::free(p);
+}
+
+/// Toggles its pin 0 every step like the MCU and also changes the pin 5,
+/// which is not connected anywhere.
+class TogglingPin : public SimulationCoupling {
+	public:
+		TogglingPin(SimulationTime step) : step(step), value(0) {}
+
+		void delta_int() {
+			value = 1 - value;
+			m_output.insert(SimulationEvent(0, value));
+			m_output.insert(SimulationEvent(5, value));
+		}
+		void delta_ext(SimulationTime e, const SimulationEventList &xb) {}
+		void delta_conf(const SimulationEventList &xb) {}
+		void output_func(SimulationEventList &yb) { yb.swap(m_output); }
+		SimulationTime ta() { return step; }
+		void gc_output(SimulationEventList &g) {}
+
+		SimulationTime step;
+		double value;
+
+	private:
+		SimulationEventList m_output;
+};
+
+/// Forwards the input on the pin 0 to the pins 1 and 2 like the ConnectionNode
+class FanOut : public SimulationCoupling {
+	public:
+		void delta_int() {}
+		void delta_ext(SimulationTime e, const SimulationEventList &xb) {
+			for (SimulationEventList::const_iterator it = xb.begin(); it != xb.end(); ++it) {
+				m_output.insert(SimulationEvent(1, (*it).value));
+				m_output.insert(SimulationEvent(2, (*it).value));
+			}
+		}
+		void delta_conf(const SimulationEventList &xb) { delta_ext(0, xb); }
+		void output_func(SimulationEventList &yb) { yb.swap(m_output); }
+		SimulationTime ta() { return m_output.empty() ? SIMULATION_TIME_MAX : 0; }
+		void gc_output(SimulationEventList &g) {}
+
+	private:
+		SimulationEventList m_output;
+};
+
+class PinInput : public SimulationCoupling {
+	public:
+		PinInput() : inputs(0), port(-1), value(-1) {}
+
+		void delta_int() {}
+		void delta_ext(SimulationTime e, const SimulationEventList &xb) {
+			for (SimulationEventList::const_iterator it = xb.begin(); it != xb.end(); ++it) {
+				inputs++;
+				port = (*it).port;
+				value = (*it).value;
+			}
+		}
+		void delta_conf(const SimulationEventList &xb) { delta_ext(0, xb); }
+		void output_func(SimulationEventList &yb) {}
+		SimulationTime ta() { return SIMULATION_TIME_MAX; }
+		void gc_output(SimulationEventList &g) {}
+
+		int inputs;
+		int port;
+		double value;
+};
+
+template <class S>
+class RoutedProject {
+	public:
+		RoutedProject() : pin(new TogglingPin(frequencyToPeriod(1000000))),
+			node(new FanOut()), a(new PinInput()), b(new PinInput()) {
+			model.add(pin);
+			model.add(node);
+			model.add(a);
+			model.add(b);
+			pin->couple(0, node, 0);
+			node->couple(0, pin, 0);
+			node->couple(1, a, 3);
+			node->couple(2, b, 4);
+			sim = new adevs::Simulator<SimulationEvent, SimulationTime, S>(&model);
+		}
+
+		~RoutedProject() {
+			// The model deletes its components
+			delete sim;
+		}
+
+		void run(int events) {
+			for (int i = 0; i < events; ++i) {
+				sim->execNextEvent();
+			}
+		}
+
+		TogglingPin *pin;
+		FanOut *node;
+		PinInput *a;
+		PinInput *b;
+		SimulationModel model;
+		adevs::Simulator<SimulationEvent, SimulationTime, S> *sim;
+};
+
+class RoutingTest : public CPPUNIT_NS :: TestFixture{
+	CPPUNIT_TEST_SUITE(RoutingTest);
+	CPPUNIT_TEST(route);
+	CPPUNIT_TEST(bagCopyAllocates);
+	CPPUNIT_TEST(noAllocations);
+	CPPUNIT_TEST_SUITE_END();
+
+	public:
+		void setUp (void) {
+
+		}
+
+		void tearDown (void) {
+			countAllocations = false;
+		}
+
+		void route() {
+			RoutedProject<adevs::Schedule<SimulationEvent, SimulationTime> > project;
+
+			// Pin changes at the first tick and outputs it at the second one,
+			// the node forwards it right away
+			project.run(3);
+			CPPUNIT_ASSERT_EQUAL(1, project.a->inputs);
+			CPPUNIT_ASSERT_EQUAL(3, project.a->port);
+			CPPUNIT_ASSERT_EQUAL(1.0, project.a->value);
+			CPPUNIT_ASSERT_EQUAL(1, project.b->inputs);
+			CPPUNIT_ASSERT_EQUAL(4, project.b->port);
+
+			project.run(4);
+			CPPUNIT_ASSERT_EQUAL(3, project.a->inputs);
+			CPPUNIT_ASSERT_EQUAL(1.0, project.a->value);
+			CPPUNIT_ASSERT_EQUAL(3, project.b->inputs);
+		}
+
+		void bagCopyAllocates() {
+			SimulationEventList output;
+			SimulationEventList events;
+			events.insert(SimulationEvent(1, 1.0));
+
+			countAllocations = true;
+			allocations = 0;
+			output = events;
+			countAllocations = false;
+			CPPUNIT_ASSERT(allocations > 0);
+
+			countAllocations = true;
+			allocations = 0;
+			output.clear();
+			output.swap(events);
+			countAllocations = false;
+			CPPUNIT_ASSERT_EQUAL(0, allocations);
+		}
+
+		template <class S>
+		int allocationsInSteadyState() {
+			RoutedProject<S> project;
+
+			// The pools of the simulator and the buffers of the models fill
+			// up with the first events
+			project.run(1000);
+			int inputs = project.a->inputs;
+
+			countAllocations = true;
+			allocations = 0;
+			project.run(10000);
+			countAllocations = false;
+
+			// Every tick of the pin is forwarded by the node as another event
+			CPPUNIT_ASSERT_EQUAL(inputs + 5000, project.a->inputs);
+			return allocations;
+		}
+
+		void noAllocations() {
+			typedef adevs::Schedule<SimulationEvent, SimulationTime> Heap;
+			typedef adevs::TimingWheel<SimulationEvent, SimulationTime> Wheel;
+			CPPUNIT_ASSERT_EQUAL(0, allocationsInSteadyState<Heap>());
+			CPPUNIT_ASSERT_EQUAL(0, allocationsInSteadyState<Wheel>());
+		}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (RoutingTest);
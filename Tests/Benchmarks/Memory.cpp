@@ -0,0 +1,96 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "CPU/Memory/Memory.h"
+
+#include <iostream>
+#include <ctime>
+
+namespace MSP430 {
+
+class CountingMemoryWatcher : public MemoryWatcher {
+	public:
+		CountingMemoryWatcher() : changed(0) {}
+
+		void handleMemoryChanged(::Memory *memory, uint16_t address) {
+			changed++;
+		}
+
+		void handleMemoryRead(::Memory *memory, uint16_t address, uint8_t &value) {}
+
+		int changed;
+};
+
+class MemoryBenchmark : public CPPUNIT_NS :: TestFixture{
+	CPPUNIT_TEST_SUITE(MemoryBenchmark);
+	CPPUNIT_TEST(benchmark);
+	CPPUNIT_TEST_SUITE_END();
+
+	public:
+		void setUp (void) {
+
+		}
+
+		void tearDown (void) {
+
+		}
+
+		void benchmark() {
+			Memory m(120000);
+			::Memory *generic = &m;
+			const int count = 50;
+
+			// Pages with peripherals are watched, so measure both of them
+			CountingMemoryWatcher w;
+			m.addWatcher(0x0120, &w);
+
+			uint32_t sum = 0;
+			std::clock_t start = std::clock();
+			for (int x = 0; x < count; ++x) {
+				for (int address = 0x0000; address < 0x10000; address += 2) {
+					generic->setBigEndian(address, address);
+					sum += generic->getBigEndian(address);
+				}
+			}
+			double virtualAccess = (double) (std::clock() - start) / CLOCKS_PER_SEC;
+
+			uint32_t sum2 = 0;
+			start = std::clock();
+			for (int x = 0; x < count; ++x) {
+				for (int address = 0x0000; address < 0x10000; address += 2) {
+					m.setWord(address, address);
+					sum2 += m.getWord(address);
+				}
+			}
+			double native = (double) (std::clock() - start) / CLOCKS_PER_SEC;
+
+			// The decoder watches the bytes of the executed instructions,
+			// the data stored to the rest of their pages are not watched
+			for (int address = 0xf000; address < 0xf100; ++address) {
+				m.addWatcher(address, &w);
+			}
+			start = std::clock();
+			for (int x = 0; x < count * 256; ++x) {
+				for (int address = 0xf100; address < 0xf200; address += 2) {
+					m.setWord(address, address);
+				}
+			}
+			double codePage = (double) (std::clock() - start) / CLOCKS_PER_SEC;
+
+			std::cout << "\nMemory interface: " << virtualAccess * 1e9 / (count * 0x8000) << " ns/word\n";
+			std::cout << "Native word access: " << native * 1e9 / (count * 0x8000) << " ns/word\n";
+			std::cout << "Speed-up: " << virtualAccess / native << "x\n";
+			std::cout << "Store to code page: " << codePage * 1e9 / (count * 256 * 0x80) << " ns/word\n";
+
+			CPPUNIT_ASSERT_EQUAL(sum, sum2);
+			CPPUNIT_ASSERT_EQUAL(2 * count, w.changed);
+			m.removeWatcher(0x0120, &w);
+			for (int address = 0xf000; address < 0xf100; ++address) {
+				m.removeWatcher(address, &w);
+			}
+		}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (MemoryBenchmark);
+
+}
@@ -0,0 +1,123 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "CPU/Memory/Memory.h"
+#include "CPU/Memory/RegisterSet.h"
+#include "CPU/Memory/Register.h"
+#include "CPU/Instructions/InstructionDecoder.h"
+#include "CPU/Instructions/InstructionManager.h"
+#include "CPU/Instructions/SpecializedInstructions.h"
+#include "CPU/Instructions/Instruction.h"
+
+#include <iostream>
+#include <ctime>
+
+namespace MSP430 {
+
+class SpecializedInstructionsBenchmark : public CPPUNIT_NS :: TestFixture{
+	CPPUNIT_TEST_SUITE(SpecializedInstructionsBenchmark);
+	CPPUNIT_TEST(benchmark);
+	CPPUNIT_TEST_SUITE_END();
+
+	// Generic InstructionArgument based execution
+	Memory *m;
+	RegisterSet *r;
+	InstructionDecoder *d;
+	Instruction *i;
+
+	// Specialized execution
+	Memory *m2;
+	RegisterSet *r2;
+	InstructionDecoder *d2;
+
+	public:
+		void setUp (void) {
+			m = new Memory(120000);
+			r = new RegisterSet;
+			r->addDefaultRegisters();
+			d = new InstructionDecoder(r, m);
+			i = new Instruction;
+
+			m2 = new Memory(120000);
+			r2 = new RegisterSet;
+			r2->addDefaultRegisters();
+			d2 = new InstructionDecoder(r2, m2);
+		}
+
+		void tearDown (void) {
+			delete d;
+			delete i;
+			delete m;
+			delete r;
+			delete d2;
+			delete m2;
+			delete r2;
+		}
+
+		void initialize(Memory *mem, RegisterSet *reg, uint16_t sr) {
+			for (int address = 0x0200; address < 0x0300; address += 2) {
+				mem->setBigEndian(address, address * 0x0101 ^ 0x8a5c);
+			}
+
+			reg->getp(0)->setBigEndian(0xf000);
+			reg->getp(1)->setBigEndian(0x0280);
+			reg->getp(2)->setBigEndian(sr);
+			reg->getp(5)->setBigEndian(0x0230);
+			reg->getp(6)->setBigEndian(0x80f1);
+			reg->getp(7)->setBigEndian(0x0250);
+		}
+
+		void benchmark() {
+			// f000: mov @r5+, r6; add r6, 2(r7); xor #0x00ff, r6
+			//       cmp #0x0260, r5; jnc f000; mov #0x0230, r5; jmp f000
+			std::vector<uint16_t> program;
+			program.push_back(0x4536);
+			program.push_back(0x5687);
+			program.push_back(0x0002);
+			program.push_back(0xe036);
+			program.push_back(0x00ff);
+			program.push_back(0x9035);
+			program.push_back(0x0260);
+			program.push_back(0x2bf8);
+			program.push_back(0x4035);
+			program.push_back(0x0230);
+			program.push_back(0x3ff5);
+
+			initialize(m, r, 0);
+			initialize(m2, r2, 0);
+			for (unsigned int x = 0; x < program.size(); ++x) {
+				m->setBigEndian(0xf000 + x * 2, program[x]);
+				m2->setBigEndian(0xf000 + x * 2, program[x]);
+			}
+
+			const int count = 500000;
+
+			std::clock_t start = std::clock();
+			for (int x = 0; x < count; ++x) {
+				d->decodeCurrentInstruction(i);
+				executeInstruction(r, m, i);
+			}
+			double generic = (double) (std::clock() - start) / CLOCKS_PER_SEC;
+
+			start = std::clock();
+			for (int x = 0; x < count; ++x) {
+				uint16_t pc = r2->getp(0)->getBigEndian();
+				const DecodedInstruction &decoded = d2->decode(pc);
+				r2->getp(0)->setBigEndian(pc + decoded.length);
+				getSpecializedInstruction(decoded)(r2, m2, decoded);
+			}
+			double specialized = (double) (std::clock() - start) / CLOCKS_PER_SEC;
+
+			std::cout << "\nGeneric handlers: " << generic * 1e9 / count << " ns/instruction\n";
+			std::cout << "Specialized handlers: " << specialized * 1e9 / count << " ns/instruction\n";
+			std::cout << "Speed-up: " << generic / specialized << "x\n";
+
+			for (int x = 0; x < 16; ++x) {
+				CPPUNIT_ASSERT_EQUAL(r->getp(x)->getBigEndian(), r2->getp(x)->getBigEndian());
+			}
+		}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (SpecializedInstructionsBenchmark);
+
+}
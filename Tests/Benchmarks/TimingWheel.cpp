@@ -0,0 +1,56 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "adevs.h"
+#include "Peripherals/SimulationTime.h"
+#include "../Simulation/BenchmarkProject.h"
+
+#include <ctime>
+#include <iostream>
+
+class TimingWheelBenchmark : public CPPUNIT_NS :: TestFixture{
+	CPPUNIT_TEST_SUITE(TimingWheelBenchmark);
+	CPPUNIT_TEST(benchmark);
+	CPPUNIT_TEST_SUITE_END();
+
+	public:
+		void setUp (void) {
+
+		}
+
+		void tearDown (void) {
+
+		}
+
+		template <class S>
+		double measure(int pinEvery, int oscillators, double seconds, long &events) {
+			BenchmarkProject<S> project(pinEvery, oscillators);
+			std::clock_t start = std::clock();
+			events = project.run(secondsToTime(seconds));
+			return (double) (std::clock() - start) / CLOCKS_PER_SEC;
+		}
+
+		void benchmark() {
+			// mmc.qsp is the MCU with the SD card, lcd.qsp adds two crystal
+			// oscillators and drives the LCD pins more often. The last one
+			// shows how the schedules scale with the number of models.
+			const char *names[] = { "mmc", "lcd", "500 oscillators" };
+			int pinEvery[] = { 40, 8, 40 };
+			int oscillators[] = { 0, 2, 500 };
+			double seconds[] = { 0.5, 0.5, 0.01 };
+
+			for (int i = 0; i < 3; ++i) {
+				long heapEvents = 0;
+				long wheelEvents = 0;
+				double heap = measure<adevs::Schedule<int, SimulationTime> >(pinEvery[i], oscillators[i], seconds[i], heapEvents);
+				double wheel = measure<adevs::TimingWheel<int, SimulationTime> >(pinEvery[i], oscillators[i], seconds[i], wheelEvents);
+
+				std::cout << "\n" << names[i] << " binary heap: " << heap * 1e9 / heapEvents << " ns/event\n";
+				std::cout << names[i] << " timing wheel: " << wheel * 1e9 / wheelEvents << " ns/event\n";
+
+				CPPUNIT_ASSERT_EQUAL(heapEvents, wheelEvents);
+			}
+		}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (TimingWheelBenchmark);
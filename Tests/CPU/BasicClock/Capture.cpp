@@ -189,14 +189,14 @@ class CaptureTest : public CPPUNIT_NS :: TestFixture {
 		}
 
 		void tearDown (void) {
+			delete d;
+			delete i;
 			delete m;
 			delete r;
 			delete intManager;
 			delete bc;
 			delete factory;
 			delete pinManager;
-			delete d;
-			delete i;
 		}
 
 	void execute() {
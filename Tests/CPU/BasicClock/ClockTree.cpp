@@ -0,0 +1,261 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "CPU/Memory/Memory.h"
+#include "CPU/Memory/RegisterSet.h"
+#include "CPU/Memory/RegisterFile.h"
+#include "CPU/Interrupts/InterruptManager.h"
+#include "CPU/BasicClock/TimerFactory.h"
+#include "CPU/BasicClock/BasicClock.h"
+#include "CPU/BasicClock/Scheduler.h"
+#include "CPU/BasicClock/MCLK.h"
+#include "CPU/BasicClock/ACLK.h"
+#include "CPU/BasicClock/SMCLK.h"
+#include "CPU/BasicClock/VLO.h"
+#include "CPU/BasicClock/DCO.h"
+#include "CPU/Variants/Variant.h"
+#include "CPU/Variants/VariantManager.h"
+#include "CPU/Pins/PinManager.h"
+
+#include <vector>
+
+namespace MSP430 {
+
+class ManualScheduler : public Scheduler {
+	public:
+		ManualScheduler() : time(0) {}
+
+		SimulationTime getTime() { return time; }
+		void schedule(TimedEventHandler *handler, SimulationTime t) {}
+		void cancel(TimedEventHandler *handler) {}
+		SimulationTime getNextEventTime() { return SIMULATION_TIME_MAX; }
+
+		SimulationTime time;
+};
+
+class ManualTimerFactory : public TimerFactory {
+	public:
+		DCO *createDCO(Memory *mem, Variant *variant) { return new DCO(mem, variant); }
+		VLO *createVLO() { return new VLO(); }
+		Scheduler *createScheduler(DCO *dco) { return new ManualScheduler(); }
+};
+
+class EdgeCountingHandler : public ClockHandler {
+	public:
+		EdgeCountingHandler() : rising(0), falling(0) {}
+
+		void tickRising() { rising++; }
+		void tickFalling() { falling++; }
+
+		int rising;
+		int falling;
+};
+
+/// Records the ticks of the oscillator at which the divided clock changed
+class EdgeRecordingHandler : public OscillatorHandler {
+	public:
+		EdgeRecordingHandler() : tick(0) {}
+
+		void tickRising() { edges.push_back(tick); }
+		void tickFalling() { edges.push_back(-tick); }
+
+		int tick;
+		std::vector<int> edges;
+};
+
+class CountingClockWatcher : public ClockWatcher {
+	public:
+		CountingClockWatcher() : changes(0) {}
+
+		void handleClockChanged(Clock *clock) { changes++; }
+
+		int changes;
+};
+
+class ClockTreeTest : public CPPUNIT_NS :: TestFixture{
+	CPPUNIT_TEST_SUITE(ClockTreeTest);
+	CPPUNIT_TEST(dividedEdges);
+	CPPUNIT_TEST(dividerChangeKeepsPhase);
+	CPPUNIT_TEST(cycleAtTime);
+	CPPUNIT_TEST(frequencyChange);
+	CPPUNIT_TEST(lowPowerMode);
+	CPPUNIT_TEST(skipKeepsPhase);
+	CPPUNIT_TEST_SUITE_END();
+
+	Memory *m;
+	RegisterSet *r;
+	Variant *v;
+	InterruptManager *intManager;
+	BasicClock *bc;
+	TimerFactory *factory;
+	PinManager *pinManager;
+	ManualScheduler *scheduler;
+
+	public:
+		void setUp (void) {
+			m = new Memory(120000);
+			r = new RegisterSet;
+			r->addDefaultRegisters();
+			v = getVariant("msp430x241x");
+			intManager = new InterruptManager(r, m, v);
+			factory = new ManualTimerFactory();
+			pinManager = new PinManager(m, intManager, v);
+			bc = new BasicClock(m, v, intManager, pinManager, factory);
+			scheduler = static_cast<ManualScheduler *>(bc->getScheduler());
+		}
+
+		void tearDown (void) {
+			delete m;
+			delete r;
+			delete intManager;
+			delete bc;
+			delete factory;
+			delete pinManager;
+		}
+
+		void tickDCO(int ticks) {
+			for (int x = 0; x < ticks; ++x) {
+				bc->getDCO()->tick();
+			}
+		}
+
+		void dividedEdges() {
+			EdgeCountingHandler h;
+			bc->getMCLK()->addHandler(&h);
+
+			// DIVMx = 4, clock changes every second rising tick of the DCO
+			m->setByte(v->getBCSCTL2(), 2 << 4);
+			tickDCO(16);
+			CPPUNIT_ASSERT_EQUAL(2, h.rising);
+			CPPUNIT_ASSERT_EQUAL(2, h.falling);
+
+			// DIVMx = 1, clock follows every tick of the DCO
+			h.rising = h.falling = 0;
+			m->setByte(v->getBCSCTL2(), 0);
+			tickDCO(16);
+			CPPUNIT_ASSERT_EQUAL(8, h.rising);
+			CPPUNIT_ASSERT_EQUAL(8, h.falling);
+
+			bc->getMCLK()->removeHandler(&h);
+		}
+
+		void dividerChangeKeepsPhase() {
+			EdgeCountingHandler h;
+			bc->getSMCLK()->addHandler(&h);
+
+			// One rising edge, the clock is high now
+			tickDCO(1);
+			CPPUNIT_ASSERT_EQUAL(1, h.rising);
+
+			// Next edge after the divider changes has to be the falling one
+			m->setByte(v->getBCSCTL2(), 1 << 1);
+			tickDCO(2);
+			CPPUNIT_ASSERT_EQUAL(1, h.rising);
+			CPPUNIT_ASSERT_EQUAL(1, h.falling);
+
+			bc->getSMCLK()->removeHandler(&h);
+		}
+
+		void cycleAtTime() {
+			Clock *smclk = bc->getSMCLK();
+			SimulationTime period = smclk->getStep();
+
+			CPPUNIT_ASSERT_EQUAL(true, smclk->isAnalytic());
+			CPPUNIT_ASSERT_EQUAL((uint64_t) 0, smclk->getCycle(0));
+			CPPUNIT_ASSERT_EQUAL((uint64_t) 0, smclk->getCycle(period / 2));
+			CPPUNIT_ASSERT_EQUAL((uint64_t) 1, smclk->getCycle(period));
+			CPPUNIT_ASSERT_EQUAL((uint64_t) 1000, smclk->getCycle(1000 * period + period / 2));
+
+			for (uint64_t cycle = 1; cycle < 100000; cycle += 997) {
+				CPPUNIT_ASSERT_EQUAL(cycle, smclk->getCycle(smclk->getCycleTime(cycle)));
+			}
+
+			// Time is integer, so the edges stay exact even after hours
+			for (uint64_t cycle = 10000000000ULL; cycle < 10000100000ULL; cycle += 997) {
+				CPPUNIT_ASSERT_EQUAL(cycle, smclk->getCycle(smclk->getCycleTime(cycle)));
+				CPPUNIT_ASSERT_EQUAL(cycle - 1, smclk->getCycle(smclk->getCycleTime(cycle) - 1));
+			}
+		}
+
+		void frequencyChange() {
+			CountingClockWatcher watcher;
+			Clock *smclk = bc->getSMCLK();
+			smclk->addWatcher(&watcher);
+			SimulationTime period = smclk->getStep();
+
+			// Cycles counted before the divider change are kept
+			scheduler->time = 100 * period;
+			m->setByte(v->getBCSCTL2(), 3 << 1);
+			CPPUNIT_ASSERT_EQUAL(1, watcher.changes);
+			CPPUNIT_ASSERT_EQUAL((uint64_t) 100, smclk->getCycle(100 * period));
+			CPPUNIT_ASSERT_EQUAL((uint64_t) 101, smclk->getCycle(108 * period));
+			CPPUNIT_ASSERT_EQUAL((uint64_t) 101, smclk->getCycle(115 * period));
+
+			// DCO frequency change goes through to the clock as well
+			unsigned long freq = smclk->getFrequency();
+			scheduler->time = 115 * period;
+			m->setByte(v->getDCOCTL(), 0);
+			CPPUNIT_ASSERT_EQUAL(2, watcher.changes);
+			CPPUNIT_ASSERT(freq != smclk->getFrequency());
+			CPPUNIT_ASSERT_EQUAL((uint64_t) 101, smclk->getCycle(scheduler->time));
+			CPPUNIT_ASSERT_EQUAL((uint64_t) 102, smclk->getCycle(scheduler->time + smclk->getStep()));
+
+			smclk->removeWatcher(&watcher);
+		}
+
+		void lowPowerMode() {
+			Clock *aclk = bc->getACLK();
+			SimulationTime period = aclk->getStep();
+
+			scheduler->time = 10 * period;
+			bc->setLowPowerMode(SR_CPU_OFF | SR_SCG0 | SR_SCG1 | SR_OSC_OFF);
+			CPPUNIT_ASSERT_EQUAL((uint64_t) 10, aclk->getCycle(100 * period));
+			CPPUNIT_ASSERT_EQUAL(SIMULATION_TIME_MAX, aclk->getCycleTime(11));
+
+			scheduler->time = 20 * period;
+			bc->setLowPowerMode(0);
+			CPPUNIT_ASSERT_EQUAL((uint64_t) 10, aclk->getCycle(20 * period));
+			CPPUNIT_ASSERT_EQUAL((uint64_t) 15, aclk->getCycle(25 * period));
+		}
+
+		void skipKeepsPhase() {
+			const unsigned int dividers[] = {1, 2, 4, 8};
+			for (int d = 0; d < 4; ++d) {
+				for (int periods = 0; periods < 20; ++periods) {
+					// Reference oscillator ticks through the skipped periods
+					VLO ticked;
+					VLO skipped;
+					EdgeRecordingHandler a;
+					EdgeRecordingHandler b;
+					ticked.addHandler(&a, dividers[d]);
+					skipped.addHandler(&b, dividers[d]);
+
+					for (a.tick = 1; a.tick <= 2 * periods + 40; ++a.tick) {
+						ticked.tick();
+					}
+
+					for (b.tick = 1; b.tick <= 6; ++b.tick) {
+						skipped.tick();
+					}
+					skipped.skip(periods);
+					for (b.tick = 2 * periods + 7; b.tick <= 2 * periods + 40; ++b.tick) {
+						skipped.tick();
+					}
+
+					// Edges outside of the skipped periods are the same
+					std::vector<int> expected;
+					for (unsigned int i = 0; i < a.edges.size(); ++i) {
+						int tick = a.edges[i] < 0 ? -a.edges[i] : a.edges[i];
+						if (tick <= 6 || tick > 2 * periods + 6) {
+							expected.push_back(a.edges[i]);
+						}
+					}
+					CPPUNIT_ASSERT(expected == b.edges);
+				}
+			}
+		}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (ClockTreeTest);
+
+}
@@ -0,0 +1,231 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "CPU/Memory/Memory.h"
+#include "CPU/Memory/RegisterSet.h"
+#include "CPU/Memory/RegisterFile.h"
+#include "CPU/Interrupts/InterruptManager.h"
+#include "CPU/BasicClock/TimerFactory.h"
+#include "CPU/BasicClock/BasicClock.h"
+#include "CPU/BasicClock/MCLK.h"
+#include "CPU/BasicClock/ACLK.h"
+#include "CPU/BasicClock/SMCLK.h"
+#include "CPU/BasicClock/VLO.h"
+#include "CPU/BasicClock/DCO.h"
+#include "CPU/Variants/Variant.h"
+#include "CPU/Variants/VariantManager.h"
+#include "CPU/Pins/PinManager.h"
+
+namespace MSP430 {
+
+class PausableDCO : public DCO {
+	public:
+		PausableDCO(Memory *mem, Variant *variant) : DCO(mem, variant), paused(true) {}
+
+		void pause() { paused = true; }
+		void start() { paused = false; }
+
+		bool paused;
+};
+
+class PausableVLO : public VLO {
+	public:
+		PausableVLO() : paused(true) {}
+
+		void pause() { paused = true; }
+		void start() { paused = false; }
+
+		bool paused;
+};
+
+class PausableTimerFactory : public TimerFactory {
+	public:
+		DCO *createDCO(Memory *mem, Variant *variant) { return new PausableDCO(mem, variant); }
+		VLO *createVLO() { return new PausableVLO(); }
+};
+
+class CountingClockHandler : public ClockHandler {
+	public:
+		CountingClockHandler() : ticks(0) {}
+
+		void tickRising() { ticks++; }
+		void tickFalling() {}
+
+		int ticks;
+};
+
+class DummyInterruptQueueWatcher : public InterruptQueueWatcher {
+	public:
+		DummyInterruptQueueWatcher() : vector(-1) {}
+
+		void handleInterruptQueued(InterruptManager *intManager, int v) {
+			vector = v;
+		}
+
+		int vector;
+};
+
+class LowPowerModeTest : public CPPUNIT_NS :: TestFixture{
+	CPPUNIT_TEST_SUITE(LowPowerModeTest);
+	CPPUNIT_TEST(lpm0);
+	CPPUNIT_TEST(lpm3);
+	CPPUNIT_TEST(lpm4);
+	CPPUNIT_TEST(addHandlerInLowPowerMode);
+	CPPUNIT_TEST(wakeUpOnInterrupt);
+	CPPUNIT_TEST(wakeUpOnlyWithGIE);
+	CPPUNIT_TEST_SUITE_END();
+
+	Memory *m;
+	RegisterSet *r;
+	Variant *v;
+	InterruptManager *intManager;
+	BasicClock *bc;
+	TimerFactory *factory;
+	PinManager *pinManager;
+	CountingClockHandler *mclk;
+	CountingClockHandler *smclk;
+	CountingClockHandler *aclk;
+
+	public:
+		void setUp (void) {
+			m = new Memory(120000);
+			r = new RegisterSet;
+			r->addDefaultRegisters();
+			v = getVariant("msp430x241x");
+			intManager = new InterruptManager(r, m, v);
+			factory = new PausableTimerFactory();
+			pinManager = new PinManager(m, intManager, v);
+			bc = new BasicClock(m, v, intManager, pinManager, factory);
+
+			mclk = new CountingClockHandler();
+			smclk = new CountingClockHandler();
+			aclk = new CountingClockHandler();
+			bc->getMCLK()->addHandler(mclk, Clock::Rising);
+			bc->getSMCLK()->addHandler(smclk, Clock::Rising);
+			bc->getACLK()->addHandler(aclk, Clock::Rising);
+		}
+
+		void tearDown (void) {
+			delete m;
+			delete r;
+			delete intManager;
+			delete bc;
+			delete factory;
+			delete pinManager;
+			delete mclk;
+			delete smclk;
+			delete aclk;
+		}
+
+		void tick() {
+			mclk->ticks = 0;
+			smclk->ticks = 0;
+			aclk->ticks = 0;
+			for (int x = 0; x < 4; ++x) {
+				bc->getDCO()->tick();
+				bc->getVLO()->tick();
+			}
+		}
+
+		bool dcoPaused() {
+			return static_cast<PausableDCO *>(bc->getDCO())->paused;
+		}
+
+		bool vloPaused() {
+			return static_cast<PausableVLO *>(bc->getVLO())->paused;
+		}
+
+		void lpm0() {
+			tick();
+			CPPUNIT_ASSERT_EQUAL(2, mclk->ticks);
+			CPPUNIT_ASSERT_EQUAL(2, smclk->ticks);
+			CPPUNIT_ASSERT_EQUAL(2, aclk->ticks);
+
+			bc->setLowPowerMode(SR_CPU_OFF);
+			tick();
+			CPPUNIT_ASSERT_EQUAL(0, mclk->ticks);
+			CPPUNIT_ASSERT_EQUAL(2, smclk->ticks);
+			CPPUNIT_ASSERT_EQUAL(2, aclk->ticks);
+			CPPUNIT_ASSERT_EQUAL(false, dcoPaused());
+
+			bc->setLowPowerMode(0);
+			tick();
+			CPPUNIT_ASSERT_EQUAL(2, mclk->ticks);
+			CPPUNIT_ASSERT_EQUAL(2, smclk->ticks);
+			CPPUNIT_ASSERT_EQUAL(2, aclk->ticks);
+		}
+
+		void lpm3() {
+			bc->setLowPowerMode(SR_CPU_OFF | SR_SCG0 | SR_SCG1);
+			tick();
+			CPPUNIT_ASSERT_EQUAL(0, mclk->ticks);
+			CPPUNIT_ASSERT_EQUAL(0, smclk->ticks);
+			CPPUNIT_ASSERT_EQUAL(2, aclk->ticks);
+			CPPUNIT_ASSERT_EQUAL(true, dcoPaused());
+			CPPUNIT_ASSERT_EQUAL(false, vloPaused());
+
+			bc->setLowPowerMode(0);
+			CPPUNIT_ASSERT_EQUAL(false, dcoPaused());
+			tick();
+			CPPUNIT_ASSERT_EQUAL(2, mclk->ticks);
+			CPPUNIT_ASSERT_EQUAL(2, smclk->ticks);
+		}
+
+		void lpm4() {
+			bc->setLowPowerMode(SR_CPU_OFF | SR_SCG0 | SR_SCG1 | SR_OSC_OFF);
+			tick();
+			CPPUNIT_ASSERT_EQUAL(0, mclk->ticks);
+			CPPUNIT_ASSERT_EQUAL(0, smclk->ticks);
+			CPPUNIT_ASSERT_EQUAL(0, aclk->ticks);
+			CPPUNIT_ASSERT_EQUAL(true, dcoPaused());
+			CPPUNIT_ASSERT_EQUAL(true, vloPaused());
+
+			bc->setLowPowerMode(0);
+			CPPUNIT_ASSERT_EQUAL(false, dcoPaused());
+			CPPUNIT_ASSERT_EQUAL(false, vloPaused());
+			tick();
+			CPPUNIT_ASSERT_EQUAL(2, mclk->ticks);
+			CPPUNIT_ASSERT_EQUAL(2, smclk->ticks);
+			CPPUNIT_ASSERT_EQUAL(2, aclk->ticks);
+		}
+
+		void addHandlerInLowPowerMode() {
+			bc->getSMCLK()->removeHandler(smclk);
+			bc->setLowPowerMode(SR_CPU_OFF | SR_SCG0 | SR_SCG1);
+
+			// Disabled clock must not start when a handler is added.
+			bc->getSMCLK()->addHandler(smclk, Clock::Rising);
+			tick();
+			CPPUNIT_ASSERT_EQUAL(0, smclk->ticks);
+			CPPUNIT_ASSERT_EQUAL(true, dcoPaused());
+
+			bc->setLowPowerMode(0);
+			tick();
+			CPPUNIT_ASSERT_EQUAL(2, smclk->ticks);
+		}
+
+		void wakeUpOnInterrupt() {
+			DummyInterruptQueueWatcher watcher;
+			intManager->setQueueWatcher(&watcher);
+
+			intManager->queueInterrupt(18);
+			CPPUNIT_ASSERT_EQUAL(18, watcher.vector);
+
+			intManager->setQueueWatcher(0);
+		}
+
+		void wakeUpOnlyWithGIE() {
+			r->getRegisterFile()->values[2] = SR_CPU_OFF;
+			CPPUNIT_ASSERT_EQUAL(false, intManager->isAccepted(18));
+
+			// NMI is not maskable
+			CPPUNIT_ASSERT_EQUAL(true, intManager->isAccepted(0xfffc - v->getINTVECT()));
+
+			r->getRegisterFile()->values[2] = SR_CPU_OFF | SR_GIE;
+			CPPUNIT_ASSERT_EQUAL(true, intManager->isAccepted(18));
+		}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (LowPowerModeTest);
+
+}
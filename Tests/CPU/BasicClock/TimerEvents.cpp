@@ -0,0 +1,498 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "CPU/Memory/Memory.h"
+#include "CPU/Memory/RegisterSet.h"
+#include "CPU/Interrupts/InterruptManager.h"
+#include "CPU/BasicClock/Timer.h"
+#include "CPU/BasicClock/TimerFactory.h"
+#include "CPU/BasicClock/Scheduler.h"
+#include "CPU/BasicClock/BasicClock.h"
+#include "CPU/BasicClock/ACLK.h"
+#include "CPU/BasicClock/SMCLK.h"
+#include "CPU/Variants/Variant.h"
+#include "CPU/Variants/VariantManager.h"
+#include "CPU/Pins/PinManager.h"
+#include "CPU/Pins/SignalHandler.h"
+#include "CPU/BasicClock/VLO.h"
+#include "CPU/BasicClock/DCO.h"
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace MSP430 {
+
+/// Scheduler with manually advanced time
+class SteppingScheduler : public Scheduler {
+	public:
+		SteppingScheduler() : now(0) {}
+
+		SimulationTime getTime() { return now; }
+
+		void schedule(TimedEventHandler *handler, SimulationTime t) { events[handler] = t; }
+
+		void cancel(TimedEventHandler *handler) { events.erase(handler); }
+
+		SimulationTime getNextEventTime() {
+			SimulationTime next = SIMULATION_TIME_MAX;
+			for (std::map<TimedEventHandler *, SimulationTime>::iterator it = events.begin(); it != events.end(); ++it) {
+				next = std::min(next, it->second);
+			}
+			return next;
+		}
+
+		/// Fires the events up to the time t in their order.
+		void advance(SimulationTime t) {
+			while (true) {
+				std::map<TimedEventHandler *, SimulationTime>::iterator next = events.end();
+				for (std::map<TimedEventHandler *, SimulationTime>::iterator it = events.begin(); it != events.end(); ++it) {
+					if (it->second <= t && (next == events.end() || it->second < next->second)) {
+						next = it;
+					}
+				}
+
+				if (next == events.end()) {
+					break;
+				}
+
+				TimedEventHandler *handler = next->first;
+				if (next->second > now) {
+					now = next->second;
+				}
+				events.erase(next);
+				handler->handleTimedEvent();
+			}
+			now = t;
+		}
+
+		std::map<TimedEventHandler *, SimulationTime> events;
+		SimulationTime now;
+};
+
+/// DCO ticked by the test. Its first tick comes half of the period after
+/// the start, like with the adevs DCO.
+class SteppedDCO : public DCO {
+	public:
+		SteppedDCO(Memory *mem, Variant *variant) : DCO(mem, variant), next(getStep() / 2) {}
+
+		SimulationTime getNextTickTime() { return next; }
+
+		void step() {
+			next += getStep() / 2;
+			tick();
+		}
+
+		SimulationTime next;
+};
+
+class SteppedVLO : public VLO {
+	public:
+		SteppedVLO() : next(getStep() / 2) {}
+
+		SimulationTime getNextTickTime() { return next; }
+
+		void step() {
+			next += getStep() / 2;
+			tick();
+		}
+
+		SimulationTime next;
+};
+
+class EdgeTimerFactory : public TimerFactory {
+	public:
+		DCO *createDCO(Memory *mem, Variant *variant) { return new SteppedDCO(mem, variant); }
+		VLO *createVLO() { return new SteppedVLO(); }
+};
+
+class SteppingTimerFactory : public TimerFactory {
+	public:
+		DCO *createDCO(Memory *mem, Variant *variant) { return new SteppedDCO(mem, variant); }
+		VLO *createVLO() { return new SteppedVLO(); }
+		Scheduler *createScheduler(DCO *dco) { return new SteppingScheduler(); }
+};
+
+/// Counts the rising edges of the clock. It keeps the clock running from
+/// the start, so the divided clocks of both boards have the same phase.
+class EdgeCounter : public ClockHandler {
+	public:
+		EdgeCounter() : count(0) {}
+
+		void tickRising() { count++; }
+		void tickFalling() {}
+
+		uint64_t count;
+};
+
+struct Signal {
+	std::string name;
+	SimulationTime t;
+	double value;
+};
+
+/// Records the output signals of the timers with the time they are
+/// generated at.
+class SignalRecorder : public SignalHandler {
+	public:
+		SignalRecorder() : time(0) {}
+
+		void handleSignal(const std::string &name, double value) {
+			Signal signal;
+			signal.name = name;
+			signal.t = *time;
+			signal.value = value;
+			signals.push_back(signal);
+		}
+
+		SimulationTime *time;
+		std::vector<Signal> signals;
+};
+
+/// MCU parts needed by the timers
+class TimerBoard {
+	public:
+		TimerBoard(Variant *v, TimerFactory *factory) {
+			m = new Memory(120000);
+			r = new RegisterSet;
+			r->addDefaultRegisters();
+			intManager = new InterruptManager(r, m, v);
+			pinManager = new PinManager(m, intManager, v);
+			bc = new BasicClock(m, v, intManager, pinManager, factory);
+			dco = static_cast<SteppedDCO *>(bc->getDCO());
+			vlo = static_cast<SteppedVLO *>(bc->getVLO());
+			bc->getSMCLK()->addHandler(&smclkEdges, Clock::Rising);
+			bc->getACLK()->addHandler(&aclkEdges, Clock::Rising);
+
+			const char *outputs[] = { "TA0.0", "TA0.1", "TA0.2", "TB0.0", "TB0.1", "TB0.2", "TB0.3" };
+			for (int i = 0; i < 7; ++i) {
+				pinManager->addSignalHandler(outputs[i], &recorder);
+			}
+		}
+
+		~TimerBoard() {
+			delete bc;
+			delete pinManager;
+			delete intManager;
+			delete r;
+			delete m;
+		}
+
+		Memory *m;
+		RegisterSet *r;
+		InterruptManager *intManager;
+		PinManager *pinManager;
+		BasicClock *bc;
+		SteppedDCO *dco;
+		SteppedVLO *vlo;
+		EdgeCounter smclkEdges;
+		EdgeCounter aclkEdges;
+		SignalRecorder recorder;
+};
+
+/// Compares the timers counted analytically with the timers ticked by
+/// every edge of their clock. The edges of both boards are generated by
+/// ticking their oscillators, so the analytic timer has to follow the
+/// real phase of the divided clocks.
+class TimerEventsTest : public CPPUNIT_NS :: TestFixture{
+	CPPUNIT_TEST_SUITE(TimerEventsTest);
+	CPPUNIT_TEST(upMode);
+	CPPUNIT_TEST(continuousMode);
+	CPPUNIT_TEST(upDownMode);
+	CPPUNIT_TEST(capture);
+	CPPUNIT_TEST(timerB);
+	CPPUNIT_TEST(aclk);
+	CPPUNIT_TEST(lateRead);
+	CPPUNIT_TEST_SUITE_END();
+
+	Variant *v;
+	TimerFactory *edgeFactory;
+	TimerFactory *steppingFactory;
+	TimerBoard *edge;
+	TimerBoard *lazy;
+	SteppingScheduler *scheduler;
+	EdgeCounter *edges;
+	SimulationTime now;
+	std::vector<uint16_t> registers;
+
+	public:
+		void setUp (void) {
+			v = getVariant("msp430x241x");
+			edgeFactory = new EdgeTimerFactory();
+			steppingFactory = new SteppingTimerFactory();
+			edge = new TimerBoard(v, edgeFactory);
+			lazy = new TimerBoard(v, steppingFactory);
+			scheduler = static_cast<SteppingScheduler *>(lazy->bc->getScheduler());
+			now = 0;
+			edge->recorder.time = &now;
+			lazy->recorder.time = &scheduler->now;
+		}
+
+		void tearDown (void) {
+			delete edge;
+			delete lazy;
+			delete edgeFactory;
+			delete steppingFactory;
+		}
+
+		void useTimerA() {
+			uint16_t regs[] = { v->getTA0R(), v->getTA0CTL(),
+				v->getTA0CCTL0(), v->getTA0CCTL1(), v->getTA0CCTL2(),
+				v->getTA0CCR0(), v->getTA0CCR1(), v->getTA0CCR2() };
+			registers.assign(regs, regs + 8);
+		}
+
+		void useTimerB() {
+			uint16_t regs[] = { v->getTBR(), v->getTBCTL(),
+				v->getTBCCTL0(), v->getTBCCTL1(), v->getTBCCTL2(), v->getTBCCTL3(),
+				v->getTBCCR0(), v->getTBCCR1(), v->getTBCCR2(), v->getTBCCR3() };
+			registers.assign(regs, regs + 10);
+		}
+
+		void write(uint16_t address, uint16_t value) {
+			edge->m->setBigEndian(address, value);
+			lazy->m->setBigEndian(address, value);
+		}
+
+		void writeByte(uint16_t address, uint8_t value) {
+			edge->m->setByte(address, value);
+			lazy->m->setByte(address, value);
+		}
+
+		/// Sets the DIVAx bits and keeps the RSELx bits of the DCO.
+		void writeDIVA(int diva) {
+			writeByte(v->getBCSCTL1(), (edge->m->getByte(v->getBCSCTL1()) & 0xcf) | (diva << 4));
+		}
+
+		void compareRegisters() {
+			for (std::vector<uint16_t>::const_iterator it = registers.begin(); it != registers.end(); ++it) {
+				CPPUNIT_ASSERT_EQUAL(edge->m->getBigEndian(*it), lazy->m->getBigEndian(*it));
+			}
+		}
+
+		/// Compares the registers and the signals generated since the last
+		/// comparison including their times.
+		void compare() {
+			compareRegisters();
+
+			std::vector<Signal> &expected = edge->recorder.signals;
+			std::vector<Signal> &signals = lazy->recorder.signals;
+			CPPUNIT_ASSERT_EQUAL(expected.size(), signals.size());
+			for (int i = 0; i < expected.size(); ++i) {
+				CPPUNIT_ASSERT_EQUAL(expected[i].name, signals[i].name);
+				CPPUNIT_ASSERT_EQUAL(expected[i].t, signals[i].t);
+				CPPUNIT_ASSERT_EQUAL(expected[i].value, signals[i].value);
+			}
+			expected.clear();
+			signals.clear();
+		}
+
+		/// Ticks the oscillators of both boards until the clock of the
+		/// timer reaches the given number of rising edges. Events of the
+		/// analytic timer are not fired.
+		void tickUntil(uint64_t count) {
+			while (edges->count < count) {
+				now = std::min(edge->dco->next, edge->vlo->next);
+				if (edge->dco->next == now) {
+					edge->dco->step();
+					lazy->dco->step();
+				}
+				if (edge->vlo->next == now) {
+					edge->vlo->step();
+					lazy->vlo->step();
+				}
+			}
+		}
+
+		/// Runs both timers for the given number of the clock cycles and
+		/// compares them after every step cycles.
+		void run(int cycles, int step) {
+			uint64_t start = edges->count;
+			for (int i = step; ; i += step) {
+				int n = std::min(i, cycles);
+				tickUntil(start + n);
+				scheduler->advance(now);
+				compare();
+				if (n == cycles) {
+					break;
+				}
+			}
+		}
+
+		void upMode() {
+			useTimerA();
+			edges = &edge->smclkEdges;
+
+			write(v->getTA0CCR0(), 50);
+			write(v->getTA0CCR1(), 20);
+			write(v->getTA0CCR2(), 35);
+			// CCIE, Toggle/Reset and Set/Reset output modes
+			write(v->getTA0CCTL0(), 16 | (4 << 5));
+			write(v->getTA0CCTL1(), 16 | (2 << 5));
+			write(v->getTA0CCTL2(), 16 | (3 << 5));
+			// SMCLK, up mode, TAIE
+			write(v->getTA0CTL(), (2 << 8) | (1 << 4) | 2);
+			run(400, 7);
+
+			write(v->getTA0CCR1(), 45);
+			write(v->getTA0R(), 10);
+			run(300, 1);
+
+			// TAR behind CCR0 counts up to 0xffff first
+			write(v->getTA0R(), 0xfff0);
+			run(100, 13);
+
+			// Divider 4
+			write(v->getTA0CTL(), (2 << 8) | (2 << 6) | (1 << 4) | 2);
+			run(1000, 31);
+
+			// SMCLK divided by 2 and then by 8 (DIVSx)
+			writeByte(v->getBCSCTL2(), 1 << 1);
+			run(300, 7);
+			writeByte(v->getBCSCTL2(), 3 << 1);
+			run(200, 1);
+		}
+
+		void continuousMode() {
+			useTimerA();
+			edges = &edge->smclkEdges;
+
+			write(v->getTA0CCR0(), 3);
+			write(v->getTA0CCR1(), 0xff80);
+			write(v->getTA0CCTL1(), 16 | (7 << 5));
+			write(v->getTA0CCTL2(), 16 | (4 << 5));
+			// SMCLK divided by 4 (DIVSx)
+			writeByte(v->getBCSCTL2(), 2 << 1);
+			// SMCLK, continuous mode, divider 2, TAIE
+			write(v->getTA0CTL(), (2 << 8) | (1 << 6) | (2 << 4) | 2);
+			write(v->getTA0R(), 0xff00);
+			run(800, 97);
+
+			// Whole period without any read
+			run(2 * 0x10000, 0x10000);
+		}
+
+		void upDownMode() {
+			useTimerA();
+			edges = &edge->smclkEdges;
+
+			write(v->getTA0CCR0(), 30);
+			write(v->getTA0CCR1(), 10);
+			write(v->getTA0CCR2(), 25);
+			write(v->getTA0CCTL1(), 16 | (6 << 5));
+			write(v->getTA0CCTL2(), 16 | (7 << 5));
+			// SMCLK, up/down mode, TAIE
+			write(v->getTA0CTL(), (2 << 8) | (3 << 4) | 2);
+			run(500, 11);
+
+			// CCR0 below TAR while counting up
+			write(v->getTA0CCR0(), 12);
+			run(300, 17);
+
+			write(v->getTA0CCR0(), 40);
+			write(v->getTA0CTL(), (2 << 8) | (1 << 6) | (3 << 4));
+			run(500, 1);
+		}
+
+		void capture() {
+			useTimerA();
+			edges = &edge->smclkEdges;
+
+			write(v->getTA0CCR0(), 100);
+			// SMCLK divided by 8 (DIVSx), up mode
+			writeByte(v->getBCSCTL2(), 3 << 1);
+			write(v->getTA0CTL(), (2 << 8) | (1 << 4));
+			run(33, 33);
+
+			// Synchronous capture on both edges of GND/VCC input
+			uint16_t cctl = (3 << 14) | (1 << 11) | (1 << 8) | 16;
+			write(v->getTA0CCTL1(), cctl | (2 << 12));
+			run(5, 1);
+			write(v->getTA0CCTL1(), cctl | (3 << 12));
+			run(3, 3);
+			write(v->getTA0CCTL1(), cctl | (2 << 12));
+			run(40, 7);
+
+			// Asynchronous capture
+			cctl = (3 << 14) | (1 << 8) | 16;
+			write(v->getTA0CCTL2(), cctl | (2 << 12));
+			run(10, 10);
+			write(v->getTA0CCTL2(), cctl | (3 << 12));
+			run(10, 10);
+		}
+
+		void timerB() {
+			useTimerB();
+			edges = &edge->smclkEdges;
+
+			write(v->getTBCCR0(), 60);
+			write(v->getTBCCR1(), 20);
+			write(v->getTBCCR2(), 40);
+			write(v->getTBCCR3(), 200);
+			// Load TBCLx when TBR counts to 0, on compare, and on 0 or turnaround
+			write(v->getTBCCTL1(), (1 << 9) | 16 | (3 << 5));
+			write(v->getTBCCTL2(), (3 << 9) | 16 | (2 << 5));
+			write(v->getTBCCTL3(), (2 << 9) | 16);
+			// SMCLK, 8-bit continuous mode, TBIE
+			write(v->getTBCTL(), (3 << 11) | (2 << 8) | (2 << 4) | 2);
+			run(300, 9);
+
+			write(v->getTBCCR1(), 50);
+			write(v->getTBCCR2(), 10);
+			write(v->getTBCCR3(), 30);
+			// SMCLK divided by 2 (DIVSx)
+			writeByte(v->getBCSCTL2(), 1 << 1);
+			run(600, 23);
+
+			// Up/down mode
+			write(v->getTBCTL(), (2 << 8) | (3 << 4) | 2);
+			run(400, 1);
+			write(v->getTBCCR3(), 15);
+			run(400, 19);
+		}
+
+		void aclk() {
+			useTimerA();
+			edges = &edge->aclkEdges;
+
+			write(v->getTA0CCR0(), 9);
+			write(v->getTA0CCR1(), 4);
+			write(v->getTA0CCTL1(), 16 | (3 << 5));
+			// ACLK divided by 2 (DIVAx), up mode, divider 8
+			writeDIVA(1);
+			write(v->getTA0CTL(), (1 << 8) | (3 << 6) | (1 << 4) | 2);
+			run(500, 3);
+
+			// ACLK divided by 8, the timer divider 1
+			writeDIVA(3);
+			write(v->getTA0CTL(), (1 << 8) | (1 << 4) | 2);
+			run(100, 1);
+		}
+
+		void lateRead() {
+			useTimerA();
+			edges = &edge->smclkEdges;
+
+			write(v->getTA0CCR0(), 20);
+			write(v->getTA0CCR1(), 5);
+			write(v->getTA0CCTL1(), 16 | (4 << 5));
+			write(v->getTA0CTL(), (2 << 8) | (1 << 4) | 2);
+
+			// TAR is read after several events which have not been fired
+			// yet, like when the CPU executes ahead of the simulation time.
+			// Outputs are generated late then, so only the registers are
+			// compared.
+			tickUntil(edges->count + 95);
+			scheduler->now = now;
+			compareRegisters();
+			edge->recorder.signals.clear();
+			lazy->recorder.signals.clear();
+
+			run(100, 10);
+		}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (TimerEventsTest);
+
+}
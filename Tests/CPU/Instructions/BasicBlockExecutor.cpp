@@ -0,0 +1,171 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "CPU/Memory/Memory.h"
+#include "CPU/Memory/RegisterSet.h"
+#include "CPU/Memory/Register.h"
+#include "CPU/Interrupts/InterruptManager.h"
+#include "CPU/Instructions/InstructionDecoder.h"
+#include "CPU/Instructions/BasicBlockExecutor.h"
+#include "CPU/Instructions/Instruction.h"
+#include "CPU/Variants/Variant.h"
+#include "CPU/Variants/VariantManager.h"
+
+namespace MSP430 {
+
+class DummyRegisterWatcher : public RegisterWatcher {
+	public:
+		bool handleRegisterChanged(::Register *reg, int id, uint16_t value) {
+			return true;
+		}
+};
+
+class DummyMemoryWatcher : public MemoryWatcher {
+	public:
+		void handleMemoryChanged(::Memory *memory, uint16_t address) {}
+
+		void handleMemoryRead(::Memory *memory, uint16_t address, uint8_t &value) {}
+};
+
+class BasicBlockExecutorTest : public CPPUNIT_NS :: TestFixture{
+	CPPUNIT_TEST_SUITE(BasicBlockExecutorTest);
+	CPPUNIT_TEST(runUntilConditionalJump);
+	CPPUNIT_TEST(runLoop);
+	CPPUNIT_TEST(stopBeforePeripheral);
+	CPPUNIT_TEST(stopWithRegisterWatcher);
+	CPPUNIT_TEST(stopWithMemoryWatcher);
+	CPPUNIT_TEST_SUITE_END();
+
+	Memory *m;
+	RegisterSet *r;
+	Variant *v;
+	InterruptManager *intManager;
+	InstructionDecoder *d;
+	BasicBlockExecutor *e;
+	Instruction *i;
+
+	public:
+		void setUp (void) {
+			m = new Memory(120000);
+			r = new RegisterSet;
+			r->addDefaultRegisters();
+			v = getVariant("msp430x241x");
+			intManager = new InterruptManager(r, m, v);
+			d = new InstructionDecoder(r, m);
+			e = new BasicBlockExecutor(r, m, d, intManager);
+			i = new Instruction;
+
+			std::string data = ""
+				":10F0000031400003B240805A20013F4000000F937E\r\n"
+				":10F0100005242F839F4FB0F00002FB233F400000E8\r\n"
+				":10F020000F9304241F83CF430002FC2330404EF093\r\n"
+				":10F03000304034F000130E430E9F042C03431E5344\r\n"
+				":10F040000E9FFC2B30410000010040004100314088\r\n"
+				":10F05000F802B240805A2001F2432200D24321003C\r\n"
+				":10F060000B433F4046F0B14F0000B14F0200B14F9B\r\n"
+				":10F070000400B14F06000F4B0F5F0F51E24F21000C\r\n"
+				":10F080003F403000B01236F03F403000B01236F052\r\n"
+				":10F090003F403000B01236F03F403000B01236F042\r\n"
+				":10F0A0001B532B92DE3BDC3F31523040AEF0FF3F32\r\n"
+				":10FFE00030F030F030F030F030F030F030F030F011\r\n"
+				":10FFF00030F030F030F030F030F030F030F000F031\r\n"
+				":040000030000F00009\r\n"
+				":00000001FF\r\n";
+
+			m->loadA43(data, r);
+		}
+
+		void tearDown (void) {
+			delete e;
+			delete d;
+			delete i;
+			delete intManager;
+			delete m;
+			delete r;
+		}
+
+		void runUntilConditionalJump() {
+			// f036: clr r14; cmp r15, r14; jc $+10
+			r->getp(0)->setBigEndian(0xf036);
+			r->getp(15)->setBigEndian(48);
+
+			CPPUNIT_ASSERT_EQUAL(4, e->run(i));
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0, r->getp(14)->getBigEndian());
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xf03c, r->getp(0)->getBigEndian());
+		}
+
+		void runLoop() {
+			// f03c: nop; inc r14; cmp r15, r14; jnc $-6
+			r->getp(0)->setBigEndian(0xf03c);
+			r->getp(14)->setBigEndian(0);
+			r->getp(15)->setBigEndian(48);
+
+			CPPUNIT_ASSERT_EQUAL(5, e->run(i));
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 1, r->getp(14)->getBigEndian());
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xf03c, r->getp(0)->getBigEndian());
+
+			CPPUNIT_ASSERT_EQUAL(5, e->run(i));
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 2, r->getp(14)->getBigEndian());
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xf03c, r->getp(0)->getBigEndian());
+
+			// cmp r15, r14; jnc $-6 are executed as single fused instruction
+			CPPUNIT_ASSERT_EQUAL(2u, e->getFusedCount(FusedCompareJump));
+		}
+
+		void stopBeforePeripheral() {
+			// f058: mov.b #-1, &0x0022
+			r->getp(0)->setBigEndian(0xf058);
+
+			CPPUNIT_ASSERT_EQUAL(0, e->run(i));
+			CPPUNIT_ASSERT_EQUAL((uint8_t) 0, m->getByte(0x0022));
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xf058, r->getp(0)->getBigEndian());
+		}
+
+		void stopWithRegisterWatcher() {
+			r->getp(0)->setBigEndian(0xf036);
+			r->getp(14)->setBigEndian(55);
+
+			DummyRegisterWatcher *watcher = new DummyRegisterWatcher();
+			r->getp(14)->addWatcher(watcher);
+
+			CPPUNIT_ASSERT_EQUAL(0, e->run(i));
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 55, r->getp(14)->getBigEndian());
+
+			r->getp(14)->removeWatcher(watcher);
+			delete watcher;
+		}
+
+		void stopWithMemoryWatcher() {
+			// f100: add.b @r5+, 2(r5); jmp $
+			m->setBigEndian(0xf100, 0x55f5);
+			m->setBigEndian(0xf102, 0x0002);
+			m->setBigEndian(0xf104, 0x3fff);
+			r->getp(0)->setBigEndian(0xf100);
+			r->getp(5)->setBigEndian(0x0300);
+
+			// The destination is read at 0x0302 before the source
+			// autoincrement and written at 0x0303 after it
+			DummyMemoryWatcher watcher;
+			m->addWatcher(0x0302, &watcher, MemoryWatcher::Read);
+			CPPUNIT_ASSERT_EQUAL(0, e->run(i));
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xf100, r->getp(0)->getBigEndian());
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0x0300, r->getp(5)->getBigEndian());
+			m->removeWatcher(0x0302, &watcher);
+
+			m->addWatcher(0x0303, &watcher, MemoryWatcher::Write);
+			CPPUNIT_ASSERT_EQUAL(0, e->run(i));
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xf100, r->getp(0)->getBigEndian());
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0x0300, r->getp(5)->getBigEndian());
+			m->removeWatcher(0x0303, &watcher);
+
+			// Watcher of the other byte of the word does not stop byte access
+			m->addWatcher(0x0301, &watcher, MemoryWatcher::ReadWrite);
+			CPPUNIT_ASSERT(e->run(i) > 0);
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0x0301, r->getp(5)->getBigEndian());
+			m->removeWatcher(0x0301, &watcher);
+		}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (BasicBlockExecutorTest);
+
+}
@@ -0,0 +1,248 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "CPU/Memory/Memory.h"
+#include "CPU/Memory/RegisterSet.h"
+#include "CPU/Memory/Register.h"
+#include "CPU/Memory/RegisterFile.h"
+#include "CPU/Interrupts/InterruptManager.h"
+#include "CPU/Instructions/InstructionDecoder.h"
+#include "CPU/Instructions/InstructionManager.h"
+#include "CPU/Instructions/IdleLoopExecutor.h"
+#include "CPU/Instructions/Instruction.h"
+#include "CPU/Variants/Variant.h"
+#include "CPU/Variants/VariantManager.h"
+
+namespace MSP430 {
+
+class DummyReadWatcher : public MemoryWatcher {
+	public:
+		void handleMemoryChanged(::Memory *memory, uint16_t address) {}
+};
+
+class IdleLoopExecutorTest : public CPPUNIT_NS :: TestFixture{
+	CPPUNIT_TEST_SUITE(IdleLoopExecutorTest);
+	CPPUNIT_TEST(delayLoop);
+	CPPUNIT_TEST(delayLoopInterrupt);
+	CPPUNIT_TEST(pollingLoop);
+	CPPUNIT_TEST(pollingLoopReadWatcher);
+	CPPUNIT_TEST(selfLoop);
+	CPPUNIT_TEST(notIdleLoop);
+	CPPUNIT_TEST(skipDelayLoop);
+	CPPUNIT_TEST(skipPollingLoop);
+	CPPUNIT_TEST_SUITE_END();
+
+	Memory *m;
+	RegisterSet *r;
+	Variant *v;
+	InterruptManager *intManager;
+	InstructionDecoder *d;
+	IdleLoopExecutor *e;
+	Instruction *i;
+
+	public:
+		void setUp (void) {
+			m = new Memory(120000);
+			r = new RegisterSet;
+			r->addDefaultRegisters();
+			v = getVariant("msp430x241x");
+			intManager = new InterruptManager(r, m, v);
+			d = new InstructionDecoder(r, m);
+			e = new IdleLoopExecutor(r, m, d, intManager);
+			i = new Instruction;
+
+			// f000: dec r15; jnz $-2
+			m->setBigEndian(0xf000, 0x831f);
+			m->setBigEndian(0xf002, 0x23fe);
+			// f010: bit.b #1, &0x0003; jz $-4
+			m->setBigEndian(0xf010, 0xb3d2);
+			m->setBigEndian(0xf012, 0x0003);
+			m->setBigEndian(0xf014, 0x27fd);
+			// f020: jmp $
+			m->setBigEndian(0xf020, 0x3fff);
+			// f030: mov r5, r6; jmp $-2
+			m->setBigEndian(0xf030, 0x4506);
+			m->setBigEndian(0xf032, 0x3ffe);
+		}
+
+		void tearDown (void) {
+			delete e;
+			delete d;
+			delete i;
+			delete intManager;
+			delete m;
+			delete r;
+		}
+
+		int run(IdleLoopExecutor::Result &result) {
+			int cycles = 0;
+			do {
+				result = e->tick();
+				cycles++;
+			} while (result == IdleLoopExecutor::Running);
+			return cycles;
+		}
+
+		void delayLoop() {
+			r->getp(0)->setBigEndian(0xf000);
+			r->getp(15)->setBigEndian(1000);
+			int period = d->decode(0xf000).cycles + d->decode(0xf002).cycles;
+
+			CPPUNIT_ASSERT(e->enter());
+
+			// The last iteration is executed normally
+			IdleLoopExecutor::Result result;
+			CPPUNIT_ASSERT_EQUAL(999 * period, run(result));
+			CPPUNIT_ASSERT_EQUAL(IdleLoopExecutor::Resume, result);
+			CPPUNIT_ASSERT_EQUAL(false, e->isActive());
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 1, r->getp(15)->getBigEndian());
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xf000, r->getp(0)->getBigEndian());
+
+			d->decodeCurrentInstruction(i);
+			executeInstruction(r, m, i);
+			d->decodeCurrentInstruction(i);
+			executeInstruction(r, m, i);
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0, r->getp(15)->getBigEndian());
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xf004, r->getp(0)->getBigEndian());
+		}
+
+		void delayLoopInterrupt() {
+			r->getp(0)->setBigEndian(0xf000);
+			r->getp(15)->setBigEndian(1000);
+
+			CPPUNIT_ASSERT(e->enter());
+
+			// dec r15 of 4th iteration is executed in 10th cycle
+			for (int x = 0; x < 9; ++x) {
+				CPPUNIT_ASSERT_EQUAL(IdleLoopExecutor::Running, e->tick());
+			}
+			intManager->queueInterrupt(0);
+
+			CPPUNIT_ASSERT_EQUAL(IdleLoopExecutor::Resume, e->tick());
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 996, r->getp(15)->getBigEndian());
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xf002, r->getp(0)->getBigEndian());
+			CPPUNIT_ASSERT(!(r->getRegisterFile()->getSR() & SR_Z));
+			CPPUNIT_ASSERT(r->getRegisterFile()->getSR() & SR_C);
+		}
+
+		void pollingLoop() {
+			r->getp(0)->setBigEndian(0xf010);
+			m->setByte(0x0003, 0);
+			int bit = d->decode(0xf010).cycles;
+			int period = bit + d->decode(0xf014).cycles;
+
+			CPPUNIT_ASSERT(e->enter());
+			for (int x = 0; x < 20; ++x) {
+				CPPUNIT_ASSERT_EQUAL(IdleLoopExecutor::Running, e->tick());
+			}
+			m->setByte(0x0003, 1);
+
+			// bit.b has to be executed when it reads the changed memory
+			IdleLoopExecutor::Result result;
+			int cycles = 20 + run(result);
+			CPPUNIT_ASSERT_EQUAL(IdleLoopExecutor::Execute, result);
+			CPPUNIT_ASSERT_EQUAL(bit, cycles % period);
+			CPPUNIT_ASSERT_EQUAL(bit - 1, e->getElapsedCycles());
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xf010, r->getp(0)->getBigEndian());
+
+			d->decodeCurrentInstruction(i);
+			executeInstruction(r, m, i);
+			d->decodeCurrentInstruction(i);
+			executeInstruction(r, m, i);
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xf016, r->getp(0)->getBigEndian());
+		}
+
+		void pollingLoopReadWatcher() {
+			r->getp(0)->setBigEndian(0xf010);
+			DummyReadWatcher watcher;
+			m->addWatcher(0x0003, &watcher, MemoryWatcher::Read);
+
+			CPPUNIT_ASSERT(!e->enter());
+
+			m->removeWatcher(0x0003, &watcher, MemoryWatcher::Read);
+		}
+
+		void selfLoop() {
+			r->getp(0)->setBigEndian(0xf020);
+
+			CPPUNIT_ASSERT(e->enter());
+			for (int x = 0; x < 1001; ++x) {
+				CPPUNIT_ASSERT_EQUAL(IdleLoopExecutor::Running, e->tick());
+			}
+			intManager->queueInterrupt(0);
+
+			CPPUNIT_ASSERT_EQUAL(IdleLoopExecutor::Resume, e->tick());
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xf020, r->getp(0)->getBigEndian());
+		}
+
+		void notIdleLoop() {
+			r->getp(0)->setBigEndian(0xf030);
+			CPPUNIT_ASSERT(!e->enter());
+
+			// Delay loop ending in the first iteration
+			r->getp(0)->setBigEndian(0xf000);
+			r->getp(15)->setBigEndian(1);
+			CPPUNIT_ASSERT(!e->enter());
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 1, r->getp(15)->getBigEndian());
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xf000, r->getp(0)->getBigEndian());
+		}
+
+		void skipDelayLoop() {
+			r->getp(0)->setBigEndian(0xf000);
+			r->getp(15)->setBigEndian(1000);
+			int period = d->decode(0xf000).cycles + d->decode(0xf002).cycles;
+
+			CPPUNIT_ASSERT(e->enter());
+			CPPUNIT_ASSERT_EQUAL((uint64_t) 999 * period - 1, e->getSkippableCycles());
+
+			// Skipped cycles end at the same place as the ticked ones
+			for (int x = 0; x < 3; ++x) {
+				CPPUNIT_ASSERT_EQUAL(IdleLoopExecutor::Running, e->tick());
+			}
+			e->skip(500 * period);
+			CPPUNIT_ASSERT_EQUAL((uint64_t) 499 * period - 4, e->getSkippableCycles());
+
+			IdleLoopExecutor::Result result;
+			CPPUNIT_ASSERT_EQUAL(499 * period - 3, run(result));
+			CPPUNIT_ASSERT_EQUAL(IdleLoopExecutor::Resume, result);
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 1, r->getp(15)->getBigEndian());
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xf000, r->getp(0)->getBigEndian());
+
+			// Same as delayLoopInterrupt, but the first 9 cycles are skipped
+			r->getp(15)->setBigEndian(1000);
+			CPPUNIT_ASSERT(e->enter());
+			e->skip(9);
+			intManager->queueInterrupt(0);
+
+			CPPUNIT_ASSERT_EQUAL(IdleLoopExecutor::Resume, e->tick());
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 996, r->getp(15)->getBigEndian());
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xf002, r->getp(0)->getBigEndian());
+			CPPUNIT_ASSERT(r->getRegisterFile()->getSR() & SR_C);
+		}
+
+		void skipPollingLoop() {
+			r->getp(0)->setBigEndian(0xf010);
+			m->setByte(0x0003, 0);
+			int bit = d->decode(0xf010).cycles;
+			int period = bit + d->decode(0xf014).cycles;
+
+			CPPUNIT_ASSERT(e->enter());
+			CPPUNIT_ASSERT_EQUAL((uint64_t) -1, e->getSkippableCycles());
+
+			// Polling loop keeps its phase however long it is skipped
+			const uint64_t skipped = 10000000001ULL;
+			e->skip(skipped);
+			m->setByte(0x0003, 1);
+			CPPUNIT_ASSERT_EQUAL((uint64_t) 0, e->getSkippableCycles());
+
+			IdleLoopExecutor::Result result;
+			uint64_t cycles = skipped + run(result);
+			CPPUNIT_ASSERT_EQUAL(IdleLoopExecutor::Execute, result);
+			CPPUNIT_ASSERT_EQUAL((uint64_t) bit, cycles % period);
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xf010, r->getp(0)->getBigEndian());
+		}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (IdleLoopExecutorTest);
+
+}
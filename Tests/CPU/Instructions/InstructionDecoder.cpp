@@ -24,6 +24,7 @@ class InstructionDecoderTest : public CPPUNIT_NS :: TestFixture{
 	CPPUNIT_TEST(decodeCALL);
 	CPPUNIT_TEST(decodeRETI);
 	CPPUNIT_TEST(decodeCMP);
+	CPPUNIT_TEST(decodeCachedInstructionModified);
 	CPPUNIT_TEST_SUITE_END();
 
 	Memory *m;
@@ -50,7 +51,7 @@ class InstructionDecoderTest : public CPPUNIT_NS :: TestFixture{
 		void decodeADD1ToRegister() {
 			std::string data =
 				// 1b 53       	inc	r11 => ADD(.B) #1,r11
-				":10F000001B530003B240805A20013F4000000F937E\r\n"
+				":10F000001B530003B240805A20013F4000000F9381\r\n"
 				":040000030000F00009\r\n"
 				":00000001FF\r\n";
 
@@ -71,7 +72,7 @@ class InstructionDecoderTest : public CPPUNIT_NS :: TestFixture{
 		void decodeADDRegisterToRegister() {
 			std::string data =
 				// 0f 51       	add	r1,	r15
-				":10F000000F510003B240805A20013F4000000F937E\r\n"
+				":10F000000F510003B240805A20013F4000000F938F\r\n"
 				":040000030000F00009\r\n"
 				":00000001FF\r\n";
 
@@ -93,7 +94,7 @@ class InstructionDecoderTest : public CPPUNIT_NS :: TestFixture{
 		void decodeMOVConstantToRegister() {
 			std::string data =
 				// 0b 43       	clr	r11 => mov 0 to r11
-				":10F000000B430003B240805A20013F4000000F937E\r\n"
+				":10F000000B430003B240805A20013F4000000F93A1\r\n"
 				":040000030000F00009\r\n"
 				":00000001FF\r\n";
 
@@ -114,7 +115,7 @@ class InstructionDecoderTest : public CPPUNIT_NS :: TestFixture{
 		void decodeMOVImmediateToRegister() {
 			std::string data =
 				// 31 40 f8 02 	mov	#760,	r1	;#0x02f8
-				":10F000003140F802B240805A20013F4000000F937E\r\n"
+				":10F000003140F802B240805A20013F4000000F9387\r\n"
 				":040000030000F00009\r\n"
 				":00000001FF\r\n";
 
@@ -136,7 +137,7 @@ class InstructionDecoderTest : public CPPUNIT_NS :: TestFixture{
 			std::string data =
 				// 31 40 f8 02 	mov	#760,	r1	;#0x02f8
 				// 0b 43       	clr	r11 => mov 0 to r11
-				":10F000003140F8020B43805A20013F4000000F937E\r\n"
+				":10F000003140F8020B43805A20013F4000000F932B\r\n"
 				":040000030000F00009\r\n"
 				":00000001FF\r\n";
 
@@ -170,7 +171,7 @@ class InstructionDecoderTest : public CPPUNIT_NS :: TestFixture{
 			std::string data =
 				// b2 40 80 5a 	mov	#23168,	&0x0120	;#0x5a80
 				// 20 01
-				":10F00000B240805A2001805A20013F4000000F937E\r\n"
+				":10F00000B240805A2001805A20013F4000000F93F7\r\n"
 				":040000030000F00009\r\n"
 				":00000001FF\r\n";
 
@@ -191,7 +192,7 @@ class InstructionDecoderTest : public CPPUNIT_NS :: TestFixture{
 		void decodeMOVAutoincrementToIndexed() {
 			std::string data =
 				// b1 4f 00 00 	mov	@r15+,	0(r1)	;0x0000(r1)
-				":10F00000B14F00002001805A20013F4000000F937E\r\n"
+				":10F00000B14F00002001805A20013F4000000F93C3\r\n"
 				":040000030000F00009\r\n"
 				":00000001FF\r\n";
 
@@ -217,7 +218,7 @@ class InstructionDecoderTest : public CPPUNIT_NS :: TestFixture{
 		void decodeMOVIndirectToAbsolute() {
 			std::string data =
 				// e2 4f 21 00 	mov.b	@r15,	&0x0021
-				":10F00000E24F21002001805A20013F4000000F937E\r\n"
+				":10F00000E24F21002001805A20013F4000000F9371\r\n"
 				":040000030000F00009\r\n"
 				":00000001FF\r\n";
 
@@ -242,7 +243,7 @@ class InstructionDecoderTest : public CPPUNIT_NS :: TestFixture{
 		void decodeJZ() {
 			std::string data =
 				// 05 24       	jz	$+12     	;abs 0xf01c
-				":10F00000052421002001805A20013F4000000F937E\r\n"
+				":10F00000052421002001805A20013F4000000F9379\r\n"
 				":040000030000F00009\r\n"
 				":00000001FF\r\n";
 
@@ -258,7 +259,7 @@ class InstructionDecoderTest : public CPPUNIT_NS :: TestFixture{
 		void decodeJNC() {
 			std::string data =
 				// fc 2b       	jnc	$-6      	;abs 0xf03c
-				":10F00000FC2B21002001805A20013F4000000F937E\r\n"
+				":10F00000FC2B21002001805A20013F4000000F937B\r\n"
 				":040000030000F00009\r\n"
 				":00000001FF\r\n";
 
@@ -274,7 +275,7 @@ class InstructionDecoderTest : public CPPUNIT_NS :: TestFixture{
 		void decodeCALL() {
 			std::string data =
 				// b0 12 36 f0 	call	#0xf036	
-				":10F00000B01236F02001805A20013F4000000F937E\r\n"
+				":10F00000B01236F02001805A20013F4000000F93DB\r\n"
 				":040000030000F00009\r\n"
 				":00000001FF\r\n";
 
@@ -291,7 +292,7 @@ class InstructionDecoderTest : public CPPUNIT_NS :: TestFixture{
 		void decodeRETI() {
 			std::string data =
 				// 00 13       	reti
-				":10F00000001336F02001805A20013F4000000F937E\r\n"
+				":10F00000001336F02001805A20013F4000000F938A\r\n"
 				":040000030000F00009\r\n"
 				":00000001FF\r\n";
 
@@ -307,7 +308,7 @@ class InstructionDecoderTest : public CPPUNIT_NS :: TestFixture{
 		void decodeCMP() {
 			std::string data =
 				//f00e:	0f 93       	tst	r15 = cmp #0, r15
-				":10F000000F9321002001805A20013F4000000F937E\r\n"
+				":10F000000F9321002001805A20013F4000000F9300\r\n"
 				":040000030000F00009\r\n"
 				":00000001FF\r\n";
 
@@ -325,6 +326,50 @@ class InstructionDecoderTest : public CPPUNIT_NS :: TestFixture{
 			CPPUNIT_ASSERT_EQUAL((int) 55, (int) i->getDst()->get());
 		}
 
+		void decodeCachedInstructionModified() {
+			std::string data =
+				// 31 40 f8 02 	mov	#760,	r1	;#0x02f8
+				":10F000003140F802B240805A20013F4000000F9387\r\n"
+				":040000030000F00009\r\n"
+				":00000001FF\r\n";
+
+			m->loadA43(data, r);
+			int inc = d->decodeCurrentInstruction(i);
+			CPPUNIT_ASSERT_EQUAL(2, inc);
+			CPPUNIT_ASSERT_EQUAL((int) 760, (int) i->getSrc()->getBigEndian());
+
+			// Decoding the same PC again uses the cached instruction
+			inc = d->decodeCurrentInstruction(i);
+			CPPUNIT_ASSERT_EQUAL(2, inc);
+			CPPUNIT_ASSERT_EQUAL((int) 760, (int) i->getSrc()->getBigEndian());
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xf004, i->pc);
+
+			// Data stored next to the instruction do not invalidate it
+			unsigned int generation = d->getGeneration();
+			m->setBigEndian(0xf004, 0x1234);
+			m->setByte(0xf006, 1);
+			CPPUNIT_ASSERT_EQUAL(generation, d->getGeneration());
+
+			// Change the immediate value
+			m->setBigEndian(0xf002, 100);
+			CPPUNIT_ASSERT(generation != d->getGeneration());
+			inc = d->decodeCurrentInstruction(i);
+			CPPUNIT_ASSERT_EQUAL(2, inc);
+			CPPUNIT_ASSERT_EQUAL((int) 100, (int) i->getSrc()->getBigEndian());
+
+			// 0b 43       	clr	r11 => mov 0 to r11
+			m->setByte(0xf000, 0x0b);
+			m->setByte(0xf001, 0x43);
+			r->getp(11)->set(55);
+			inc = d->decodeCurrentInstruction(i);
+			CPPUNIT_ASSERT_EQUAL(1, inc);
+			CPPUNIT_ASSERT_EQUAL((int) Instruction2, (int) i->type);
+			CPPUNIT_ASSERT_EQUAL((int) 4, (int) i->opcode);
+			CPPUNIT_ASSERT_EQUAL((int) 0, (int) i->getSrc()->get());
+			CPPUNIT_ASSERT_EQUAL((int) 55, (int) i->getDst()->get());
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xf002, i->pc);
+		}
+
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION (InstructionDecoderTest);
@@ -0,0 +1,106 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "CPU/Memory/Memory.h"
+#include "CPU/Memory/RegisterSet.h"
+#include "CPU/Instructions/InstructionDecoder.h"
+#include "CPU/Instructions/InstructionDisassembler.h"
+
+namespace MSP430 {
+
+class InstructionDisassemblerTest : public CPPUNIT_NS :: TestFixture{
+	CPPUNIT_TEST_SUITE(InstructionDisassemblerTest);
+	CPPUNIT_TEST(twoOperand);
+	CPPUNIT_TEST(singleOperand);
+	CPPUNIT_TEST(jump);
+	CPPUNIT_TEST(emulated);
+	CPPUNIT_TEST(unknown);
+	CPPUNIT_TEST_SUITE_END();
+
+	Memory *m;
+	RegisterSet *r;
+	InstructionDecoder *d;
+	InstructionDisassembler *dis;
+
+	public:
+		void setUp (void) {
+			m = new Memory(120000);
+			r = new RegisterSet;
+			r->addDefaultRegisters();
+			d = new InstructionDecoder(r, m);
+			dis = new InstructionDisassembler(m, d);
+		}
+
+		void tearDown (void) {
+			delete dis;
+			delete d;
+			delete m;
+			delete r;
+		}
+
+		std::string disassemble(uint16_t w0, uint16_t w1, uint16_t w2, int length) {
+			m->setBigEndian(0xf000, w0);
+			m->setBigEndian(0xf002, w1);
+			m->setBigEndian(0xf004, w2);
+
+			uint8_t l = 0;
+			std::string text = dis->disassemble(0xf000, l);
+			CPPUNIT_ASSERT_EQUAL(length, (int) l);
+			CPPUNIT_ASSERT_EQUAL(length, (int) dis->getLength(0xf000));
+			return text;
+		}
+
+		void twoOperand() {
+			CPPUNIT_ASSERT_EQUAL(std::string("mov #0x0280, r1"), disassemble(0x4031, 0x0280, 0, 4));
+			CPPUNIT_ASSERT_EQUAL(std::string("mov r5, r6"), disassemble(0x4506, 0, 0, 2));
+			CPPUNIT_ASSERT_EQUAL(std::string("mov @r5, r7"), disassemble(0x4527, 0, 0, 2));
+			CPPUNIT_ASSERT_EQUAL(std::string("mov @r5+, 2(r7)"), disassemble(0x45b7, 0x0002, 0, 4));
+			CPPUNIT_ASSERT_EQUAL(std::string("mov -2(r5), r6"), disassemble(0x4516, 0xfffe, 0, 4));
+			CPPUNIT_ASSERT_EQUAL(std::string("add.b &0x0022, 4(r7)"), disassemble(0x52d7, 0x0022, 0x0004, 6));
+			CPPUNIT_ASSERT_EQUAL(std::string("cmp #0x0260, r5"), disassemble(0x9035, 0x0260, 0, 4));
+			// Symbolic mode, address is relative to the extension word
+			CPPUNIT_ASSERT_EQUAL(std::string("mov 0xf012, r6"), disassemble(0x4016, 0x0010, 0, 4));
+			CPPUNIT_ASSERT_EQUAL(std::string("and #-1, 0xf012"), disassemble(0xf3b0, 0x0010, 0, 4));
+			CPPUNIT_ASSERT_EQUAL(std::string("inv 0xf012"), disassemble(0xe3b0, 0x0010, 0, 4));
+			CPPUNIT_ASSERT_EQUAL(std::string("mov #0x1234, 0xf014"), disassemble(0x40b0, 0x1234, 0x0010, 6));
+		}
+
+		void singleOperand() {
+			CPPUNIT_ASSERT_EQUAL(std::string("call #0xf100"), disassemble(0x12b0, 0xf100, 0, 4));
+			CPPUNIT_ASSERT_EQUAL(std::string("push r6"), disassemble(0x1206, 0, 0, 2));
+			CPPUNIT_ASSERT_EQUAL(std::string("rra.b 2(r5)"), disassemble(0x1155, 0x0002, 0, 4));
+			CPPUNIT_ASSERT_EQUAL(std::string("reti"), disassemble(0x1300, 0, 0, 2));
+		}
+
+		void jump() {
+			CPPUNIT_ASSERT_EQUAL(std::string("jnz 0xf000"), disassemble(0x23ff, 0, 0, 2));
+			CPPUNIT_ASSERT_EQUAL(std::string("jmp 0xeffc"), disassemble(0x3ffd, 0, 0, 2));
+			CPPUNIT_ASSERT_EQUAL(std::string("jc 0xf00a"), disassemble(0x2c04, 0, 0, 2));
+		}
+
+		void emulated() {
+			CPPUNIT_ASSERT_EQUAL(std::string("ret"), disassemble(0x4130, 0, 0, 2));
+			CPPUNIT_ASSERT_EQUAL(std::string("pop r11"), disassemble(0x413b, 0, 0, 2));
+			CPPUNIT_ASSERT_EQUAL(std::string("nop"), disassemble(0x4303, 0, 0, 2));
+			CPPUNIT_ASSERT_EQUAL(std::string("br r6"), disassemble(0x4600, 0, 0, 2));
+			CPPUNIT_ASSERT_EQUAL(std::string("br #0xf100"), disassemble(0x4030, 0xf100, 0, 4));
+			CPPUNIT_ASSERT_EQUAL(std::string("clr.b &0x0022"), disassemble(0x43c2, 0x0022, 0, 4));
+			CPPUNIT_ASSERT_EQUAL(std::string("inc r15"), disassemble(0x531f, 0, 0, 2));
+			CPPUNIT_ASSERT_EQUAL(std::string("decd r1"), disassemble(0x8321, 0, 0, 2));
+			CPPUNIT_ASSERT_EQUAL(std::string("tst r15"), disassemble(0x930f, 0, 0, 2));
+			CPPUNIT_ASSERT_EQUAL(std::string("rla r15"), disassemble(0x5f0f, 0, 0, 2));
+			CPPUNIT_ASSERT_EQUAL(std::string("eint"), disassemble(0xd232, 0, 0, 2));
+			CPPUNIT_ASSERT_EQUAL(std::string("clrc"), disassemble(0xc312, 0, 0, 2));
+			CPPUNIT_ASSERT_EQUAL(std::string("bis #0x00f0, r2"), disassemble(0xd032, 0x00f0, 0, 4));
+		}
+
+		void unknown() {
+			CPPUNIT_ASSERT_EQUAL(std::string(".word 0x0000"), disassemble(0x0000, 0, 0, 2));
+			// dadd is not implemented
+			CPPUNIT_ASSERT_EQUAL(std::string(".word 0xa506"), disassemble(0xa506, 0, 0, 2));
+		}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (InstructionDisassemblerTest);
+
+}
@@ -56,7 +56,7 @@ class InstructionManagerTest : public CPPUNIT_NS :: TestFixture {
 		void executeADD1ToRegister() {
 			std::string data =
 				// 1b 53       	inc	r11 => ADD(.B) #1,r11
-				":10F000001B530003B240805A20013F4000000F937E\r\n"
+				":10F000001B530003B240805A20013F4000000F9381\r\n"
 				":040000030000F00009\r\n"
 				":00000001FF\r\n";
 
@@ -73,7 +73,7 @@ class InstructionManagerTest : public CPPUNIT_NS :: TestFixture {
 		void executeADDRegisterToRegister() {
 			std::string data =
 				// 0f 51       	add	r1,	r15
-				":10F000000F510003B240805A20013F4000000F937E\r\n"
+				":10F000000F510003B240805A20013F4000000F938F\r\n"
 				":040000030000F00009\r\n"
 				":00000001FF\r\n";
 
@@ -95,7 +95,7 @@ class InstructionManagerTest : public CPPUNIT_NS :: TestFixture {
 		void executeADDRegisterToRegisterOverflow() {
 			std::string data =
 				// 0f 51       	add	r1,	r15
-				":10F000000F510003B240805A20013F4000000F937E\r\n"
+				":10F000000F510003B240805A20013F4000000F938F\r\n"
 				":040000030000F00009\r\n"
 				":00000001FF\r\n";
 
@@ -117,7 +117,7 @@ class InstructionManagerTest : public CPPUNIT_NS :: TestFixture {
 		void executeADDRegisterToRegisterZero() {
 			std::string data =
 				// 0f 51       	add	r1,	r15
-				":10F000000F510003B240805A20013F4000000F937E\r\n"
+				":10F000000F510003B240805A20013F4000000F938F\r\n"
 				":040000030000F00009\r\n"
 				":00000001FF\r\n";
 
@@ -139,7 +139,7 @@ class InstructionManagerTest : public CPPUNIT_NS :: TestFixture {
 		void executeMOVConstantToRegister() {
 			std::string data =
 				// 0b 43       	clr	r11 => mov 0 to r11
-				":10F000000B430003B240805A20013F4000000F937E\r\n"
+				":10F000000B430003B240805A20013F4000000F93A1\r\n"
 				":040000030000F00009\r\n"
 				":00000001FF\r\n";
 
@@ -157,7 +157,7 @@ class InstructionManagerTest : public CPPUNIT_NS :: TestFixture {
 		void executeMOVImmediateToRegister() {
 			std::string data =
 				// 31 40 f8 02 	mov	#760,	r1	;#0x02f8
-				":10F000003140F802B240805A20013F4000000F937E\r\n"
+				":10F000003140F802B240805A20013F4000000F9387\r\n"
 				":040000030000F00009\r\n"
 				":00000001FF\r\n";
 
@@ -176,7 +176,7 @@ class InstructionManagerTest : public CPPUNIT_NS :: TestFixture {
 			std::string data =
 				// 31 40 f8 02 	mov	#760,	r1	;#0x02f8
 				// 0b 43       	clr	r11 => mov 0 to r11
-				":10F000003140F8020B43805A20013F4000000F937E\r\n"
+				":10F000003140F8020B43805A20013F4000000F932B\r\n"
 				":040000030000F00009\r\n"
 				":00000001FF\r\n";
 
@@ -201,7 +201,7 @@ class InstructionManagerTest : public CPPUNIT_NS :: TestFixture {
 			std::string data =
 				// b2 40 80 5a 	mov	#23168,	&0x0120	;#0x5a80
 				// 20 01
-				":10F00000B240805A2001805A20013F4000000F937E\r\n"
+				":10F00000B240805A2001805A20013F4000000F93F7\r\n"
 				":040000030000F00009\r\n"
 				":00000001FF\r\n";
 
@@ -219,7 +219,7 @@ class InstructionManagerTest : public CPPUNIT_NS :: TestFixture {
 		void executeMOVAutoincrementToIndexed() {
 			std::string data =
 				// b1 4f 00 00 	mov	@r15+,	0(r1)	;0x0000(r1)
-				":10F00000B14F00002001805A20013F4000000F937E\r\n"
+				":10F00000B14F00002001805A20013F4000000F93C3\r\n"
 				":040000030000F00009\r\n"
 				":00000001FF\r\n";
 
@@ -244,7 +244,7 @@ class InstructionManagerTest : public CPPUNIT_NS :: TestFixture {
 		void executeMOVIndirectToAbsolute() {
 			std::string data =
 				// e2 4f 21 00 	mov.b	@r15,	&0x0021
-				":10F00000E24F21002001805A20013F4000000F937E\r\n"
+				":10F00000E24F21002001805A20013F4000000F9371\r\n"
 				":040000030000F00009\r\n"
 				":00000001FF\r\n";
 
@@ -272,8 +272,8 @@ class InstructionManagerTest : public CPPUNIT_NS :: TestFixture {
 		void executeJZ() {
 			std::string data =
 				// f010: 05 24       	jz	$+12     	;abs 0xf01c
-				":10F01000052421002001805A20013F4000000F937E\r\n"
-				":040000030000F01009\r\n"
+				":10F01000052421002001805A20013F4000000F9369\r\n"
+				":040000030000F010F9\r\n"
 				":00000001FF\r\n";
 
 			m->loadA43(data, r);
@@ -297,8 +297,8 @@ class InstructionManagerTest : public CPPUNIT_NS :: TestFixture {
 		void executeJNC() {
 			std::string data =
 				//f042: fc 2b       	jnc	$-6      	;abs 0xf03c
-				":10F04200FC2B21002001805A20013F4000000F937E\r\n"
-				":040000030000F04209\r\n"
+				":10F04200FC2B21002001805A20013F4000000F9339\r\n"
+				":040000030000F042C7\r\n"
 				":00000001FF\r\n";
 
 			m->loadA43(data, r);
@@ -322,7 +322,7 @@ class InstructionManagerTest : public CPPUNIT_NS :: TestFixture {
 		void executeCALL() {
 			std::string data =
 				// b0 12 36 f0 	call	#0xf036	
-				":10F00000B01236F02001805A20013F4000000F937E\r\n"
+				":10F00000B01236F02001805A20013F4000000F93DB\r\n"
 				":040000030000F00009\r\n"
 				":00000001FF\r\n";
 
@@ -344,7 +344,7 @@ class InstructionManagerTest : public CPPUNIT_NS :: TestFixture {
 			// TODO:
 // 			std::string data =
 // 				// 00 13       	reti
-// 				":10F00000001336F02001805A20013F4000000F937E\r\n"
+// 				":10F00000001336F02001805A20013F4000000F938A\r\n"
 // 				":040000030000F00009\r\n"
 // 				":00000001FF\r\n";
 // 
@@ -359,7 +359,7 @@ class InstructionManagerTest : public CPPUNIT_NS :: TestFixture {
 		void executeCMPPositive() {
 			std::string data =
 				//f00e:	0f 93       	tst	r15 = cmp #0, r15
-				":10F000000F9321002001805A20013F4000000F937E\r\n"
+				":10F000000F9321002001805A20013F4000000F9300\r\n"
 				":040000030000F00009\r\n"
 				":00000001FF\r\n";
 
@@ -378,7 +378,7 @@ class InstructionManagerTest : public CPPUNIT_NS :: TestFixture {
 		void executeCMPZero() {
 			std::string data =
 				//f00e:	0f 93       	tst	r15 = cmp #0, r15
-				":10F000000F9321002001805A20013F4000000F937E\r\n"
+				":10F000000F9321002001805A20013F4000000F9300\r\n"
 				":040000030000F00009\r\n"
 				":00000001FF\r\n";
 
@@ -396,7 +396,7 @@ class InstructionManagerTest : public CPPUNIT_NS :: TestFixture {
 		void executeCMPNegative() {
 			std::string data =
 				//f00e:	0f 93       	tst	r15 = cmp #0, r15
-				":10F000000F9321002001805A20013F4000000F937E\r\n"
+				":10F000000F9321002001805A20013F4000000F9300\r\n"
 				":040000030000F00009\r\n"
 				":00000001FF\r\n";
 
@@ -414,7 +414,7 @@ class InstructionManagerTest : public CPPUNIT_NS :: TestFixture {
 		void executeCMPCarry() {
 			std::string data =
 				// f038:	0e 9f       	cmp	r15,	r14	// r14 - r15
-				":10F000000E9F21002001805A20013F4000000F937E\r\n"
+				":10F000000E9F21002001805A20013F4000000F93F5\r\n"
 				":040000030000F00009\r\n"
 				":00000001FF\r\n";
 
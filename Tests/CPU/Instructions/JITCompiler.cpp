@@ -0,0 +1,308 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "CPU/Memory/Memory.h"
+#include "CPU/Memory/RegisterSet.h"
+#include "CPU/Memory/Register.h"
+#include "CPU/Interrupts/InterruptManager.h"
+#include "CPU/Instructions/InstructionDecoder.h"
+#include "CPU/Instructions/InstructionManager.h"
+#include "CPU/Instructions/SpecializedInstructions.h"
+#include "CPU/Instructions/BasicBlockExecutor.h"
+#include "CPU/Instructions/JITCompiler.h"
+#include "CPU/Instructions/Instruction.h"
+#include "CPU/Variants/Variant.h"
+#include "CPU/Variants/VariantManager.h"
+
+#include <stdio.h>
+#include <fstream>
+
+namespace MSP430 {
+
+// Returns the permissions of the mapping containing the address, like "r-xp".
+static std::string protection(const void *address) {
+	std::ifstream maps("/proc/self/maps");
+	std::string line;
+	while (std::getline(maps, line)) {
+		unsigned long start, end;
+		char perms[5];
+		if (sscanf(line.c_str(), "%lx-%lx %4s", &start, &end, perms) == 3 &&
+			(unsigned long) address >= start && (unsigned long) address < end) {
+			return perms;
+		}
+	}
+	return "";
+}
+
+class DummyWriteWatcher : public MemoryWatcher {
+	public:
+		void handleMemoryChanged(::Memory *memory, uint16_t address) {}
+};
+
+class JITCompilerTest : public CPPUNIT_NS :: TestFixture{
+	CPPUNIT_TEST_SUITE(JITCompilerTest);
+	CPPUNIT_TEST(compareTwoOperand);
+	CPPUNIT_TEST(compareSingleOperand);
+	CPPUNIT_TEST(stopBeforeWatchedMemory);
+	CPPUNIT_TEST(validateHotBlock);
+	CPPUNIT_TEST(protectCode);
+	CPPUNIT_TEST(unavailableBuffer);
+	CPPUNIT_TEST_SUITE_END();
+
+	// Specialized handlers
+	Memory *m;
+	RegisterSet *r;
+	InstructionDecoder *d;
+
+	// Compiled code
+	Memory *m2;
+	RegisterSet *r2;
+	InstructionDecoder *d2;
+	JITCompiler *jit;
+
+	public:
+		void setUp (void) {
+			m = new Memory(120000);
+			r = new RegisterSet;
+			r->addDefaultRegisters();
+			d = new InstructionDecoder(r, m);
+
+			m2 = new Memory(120000);
+			r2 = new RegisterSet;
+			r2->addDefaultRegisters();
+			d2 = new InstructionDecoder(r2, m2);
+			jit = new JITCompiler();
+		}
+
+		void tearDown (void) {
+			delete jit;
+			delete d;
+			delete m;
+			delete r;
+			delete d2;
+			delete m2;
+			delete r2;
+		}
+
+		void initialize(Memory *mem, RegisterSet *reg, uint16_t sr) {
+			for (int address = 0x0200; address < 0x0300; address += 2) {
+				mem->setBigEndian(address, address * 0x0101 ^ 0x8a5c);
+			}
+
+			reg->getp(0)->setBigEndian(0xf000);
+			reg->getp(1)->setBigEndian(0x0280);
+			reg->getp(2)->setBigEndian(sr);
+			reg->getp(5)->setBigEndian(0x0230);
+			reg->getp(6)->setBigEndian(0x80f1);
+			reg->getp(7)->setBigEndian(0x0250);
+		}
+
+		// Executes the program at 0xf000 using the specialized handler and
+		// the compiled code and checks the results are the same.
+		void compare(const std::vector<uint16_t> &program, uint16_t sr) {
+			initialize(m, r, sr);
+			initialize(m2, r2, sr);
+			for (unsigned int x = 0; x < program.size(); ++x) {
+				m->setBigEndian(0xf000 + x * 2, program[x]);
+				m2->setBigEndian(0xf000 + x * 2, program[x]);
+			}
+
+			const DecodedInstruction &decoded = d->decode(0xf000);
+			if (!JITCompiler::canCompile(decoded)) {
+				return;
+			}
+
+			r->getp(0)->setBigEndian(0xf000 + decoded.length);
+			getSpecializedInstruction(decoded)(r, m, decoded);
+
+			std::vector<const DecodedInstruction *> instructions;
+			instructions.push_back(&d2->decode(0xf000));
+			JITFunction f = jit->compile(instructions, 0xf000);
+			CPPUNIT_ASSERT(f);
+			CPPUNIT_ASSERT_EQUAL(1, f(r2->getRegisterFile(), m2->getData(), m2->getWatchedMask()));
+			r2->getp(0)->setBigEndian(0xf000 + decoded.length);
+
+			for (int x = 0; x < 16; ++x) {
+				CPPUNIT_ASSERT_EQUAL(r->getp(x)->getBigEndian(), r2->getp(x)->getBigEndian());
+			}
+
+			for (int address = 0x0200; address < 0x0300; ++address) {
+				CPPUNIT_ASSERT_EQUAL(m->getByte(address), m2->getByte(address));
+			}
+		}
+
+		void compareTwoOperand() {
+			if (!JITCompiler::isSupported()) {
+				return;
+			}
+
+			// register, as; last one is symbolic mode
+			const int src[][2] = {{5, 0}, {5, 1}, {5, 2}, {5, 3}, {2, 1}, {3, 1}, {2, 3}, {0, 3}, {0, 1}};
+			// register, ad
+			const int dst[][2] = {{6, 0}, {7, 1}, {2, 1}, {5, 1}};
+			const int opcodes[] = {4, 5, 8, 9, 11, 12, 13, 14, 15};
+
+			for (int o = 0; o < 9; ++o) {
+				for (int s = 0; s < 9; ++s) {
+					for (int t = 0; t < 4; ++t) {
+						for (int bw = 0; bw < 2; ++bw) {
+							std::vector<uint16_t> program;
+							program.push_back(opcodes[o] << 12 | src[s][0] << 8 | dst[t][1] << 7 | bw << 6 | src[s][1] << 4 | dst[t][0]);
+							if (src[s][1] == 1 && src[s][0] != 3) {
+								// offset / absolute address / symbolic offset
+								program.push_back(src[s][0] == 2 ? 0x0240 : src[s][0] == 0 ? 0x0240 - 0xf004 : 4);
+							}
+							else if (src[s][0] == 0 && src[s][1] == 3) {
+								program.push_back(0x7f81);
+							}
+							if (dst[t][1] == 1) {
+								program.push_back(dst[t][0] == 2 ? 0x0260 : 6);
+							}
+
+							compare(program, 0);
+							compare(program, SR_C | SR_N);
+						}
+					}
+				}
+			}
+		}
+
+		void compareSingleOperand() {
+			if (!JITCompiler::isSupported()) {
+				return;
+			}
+
+			// register, as
+			const int operands[][2] = {{6, 0}, {5, 1}, {5, 2}, {5, 3}, {2, 1}, {0, 3}};
+			// swpb, push
+			const int opcodes[] = {1, 4};
+
+			for (int o = 0; o < 2; ++o) {
+				for (int s = 0; s < 6; ++s) {
+					std::vector<uint16_t> program;
+					program.push_back(0x1000 | opcodes[o] << 7 | operands[s][1] << 4 | operands[s][0]);
+					if (operands[s][1] == 1) {
+						program.push_back(operands[s][0] == 2 ? 0x0240 : 4);
+					}
+					else if (operands[s][1] == 3 && operands[s][0] == 0) {
+						program.push_back(0x7f81);
+					}
+
+					compare(program, 0);
+				}
+			}
+		}
+
+		void stopBeforeWatchedMemory() {
+			if (!JITCompiler::isSupported()) {
+				return;
+			}
+
+			// f000: inc r6; mov r6, 2(r7); inc r6
+			initialize(m2, r2, 0);
+			m2->setBigEndian(0xf000, 0x5316);
+			m2->setBigEndian(0xf002, 0x4687);
+			m2->setBigEndian(0xf004, 0x0002);
+			m2->setBigEndian(0xf006, 0x5316);
+
+			std::vector<const DecodedInstruction *> instructions;
+			instructions.push_back(&d2->decode(0xf000));
+			instructions.push_back(&d2->decode(0xf002));
+			instructions.push_back(&d2->decode(0xf006));
+			JITFunction f = jit->compile(instructions, 0xf000);
+			CPPUNIT_ASSERT(f);
+
+			DummyWriteWatcher watcher;
+			m2->addWatcher(0x0253, &watcher);
+			CPPUNIT_ASSERT_EQUAL(1, f(r2->getRegisterFile(), m2->getData(), m2->getWatchedMask()));
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0x80f2, r2->getp(6)->getBigEndian());
+			CPPUNIT_ASSERT_EQUAL((uint16_t) (0x0252 * 0x0101 ^ 0x8a5c), m2->getBigEndian(0x0252));
+
+			// Peripherals are never accessed by the compiled code
+			r2->getp(7)->setBigEndian(0x0100);
+			CPPUNIT_ASSERT_EQUAL(1, f(r2->getRegisterFile(), m2->getData(), m2->getWatchedMask()));
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0x80f3, r2->getp(6)->getBigEndian());
+
+			m2->removeWatcher(0x0253, &watcher);
+			r2->getp(7)->setBigEndian(0x0250);
+			CPPUNIT_ASSERT_EQUAL(3, f(r2->getRegisterFile(), m2->getData(), m2->getWatchedMask()));
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0x80f5, r2->getp(6)->getBigEndian());
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0x80f4, m2->getBigEndian(0x0252));
+		}
+
+		void validateHotBlock() {
+			Variant *v = getVariant("msp430x241x");
+			InterruptManager intManager(r2, m2, v);
+			BasicBlockExecutor executor(r2, m2, d2, &intManager);
+			Instruction instruction;
+			executor.setJITValidation(true);
+
+			// f000: mov @r5+, r6; add r6, 2(r7); xor #0x00ff, r6; push r6
+			//       add #2, r1; cmp #0x0260, r5; jnc f000
+			initialize(m2, r2, 0);
+			const uint16_t program[] = {0x4536, 0x5687, 0x0002, 0xe036, 0x00ff, 0x1206,
+				0x5321, 0x9035, 0x0260, 0x2bf6};
+			for (unsigned int x = 0; x < sizeof(program) / sizeof(program[0]); ++x) {
+				m2->setBigEndian(0xf000 + x * 2, program[x]);
+			}
+
+			for (int x = 0; x < 200; ++x) {
+				CPPUNIT_ASSERT(executor.run(&instruction) != 0);
+				if (r2->getp(0)->getBigEndian() != 0xf000) {
+					r2->getp(0)->setBigEndian(0xf000);
+					r2->getp(5)->setBigEndian(0x0230);
+				}
+			}
+
+			CPPUNIT_ASSERT_EQUAL(0u, executor.getJITErrors());
+		}
+
+		void protectCode() {
+			if (!JITCompiler::isSupported()) {
+				return;
+			}
+
+			// f000: inc r6
+			initialize(m2, r2, 0);
+			m2->setBigEndian(0xf000, 0x5316);
+			std::vector<const DecodedInstruction *> instructions;
+			instructions.push_back(&d2->decode(0xf000));
+
+			// The second function shares the page with the first one,
+			// which has to stay executable
+			JITFunction f1 = jit->compile(instructions, 0xf000);
+			CPPUNIT_ASSERT(f1);
+			CPPUNIT_ASSERT(protection((void *) f1) == "r-xp");
+			JITFunction f2 = jit->compile(instructions, 0xf000);
+			CPPUNIT_ASSERT(f2);
+			CPPUNIT_ASSERT(protection((void *) f2) == "r-xp");
+			CPPUNIT_ASSERT_EQUAL(1, f1(r2->getRegisterFile(), m2->getData(), m2->getWatchedMask()));
+			CPPUNIT_ASSERT_EQUAL(1, f2(r2->getRegisterFile(), m2->getData(), m2->getWatchedMask()));
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0x80f3, r2->getp(6)->getBigEndian());
+
+			// Code is written over the old one after the flush
+			jit->flush();
+			JITFunction f3 = jit->compile(instructions, 0xf000);
+			CPPUNIT_ASSERT(f3 == f1);
+			CPPUNIT_ASSERT(protection((void *) f3) == "r-xp");
+			CPPUNIT_ASSERT_EQUAL(1, f3(r2->getRegisterFile(), m2->getData(), m2->getWatchedMask()));
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0x80f4, r2->getp(6)->getBigEndian());
+		}
+
+		void unavailableBuffer() {
+			// Empty buffer cannot be mapped
+			JITCompiler empty(0);
+			CPPUNIT_ASSERT(!empty.isAvailable());
+
+			initialize(m2, r2, 0);
+			m2->setBigEndian(0xf000, 0x5316);
+			std::vector<const DecodedInstruction *> instructions;
+			instructions.push_back(&d2->decode(0xf000));
+			CPPUNIT_ASSERT(!empty.compile(instructions, 0xf000));
+			CPPUNIT_ASSERT(!empty.isFull());
+		}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (JITCompilerTest);
+
+}
@@ -0,0 +1,246 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "CPU/Memory/Memory.h"
+#include "CPU/Memory/RegisterSet.h"
+#include "CPU/Memory/Register.h"
+#include "CPU/Instructions/InstructionDecoder.h"
+#include "CPU/Instructions/InstructionManager.h"
+#include "CPU/Instructions/SpecializedInstructions.h"
+#include "CPU/Instructions/Instruction.h"
+
+namespace MSP430 {
+
+class SpecializedInstructionsTest : public CPPUNIT_NS :: TestFixture{
+	CPPUNIT_TEST_SUITE(SpecializedInstructionsTest);
+	CPPUNIT_TEST(compareTwoOperand);
+	CPPUNIT_TEST(compareSingleOperand);
+	CPPUNIT_TEST(compareCond);
+	CPPUNIT_TEST(compareFused);
+	CPPUNIT_TEST_SUITE_END();
+
+	// Generic InstructionArgument based execution
+	Memory *m;
+	RegisterSet *r;
+	InstructionDecoder *d;
+	Instruction *i;
+
+	// Specialized execution
+	Memory *m2;
+	RegisterSet *r2;
+	InstructionDecoder *d2;
+
+	public:
+		void setUp (void) {
+			m = new Memory(120000);
+			r = new RegisterSet;
+			r->addDefaultRegisters();
+			d = new InstructionDecoder(r, m);
+			i = new Instruction;
+
+			m2 = new Memory(120000);
+			r2 = new RegisterSet;
+			r2->addDefaultRegisters();
+			d2 = new InstructionDecoder(r2, m2);
+		}
+
+		void tearDown (void) {
+			delete d;
+			delete i;
+			delete m;
+			delete r;
+			delete d2;
+			delete m2;
+			delete r2;
+		}
+
+		void initialize(Memory *mem, RegisterSet *reg, uint16_t sr) {
+			for (int address = 0x0200; address < 0x0300; address += 2) {
+				mem->setBigEndian(address, address * 0x0101 ^ 0x8a5c);
+			}
+
+			reg->getp(0)->setBigEndian(0xf000);
+			reg->getp(1)->setBigEndian(0x0280);
+			reg->getp(2)->setBigEndian(sr);
+			reg->getp(5)->setBigEndian(0x0230);
+			reg->getp(6)->setBigEndian(0x80f1);
+			reg->getp(7)->setBigEndian(0x0250);
+		}
+
+		// Executes the program at 0xf000 using both the generic and
+		// specialized handlers and checks the results are the same.
+		void compare(const std::vector<uint16_t> &program, uint16_t sr) {
+			initialize(m, r, sr);
+			initialize(m2, r2, sr);
+			for (unsigned int x = 0; x < program.size(); ++x) {
+				m->setBigEndian(0xf000 + x * 2, program[x]);
+				m2->setBigEndian(0xf000 + x * 2, program[x]);
+			}
+
+			d->decodeCurrentInstruction(i);
+			CPPUNIT_ASSERT_EQUAL(0, executeInstruction(r, m, i));
+
+			const DecodedInstruction &decoded = d2->decode(0xf000);
+			SpecializedCallback handler = getSpecializedInstruction(decoded);
+			CPPUNIT_ASSERT(handler);
+			r2->getp(0)->setBigEndian(0xf000 + decoded.length);
+			CPPUNIT_ASSERT_EQUAL(0, handler(r2, m2, decoded));
+
+			for (int x = 0; x < 16; ++x) {
+				CPPUNIT_ASSERT_EQUAL(r->getp(x)->getBigEndian(), r2->getp(x)->getBigEndian());
+			}
+
+			for (int address = 0x0200; address < 0x0300; ++address) {
+				CPPUNIT_ASSERT_EQUAL(m->getByte(address), m2->getByte(address));
+			}
+		}
+
+		void compareTwoOperand() {
+			// register, as; last one is symbolic mode
+			const int src[][2] = {{5, 0}, {5, 1}, {5, 2}, {5, 3}, {2, 1}, {3, 1}, {2, 3}, {0, 3}, {0, 1}};
+			// register, ad
+			const int dst[][2] = {{6, 0}, {7, 1}, {2, 1}, {5, 1}};
+			const int opcodes[] = {4, 5, 6, 7, 8, 9, 11, 12, 13, 14, 15};
+
+			for (int o = 0; o < 11; ++o) {
+				for (int s = 0; s < 9; ++s) {
+					for (int t = 0; t < 4; ++t) {
+						for (int bw = 0; bw < 2; ++bw) {
+							std::vector<uint16_t> program;
+							program.push_back(opcodes[o] << 12 | src[s][0] << 8 | dst[t][1] << 7 | bw << 6 | src[s][1] << 4 | dst[t][0]);
+							if (src[s][1] == 1 && src[s][0] != 3) {
+								// offset / absolute address / symbolic offset
+								program.push_back(src[s][0] == 2 ? 0x0240 : src[s][0] == 0 ? 0x0240 - 0xf004 : 4);
+							}
+							else if (src[s][0] == 0 && src[s][1] == 3) {
+								program.push_back(0x7f81);
+							}
+							if (dst[t][1] == 1) {
+								program.push_back(dst[t][0] == 2 ? 0x0260 : 6);
+							}
+
+							compare(program, 0);
+							compare(program, SR_C | SR_N);
+						}
+					}
+				}
+			}
+		}
+
+		void compareSingleOperand() {
+			// register, as
+			const int operands[][2] = {{6, 0}, {5, 1}, {5, 2}, {5, 3}, {2, 1}, {0, 3}};
+
+			// reti does not use operand, so test it just once
+			for (int o = 0; o < 7; ++o) {
+				for (int s = 0; s < 6; ++s) {
+					for (int bw = 0; bw < 2; ++bw) {
+						std::vector<uint16_t> program;
+						program.push_back(0x1000 | o << 7 | bw << 6 | operands[s][1] << 4 | operands[s][0]);
+						if (operands[s][1] == 1) {
+							program.push_back(operands[s][0] == 2 ? 0x0240 : 4);
+						}
+						else if (operands[s][1] == 3 && operands[s][0] == 0) {
+							program.push_back(0x7f81);
+						}
+
+						compare(program, 0);
+						compare(program, SR_C);
+						if (o == 6) {
+							return;
+						}
+					}
+				}
+			}
+		}
+
+		void compareCond() {
+			const uint16_t flags[] = {0, SR_Z, SR_C, SR_N, SR_V, SR_N | SR_V};
+			for (int o = 0; o < 8; ++o) {
+				for (int f = 0; f < 6; ++f) {
+					std::vector<uint16_t> program;
+					program.push_back(0x2000 | o << 10 | 0x3fc);
+					compare(program, flags[f]);
+				}
+			}
+		}
+
+		// Executes two instructions at 0xf000 one by one using the specialized
+		// handlers and at once using the fused handler.
+		void comparePair(const std::vector<uint16_t> &program, uint16_t sr, int pattern) {
+			initialize(m, r, sr);
+			initialize(m2, r2, sr);
+			for (unsigned int x = 0; x < program.size(); ++x) {
+				m->setBigEndian(0xf000 + x * 2, program[x]);
+				m2->setBigEndian(0xf000 + x * 2, program[x]);
+			}
+
+			const DecodedInstruction &first = d->decode(0xf000);
+			const DecodedInstruction &second = d->decode(0xf000 + first.length);
+			r->getp(0)->setBigEndian(0xf000 + first.length);
+			getSpecializedInstruction(first)(r, m, first);
+			r->getp(0)->setBigEndian(0xf000 + first.length + second.length);
+			getSpecializedInstruction(second)(r, m, second);
+
+			const DecodedInstruction &first2 = d2->decode(0xf000);
+			const DecodedInstruction &second2 = d2->decode(0xf000 + first2.length);
+			int p = -1;
+			FusedCallback fused = getFusedInstruction(first2, second2, p);
+			CPPUNIT_ASSERT(fused);
+			CPPUNIT_ASSERT_EQUAL(pattern, p);
+			r2->getp(0)->setBigEndian(0xf000 + first2.length + second2.length);
+			fused(r2, m2, first2, second2);
+
+			for (int x = 0; x < 16; ++x) {
+				CPPUNIT_ASSERT_EQUAL(r->getp(x)->getBigEndian(), r2->getp(x)->getBigEndian());
+			}
+
+			for (int address = 0x0200; address < 0x0300; ++address) {
+				CPPUNIT_ASSERT_EQUAL(m->getByte(address), m2->getByte(address));
+			}
+		}
+
+		void compareFused() {
+			const uint16_t flags[] = {0, SR_Z, SR_C};
+			for (int f = 0; f < 3; ++f) {
+				for (int o = 0; o < 4; ++o) {
+					std::vector<uint16_t> program;
+					// dec r6; jnz/jz/jnc/jc $-2
+					program.push_back(0x8316);
+					program.push_back(0x2000 | o << 10 | 0x3fe);
+					comparePair(program, flags[f], FusedArithmeticJump);
+
+					// add.b r5, r6; jnz/jz/jnc/jc $-2
+					program[0] = 0x5546;
+					comparePair(program, flags[f], FusedArithmeticJump);
+
+					// cmp #0x80f1, r6; jnz/jz/jnc/jc $-4
+					program[0] = 0x9036;
+					program[1] = 0x80f1;
+					program.push_back(0x2000 | o << 10 | 0x3fd);
+					comparePair(program, flags[f], FusedCompareJump);
+
+					// cmp r7, r6
+					program.clear();
+					program.push_back(0x9706);
+					program.push_back(0x2000 | o << 10 | 0x3fe);
+					comparePair(program, flags[f], FusedCompareJump);
+				}
+			}
+
+			// push r6; push #8
+			std::vector<uint16_t> program;
+			program.push_back(0x1206);
+			program.push_back(0x1232);
+			comparePair(program, 0, FusedPushPush);
+
+			// push #8; push r6
+			program[0] = 0x1232;
+			program[1] = 0x1206;
+			comparePair(program, 0, FusedPushPush);
+		}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (SpecializedInstructionsTest);
+
+}
@@ -7,10 +7,31 @@
 
 namespace MSP430 {
 
+class CountingMemoryWatcher : public MemoryWatcher {
+	public:
+		CountingMemoryWatcher() : changed(0), read(0) {}
+
+		void handleMemoryChanged(::Memory *memory, uint16_t address) {
+			changed++;
+		}
+
+		void handleMemoryRead(::Memory *memory, uint16_t address, uint8_t &value) {
+			read++;
+		}
+
+		int changed;
+		int read;
+};
+
 class MemoryTest : public CPPUNIT_NS :: TestFixture{
 	CPPUNIT_TEST_SUITE(MemoryTest);
 	CPPUNIT_TEST(loadA43);
+	CPPUNIT_TEST(loadA43Checksum);
+	CPPUNIT_TEST(resetImage);
+	CPPUNIT_TEST(loadELF);
 	CPPUNIT_TEST(setget);
+	CPPUNIT_TEST(watchers);
+	CPPUNIT_TEST(word);
 	CPPUNIT_TEST_SUITE_END();
 
 	public:
@@ -39,6 +60,79 @@ class MemoryTest : public CPPUNIT_NS :: TestFixture{
 			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xf000, m.getBigEndian(1));
 		}
 
+		void watchers() {
+			Memory m(120000);
+			CountingMemoryWatcher w1;
+			CountingMemoryWatcher w2;
+
+			m.addWatcher(0x0021, &w1);
+			m.addWatcher(0x0021, &w2, MemoryWatcher::ReadWrite);
+			CPPUNIT_ASSERT(m.isWatched(0x0021, MemoryWatcher::Read));
+			CPPUNIT_ASSERT(m.isWatched(0x0021, MemoryWatcher::Write));
+			CPPUNIT_ASSERT(!m.isWatched(0x0020));
+			CPPUNIT_ASSERT_EQUAL((uint8_t) (MEMORY_READ_WATCHED | MEMORY_WRITE_WATCHED), m.getWatchedMask()[0x0021]);
+
+			m.setByte(0x0021, 1);
+			m.setByte(0x0020, 1);
+			m.getByte(0x0021);
+			CPPUNIT_ASSERT_EQUAL(1, w1.changed);
+			CPPUNIT_ASSERT_EQUAL(1, w2.changed);
+			CPPUNIT_ASSERT_EQUAL(0, w1.read);
+			CPPUNIT_ASSERT_EQUAL(1, w2.read);
+
+			m.removeWatcher(0x0021, &w2, MemoryWatcher::Read);
+			CPPUNIT_ASSERT(!m.isWatched(0x0021, MemoryWatcher::Read));
+			CPPUNIT_ASSERT_EQUAL((uint8_t) MEMORY_WRITE_WATCHED, m.getWatchedMask()[0x0021]);
+
+			m.removeWatcher(0x0021, &w1);
+			m.removeWatcher(0x0021, &w2);
+			CPPUNIT_ASSERT(!m.isWatched(0x0021));
+			m.setByte(0x0021, 2);
+			CPPUNIT_ASSERT_EQUAL(1, w1.changed);
+
+			// RAM watchers, like breakpoints
+			m.addWatcher(0x0300, &w1);
+			m.addWatcher(0x0302, &w1);
+			m.setBigEndian(0x02fe, 0x1234);
+			m.setBigEndian(0x0300, 0x1234);
+			m.setByte(0x0302, 1);
+			CPPUNIT_ASSERT_EQUAL(3, w1.changed);
+			m.removeWatcher(0x0300, &w1);
+			m.setByte(0x0300, 1);
+			m.setByte(0x0302, 1);
+			CPPUNIT_ASSERT_EQUAL(4, w1.changed);
+			m.removeWatcher(0x0302, &w1);
+			m.setByte(0x0302, 1);
+			CPPUNIT_ASSERT_EQUAL(4, w1.changed);
+
+			// Word access at the last address
+			m.setBigEndian(0xfffe, 0x1234);
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0x1234, m.getBigEndian(0xfffe));
+			CPPUNIT_ASSERT_EQUAL((uint8_t) 0, m.getWatchedMask()[0x10000]);
+		}
+
+		void word() {
+			Memory m(120000);
+			CountingMemoryWatcher w;
+
+			m.setWord(0x0300, 0x1234);
+			CPPUNIT_ASSERT_EQUAL((uint8_t) 0x34, m.getByte(0x0300));
+			CPPUNIT_ASSERT_EQUAL((uint8_t) 0x12, m.getByte(0x0301));
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0x1234, m.getWord(0x0300));
+			CPPUNIT_ASSERT_EQUAL(m.getBigEndian(0x0300), m.getWord(0x0300));
+
+			// Word at the end of the page has the second byte watched in the
+			// next page
+			m.addWatcher(0x0400, &w);
+			m.setWord(0x03fe, 1);
+			CPPUNIT_ASSERT_EQUAL(0, w.changed);
+			m.setWord(0x03ff, 1);
+			CPPUNIT_ASSERT_EQUAL(1, w.changed);
+			m.setWord(0x0400, 1, false);
+			CPPUNIT_ASSERT_EQUAL(1, w.changed);
+			m.removeWatcher(0x0400, &w);
+		}
+
 		void loadA43() {
 			Memory m(120000);
 			RegisterSet r;
@@ -72,6 +166,133 @@ class MemoryTest : public CPPUNIT_NS :: TestFixture{
 			// check if PC is set properly
 			CPPUNIT_ASSERT_EQUAL((uint16_t) 61440, r[0]->getBigEndian()); // 0xF000
 		}
+
+		void loadA43Checksum() {
+			Memory m(120000);
+			RegisterSet r;
+			r.addRegister("PC", 0);
+
+			// Checksum of the first record is wrong
+			std::string data =
+				":10F000001B530003B240805A20013F4000000F937F\r\n"
+				":040000030000F00009\r\n"
+				":00000001FF\r\n";
+			CPPUNIT_ASSERT_EQUAL(false, m.loadA43(data, &r));
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0, m.getBigEndian(0xf000));
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0, r[0]->getBigEndian());
+
+			// Missing end of file record
+			data = ":10F000001B530003B240805A20013F4000000F9381\r\n";
+			CPPUNIT_ASSERT_EQUAL(false, m.loadA43(data, &r));
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0, m.getBigEndian(0xf000));
+
+			// Not a hex digit
+			data = ":10F000001B530003B240805A2001XF4000000F9381\r\n:00000001FF\r\n";
+			CPPUNIT_ASSERT_EQUAL(false, m.loadA43(data, &r));
+		}
+
+		void resetImage() {
+			Memory m(120000);
+			RegisterSet r;
+			r.addRegister("PC", 0);
+
+			std::string data =
+				":10F000001B530003B240805A20013F4000000F9381\r\n"
+				":040000030000F00009\r\n"
+				":00000001FF\r\n";
+
+			m.setBigEndian(0x0200, 0x1234);
+			CPPUNIT_ASSERT_EQUAL(true, m.loadA43(data, &r));
+			// Loading the program does not touch the other memory
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0x1234, m.getBigEndian(0x0200));
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0x531b, m.getBigEndian(0xf000));
+
+			m.setBigEndian(0xf000, 0x4303);
+			r[0]->setBigEndian(0xf100);
+			m.reset();
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0, m.getBigEndian(0x0200));
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0x531b, m.getBigEndian(0xf000));
+			CPPUNIT_ASSERT_EQUAL(true, m.loadEntryPoint(&r));
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xf000, r[0]->getBigEndian());
+
+			// Image without the start address record keeps the PC
+			data =
+				":10F000001B530003B240805A20013F4000000F9381\r\n"
+				":00000001FF\r\n";
+			CPPUNIT_ASSERT_EQUAL(true, m.loadA43(data, &r));
+			r[0]->setBigEndian(0xf100);
+			CPPUNIT_ASSERT_EQUAL(false, m.loadEntryPoint(&r));
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xf100, r[0]->getBigEndian());
+		}
+
+		static void putELF16(std::string &elf, int offset, uint16_t value) {
+			elf[offset] = value & 0xff;
+			elf[offset + 1] = value >> 8;
+		}
+
+		static void putELF32(std::string &elf, int offset, uint32_t value) {
+			putELF16(elf, offset, value & 0xffff);
+			putELF16(elf, offset + 2, value >> 16);
+		}
+
+		// Returns ELF with header, two program headers and the segment data
+		static std::string createELF(uint16_t machine) {
+			std::string elf(52 + 2 * 32 + 6, 0);
+			elf.replace(0, 4, "\x7f" "ELF");
+			elf[4] = 1; // 32-bit
+			elf[5] = 1; // little endian
+			putELF16(elf, 18, machine);
+			putELF32(elf, 24, 0xf000); // entry
+			putELF32(elf, 28, 52); // program headers offset
+			putELF16(elf, 42, 32);
+			putELF16(elf, 44, 2);
+
+			// .text: mov #0x0300, r1
+			putELF32(elf, 52, 1);
+			putELF32(elf, 52 + 4, 116);
+			putELF32(elf, 52 + 8, 0xf000);
+			putELF32(elf, 52 + 12, 0xf000);
+			putELF32(elf, 52 + 16, 4);
+			putELF32(elf, 52 + 20, 4);
+			putELF16(elf, 116, 0x4031);
+			putELF16(elf, 118, 0x0300);
+
+			// .vectors: reset vector
+			putELF32(elf, 84, 1);
+			putELF32(elf, 84 + 4, 120);
+			putELF32(elf, 84 + 8, 0xfffe);
+			putELF32(elf, 84 + 12, 0xfffe);
+			putELF32(elf, 84 + 16, 2);
+			putELF32(elf, 84 + 20, 2);
+			putELF16(elf, 120, 0xf000);
+			return elf;
+		}
+
+		void loadELF() {
+			Memory m(120000);
+			RegisterSet r;
+			r.addRegister("PC", 0);
+
+			CPPUNIT_ASSERT_EQUAL(false, m.loadELF(createELF(0x3e), &r));
+			CPPUNIT_ASSERT_EQUAL(false, m.loadELF("not an ELF file", &r));
+
+			std::string elf = createELF(105);
+			CPPUNIT_ASSERT_EQUAL(true, m.loadELF(elf, &r));
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0x4031, m.getBigEndian(0xf000));
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0x0300, m.getBigEndian(0xf002));
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xf000, m.getBigEndian(0xfffe));
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xf000, r[0]->getBigEndian());
+			CPPUNIT_ASSERT_EQUAL(2, (int) m.getLoadedSpans().size());
+			CPPUNIT_ASSERT_EQUAL(0xf000u, m.getLoadedSpans()[0].start);
+
+			// Segment out of the file
+			putELF32(elf, 52 + 16, 0x100);
+			CPPUNIT_ASSERT_EQUAL(false, m.loadELF(elf, &r));
+
+			m.setBigEndian(0xf000, 0);
+			m.reset();
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0x4031, m.getBigEndian(0xf000));
+		}
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION (MemoryTest);
@@ -10,8 +10,11 @@ class RegisterTest : public CPPUNIT_NS :: TestFixture{
 	CPPUNIT_TEST(setget);
 	CPPUNIT_TEST(setByte);
 	CPPUNIT_TEST(setBit);
+	CPPUNIT_TEST(lazyFlags);
 	CPPUNIT_TEST_SUITE_END();
 
+	RegisterFile file;
+
 	public:
 		void setUp (void) {
 			
@@ -22,7 +25,7 @@ class RegisterTest : public CPPUNIT_NS :: TestFixture{
 		}
 
 		void setget() {
-			Register r(0, "R0", 55, "desc");
+			Register r(&file, 0, "R0", 55, "desc");
 			CPPUNIT_ASSERT_EQUAL((uint16_t) 55, r.getBigEndian());
 			r.setBigEndian(0xff00);
 			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xff00, r.getBigEndian());
@@ -33,7 +36,7 @@ class RegisterTest : public CPPUNIT_NS :: TestFixture{
 		}
 
 		void setByte() {
-			Register r(0, "R0", 0x0203, "desc");
+			Register r(&file, 0, "R0", 0x0203, "desc");
 			CPPUNIT_ASSERT_EQUAL((int) 3, (int) r.getByte());
 			r.setByte(0x04);
 			CPPUNIT_ASSERT_EQUAL((int) 4, (int) r.getByte());
@@ -41,7 +44,7 @@ class RegisterTest : public CPPUNIT_NS :: TestFixture{
 		}
 
 		void setBit() {
-			Register r(0, "R0", 0x0203, "desc");
+			Register r(&file, 0, "R0", 0x0203, "desc");
 			r.setBit(SR_V, false);
 			CPPUNIT_ASSERT_EQUAL(false, r.isBitSet(SR_V));
 			r.setBit(SR_V, true);
@@ -49,6 +52,27 @@ class RegisterTest : public CPPUNIT_NS :: TestFixture{
 			r.setBit(SR_V, false);
 			CPPUNIT_ASSERT_EQUAL(false, r.isBitSet(SR_V));
 		}
+
+		void lazyFlags() {
+			Register sr(&file, 2, "R2", SR_GIE | SR_V, "desc");
+
+			// cmp #2, r5 with r5 = 1
+			file.setFlags(FlagsSub, false, 1, 2, 1 + (~2 & 0xffff) + 1);
+			CPPUNIT_ASSERT_EQUAL((uint16_t) (SR_GIE | SR_N), sr.getBigEndian());
+			CPPUNIT_ASSERT_EQUAL((int) FlagsNone, (int) file.flagsOp);
+
+			// add.b #1, r5 with r5 = 0xff
+			file.setFlags(FlagsAdd, true, 0xff, 1, 0x100);
+			CPPUNIT_ASSERT_EQUAL(true, sr.isBitSet(SR_Z));
+			CPPUNIT_ASSERT_EQUAL(true, sr.isBitSet(SR_C));
+			CPPUNIT_ASSERT_EQUAL(false, sr.isBitSet(SR_N));
+			CPPUNIT_ASSERT_EQUAL(true, sr.isBitSet(SR_GIE));
+
+			// Writing SR discards flags of the previous operation
+			file.setFlags(FlagsLogic, false, 1, 1, 0);
+			sr.setBigEndian(SR_C);
+			CPPUNIT_ASSERT_EQUAL((uint16_t) SR_C, sr.getBigEndian());
+		}
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION (RegisterTest);
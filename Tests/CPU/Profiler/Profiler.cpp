@@ -0,0 +1,178 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "CPU/Memory/Memory.h"
+#include "CPU/Memory/RegisterSet.h"
+#include "CPU/Memory/Register.h"
+#include "CPU/Interrupts/InterruptManager.h"
+#include "CPU/Instructions/InstructionDecoder.h"
+#include "CPU/Instructions/InstructionManager.h"
+#include "CPU/Instructions/BasicBlockExecutor.h"
+#include "CPU/Instructions/Instruction.h"
+#include "CPU/Profiler/Profiler.h"
+#include "CPU/Variants/Variant.h"
+#include "CPU/Variants/VariantManager.h"
+
+namespace MSP430 {
+
+class ProfilerTest : public CPPUNIT_NS :: TestFixture{
+	CPPUNIT_TEST_SUITE(ProfilerTest);
+	CPPUNIT_TEST(callGraph);
+	CPPUNIT_TEST(interrupt);
+	CPPUNIT_TEST(basicBlocks);
+	CPPUNIT_TEST(removeCycles);
+	CPPUNIT_TEST_SUITE_END();
+
+	Memory *m;
+	RegisterSet *r;
+	Variant *v;
+	InterruptManager *intManager;
+	InstructionDecoder *d;
+	Instruction *i;
+	Profiler *p;
+
+	public:
+		void setUp (void) {
+			m = new Memory(120000);
+			r = new RegisterSet;
+			r->addDefaultRegisters();
+			v = getVariant("msp430x241x");
+			intManager = new InterruptManager(r, m, v);
+			d = new InstructionDecoder(r, m);
+			i = new Instruction;
+			p = new Profiler(r, intManager);
+
+			// f000: call #f100; jmp $
+			m->setBigEndian(0xf000, 0x12b0);
+			m->setBigEndian(0xf002, 0xf100);
+			m->setBigEndian(0xf004, 0x3fff);
+			// f100: call #f200; ret
+			m->setBigEndian(0xf100, 0x12b0);
+			m->setBigEndian(0xf102, 0xf200);
+			m->setBigEndian(0xf104, 0x4130);
+			// f200: nop; ret
+			m->setBigEndian(0xf200, 0x4303);
+			m->setBigEndian(0xf202, 0x4130);
+			// f300: reti
+			m->setBigEndian(0xf300, 0x1300);
+
+			r->getp(0)->setBigEndian(0xf000);
+			r->getp(1)->setBigEndian(0x0400);
+		}
+
+		void tearDown (void) {
+			delete p;
+			delete d;
+			delete i;
+			delete intManager;
+			delete m;
+			delete r;
+		}
+
+		int cycles(uint16_t pc) {
+			return d->decode(pc).cycles;
+		}
+
+		void step() {
+			uint16_t pc = r->getp(0)->getBigEndian();
+			d->decodeCurrentInstruction(i);
+			CPPUNIT_ASSERT_EQUAL(0, executeInstruction(r, m, i));
+			p->addInstruction(pc, d->decode(pc));
+			intManager->handleInstruction(i);
+		}
+
+		void checkCallGraph() {
+			std::vector<ProfilerCall> calls = p->getCalls();
+			CPPUNIT_ASSERT_EQUAL((size_t) 2, calls.size());
+
+			int inner = cycles(0xf200) + cycles(0xf202);
+			int outer = cycles(0xf100) + inner + cycles(0xf104);
+
+			// Calls are sorted by caller
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0, calls[0].caller);
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xf100, calls[0].callee);
+			CPPUNIT_ASSERT_EQUAL((uint64_t) 1, calls[0].calls);
+			CPPUNIT_ASSERT_EQUAL((uint64_t) outer, calls[0].cycles);
+
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xf100, calls[1].caller);
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xf200, calls[1].callee);
+			CPPUNIT_ASSERT_EQUAL((uint64_t) 1, calls[1].calls);
+			CPPUNIT_ASSERT_EQUAL((uint64_t) inner, calls[1].cycles);
+
+			CPPUNIT_ASSERT_EQUAL((uint64_t) (cycles(0xf000) + outer), p->getTotalCycles());
+			CPPUNIT_ASSERT_EQUAL((uint64_t) (cycles(0xf100) + cycles(0xf104)), p->getCycles(0xf100) + p->getCycles(0xf104));
+			CPPUNIT_ASSERT_EQUAL((uint64_t) 1, p->getInstructions(0xf202));
+		}
+
+		void callGraph() {
+			while (r->getp(0)->getBigEndian() != 0xf004) {
+				step();
+			}
+
+			checkCallGraph();
+		}
+
+		void interrupt() {
+			m->setBigEndian(v->getINTVECT() + 0x12, 0xf300);
+
+			// Interrupt while the inner function runs
+			step();
+			step();
+			intManager->queueInterrupt(0x12);
+			CPPUNIT_ASSERT(intManager->runQueuedInterrupts());
+			p->addInterrupt(5);
+			CPPUNIT_ASSERT_EQUAL(0x12, intManager->getRunningInterrupt());
+			step();
+			CPPUNIT_ASSERT_EQUAL(-1, intManager->getRunningInterrupt());
+
+			const std::map<int, ProfilerCall> &interrupts = p->getInterrupts();
+			CPPUNIT_ASSERT_EQUAL((size_t) 1, interrupts.size());
+			const ProfilerCall &call = interrupts.find(0x12)->second;
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xf300, call.callee);
+			CPPUNIT_ASSERT_EQUAL((uint64_t) 1, call.calls);
+			CPPUNIT_ASSERT_EQUAL((uint64_t) (5 + cycles(0xf300)), call.cycles);
+
+			// Returning from the interrupt must not finish the interrupted
+			// functions
+			CPPUNIT_ASSERT(p->getCalls().empty());
+
+			while (r->getp(0)->getBigEndian() != 0xf004) {
+				step();
+			}
+			std::vector<ProfilerCall> calls = p->getCalls();
+			CPPUNIT_ASSERT_EQUAL((size_t) 2, calls.size());
+			CPPUNIT_ASSERT_EQUAL((uint64_t) (cycles(0xf200) + cycles(0xf202) + 5 + cycles(0xf300)), calls[1].cycles);
+		}
+
+		void basicBlocks() {
+			BasicBlockExecutor e(r, m, d, intManager);
+			e.setProfiler(p);
+
+			int total = 0;
+			while (r->getp(0)->getBigEndian() != 0xf004) {
+				int executed = e.run(i);
+				CPPUNIT_ASSERT(executed != 0);
+				total += executed;
+			}
+
+			CPPUNIT_ASSERT_EQUAL((uint64_t) total, p->getTotalCycles());
+			checkCallGraph();
+		}
+
+		void removeCycles() {
+			p->addCycles(0xf004, 10);
+			p->addCycles(0xf100, 5);
+			p->removeCycles(0xf004, 4);
+			CPPUNIT_ASSERT_EQUAL((uint64_t) 6, p->getCycles(0xf004));
+			CPPUNIT_ASSERT_EQUAL((uint64_t) 11, p->getTotalCycles());
+
+			// Only the cycles counted at the PC can be taken back
+			p->removeCycles(0xf004, 100);
+			CPPUNIT_ASSERT_EQUAL((uint64_t) 0, p->getCycles(0xf004));
+			CPPUNIT_ASSERT_EQUAL((uint64_t) 5, p->getTotalCycles());
+		}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (ProfilerTest);
+
+}
@@ -0,0 +1,274 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <QCryptographicHash>
+#include <QFile>
+#include <QDir>
+
+#include "Dwarf/DwarfCache.h"
+#include "Dwarf/DwarfDebugData.h"
+#include "Dwarf/DwarfSubprogram.h"
+#include "Dwarf/DwarfVariable.h"
+#include "Dwarf/DwarfLocation.h"
+#include "Dwarf/DwarfLocationList.h"
+#include "Dwarf/DwarfExpression.h"
+#include "Dwarf/dwarf.h"
+
+class DwarfCacheTest : public CPPUNIT_NS :: TestFixture{
+	CPPUNIT_TEST_SUITE(DwarfCacheTest);
+	CPPUNIT_TEST(debugDataRoundTrip);
+	CPPUNIT_TEST(disassembledCodeRoundTrip);
+	CPPUNIT_TEST(invalidHeader);
+	CPPUNIT_TEST(staleHash);
+	CPPUNIT_TEST_SUITE_END();
+
+	QString dir;
+	QByteArray elf;
+	QByteArray otherElf;
+
+	public:
+		void setUp (void) {
+			dir = QDir::tempPath() + "/qsimkit_cache_test";
+			elf = QByteArray("\x7f" "ELF first file");
+			otherElf = QByteArray("\x7f" "ELF second file");
+			removeFiles();
+		}
+
+		void tearDown (void) {
+			removeFiles();
+		}
+
+		QString path(const QByteArray &data, const QString &suffix) {
+			return dir + "/" + QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex() + suffix;
+		}
+
+		void removeFiles() {
+			QFile::remove(path(elf, ".debug"));
+			QFile::remove(path(elf, ".code"));
+			QFile::remove(path(otherElf, ".debug"));
+			QFile::remove(path(otherElf, ".code"));
+		}
+
+		QByteArray readFile(const QString &path) {
+			QFile file(path);
+			CPPUNIT_ASSERT(file.open(QIODevice::ReadOnly));
+			return file.readAll();
+		}
+
+		void writeFile(const QString &path, const QByteArray &data) {
+			QFile::remove(path);
+			QFile file(path);
+			CPPUNIT_ASSERT(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+			file.write(data);
+			file.close();
+		}
+
+		DwarfExpression *expression(const char *code, int size) {
+			return new DwarfExpression((const uint8_t *) code, size, 2);
+		}
+
+		void compareExpressions(DwarfExpression *expected, DwarfExpression *expr) {
+			CPPUNIT_ASSERT_EQUAL(expected == 0, expr == 0);
+			if (expected) {
+				CPPUNIT_ASSERT(expected->getCode() == expr->getCode());
+				CPPUNIT_ASSERT_EQUAL(expected->getAddressSize(), expr->getAddressSize());
+			}
+		}
+
+		void compareLocationLists(DwarfLocationList *expected, DwarfLocationList *ll) {
+			CPPUNIT_ASSERT_EQUAL(expected == 0, ll == 0);
+			if (!expected) {
+				return;
+			}
+
+			CPPUNIT_ASSERT_EQUAL(expected->getLocations().size(), ll->getLocations().size());
+			for (int i = 0; i < expected->getLocations().size(); ++i) {
+				DwarfLocation *l1 = expected->getLocations()[i];
+				DwarfLocation *l2 = ll->getLocations()[i];
+				CPPUNIT_ASSERT_EQUAL(l1->getPCLow(), l2->getPCLow());
+				CPPUNIT_ASSERT_EQUAL(l1->getPCHigh(), l2->getPCHigh());
+				compareExpressions(l1->getExpression(), l2->getExpression());
+			}
+		}
+
+		/// Builds the debug data using every kind of the cached record.
+		DwarfDebugData *buildDebugData() {
+			DwarfDebugData *dd = new DwarfDebugData();
+			VariableType *intType = new VariableType("int", 2, VariableType::Signed, VariableType::Base);
+			VariableType *pointer = new VariableType("", 2, VariableType::Address, VariableType::Pointer, 0, intType);
+			VariableType *array = new VariableType("", 0, VariableType::Unsigned, VariableType::Array, 9, pointer);
+			dd->addVariableType(intType);
+			dd->addVariableType(pointer);
+			dd->addVariableType(array);
+
+			DwarfSubprogram *main = new DwarfSubprogram("main", 0xc010, 0xc050, 0, expression("\x71\x04", 2));
+			DwarfVariable *argc = new DwarfVariable(intType, "argc", 0, expression("\x91\x7e", 2));
+			main->addArg(argc);
+			DwarfLocationList *ll = new DwarfLocationList();
+			ll->append(new DwarfLocation(expression("\x5c", 1), 0xc010, 0xc020));
+			ll->append(new DwarfLocation(0, 0xc020, 0xc030));
+			main->addVariable(new DwarfVariable(pointer, "p", ll, 0));
+			main->addVariable(new DwarfVariable(array, "buffer", 0, expression("\x03\x00\x02", 3)));
+			main->addVariable(new DwarfVariable(0, "unknown", 0, 0));
+			dd->addSubprogram("main.c", main);
+
+			ll = new DwarfLocationList();
+			ll->append(new DwarfLocation(expression("\x71\x02", 2), 0xe000, 0xe004));
+			dd->addSubprogram("util.c", new DwarfSubprogram("util", 0xe000, 0xe020, ll, 0));
+			dd->addSubprogram("util.c", new DwarfSubprogram("helper", 0xe020, 0xe030, 0, 0));
+
+			dd->addLine("/src/main.c", 10, 0xc010);
+			dd->addLine("/src/main.c", 11, 0xc014);
+			dd->addLine("/src/defs.h", 3, 0xc01a);
+			dd->addLine("/src/main.c", 0, 0xc050);
+			dd->addLine("util.c", 1, 0xe000);
+			return dd;
+		}
+
+		void debugDataRoundTrip() {
+			DwarfDebugData *expected = buildDebugData();
+			DwarfCache cache(elf, dir);
+			CPPUNIT_ASSERT(!cache.loadDebugData());
+			cache.saveDebugData(expected);
+			DwarfDebugData *dd = cache.loadDebugData();
+			CPPUNIT_ASSERT(dd);
+
+			const QList<VariableType *> &types1 = expected->getVariableTypes();
+			const QList<VariableType *> &types2 = dd->getVariableTypes();
+			CPPUNIT_ASSERT_EQUAL(types1.size(), types2.size());
+			for (int i = 0; i < types1.size(); ++i) {
+				CPPUNIT_ASSERT(types1[i]->getName() == types2[i]->getName());
+				CPPUNIT_ASSERT_EQUAL(types1[i]->getByteSize(), types2[i]->getByteSize());
+				CPPUNIT_ASSERT_EQUAL(types1[i]->getEncoding(), types2[i]->getEncoding());
+				CPPUNIT_ASSERT_EQUAL(types1[i]->getType(), types2[i]->getType());
+				CPPUNIT_ASSERT_EQUAL(types1[i]->getUpperBound(), types2[i]->getUpperBound());
+				CPPUNIT_ASSERT_EQUAL(types1.indexOf(types1[i]->getSubtype()), types2.indexOf(types2[i]->getSubtype()));
+			}
+
+			const QMap<QString, Subprograms> &s1 = expected->getAllSubprograms();
+			const QMap<QString, Subprograms> &s2 = dd->getAllSubprograms();
+			CPPUNIT_ASSERT_EQUAL(s1.size(), s2.size());
+			for (QMap<QString, Subprograms>::const_iterator it = s1.begin(); it != s1.end(); ++it) {
+				CPPUNIT_ASSERT(s2.contains(it.key()));
+				const Subprograms &subprograms = s2[it.key()];
+				CPPUNIT_ASSERT_EQUAL(it.value().size(), subprograms.size());
+				for (int i = 0; i < subprograms.size(); ++i) {
+					DwarfSubprogram *p1 = static_cast<DwarfSubprogram *>(it.value()[i]);
+					DwarfSubprogram *p2 = static_cast<DwarfSubprogram *>(subprograms[i]);
+					CPPUNIT_ASSERT(p1->getName() == p2->getName());
+					CPPUNIT_ASSERT_EQUAL(p1->getPCLow(), p2->getPCLow());
+					CPPUNIT_ASSERT_EQUAL(p1->getPCHigh(), p2->getPCHigh());
+					compareLocationLists(p1->getLocationList(), p2->getLocationList());
+					compareExpressions(p1->getExpression(), p2->getExpression());
+
+					CPPUNIT_ASSERT_EQUAL(p1->getVariables().size(), p2->getVariables().size());
+					CPPUNIT_ASSERT_EQUAL(p1->getArgs().size(), p2->getArgs().size());
+					for (int v = 0; v < p1->getVariables().size(); ++v) {
+						DwarfVariable *v1 = static_cast<DwarfVariable *>(p1->getVariables()[v]);
+						DwarfVariable *v2 = static_cast<DwarfVariable *>(p2->getVariables()[v]);
+						CPPUNIT_ASSERT(v1->getName() == v2->getName());
+						CPPUNIT_ASSERT_EQUAL(types1.indexOf(v1->getType()), types2.indexOf(v2->getType()));
+						CPPUNIT_ASSERT_EQUAL(p1->getArgs().contains(v1), p2->getArgs().contains(v2));
+						compareLocationLists(v1->getLocationList(), v2->getLocationList());
+						compareExpressions(v1->getExpression(), v2->getExpression());
+					}
+				}
+			}
+
+			CPPUNIT_ASSERT_EQUAL(expected->getLines().size(), dd->getLines().size());
+			for (int pc = 0xc000; pc < 0xe040; ++pc) {
+				QString file1, file2;
+				CPPUNIT_ASSERT_EQUAL(expected->getLine(pc, file1), dd->getLine(pc, file2));
+				CPPUNIT_ASSERT(file1 == file2);
+			}
+			CPPUNIT_ASSERT(dd->getSubprogram(0xe024) == s2["util.c"][1]);
+
+			delete expected;
+			delete dd;
+		}
+
+		void disassembledCodeRoundTrip() {
+			DisassembledFiles expected;
+			expected["main.c"].append(DisassembledLine(0, 0, DisassembledLine::Section, ".text"));
+			expected["main.c"].append(DisassembledLine(0xc010, 10, DisassembledLine::Code, "int main() {"));
+			expected["main.c"].append(DisassembledLine(0xc010, 10, DisassembledLine::Instruction, "push r4"));
+			expected["util.c"].append(DisassembledLine(0xe000, 1, DisassembledLine::Instruction, "ret"));
+			expected["empty.c"];
+
+			DwarfCache cache(elf, dir);
+			DisassembledFiles files;
+			CPPUNIT_ASSERT(!cache.loadDisassembledCode(files));
+			cache.saveDisassembledCode(expected);
+			CPPUNIT_ASSERT(cache.loadDisassembledCode(files));
+
+			CPPUNIT_ASSERT_EQUAL(expected.size(), files.size());
+			for (DisassembledFiles::const_iterator it = expected.begin(); it != expected.end(); ++it) {
+				CPPUNIT_ASSERT(files.contains(it.key()));
+				const DisassembledCode &code = files[it.key()];
+				CPPUNIT_ASSERT_EQUAL(it.value().size(), code.size());
+				for (int i = 0; i < code.size(); ++i) {
+					CPPUNIT_ASSERT_EQUAL(it.value()[i].getAddr(), code[i].getAddr());
+					CPPUNIT_ASSERT_EQUAL(it.value()[i].getLineNumber(), code[i].getLineNumber());
+					CPPUNIT_ASSERT_EQUAL(it.value()[i].getType(), code[i].getType());
+					CPPUNIT_ASSERT(it.value()[i].getData() == code[i].getData());
+				}
+			}
+		}
+
+		void invalidHeader() {
+			DwarfDebugData *dd = buildDebugData();
+			DwarfCache cache(elf, dir);
+			cache.saveDebugData(dd);
+			delete dd;
+
+			QString debug = path(elf, ".debug");
+			QByteArray data = readFile(debug);
+
+			// magic, version, payload size and the hash of the ELF file
+			const int offsets[] = {0, 7, 11, 12, 31};
+			for (int i = 0; i < 5; ++i) {
+				QByteArray corrupted = data;
+				corrupted[offsets[i]] = corrupted[offsets[i]] ^ 0x01;
+				writeFile(debug, corrupted);
+				CPPUNIT_ASSERT(!cache.loadDebugData());
+			}
+
+			// Truncated payload and the file without the whole header
+			writeFile(debug, data.left(data.size() - 1));
+			CPPUNIT_ASSERT(!cache.loadDebugData());
+			writeFile(debug, data.left(20));
+			CPPUNIT_ASSERT(!cache.loadDebugData());
+
+			// Counts larger than the rest of the payload
+			QByteArray corrupted = data;
+			corrupted[32] = 0x7f;
+			writeFile(debug, corrupted);
+			CPPUNIT_ASSERT(!cache.loadDebugData());
+
+			writeFile(debug, data);
+			dd = cache.loadDebugData();
+			CPPUNIT_ASSERT(dd);
+			delete dd;
+		}
+
+		void staleHash() {
+			DwarfDebugData *dd = buildDebugData();
+			DisassembledFiles files;
+			files["main.c"].append(DisassembledLine(0xc010, 10, DisassembledLine::Instruction, "push r4"));
+			DwarfCache cache(elf, dir);
+			cache.saveDebugData(dd);
+			cache.saveDisassembledCode(files);
+			delete dd;
+
+			// Cache files of other ELF file copied under the name of this one
+			DwarfCache other(otherElf, dir);
+			CPPUNIT_ASSERT(QFile::copy(path(elf, ".debug"), path(otherElf, ".debug")));
+			CPPUNIT_ASSERT(QFile::copy(path(elf, ".code"), path(otherElf, ".code")));
+			CPPUNIT_ASSERT(!other.loadDebugData());
+			DisassembledFiles loaded;
+			CPPUNIT_ASSERT(!other.loadDisassembledCode(loaded));
+			CPPUNIT_ASSERT(loaded.isEmpty());
+		}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (DwarfCacheTest);
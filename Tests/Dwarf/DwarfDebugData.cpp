@@ -0,0 +1,147 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "Dwarf/DwarfDebugData.h"
+#include "Dwarf/DwarfSubprogram.h"
+
+class DwarfDebugDataTest : public CPPUNIT_NS :: TestFixture{
+	CPPUNIT_TEST_SUITE(DwarfDebugDataTest);
+	CPPUNIT_TEST(subprogramLookup);
+	CPPUNIT_TEST(lineLookup);
+	CPPUNIT_TEST(indexInvalidation);
+	CPPUNIT_TEST_SUITE_END();
+
+	DwarfDebugData *dd;
+
+	public:
+		void setUp (void) {
+			dd = new DwarfDebugData();
+		}
+
+		void tearDown (void) {
+			delete dd;
+		}
+
+		Subprogram *add(const QString &file, uint16_t pcLow, uint16_t pcHigh) {
+			DwarfSubprogram *s = new DwarfSubprogram(file, pcLow, pcHigh, 0, 0);
+			dd->addSubprogram(file, s);
+			return s;
+		}
+
+		/// The linear search getSubprogram(pc) did before the lookup table.
+		Subprogram *linearSubprogram(uint16_t pc) {
+			const QMap<QString, Subprograms> &subprograms = dd->getAllSubprograms();
+			QMap<QString, Subprograms>::const_iterator i = subprograms.begin();
+			while (i != subprograms.end()) {
+				foreach(Subprogram *s, i.value()) {
+					if (pc >= s->getPCLow() && pc < s->getPCHigh()) {
+						return s;
+					}
+				}
+				++i;
+			}
+
+			return 0;
+		}
+
+		/// The map search getLine() did before the lookup table.
+		int mapLine(uint16_t pc, QString &file) {
+			const QMap<uint16_t, DwarfDebugData::Line> &lines = dd->getLines();
+			QMap<uint16_t, DwarfDebugData::Line>::const_iterator it = lines.upperBound(pc);
+			if (it == lines.constBegin()) {
+				return 0;
+			}
+
+			--it;
+			file = it.value().file;
+			return it.value().line;
+		}
+
+		void compareAll() {
+			for (uint32_t pc = 0; pc < 0x10000; ++pc) {
+				CPPUNIT_ASSERT(dd->getSubprogram(pc) == linearSubprogram(pc));
+
+				QString file1 = "none";
+				QString file2 = "none";
+				CPPUNIT_ASSERT_EQUAL(mapLine(pc, file1), dd->getLine(pc, file2));
+				CPPUNIT_ASSERT(file1 == file2);
+			}
+		}
+
+		void subprogramLookup() {
+			// Files are added out of their map order, so the file order
+			// decides which of the overlapping subprograms wins
+			Subprogram *overlapping = add("b.c", 0x1008, 0x1020);
+			Subprogram *adjacent = add("b.c", 0x1020, 0x1030);
+			Subprogram *outer = add("a.c", 0x1000, 0x1010);
+			// Nested in the previous one which is found first
+			add("a.c", 0x1004, 0x1008);
+			Subprogram *first = add("c.c", 0x0000, 0x0002);
+			Subprogram *last = add("c.c", 0xff00, 0xffff);
+			add("c.c", 0xfffe, 0xffff);
+			add("c.c", 0x2000, 0x2000);
+			add("c.c", 0x3000, 0x2ff0);
+
+			CPPUNIT_ASSERT(dd->getSubprogram(0x0fff) == 0);
+			CPPUNIT_ASSERT(dd->getSubprogram(0x1004) == outer);
+			CPPUNIT_ASSERT(dd->getSubprogram(0x100f) == outer);
+			CPPUNIT_ASSERT(dd->getSubprogram(0x1010) == overlapping);
+			CPPUNIT_ASSERT(dd->getSubprogram(0x1020) == adjacent);
+			CPPUNIT_ASSERT(dd->getSubprogram(0x1030) == 0);
+			CPPUNIT_ASSERT(dd->getSubprogram(0x0000) == first);
+			CPPUNIT_ASSERT(dd->getSubprogram(0xfffe) == last);
+			CPPUNIT_ASSERT(dd->getSubprogram(0xffff) == 0);
+			CPPUNIT_ASSERT(dd->getSubprogram("a.c", 0x1006) == outer);
+			CPPUNIT_ASSERT(dd->getSubprogram("b.c", 0x100a) == overlapping);
+
+			// Every pcLow - 1, pcLow, pcHigh - 1 and pcHigh is covered
+			compareAll();
+		}
+
+		void lineLookup() {
+			dd->addLine("main.c", 1, 0x0000);
+			dd->addLine("main.c", 10, 0x1000);
+			dd->addLine("defs.h", 3, 0x1004);
+			dd->addLine("main.c", 11, 0x1006);
+			// End of the sequence, rewritten by the row of the next one
+			dd->addLine("main.c", 0, 0x1010);
+			dd->addLine("util.c", 20, 0x1010);
+			dd->addLine("util.c", 0, 0x1020);
+			dd->addLine("util.c", 30, 0xffff);
+
+			QString file;
+			CPPUNIT_ASSERT_EQUAL(3, dd->getLine(0x1005, file));
+			CPPUNIT_ASSERT(file == "defs.h");
+			CPPUNIT_ASSERT_EQUAL(20, dd->getLine(0x1010, file));
+			CPPUNIT_ASSERT(file == "util.c");
+			CPPUNIT_ASSERT_EQUAL(30, dd->getLine(0xffff, file));
+
+			compareAll();
+		}
+
+		void indexInvalidation() {
+			Subprogram *main = add("main.c", 0x1000, 0x1010);
+			dd->addLine("main.c", 10, 0x1004);
+			QString file;
+			CPPUNIT_ASSERT(dd->getSubprogram(0x0fff) == 0);
+			CPPUNIT_ASSERT_EQUAL(0, dd->getLine(0x1000, file));
+			CPPUNIT_ASSERT_EQUAL(10, dd->getLine(0x1008, file));
+
+			// Lookups after the data change see the new entries
+			Subprogram *before = add("a.c", 0x0ff0, 0x1008);
+			CPPUNIT_ASSERT(dd->getSubprogram(0x0fff) == before);
+			CPPUNIT_ASSERT(dd->getSubprogram(0x1004) == before);
+			CPPUNIT_ASSERT(dd->getSubprogram(0x1008) == main);
+
+			dd->addLine("a.c", 5, 0x0ff0);
+			dd->addLine("main.c", 12, 0x1008);
+			CPPUNIT_ASSERT_EQUAL(5, dd->getLine(0x1000, file));
+			CPPUNIT_ASSERT(file == "a.c");
+			CPPUNIT_ASSERT_EQUAL(12, dd->getLine(0x1008, file));
+			CPPUNIT_ASSERT(file == "main.c");
+
+			compareAll();
+		}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (DwarfDebugDataTest);
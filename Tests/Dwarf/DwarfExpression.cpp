@@ -0,0 +1,308 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "ElfFixture.h"
+#include "Dwarf/DwarfExpression.h"
+#include "Dwarf/DwarfSubprogram.h"
+#include "Dwarf/dwarf.h"
+#include "CPU/Memory/Memory.h"
+#include "CPU/Memory/RegisterSet.h"
+#include "CPU/Memory/Register.h"
+
+class DwarfExpressionTest : public CPPUNIT_NS :: TestFixture{
+	CPPUNIT_TEST_SUITE(DwarfExpressionTest);
+	CPPUNIT_TEST(constants);
+	CPPUNIT_TEST(arithmetic);
+	CPPUNIT_TEST(stackOperations);
+	CPPUNIT_TEST(registers);
+	CPPUNIT_TEST(memory);
+	CPPUNIT_TEST(frameBase);
+	CPPUNIT_TEST(branches);
+	CPPUNIT_TEST(pieces);
+	CPPUNIT_TEST(stackOverflow);
+	CPPUNIT_TEST(stackUnderflow);
+	CPPUNIT_TEST(divisionByZero);
+	CPPUNIT_TEST(invalidCode);
+	CPPUNIT_TEST_SUITE_END();
+
+	MSP430::Memory *m;
+	MSP430::RegisterSet *r;
+
+	public:
+		void setUp (void) {
+			m = new MSP430::Memory(120000);
+			r = new MSP430::RegisterSet;
+			r->addDefaultRegisters();
+			r->getp(1)->setBigEndian(0x0400);
+			r->getp(4)->setBigEndian(0x0300);
+			r->getp(5)->setBigEndian(0x1234);
+			r->getp(15)->setBigEndian(0xfffe);
+		}
+
+		void tearDown (void) {
+			delete m;
+			delete r;
+		}
+
+		VariableValue evaluate(const ByteWriter &code, bool &isAddress, DwarfSubprogram *s = 0) {
+			DwarfExpression expr((const uint8_t *) code.data().constData(), code.size(), 2);
+			return expr.getValue(r, m, s, 0, isAddress);
+		}
+
+		bool fails(const ByteWriter &code) {
+			bool isAddress;
+			return evaluate(code, isAddress).isEmpty();
+		}
+
+		/// Evaluates the expression without pieces and returns its result.
+		uint32_t value(const ByteWriter &code, bool isAddress = false) {
+			bool address;
+			VariableValue v = evaluate(code, address);
+			CPPUNIT_ASSERT_EQUAL(1, v.size());
+			CPPUNIT_ASSERT_EQUAL(isAddress, address);
+			CPPUNIT_ASSERT_EQUAL(isAddress, v[0].isAddress());
+			CPPUNIT_ASSERT_EQUAL((uint8_t) 0, v[0].getPieceSize());
+			return v[0].getData();
+		}
+
+		void constants() {
+			CPPUNIT_ASSERT_EQUAL(31u, value(ByteWriter().u8(DW_OP_lit31)));
+			CPPUNIT_ASSERT_EQUAL(0xffu, value(ByteWriter().u8(DW_OP_const1u).u8(0xff)));
+			CPPUNIT_ASSERT_EQUAL((uint32_t) -1, value(ByteWriter().u8(DW_OP_const1s).u8(0xff)));
+			CPPUNIT_ASSERT_EQUAL(0xfffeu, value(ByteWriter().u8(DW_OP_const2u).u16(0xfffe)));
+			CPPUNIT_ASSERT_EQUAL((uint32_t) -2, value(ByteWriter().u8(DW_OP_const2s).u16(0xfffe)));
+			CPPUNIT_ASSERT_EQUAL(0x12345678u, value(ByteWriter().u8(DW_OP_const4u).u32(0x12345678)));
+			CPPUNIT_ASSERT_EQUAL(0x9abcdef0u, value(ByteWriter().u8(DW_OP_const8u).u64(0x123456789abcdef0ULL)));
+			CPPUNIT_ASSERT_EQUAL(300u, value(ByteWriter().u8(DW_OP_constu).uleb(300)));
+			CPPUNIT_ASSERT_EQUAL((uint32_t) -300, value(ByteWriter().u8(DW_OP_consts).sleb(-300)));
+			CPPUNIT_ASSERT_EQUAL(7u, value(ByteWriter().u8(DW_OP_nop).u8(DW_OP_lit7).u8(DW_OP_nop)));
+
+			// DW_OP_addr pushes an address of the size given by the unit
+			CPPUNIT_ASSERT_EQUAL(0x0200u, value(ByteWriter().u8(DW_OP_addr).u16(0x0200), true));
+		}
+
+		uint32_t binary(int32_t a, int32_t b, uint8_t op) {
+			return value(ByteWriter().u8(DW_OP_consts).sleb(a).u8(DW_OP_consts).sleb(b).u8(op));
+		}
+
+		void arithmetic() {
+			CPPUNIT_ASSERT_EQUAL(0x0c0u, binary(0x0f0, 0xfcc, DW_OP_and));
+			CPPUNIT_ASSERT_EQUAL(0xffcu, binary(0x0f0, 0xfcc, DW_OP_or));
+			CPPUNIT_ASSERT_EQUAL(0xf3cu, binary(0x0f0, 0xfcc, DW_OP_xor));
+			CPPUNIT_ASSERT_EQUAL(5u, binary(7, -2, DW_OP_plus));
+			CPPUNIT_ASSERT_EQUAL((uint32_t) -9, binary(-7, 2, DW_OP_minus));
+			CPPUNIT_ASSERT_EQUAL((uint32_t) -14, binary(-7, 2, DW_OP_mul));
+			CPPUNIT_ASSERT_EQUAL((uint32_t) -3, binary(-7, 2, DW_OP_div));
+			CPPUNIT_ASSERT_EQUAL((uint32_t) -1, binary(-7, 2, DW_OP_mod));
+			CPPUNIT_ASSERT_EQUAL(0x50u, binary(5, 4, DW_OP_shl));
+			CPPUNIT_ASSERT_EQUAL(0u, binary(5, 32, DW_OP_shl));
+			CPPUNIT_ASSERT_EQUAL(0x7ffffffcu, binary(-8, 1, DW_OP_shr));
+			CPPUNIT_ASSERT_EQUAL((uint32_t) -4, binary(-8, 1, DW_OP_shra));
+			CPPUNIT_ASSERT_EQUAL((uint32_t) -1, binary(-8, 40, DW_OP_shra));
+
+			// Comparisons are signed
+			CPPUNIT_ASSERT_EQUAL(1u, binary(-1, -1, DW_OP_eq));
+			CPPUNIT_ASSERT_EQUAL(0u, binary(-1, -1, DW_OP_ne));
+			CPPUNIT_ASSERT_EQUAL(1u, binary(-1, 1, DW_OP_lt));
+			CPPUNIT_ASSERT_EQUAL(1u, binary(1, 1, DW_OP_le));
+			CPPUNIT_ASSERT_EQUAL(0u, binary(-1, 1, DW_OP_gt));
+			CPPUNIT_ASSERT_EQUAL(1u, binary(1, 1, DW_OP_ge));
+
+			CPPUNIT_ASSERT_EQUAL(5u, value(ByteWriter().u8(DW_OP_consts).sleb(-5).u8(DW_OP_abs)));
+			CPPUNIT_ASSERT_EQUAL((uint32_t) -5, value(ByteWriter().u8(DW_OP_lit5).u8(DW_OP_neg)));
+			CPPUNIT_ASSERT_EQUAL(~5u, value(ByteWriter().u8(DW_OP_lit5).u8(DW_OP_not)));
+			CPPUNIT_ASSERT_EQUAL(305u, value(ByteWriter().u8(DW_OP_lit5).u8(DW_OP_plus_uconst).uleb(300)));
+		}
+
+		void stackOperations() {
+			// Result is the top of the stack
+			CPPUNIT_ASSERT_EQUAL(2u, value(ByteWriter().u8(DW_OP_lit1).u8(DW_OP_lit2)));
+			CPPUNIT_ASSERT_EQUAL(4u, value(ByteWriter().u8(DW_OP_lit2).u8(DW_OP_dup).u8(DW_OP_plus)));
+			CPPUNIT_ASSERT_EQUAL(1u, value(ByteWriter().u8(DW_OP_lit1).u8(DW_OP_lit2).u8(DW_OP_drop)));
+			CPPUNIT_ASSERT_EQUAL(1u, value(ByteWriter().u8(DW_OP_lit1).u8(DW_OP_lit2).u8(DW_OP_over)));
+			CPPUNIT_ASSERT_EQUAL(1u, value(ByteWriter().u8(DW_OP_lit1).u8(DW_OP_lit2).u8(DW_OP_lit3).u8(DW_OP_pick).u8(2)));
+			CPPUNIT_ASSERT_EQUAL(3u, value(ByteWriter().u8(DW_OP_lit1).u8(DW_OP_lit2).u8(DW_OP_lit3).u8(DW_OP_pick).u8(0)));
+			CPPUNIT_ASSERT_EQUAL(1u, value(ByteWriter().u8(DW_OP_lit1).u8(DW_OP_lit2).u8(DW_OP_swap)));
+
+			// 1 2 3 -> 3 1 2
+			ByteWriter rot;
+			rot.u8(DW_OP_lit1).u8(DW_OP_lit2).u8(DW_OP_lit3).u8(DW_OP_rot);
+			CPPUNIT_ASSERT_EQUAL(2u, value(rot));
+			CPPUNIT_ASSERT_EQUAL(1u, value(ByteWriter(rot).u8(DW_OP_drop)));
+			CPPUNIT_ASSERT_EQUAL(3u, value(ByteWriter(rot).u8(DW_OP_drop).u8(DW_OP_drop)));
+		}
+
+		void registers() {
+			CPPUNIT_ASSERT_EQUAL(0x1234u, value(ByteWriter().u8(DW_OP_reg5)));
+			CPPUNIT_ASSERT_EQUAL(0xfffeu, value(ByteWriter().u8(DW_OP_regx).uleb(15)));
+			CPPUNIT_ASSERT_EQUAL(0x03feu, value(ByteWriter().u8(DW_OP_breg1).sleb(-2), true));
+			CPPUNIT_ASSERT_EQUAL(0x0306u, value(ByteWriter().u8(DW_OP_bregx).uleb(4).sleb(6), true));
+
+			// MSP430 has only 16 registers
+			CPPUNIT_ASSERT(fails(ByteWriter().u8(DW_OP_reg16)));
+			CPPUNIT_ASSERT(fails(ByteWriter().u8(DW_OP_bregx).uleb(200).sleb(0)));
+			CPPUNIT_ASSERT(fails(ByteWriter().u8(DW_OP_regx).uleb(0x100)));
+		}
+
+		void memory() {
+			m->setBigEndian(0x0200, 0x1234);
+			m->setBigEndian(0x0202, 0xabcd);
+
+			CPPUNIT_ASSERT_EQUAL(0x1234u, value(ByteWriter().u8(DW_OP_addr).u16(0x0200).u8(DW_OP_deref)));
+			CPPUNIT_ASSERT_EQUAL(0x34u, value(ByteWriter().u8(DW_OP_addr).u16(0x0200).u8(DW_OP_deref_size).u8(1)));
+			CPPUNIT_ASSERT_EQUAL(0x1234u, value(ByteWriter().u8(DW_OP_addr).u16(0x0200).u8(DW_OP_deref_size).u8(2)));
+			CPPUNIT_ASSERT_EQUAL(0xabcd1234u, value(ByteWriter().u8(DW_OP_addr).u16(0x0200).u8(DW_OP_deref_size).u8(4)));
+			CPPUNIT_ASSERT(fails(ByteWriter().u8(DW_OP_addr).u16(0x0200).u8(DW_OP_deref_size).u8(3)));
+
+			// Pointer stored in the stack frame
+			m->setBigEndian(0x03fe, 0x0202);
+			CPPUNIT_ASSERT_EQUAL(0xabcdu, value(ByteWriter().u8(DW_OP_breg1).sleb(-2).u8(DW_OP_deref).u8(DW_OP_deref)));
+
+			// The value is the result of the expression, not its address
+			CPPUNIT_ASSERT_EQUAL(0x0400u, value(ByteWriter().u8(DW_OP_breg1).sleb(0).u8(DW_OP_stack_value)));
+		}
+
+		void frameBase() {
+			ByteWriter base;
+			base.u8(DW_OP_breg1).sleb(4);
+			DwarfSubprogram s("f", 0xc000, 0xc010, 0, new DwarfExpression((const uint8_t *) base.data().constData(), base.size(), 2));
+
+			bool isAddress;
+			VariableValue v = evaluate(ByteWriter().u8(DW_OP_fbreg).sleb(-2), isAddress, &s);
+			CPPUNIT_ASSERT_EQUAL(1, v.size());
+			CPPUNIT_ASSERT_EQUAL(0x0402u, v[0].getData());
+			CPPUNIT_ASSERT(isAddress);
+
+			// Frame base is known only inside the subprogram
+			CPPUNIT_ASSERT(fails(ByteWriter().u8(DW_OP_fbreg).sleb(-2)));
+		}
+
+		void branches() {
+			// lit1; skip over lit2; lit3; plus
+			CPPUNIT_ASSERT_EQUAL(4u, value(ByteWriter().u8(DW_OP_lit1).u8(DW_OP_skip).u16(1).u8(DW_OP_lit2).u8(DW_OP_lit3).u8(DW_OP_plus)));
+
+			// Branch is taken only if the popped value is not zero
+			CPPUNIT_ASSERT_EQUAL(4u, value(ByteWriter().u8(DW_OP_lit4).u8(DW_OP_lit1).u8(DW_OP_bra).u16(1).u8(DW_OP_lit6)));
+			CPPUNIT_ASSERT_EQUAL(6u, value(ByteWriter().u8(DW_OP_lit4).u8(DW_OP_lit0).u8(DW_OP_bra).u16(1).u8(DW_OP_lit6)));
+
+			// Branch right after the last operation
+			CPPUNIT_ASSERT_EQUAL(4u, value(ByteWriter().u8(DW_OP_lit4).u8(DW_OP_skip).u16(1).u8(DW_OP_lit6)));
+
+			// Counts 3 down to 0: dup; bra to the loop body; skip to the end;
+			// body: lit1; minus; skip back to dup
+			ByteWriter loop;
+			loop.u8(DW_OP_lit3);
+			loop.u8(DW_OP_dup).u8(DW_OP_bra).u16(3);
+			loop.u8(DW_OP_skip).u16(5);
+			loop.u8(DW_OP_lit1).u8(DW_OP_minus).u8(DW_OP_skip).u16(-12);
+			CPPUNIT_ASSERT_EQUAL(0u, value(loop));
+
+			// Infinite loop is stopped
+			CPPUNIT_ASSERT(fails(ByteWriter().u8(DW_OP_lit1).u8(DW_OP_skip).u16(-3)));
+
+			// Branch into the middle of an operation
+			CPPUNIT_ASSERT(fails(ByteWriter().u8(DW_OP_skip).u16(1).u8(DW_OP_const1u).u8(1)));
+			// Branch outside of the expression
+			CPPUNIT_ASSERT(fails(ByteWriter().u8(DW_OP_lit1).u8(DW_OP_skip).u16(10)));
+			// Branch without the condition
+			CPPUNIT_ASSERT(fails(ByteWriter().u8(DW_OP_bra).u16(0)));
+		}
+
+		void pieces() {
+			// Variable split into the register and the memory. The last piece
+			// is the first one in the value, so it is the most significant.
+			bool isAddress;
+			VariableValue v = evaluate(ByteWriter().u8(DW_OP_reg5).u8(DW_OP_piece).uleb(2)
+				.u8(DW_OP_addr).u16(0x0200).u8(DW_OP_piece).uleb(2), isAddress);
+			CPPUNIT_ASSERT_EQUAL(2, v.size());
+			CPPUNIT_ASSERT_EQUAL(0x0200u, v[0].getData());
+			CPPUNIT_ASSERT(v[0].isAddress());
+			CPPUNIT_ASSERT_EQUAL((uint8_t) 2, v[0].getPieceSize());
+			CPPUNIT_ASSERT_EQUAL(0x1234u, v[1].getData());
+			CPPUNIT_ASSERT(!v[1].isAddress());
+			CPPUNIT_ASSERT_EQUAL((uint8_t) 2, v[1].getPieceSize());
+
+			// Values left on the stack after the last piece are not used
+			v = evaluate(ByteWriter().u8(DW_OP_lit1).u8(DW_OP_lit2).u8(DW_OP_piece).uleb(1), isAddress);
+			CPPUNIT_ASSERT_EQUAL(1, v.size());
+			CPPUNIT_ASSERT_EQUAL(2u, v[0].getData());
+			CPPUNIT_ASSERT_EQUAL((uint8_t) 1, v[0].getPieceSize());
+
+			CPPUNIT_ASSERT(fails(ByteWriter().u8(DW_OP_piece).uleb(2)));
+		}
+
+		void stackOverflow() {
+			ByteWriter code;
+			for (int i = 0; i < 64; ++i) {
+				code.u8(DW_OP_lit1);
+			}
+			CPPUNIT_ASSERT_EQUAL(1u, value(code));
+
+			code.u8(DW_OP_lit1);
+			CPPUNIT_ASSERT(fails(code));
+
+			// Every pushing operation checks the stack
+			ByteWriter dup;
+			dup.u8(DW_OP_lit1);
+			for (int i = 0; i < 64; ++i) {
+				dup.u8(DW_OP_dup);
+			}
+			CPPUNIT_ASSERT(fails(dup));
+
+			ByteWriter over;
+			over.u8(DW_OP_lit1).u8(DW_OP_lit2);
+			for (int i = 0; i < 63; ++i) {
+				over.u8(DW_OP_over);
+			}
+			CPPUNIT_ASSERT(fails(over));
+
+			ByteWriter reg;
+			for (int i = 0; i < 65; ++i) {
+				reg.u8(DW_OP_breg1).sleb(i);
+			}
+			CPPUNIT_ASSERT(fails(reg));
+		}
+
+		void stackUnderflow() {
+			CPPUNIT_ASSERT(fails(ByteWriter()));
+			CPPUNIT_ASSERT(fails(ByteWriter().u8(DW_OP_deref)));
+			CPPUNIT_ASSERT(fails(ByteWriter().u8(DW_OP_lit1).u8(DW_OP_drop)));
+			CPPUNIT_ASSERT(fails(ByteWriter().u8(DW_OP_lit1).u8(DW_OP_plus)));
+			CPPUNIT_ASSERT(fails(ByteWriter().u8(DW_OP_lit1).u8(DW_OP_swap)));
+			CPPUNIT_ASSERT(fails(ByteWriter().u8(DW_OP_lit1).u8(DW_OP_over)));
+			CPPUNIT_ASSERT(fails(ByteWriter().u8(DW_OP_lit1).u8(DW_OP_lit2).u8(DW_OP_rot)));
+			CPPUNIT_ASSERT(fails(ByteWriter().u8(DW_OP_lit1).u8(DW_OP_pick).u8(1)));
+			CPPUNIT_ASSERT(fails(ByteWriter().u8(DW_OP_lit1).u8(DW_OP_pick).u8(0xff)));
+		}
+
+		void divisionByZero() {
+			CPPUNIT_ASSERT(fails(ByteWriter().u8(DW_OP_lit4).u8(DW_OP_lit0).u8(DW_OP_div)));
+			CPPUNIT_ASSERT(fails(ByteWriter().u8(DW_OP_lit4).u8(DW_OP_lit0).u8(DW_OP_mod)));
+			CPPUNIT_ASSERT(fails(ByteWriter().u8(DW_OP_lit0).u8(DW_OP_lit0).u8(DW_OP_div)));
+			CPPUNIT_ASSERT_EQUAL(0u, binary(0, 4, DW_OP_div));
+
+			// Division of the lowest value by -1 overflows
+			CPPUNIT_ASSERT_EQUAL(0x80000000u, binary((int32_t) 0x80000000, -1, DW_OP_div));
+			CPPUNIT_ASSERT_EQUAL(0u, binary((int32_t) 0x80000000, -1, DW_OP_mod));
+			CPPUNIT_ASSERT_EQUAL((uint32_t) -7, binary(7, -1, DW_OP_div));
+			CPPUNIT_ASSERT_EQUAL(0u, binary(7, -1, DW_OP_mod));
+		}
+
+		void invalidCode() {
+			// Unsupported operation
+			CPPUNIT_ASSERT(fails(ByteWriter().u8(DW_OP_lit1).u8(DW_OP_call2).u16(0)));
+			// Operand missing at the end of the expression
+			CPPUNIT_ASSERT(fails(ByteWriter().u8(DW_OP_const2u).u8(0x12)));
+			CPPUNIT_ASSERT(fails(ByteWriter().u8(DW_OP_addr).u8(0x00)));
+			CPPUNIT_ASSERT(fails(ByteWriter().u8(DW_OP_constu).u8(0x80)));
+
+			// The code is kept for the cache even if it is not valid
+			ByteWriter code;
+			code.u8(DW_OP_call2).u16(0);
+			DwarfExpression expr((const uint8_t *) code.data().constData(), code.size(), 2);
+			CPPUNIT_ASSERT(expr.getCode() == code.data());
+			CPPUNIT_ASSERT_EQUAL((uint8_t) 2, expr.getAddressSize());
+		}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (DwarfExpressionTest);
@@ -0,0 +1,518 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "ElfFixture.h"
+#include "Dwarf/DwarfLoader.h"
+#include "Dwarf/DwarfDebugData.h"
+#include "Dwarf/DwarfSubprogram.h"
+#include "Dwarf/DwarfVariable.h"
+#include "Dwarf/DwarfLocation.h"
+#include "Dwarf/DwarfLocationList.h"
+#include "Dwarf/DwarfExpression.h"
+#include "Dwarf/ElfFile.h"
+#include "Dwarf/dwarf.h"
+#include "CPU/Memory/Memory.h"
+#include "CPU/Memory/RegisterSet.h"
+#include "CPU/Memory/Register.h"
+#include "CPU/Instructions/InstructionDecoder.h"
+#include "CodeUtil.h"
+
+#include <QCryptographicHash>
+#include <QFile>
+#include <QDir>
+
+/// Writes the abbreviation, attributes are the name and form pairs ending
+/// with two zeros.
+static void writeAbbrev(ByteWriter &w, int code, int tag, bool children, const uint16_t *attributes) {
+	w.uleb(code).uleb(tag).u8(children ? DW_CHILDREN_yes : DW_CHILDREN_no);
+	do {
+		w.uleb(attributes[0]).uleb(attributes[1]);
+		attributes += 2;
+	} while (attributes[-2] != 0 || attributes[-1] != 0);
+}
+
+/// Builds the ELF file with two compilation units. The first one is DWARF 4
+/// and the second one DWARF 2 and together they use all the attribute forms
+/// the loader reads.
+static QByteArray buildElf(bool dwarf5Unit = false) {
+	static const uint16_t cu1[] = {DW_AT_name, DW_FORM_strp, DW_AT_comp_dir, DW_FORM_string,
+		DW_AT_low_pc, DW_FORM_addr, DW_AT_high_pc, DW_FORM_data2, DW_AT_stmt_list, DW_FORM_sec_offset, 0, 0};
+	static const uint16_t baseType1[] = {DW_AT_name, DW_FORM_string, DW_AT_byte_size, DW_FORM_data1,
+		DW_AT_encoding, DW_FORM_data1, 0, 0};
+	static const uint16_t pointerType[] = {DW_AT_byte_size, DW_FORM_sdata, DW_AT_type, DW_FORM_ref4, 0, 0};
+	static const uint16_t typedefType[] = {DW_AT_name, DW_FORM_string, DW_AT_type, DW_FORM_ref4, 0, 0};
+	static const uint16_t arrayType[] = {DW_AT_type, DW_FORM_ref4, 0, 0};
+	static const uint16_t subrangeType[] = {DW_AT_upper_bound, DW_FORM_data1, 0, 0};
+	static const uint16_t subprogram1[] = {DW_AT_name, DW_FORM_strp, DW_AT_low_pc, DW_FORM_addr,
+		DW_AT_high_pc, DW_FORM_data4, DW_AT_frame_base, DW_FORM_exprloc, DW_AT_type, DW_FORM_ref4,
+		DW_AT_external, DW_FORM_flag_present, 0, 0};
+	static const uint16_t parameter1[] = {DW_AT_name, DW_FORM_string, DW_AT_type, DW_FORM_ref_udata,
+		DW_AT_location, DW_FORM_exprloc, 0, 0};
+	static const uint16_t variable1[] = {DW_AT_name, DW_FORM_string, DW_AT_type, DW_FORM_ref2,
+		DW_AT_location, DW_FORM_sec_offset, 0, 0};
+	static const uint16_t lexicalBlock[] = {DW_AT_low_pc, DW_FORM_addr, DW_AT_high_pc, DW_FORM_udata, 0, 0};
+	static const uint16_t variable2[] = {DW_AT_name, DW_FORM_indirect, DW_AT_type, DW_FORM_ref1,
+		DW_AT_location, DW_FORM_block1, 0, 0};
+	static const uint16_t declaration[] = {DW_AT_name, DW_FORM_string, DW_AT_declaration, DW_FORM_flag, 0, 0};
+
+	static const uint16_t cu2[] = {DW_AT_name, DW_FORM_string, DW_AT_low_pc, DW_FORM_addr,
+		DW_AT_stmt_list, DW_FORM_data4, 0, 0};
+	static const uint16_t baseType2[] = {DW_AT_name, DW_FORM_string, DW_AT_byte_size, DW_FORM_data8,
+		DW_AT_encoding, DW_FORM_data1, 0, 0};
+	static const uint16_t subprogram2[] = {DW_AT_name, DW_FORM_string, DW_AT_low_pc, DW_FORM_addr,
+		DW_AT_high_pc, DW_FORM_addr, DW_AT_frame_base, DW_FORM_data4, 0, 0};
+	static const uint16_t variable3[] = {DW_AT_name, DW_FORM_string, DW_AT_type, DW_FORM_ref_addr,
+		DW_AT_location, DW_FORM_block2, 0, 0};
+	static const uint16_t parameter2[] = {DW_AT_name, DW_FORM_string, DW_AT_type, DW_FORM_ref_addr,
+		DW_AT_location, DW_FORM_block4, 0, 0};
+	static const uint16_t variable4[] = {DW_AT_name, DW_FORM_string, DW_AT_type, DW_FORM_ref8,
+		DW_AT_location, DW_FORM_block, 0, 0};
+
+	ByteWriter abbrev;
+	writeAbbrev(abbrev, 1, DW_TAG_compile_unit, true, cu1);
+	writeAbbrev(abbrev, 2, DW_TAG_base_type, false, baseType1);
+	writeAbbrev(abbrev, 3, DW_TAG_pointer_type, false, pointerType);
+	writeAbbrev(abbrev, 4, DW_TAG_typedef, false, typedefType);
+	writeAbbrev(abbrev, 5, DW_TAG_array_type, true, arrayType);
+	writeAbbrev(abbrev, 6, DW_TAG_subrange_type, false, subrangeType);
+	writeAbbrev(abbrev, 7, DW_TAG_subprogram, true, subprogram1);
+	writeAbbrev(abbrev, 8, DW_TAG_formal_parameter, false, parameter1);
+	writeAbbrev(abbrev, 9, DW_TAG_variable, false, variable1);
+	writeAbbrev(abbrev, 10, DW_TAG_lexical_block, true, lexicalBlock);
+	writeAbbrev(abbrev, 11, DW_TAG_variable, false, variable2);
+	writeAbbrev(abbrev, 12, DW_TAG_subprogram, false, declaration);
+	abbrev.u8(0);
+
+	uint32_t abbrev2 = abbrev.size();
+	writeAbbrev(abbrev, 1, DW_TAG_compile_unit, true, cu2);
+	writeAbbrev(abbrev, 2, DW_TAG_base_type, false, baseType2);
+	writeAbbrev(abbrev, 3, DW_TAG_subprogram, true, subprogram2);
+	writeAbbrev(abbrev, 4, DW_TAG_variable, false, variable3);
+	writeAbbrev(abbrev, 5, DW_TAG_formal_parameter, false, parameter2);
+	writeAbbrev(abbrev, 6, DW_TAG_variable, false, variable4);
+	abbrev.u8(0);
+
+	ByteWriter str;
+	str.cstr("unused");
+	uint32_t mainCName = str.size();
+	str.cstr("src/main.c");
+	uint32_t mainName = str.size();
+	str.cstr("main");
+
+	// The second entry of the first list changes the base address, the
+	// second list is relative to low_pc of its compilation unit
+	ByteWriter loc;
+	loc.u16(0x10).u16(0x20).u16(1).u8(DW_OP_reg12);
+	loc.u16(0xffff).u16(0xd000);
+	loc.u16(0x0).u16(0x8).u16(1).u8(DW_OP_reg13);
+	loc.u16(0).u16(0);
+	uint32_t loc2 = loc.size();
+	loc.u16(0x0).u16(0x4).u16(2).u8(DW_OP_breg1).sleb(2);
+	loc.u16(0x4).u16(0x20).u16(2).u8(DW_OP_breg4).sleb(4);
+	loc.u16(0).u16(0);
+
+	static const uint8_t opcodeLengths[] = {0, 1, 1, 1, 1, 0, 0, 0, 1, 0, 0, 1};
+
+	// DWARF 4 line program, files are relative to the compilation directory,
+	// to the include directory or absolute
+	ByteWriter line;
+	line.u32(0).u16(4).u32(0);
+	line.u8(1).u8(1).u8(1).u8(-5).u8(14).u8(13);
+	for (int i = 0; i < 12; ++i) {
+		line.u8(opcodeLengths[i]);
+	}
+	line.cstr("include").u8(0);
+	line.cstr("main.c").uleb(0).uleb(0).uleb(0);
+	line.cstr("defs.h").uleb(1).uleb(0).uleb(0);
+	line.cstr("/abs/abs.h").uleb(1).uleb(0).uleb(0);
+	line.u8(0);
+	line.setU32(6, line.size() - 10);
+	line.u8(0).uleb(3).u8(DW_LNE_set_address).u16(0xc010);
+	line.u8(DW_LNS_advance_line).sleb(9);
+	line.u8(DW_LNS_copy);
+	// Special opcode advancing the address by 4 and the line by 1
+	line.u8(13 + (1 + 5) + 14 * 4);
+	line.u8(DW_LNS_set_isa).uleb(1);
+	line.u8(DW_LNS_set_file).uleb(2);
+	line.u8(DW_LNS_advance_pc).uleb(6);
+	line.u8(DW_LNS_advance_line).sleb(-8);
+	line.u8(DW_LNS_copy);
+	line.u8(DW_LNS_set_file).uleb(3);
+	line.u8(DW_LNS_const_add_pc);
+	line.u8(13 + 5 + 14);
+	line.u8(DW_LNS_fixed_advance_pc).u16(0x24);
+	line.u8(0).uleb(1).u8(DW_LNE_end_sequence);
+	line.setU32(0, line.size() - 4);
+
+	// DWARF 2 line program with 2 bytes long instructions
+	uint32_t line2 = line.size();
+	line.u32(0).u16(2).u32(0);
+	line.u8(2).u8(1).u8(-5).u8(14).u8(10);
+	for (int i = 0; i < 9; ++i) {
+		line.u8(opcodeLengths[i]);
+	}
+	line.u8(0);
+	line.cstr("util.c").uleb(0).uleb(0).uleb(0);
+	line.u8(0);
+	line.setU32(line2 + 6, line.size() - line2 - 10);
+	line.u8(0).uleb(3).u8(DW_LNE_set_address).u16(0xe000);
+	line.u8(DW_LNS_copy);
+	line.u8(10 + (2 + 5) + 14 * 4);
+	line.u8(DW_LNS_advance_pc).uleb(12);
+	line.u8(0).uleb(1).u8(DW_LNE_end_sequence);
+	// Sequence ending where the row of the first unit already is, its last
+	// row is at the end address and covers no code
+	line.u8(0).uleb(3).u8(DW_LNE_set_address).u16(0xbff0);
+	line.u8(DW_LNS_advance_line).sleb(39);
+	line.u8(DW_LNS_copy);
+	line.u8(DW_LNS_advance_pc).uleb(16);
+	line.u8(DW_LNS_advance_line).sleb(1);
+	line.u8(DW_LNS_copy);
+	line.u8(0).uleb(1).u8(DW_LNE_end_sequence);
+	// Sequence starting where the first one of this unit ends
+	line.u8(0).uleb(3).u8(DW_LNE_set_address).u16(0xe020);
+	line.u8(DW_LNS_advance_line).sleb(49);
+	line.u8(DW_LNS_copy);
+	line.u8(DW_LNS_advance_pc).uleb(2);
+	line.u8(0).uleb(1).u8(DW_LNE_end_sequence);
+	line.setU32(line2, line.size() - line2 - 4);
+
+	ByteWriter info;
+	info.u32(0).u16(4).u32(0).u8(2);
+	info.uleb(1).u32(mainCName).cstr("/home/user/project").u16(0xc000).u16(0x100).u32(0);
+	uint32_t intType = info.size();
+	info.uleb(2).cstr("int").u8(2).u8(DW_ATE_signed);
+	uint32_t pointer = info.size();
+	info.uleb(3).sleb(2).u32(intType);
+	uint32_t myint = info.size();
+	info.uleb(4).cstr("myint").u32(intType);
+	uint32_t array = info.size();
+	info.uleb(5).u32(intType);
+	info.uleb(6).u8(9);
+	info.u8(0);
+	info.uleb(7).u32(mainName).u16(0xc010).u32(0x40).uleb(2).u8(DW_OP_breg1).sleb(4).u32(intType);
+	info.uleb(8).cstr("argc").uleb(myint).uleb(2).u8(DW_OP_fbreg).sleb(-2);
+	info.uleb(9).cstr("count").u16(intType).u32(0);
+	info.uleb(10).u16(0xc020).uleb(0x10);
+	info.uleb(11).uleb(DW_FORM_string).cstr("buffer").u8(array).u8(3).u8(DW_OP_addr).u16(0x0200);
+	info.u8(0);
+	info.u8(0);
+	// Declaration without the code is not a subprogram we can stop in
+	info.uleb(12).cstr("extern").u8(1);
+	info.u8(0);
+	info.setU32(0, info.size() - 4);
+
+	if (dwarf5Unit) {
+		// DWARF 5 header has the unit type before the address size and
+		// the abbreviations offset
+		uint32_t unit5 = info.size();
+		info.u32(0).u16(5).u8(0x01 /* DW_UT_compile */).u8(2).u32(0);
+		info.uleb(1).u32(mainCName).cstr("/home/user/project").u16(0xc000).u16(0x100).u32(0);
+		info.u8(0);
+		info.setU32(unit5, info.size() - unit5 - 4);
+	}
+
+	// References to the types of the first unit are section offsets of
+	// the address size in DWARF 2
+	uint32_t unit2 = info.size();
+	info.u32(0).u16(2).u32(abbrev2).u8(2);
+	info.uleb(1).cstr("lib/util.c").u16(0xe000).u32(line2);
+	uint32_t longType = info.size() - unit2;
+	info.uleb(2).cstr("long").u64(4).u8(DW_ATE_signed);
+	info.uleb(3).cstr("util").u16(0xe000).u16(0xe020).u32(loc2);
+	info.uleb(4).cstr("v").u16(intType).u16(2).u8(DW_OP_fbreg).sleb(2);
+	info.uleb(5).cstr("p").u16(pointer).u32(1).u8(DW_OP_reg15);
+	info.uleb(6).cstr("l").u64(longType).uleb(2).u8(DW_OP_breg1).sleb(0);
+	info.u8(0);
+	info.u8(0);
+	info.setU32(unit2, info.size() - unit2 - 4);
+
+	ElfFixture elf;
+	int text = elf.addSection(".text", QByteArray(0x40, 0), 0xc010, ElfFile::SectionAlloc | ElfFile::SectionExec);
+	int utilText = elf.addSection(".text.util", QByteArray(0x24, 0), 0xe000, ElfFile::SectionAlloc | ElfFile::SectionExec);
+	elf.addSymbol("main", 0xc010, ElfFile::SymbolFunction, text);
+	elf.addSymbol("util", 0xe000, ElfFile::SymbolFunction, utilText);
+	elf.addSection(".debug_info", info.data());
+	elf.addSection(".debug_abbrev", abbrev.data());
+	elf.addSection(".debug_loc", loc.data());
+	elf.addSection(".debug_line", line.data());
+	elf.addSection(".debug_str", str.data());
+	return elf.build();
+}
+
+class DwarfLoaderTest : public CPPUNIT_NS :: TestFixture{
+	CPPUNIT_TEST_SUITE(DwarfLoaderTest);
+	CPPUNIT_TEST(attributeForms);
+	CPPUNIT_TEST(locationLists);
+	CPPUNIT_TEST(lineRows);
+	CPPUNIT_TEST(disassembledFiles);
+	CPPUNIT_TEST(invalidFiles);
+	CPPUNIT_TEST(unsupportedUnits);
+	CPPUNIT_TEST_SUITE_END();
+
+	DwarfDebugData *dd;
+	DwarfSubprogram *mainFunction;
+	DwarfSubprogram *utilFunction;
+
+	public:
+		void setUp (void) {
+			DwarfLoader loader;
+			QString error;
+			dd = loader.load(buildElf(), error);
+			mainFunction = 0;
+			utilFunction = 0;
+			if (dd && dd->getSubprograms("main.c").size() == 1 && dd->getSubprograms("util.c").size() == 1) {
+				mainFunction = static_cast<DwarfSubprogram *>(dd->getSubprograms("main.c")[0]);
+				utilFunction = static_cast<DwarfSubprogram *>(dd->getSubprograms("util.c")[0]);
+			}
+		}
+
+		void tearDown (void) {
+			delete dd;
+		}
+
+		DwarfVariable *variable(DwarfSubprogram *s, int i) {
+			return static_cast<DwarfVariable *>(s->getVariables()[i]);
+		}
+
+		void attributeForms() {
+			CPPUNIT_ASSERT(mainFunction);
+			CPPUNIT_ASSERT(mainFunction->getName() == "main");
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xc010, mainFunction->getPCLow());
+			// DWARF 4 high_pc is the size of the code
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xc050, mainFunction->getPCHigh());
+			CPPUNIT_ASSERT(!mainFunction->getLocationList());
+			CPPUNIT_ASSERT(mainFunction->getExpression()->getCode() == QByteArray("\x71\x04", 2));
+
+			// Variables of the lexical block belong to the subprogram
+			CPPUNIT_ASSERT_EQUAL(3, mainFunction->getVariables().size());
+			CPPUNIT_ASSERT_EQUAL(1, mainFunction->getArgs().size());
+			DwarfVariable *argc = variable(mainFunction, 0);
+			DwarfVariable *count = variable(mainFunction, 1);
+			DwarfVariable *buffer = variable(mainFunction, 2);
+			CPPUNIT_ASSERT(mainFunction->getArgs()[0] == argc);
+			CPPUNIT_ASSERT(argc->getName() == "argc");
+			CPPUNIT_ASSERT(count->getName() == "count");
+			CPPUNIT_ASSERT(buffer->getName() == "buffer");
+
+			VariableType *intType = count->getType();
+			CPPUNIT_ASSERT(intType);
+			CPPUNIT_ASSERT(intType->getName() == "int");
+			CPPUNIT_ASSERT_EQUAL((uint8_t) 2, intType->getByteSize());
+			CPPUNIT_ASSERT_EQUAL(VariableType::Signed, intType->getEncoding());
+			CPPUNIT_ASSERT_EQUAL(VariableType::Base, intType->getType());
+
+			// Typedef is the type it names
+			CPPUNIT_ASSERT(argc->getType() == intType);
+			CPPUNIT_ASSERT(argc->getExpression()->getCode() == QByteArray("\x91\x7e", 2));
+
+			VariableType *arrayType = buffer->getType();
+			CPPUNIT_ASSERT(arrayType);
+			CPPUNIT_ASSERT_EQUAL(VariableType::Array, arrayType->getType());
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 9, arrayType->getUpperBound());
+			CPPUNIT_ASSERT(arrayType->getSubtype() == intType);
+			CPPUNIT_ASSERT(buffer->getExpression()->getCode() == QByteArray("\x03\x00\x02", 3));
+			CPPUNIT_ASSERT_EQUAL((uint8_t) 2, buffer->getExpression()->getAddressSize());
+
+			// DWARF 2 unit referring to the types of the first one
+			CPPUNIT_ASSERT(utilFunction);
+			CPPUNIT_ASSERT(utilFunction->getName() == "util");
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xe000, utilFunction->getPCLow());
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xe020, utilFunction->getPCHigh());
+			CPPUNIT_ASSERT_EQUAL(3, utilFunction->getVariables().size());
+			CPPUNIT_ASSERT_EQUAL(1, utilFunction->getArgs().size());
+			DwarfVariable *v = variable(utilFunction, 0);
+			DwarfVariable *p = variable(utilFunction, 1);
+			DwarfVariable *l = variable(utilFunction, 2);
+			CPPUNIT_ASSERT(utilFunction->getArgs()[0] == p);
+
+			CPPUNIT_ASSERT(v->getType() == intType);
+			CPPUNIT_ASSERT(v->getExpression()->getCode() == QByteArray("\x91\x02", 2));
+
+			CPPUNIT_ASSERT(p->getType());
+			CPPUNIT_ASSERT_EQUAL(VariableType::Pointer, p->getType()->getType());
+			CPPUNIT_ASSERT_EQUAL((uint8_t) 2, p->getType()->getByteSize());
+			CPPUNIT_ASSERT(p->getType()->getSubtype() == intType);
+			CPPUNIT_ASSERT(p->getExpression()->getCode() == QByteArray("\x5f", 1));
+
+			CPPUNIT_ASSERT(l->getType());
+			CPPUNIT_ASSERT(l->getType()->getName() == "long");
+			CPPUNIT_ASSERT_EQUAL((uint8_t) 4, l->getType()->getByteSize());
+			CPPUNIT_ASSERT(l->getExpression()->getCode() == QByteArray("\x71\x00", 2));
+
+			CPPUNIT_ASSERT(dd->getSubprogram(0xc030) == mainFunction);
+			CPPUNIT_ASSERT(dd->getSubprogram(0xe01f) == utilFunction);
+			CPPUNIT_ASSERT(dd->getSubprogram(0xc050) == 0);
+		}
+
+		void locationLists() {
+			CPPUNIT_ASSERT(mainFunction);
+			DwarfVariable *count = variable(mainFunction, 1);
+			CPPUNIT_ASSERT(!count->getExpression());
+			CPPUNIT_ASSERT(count->getLocationList());
+
+			// Base address is the low_pc of the unit until the base address
+			// selection entry
+			const QList<DwarfLocation *> &locations = count->getLocationList()->getLocations();
+			CPPUNIT_ASSERT_EQUAL(2, locations.size());
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xc010, locations[0]->getPCLow());
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xc020, locations[0]->getPCHigh());
+			CPPUNIT_ASSERT(locations[0]->getExpression()->getCode() == QByteArray("\x5c", 1));
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xd000, locations[1]->getPCLow());
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xd008, locations[1]->getPCHigh());
+			CPPUNIT_ASSERT(locations[1]->getExpression()->getCode() == QByteArray("\x5d", 1));
+
+			// Frame base of the DWARF 2 subprogram is a location list
+			CPPUNIT_ASSERT(utilFunction);
+			CPPUNIT_ASSERT(!utilFunction->getExpression());
+			CPPUNIT_ASSERT(utilFunction->getLocationList());
+			const QList<DwarfLocation *> &frameBase = utilFunction->getLocationList()->getLocations();
+			CPPUNIT_ASSERT_EQUAL(2, frameBase.size());
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xe000, frameBase[0]->getPCLow());
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xe004, frameBase[0]->getPCHigh());
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xe004, frameBase[1]->getPCLow());
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xe020, frameBase[1]->getPCHigh());
+
+			MSP430::RegisterSet r;
+			r.addDefaultRegisters();
+			r.getp(1)->setBigEndian(0x0400);
+			r.getp(4)->setBigEndian(0x0300);
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0x0402, utilFunction->getFrameBase(&r, 0, 0xe002));
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0x0304, utilFunction->getFrameBase(&r, 0, 0xe010));
+		}
+
+		void lineRows() {
+			CPPUNIT_ASSERT(dd);
+			CPPUNIT_ASSERT_EQUAL(10, dd->getLines().size());
+
+			QString file;
+			CPPUNIT_ASSERT_EQUAL(0, dd->getLine(0xbfef, file));
+			CPPUNIT_ASSERT_EQUAL(40, dd->getLine(0xbff0, file));
+			CPPUNIT_ASSERT(file == "util.c");
+			CPPUNIT_ASSERT_EQUAL(40, dd->getLine(0xc00f, file));
+			// End of the sequence loaded later does not replace the row
+			// of the first unit
+			CPPUNIT_ASSERT_EQUAL(10, dd->getLine(0xc010, file));
+			CPPUNIT_ASSERT(file == "/home/user/project/main.c");
+			CPPUNIT_ASSERT_EQUAL(10, dd->getLine(0xc013, file));
+			CPPUNIT_ASSERT_EQUAL(11, dd->getLine(0xc014, file));
+			CPPUNIT_ASSERT(file == "/home/user/project/main.c");
+			CPPUNIT_ASSERT_EQUAL(3, dd->getLine(0xc01a, file));
+			CPPUNIT_ASSERT(file == "/home/user/project/include/defs.h");
+			CPPUNIT_ASSERT_EQUAL(3, dd->getLine(0xc02b, file));
+			CPPUNIT_ASSERT(file == "/home/user/project/include/defs.h");
+			CPPUNIT_ASSERT_EQUAL(3, dd->getLine(0xc02c, file));
+			CPPUNIT_ASSERT(file == "/abs/abs.h");
+			CPPUNIT_ASSERT_EQUAL(3, dd->getLine(0xc04f, file));
+			// End of the sequence
+			CPPUNIT_ASSERT_EQUAL(0, dd->getLine(0xc050, file));
+
+			CPPUNIT_ASSERT_EQUAL(1, dd->getLine(0xe000, file));
+			CPPUNIT_ASSERT(file == "util.c");
+			CPPUNIT_ASSERT_EQUAL(1, dd->getLine(0xe007, file));
+			CPPUNIT_ASSERT_EQUAL(3, dd->getLine(0xe008, file));
+			CPPUNIT_ASSERT_EQUAL(3, dd->getLine(0xe01f, file));
+			CPPUNIT_ASSERT_EQUAL(50, dd->getLine(0xe020, file));
+			CPPUNIT_ASSERT(file == "util.c");
+			CPPUNIT_ASSERT_EQUAL(50, dd->getLine(0xe023, file));
+			CPPUNIT_ASSERT_EQUAL(0, dd->getLine(0xe024, file));
+		}
+
+		void disassembledFiles() {
+			CPPUNIT_ASSERT(dd);
+			MSP430::Memory m(120000);
+			MSP430::RegisterSet r;
+			r.addDefaultRegisters();
+			MSP430::InstructionDecoder decoder(&r, &m);
+			// nop
+			for (int address = 0xc010; address < 0xc050; address += 2) {
+				m.setBigEndian(address, 0x4303);
+			}
+			for (int address = 0xe000; address < 0xe024; address += 2) {
+				m.setBigEndian(address, 0x4303);
+			}
+
+			QByteArray elf = buildElf();
+			QString cacheDir = QDir::tempPath() + "/qsimkit_codeutil_test";
+			QString cached = cacheDir + "/" + QCryptographicHash::hash(elf, QCryptographicHash::Sha1).toHex() + ".code";
+			QFile::remove(cached);
+			QString error;
+			DisassembledFiles df = CodeUtil::disassemble(elf, &m, &decoder, dd, error, cacheDir);
+			QFile::remove(cached);
+			CPPUNIT_ASSERT(error.isEmpty());
+
+			// The first instruction of every function is in its source
+			// file, even though the other sequence ends at the address of
+			// main
+			CPPUNIT_ASSERT(!df.contains(QString()));
+			CPPUNIT_ASSERT(df.contains("/home/user/project/main.c"));
+			const DisassembledCode &main = df["/home/user/project/main.c"];
+			CPPUNIT_ASSERT(main.size() >= 2);
+			CPPUNIT_ASSERT_EQUAL(DisassembledLine::Section, main[0].getType());
+			CPPUNIT_ASSERT(main[0].getData() == "<main>:");
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xc010, main[0].getAddr());
+			CPPUNIT_ASSERT_EQUAL(10, main[0].getLineNumber());
+			CPPUNIT_ASSERT_EQUAL(DisassembledLine::Instruction, main[1].getType());
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xc010, main[1].getAddr());
+			CPPUNIT_ASSERT_EQUAL(10, main[1].getLineNumber());
+
+			CPPUNIT_ASSERT(df.contains("util.c"));
+			const DisassembledCode &util = df["util.c"];
+			CPPUNIT_ASSERT(util.size() >= 2);
+			CPPUNIT_ASSERT(util[0].getData() == "<util>:");
+			CPPUNIT_ASSERT_EQUAL((uint16_t) 0xe000, util[1].getAddr());
+			CPPUNIT_ASSERT_EQUAL(1, util[1].getLineNumber());
+		}
+
+		void invalidFiles() {
+			DwarfLoader loader;
+			QString error;
+			CPPUNIT_ASSERT(!loader.load(QByteArray("not an ELF file"), error));
+			CPPUNIT_ASSERT(!error.isEmpty());
+
+			ElfFixture noDebug;
+			noDebug.addSection(".text", QByteArray(0x10, 0));
+			error = QString();
+			CPPUNIT_ASSERT(!loader.load(noDebug.build(), error));
+			CPPUNIT_ASSERT(!error.isEmpty());
+
+			// Only a DWARF 5 unit and the entry with unknown abbreviation code
+			ByteWriter abbrev;
+			abbrev.u8(0);
+			for (int version = 5; version >= 4; --version) {
+				ByteWriter info;
+				info.u32(8).u16(version).u32(0).u8(2).u8(1);
+				ElfFixture elf;
+				elf.addSection(".debug_info", info.data());
+				elf.addSection(".debug_abbrev", abbrev.data());
+				error = QString();
+				CPPUNIT_ASSERT(!loader.load(elf.build(), error));
+				CPPUNIT_ASSERT(!error.isEmpty());
+			}
+		}
+
+		void unsupportedUnits() {
+			DwarfLoader loader;
+			QString error;
+			DwarfDebugData *data = loader.load(buildElf(true), error);
+			CPPUNIT_ASSERT(data);
+			CPPUNIT_ASSERT(error.isEmpty());
+			CPPUNIT_ASSERT_EQUAL(1, loader.getWarnings().size());
+			CPPUNIT_ASSERT(loader.getWarnings()[0].contains("DWARF version 5"));
+
+			// The units around the skipped one are loaded as usual
+			CPPUNIT_ASSERT_EQUAL(1, data->getSubprograms("main.c").size());
+			CPPUNIT_ASSERT_EQUAL(1, data->getSubprograms("util.c").size());
+			CPPUNIT_ASSERT(data->getSubprogram(0xe01f));
+			QString file;
+			CPPUNIT_ASSERT_EQUAL(11, data->getLine(0xc014, file));
+			delete data;
+
+			data = loader.load(buildElf(), error);
+			CPPUNIT_ASSERT(data);
+			CPPUNIT_ASSERT(loader.getWarnings().empty());
+			delete data;
+		}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (DwarfLoaderTest);
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QList>
+#include <stdint.h>
+#include <string.h>
+
+/// Writes the little-endian values and LEB128 numbers the DWARF sections
+/// are made of.
+class ByteWriter {
+	public:
+		ByteWriter &u8(uint8_t v) {
+			m_data.append((char) v);
+			return *this;
+		}
+
+		ByteWriter &u16(uint16_t v) {
+			return u8(v).u8(v >> 8);
+		}
+
+		ByteWriter &u32(uint32_t v) {
+			return u16(v).u16(v >> 16);
+		}
+
+		ByteWriter &u64(uint64_t v) {
+			return u32(v).u32(v >> 32);
+		}
+
+		ByteWriter &uleb(uint64_t v) {
+			do {
+				uint8_t byte = v & 0x7f;
+				v >>= 7;
+				u8(v ? byte | 0x80 : byte);
+			} while (v);
+			return *this;
+		}
+
+		ByteWriter &sleb(int64_t v) {
+			while (true) {
+				uint8_t byte = v & 0x7f;
+				v >>= 7;
+				if ((v == 0 && !(byte & 0x40)) || (v == -1 && (byte & 0x40))) {
+					return u8(byte);
+				}
+				u8(byte | 0x80);
+			}
+		}
+
+		ByteWriter &cstr(const char *s) {
+			m_data.append(s, strlen(s) + 1);
+			return *this;
+		}
+
+		ByteWriter &bytes(const QByteArray &data) {
+			m_data.append(data.constData(), data.size());
+			return *this;
+		}
+
+		/// Overwrites the 32-bit value at the offset, used for the lengths
+		/// known only once the data after them are written.
+		void setU32(int offset, uint32_t v) {
+			for (int i = 0; i < 4; ++i) {
+				m_data[offset + i] = (char) (v >> (i * 8));
+			}
+		}
+
+		int size() const {
+			return m_data.size();
+		}
+
+		const QByteArray &data() const {
+			return m_data;
+		}
+
+	private:
+		QByteArray m_data;
+};
+
+/// Builds the minimal 32-bit little-endian MSP430 ELF file which contains
+/// only the section headers, the data of the added sections and the symbol
+/// table when any symbol is added.
+class ElfFixture {
+	public:
+		/// Returns the index of the section, which the symbols refer to.
+		int addSection(const QString &name, const QByteArray &data, uint32_t address = 0, uint32_t flags = 0) {
+			Section s;
+			s.name = name;
+			s.data = data;
+			s.address = address;
+			s.flags = flags;
+			m_sections.append(s);
+			return m_sections.size();
+		}
+
+		void addSymbol(const QString &name, uint32_t value, uint8_t type, uint16_t section) {
+			Symbol s;
+			s.name = name;
+			s.value = value;
+			s.type = type;
+			s.section = section;
+			m_symbols.append(s);
+		}
+
+		QByteArray build() const {
+			QList<Section> sections = m_sections;
+			if (!m_symbols.isEmpty()) {
+				ByteWriter symtab;
+				ByteWriter strtab;
+				strtab.u8(0);
+				// Symbol 0 is the null symbol
+				symtab.u32(0).u32(0).u32(0).u8(0).u8(0).u16(0);
+				for (int i = 0; i < m_symbols.size(); ++i) {
+					const Symbol &symbol = m_symbols[i];
+					symtab.u32(strtab.size()).u32(symbol.value).u32(0);
+					symtab.u8(symbol.type).u8(0).u16(symbol.section);
+					strtab.cstr(symbol.name.toLatin1().constData());
+				}
+
+				Section s;
+				s.name = ".symtab";
+				s.data = symtab.data();
+				s.type = 2;
+				s.link = sections.size() + 2;
+				sections.append(s);
+
+				s.name = ".strtab";
+				s.data = strtab.data();
+				s.type = 3;
+				s.link = 0;
+				sections.append(s);
+			}
+
+			// Section 0 is the null section, the names are the last one
+			ByteWriter names;
+			names.u8(0);
+			QList<uint32_t> nameOffsets;
+			for (int i = 0; i < sections.size(); ++i) {
+				nameOffsets.append(names.size());
+				names.cstr(sections[i].name.toLatin1().constData());
+			}
+			nameOffsets.append(names.size());
+			names.cstr(".shstrtab");
+
+			Section s;
+			s.data = names.data();
+			s.type = 3;
+			sections.append(s);
+
+			ByteWriter data;
+			QList<uint32_t> offsets;
+			for (int i = 0; i < sections.size(); ++i) {
+				offsets.append(52 + data.size());
+				data.bytes(sections[i].data);
+			}
+
+			ByteWriter elf;
+			elf.u8(0x7f).u8('E').u8('L').u8('F');
+			// 32-bit, little endian, current version
+			elf.u8(1).u8(1).u8(1);
+			while (elf.size() < 16) {
+				elf.u8(0);
+			}
+			elf.u16(2).u16(105).u32(1);
+			// entry, program headers and section headers
+			elf.u32(0).u32(0).u32(52 + data.size());
+			elf.u32(0).u16(52).u16(32).u16(0);
+			elf.u16(40).u16(sections.size() + 1).u16(sections.size());
+			elf.bytes(data.data());
+
+			for (int i = 0; i < 10; ++i) {
+				elf.u32(0);
+			}
+			for (int i = 0; i < sections.size(); ++i) {
+				const Section &s = sections[i];
+				elf.u32(nameOffsets[i]).u32(s.type);
+				elf.u32(s.flags).u32(s.address).u32(offsets[i]).u32(s.data.size());
+				elf.u32(s.link).u32(0).u32(1).u32(s.type == 2 ? 16 : 0);
+			}
+
+			return elf.data();
+		}
+
+	private:
+		class Section {
+			public:
+				// SHT_PROGBITS
+				Section() : type(1), flags(0), address(0), link(0) {}
+
+				QString name;
+				QByteArray data;
+				uint32_t type;
+				uint32_t flags;
+				uint32_t address;
+				uint32_t link;
+		};
+
+		class Symbol {
+			public:
+				QString name;
+				uint32_t value;
+				uint8_t type;
+				uint16_t section;
+		};
+
+		QList<Section> m_sections;
+		QList<Symbol> m_symbols;
+};
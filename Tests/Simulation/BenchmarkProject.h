@@ -0,0 +1,129 @@
+#pragma once
+
+#include "adevs.h"
+#include "Peripherals/SimulationTime.h"
+
+#include <vector>
+
+typedef adevs::Atomic<int, SimulationTime> ScheduledModel;
+typedef adevs::SimpleDigraph<int, SimulationTime> BenchmarkNetwork;
+
+class Notifier {
+	public:
+		virtual void notify(ScheduledModel *model) = 0;
+};
+
+/// Oscillator ticking with the fixed step, like the DCO or the VLO. Every
+/// n-th tick changes a pin of the MCU.
+class TickingModel : public ScheduledModel {
+	public:
+		TickingModel(SimulationTime step, ScheduledModel *mcu = 0, int every = 0) :
+			step(step), mcu(mcu), every(every), ticks(0), notifier(0) {}
+
+		void delta_int() {
+			ticks++;
+			if (mcu && ticks % every == 0) {
+				notifier->notify(mcu);
+			}
+		}
+		void delta_ext(SimulationTime e, const adevs::Bag<int> &xb) {}
+		void delta_conf(const adevs::Bag<int> &xb) {}
+		void output_func(adevs::Bag<int> &yb) {}
+		SimulationTime ta() { return step; }
+		void gc_output(adevs::Bag<int> &g) {}
+
+		SimulationTime step;
+		ScheduledModel *mcu;
+		int every;
+		int ticks;
+		Notifier *notifier;
+};
+
+/// MCU which outputs its pin changes to the peripheral
+class OutputModel : public ScheduledModel {
+	public:
+		OutputModel() : pending(false), outputs(0) {}
+
+		void delta_int() { pending = false; }
+		void delta_ext(SimulationTime e, const adevs::Bag<int> &xb) {}
+		void delta_conf(const adevs::Bag<int> &xb) {}
+		void output_func(adevs::Bag<int> &yb) { yb.insert(outputs++); }
+		SimulationTime ta() { return pending ? 0 : SIMULATION_TIME_MAX; }
+		void gc_output(adevs::Bag<int> &g) {}
+
+		bool pending;
+		int outputs;
+};
+
+/// Peripheral like the LCD or the SD card, which reacts to the pins after
+/// a delay.
+class PeripheralModel : public ScheduledModel {
+	public:
+		PeripheralModel(SimulationTime delay) : delay(delay), busy(false), inputs(0) {}
+
+		void delta_int() { busy = false; }
+		void delta_ext(SimulationTime e, const adevs::Bag<int> &xb) { busy = true; inputs += xb.size(); }
+		void delta_conf(const adevs::Bag<int> &xb) { delta_int(); delta_ext(0, xb); }
+		void output_func(adevs::Bag<int> &yb) {}
+		SimulationTime ta() { return busy ? delay : SIMULATION_TIME_MAX; }
+		void gc_output(adevs::Bag<int> &g) {}
+
+		SimulationTime delay;
+		bool busy;
+		int inputs;
+};
+
+/// Models of an example project simulated with the given schedule
+template <class S>
+class BenchmarkProject : public Notifier {
+	public:
+		typedef adevs::Simulator<int, SimulationTime, S> Kernel;
+
+		/// Creates the MCU clocked by the DCO, which changes a pin every
+		/// pinEvery cycles, and the given number of crystal oscillators.
+		BenchmarkProject(int pinEvery, int oscillators) :
+			mcu(new OutputModel()), peripheral(new PeripheralModel(secondsToTime(50e-6))) {
+			// DCO at 1 MHz executing one cycle per event and the VLO
+			models.push_back(new TickingModel(frequencyToPeriod(1000000), mcu, pinEvery));
+			models.push_back(new TickingModel(frequencyToPeriod(12000) / 2));
+			for (int i = 0; i < oscillators; ++i) {
+				// Crystals are never exactly at their nominal frequency
+				models.push_back(new TickingModel(frequencyToPeriod(32768 + 7 * i) / 2));
+			}
+			for (std::vector<TickingModel *>::iterator it = models.begin(); it != models.end(); ++it) {
+				(*it)->notifier = this;
+				network.add(*it);
+			}
+			network.add(mcu);
+			network.add(peripheral);
+			network.couple(mcu, peripheral);
+			sim = new Kernel(&network);
+		}
+
+		~BenchmarkProject() {
+			// The network deletes the models
+			delete sim;
+		}
+
+		void notify(ScheduledModel *model) {
+			mcu->pending = true;
+			sim->timeAdvanceChanged(model);
+		}
+
+		/// Runs the simulation until the time t and returns the number of
+		/// executed events.
+		long run(SimulationTime t) {
+			long events = 0;
+			while (sim->nextEventTime() <= t) {
+				sim->execNextEvent();
+				events++;
+			}
+			return events;
+		}
+
+		std::vector<TickingModel *> models;
+		OutputModel *mcu;
+		PeripheralModel *peripheral;
+		BenchmarkNetwork network;
+		Kernel *sim;
+};
@@ -0,0 +1,210 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "Peripherals/SimulationObject.h"
+#include "Peripherals/SimulationModel.h"
+#include "CPU/Memory/Memory.h"
+#include "CPU/Memory/RegisterSet.h"
+#include "CPU/Interrupts/InterruptManager.h"
+#include "CPU/BasicClock/BasicClock.h"
+#include "CPU/BasicClock/MCLK.h"
+#include "CPU/BasicClock/SMCLK.h"
+#include "CPU/BasicClock/ACLK.h"
+#include "CPU/Pins/PinManager.h"
+#include "CPU/Variants/Variant.h"
+#include "CPU/Variants/VariantManager.h"
+#include "SimulationObjects/Timer/AdevsTimerFactory.h"
+#include "SimulationObjects/Timer/DCO.h"
+#include "SimulationObjects/Timer/VLO.h"
+#include "SimulationObjects/Timer/Scheduler.h"
+
+#include <map>
+#include <vector>
+
+/// Counts the rising edges of the clock generated by ticking the adevs
+/// oscillators and checks at every edge that the analytic cycle count of
+/// the clock ends the next cycle right there. Memory writes can be done at the
+/// given edges.
+class EdgeCountingHandler : public MSP430::ClockHandler {
+	public:
+		EdgeCountingHandler(MSP430::Clock *clock, MSP430::Scheduler *scheduler, MSP430::Memory *mem) :
+			clock(clock), scheduler(scheduler), mem(mem), edges(0), cycle(0), errors(0) {}
+
+		void start() {
+			clock->addHandler(this, MSP430::Clock::Rising);
+		}
+
+		void tickRising() {
+			// The first edge only gives the cycle the counting starts from
+			SimulationTime now = scheduler->getTime();
+			if (edges++ == 0) {
+				cycle = clock->getCycle(now) - 1;
+			}
+
+			if (clock->getCycle(now) != cycle + 1 || clock->getCycle(now - 1) != cycle ||
+				clock->getCycleTime(cycle + 1) != now) {
+				errors++;
+			}
+			cycle = clock->getCycle(now);
+
+			std::map<int, std::pair<uint16_t, uint8_t> >::iterator it = writes.find(edges);
+			if (it != writes.end()) {
+				mem->setByte(it->second.first, it->second.second);
+			}
+		}
+
+		void tickFalling() {}
+
+		MSP430::Clock *clock;
+		MSP430::Scheduler *scheduler;
+		MSP430::Memory *mem;
+		int edges;
+		uint64_t cycle;
+		int errors;
+		// Address and value written at the given edge
+		std::map<int, std::pair<uint16_t, uint8_t> > writes;
+};
+
+class ClockPhaseTest : public CPPUNIT_NS :: TestFixture{
+	CPPUNIT_TEST_SUITE(ClockPhaseTest);
+	CPPUNIT_TEST(dividers);
+	CPPUNIT_TEST(dividerChangeInHandler);
+	CPPUNIT_TEST(dividerChangeBetweenEvents);
+	CPPUNIT_TEST_SUITE_END();
+
+	MSP430::Memory *m;
+	MSP430::RegisterSet *r;
+	Variant *v;
+	MSP430::InterruptManager *intManager;
+	MSP430::PinManager *pinManager;
+	AdevsTimerFactory *factory;
+	MSP430::BasicClock *bc;
+	EdgeCountingHandler *mclk;
+	EdgeCountingHandler *smclk;
+	EdgeCountingHandler *aclk;
+	SimulationModel *dig;
+	SimulationKernel *sim;
+
+	public:
+		void setUp (void) {
+			m = new MSP430::Memory(120000);
+			r = new MSP430::RegisterSet();
+			r->addDefaultRegisters();
+			v = getVariant("msp430x241x");
+			intManager = new MSP430::InterruptManager(r, m, v);
+			pinManager = new MSP430::PinManager(m, intManager, v);
+			factory = new AdevsTimerFactory();
+			bc = new MSP430::BasicClock(m, v, intManager, pinManager, factory);
+			mclk = new EdgeCountingHandler(bc->getMCLK(), bc->getScheduler(), m);
+			smclk = new EdgeCountingHandler(bc->getSMCLK(), bc->getScheduler(), m);
+			aclk = new EdgeCountingHandler(bc->getACLK(), bc->getScheduler(), m);
+
+			// The network deletes the wrappers
+			dig = new SimulationModel();
+			std::vector<SimulationObject *> objects;
+			objects.push_back(dynamic_cast<DCO *>(bc->getDCO()));
+			objects.push_back(dynamic_cast<VLO *>(bc->getVLO()));
+			objects.push_back(dynamic_cast<Scheduler *>(bc->getScheduler()));
+			std::vector<SimulationObjectWrapper *> wrappers;
+			for (std::vector<SimulationObject *>::iterator it = objects.begin(); it != objects.end(); ++it) {
+				SimulationObjectWrapper *wrapper = new SimulationObjectWrapper(*it);
+				dig->add(wrapper);
+				(*it)->setWrapper(wrapper);
+				wrappers.push_back(wrapper);
+			}
+
+			sim = new SimulationKernel(dig);
+			for (std::vector<SimulationObjectWrapper *>::iterator it = wrappers.begin(); it != wrappers.end(); ++it) {
+				(*it)->setSimulator(sim);
+			}
+		}
+
+		void tearDown (void) {
+			delete sim;
+			delete dig;
+			delete aclk;
+			delete smclk;
+			delete mclk;
+			delete bc;
+			delete factory;
+			delete pinManager;
+			delete intManager;
+			delete r;
+			delete m;
+		}
+
+		/// Executes the events until the time t, writing the BCSCTL2 values
+		/// once the given times are reached.
+		void run(SimulationTime t, const std::map<SimulationTime, uint8_t> &writes = std::map<SimulationTime, uint8_t>()) {
+			std::map<SimulationTime, uint8_t>::const_iterator it = writes.begin();
+			while (sim->nextEventTime() <= t) {
+				if (it != writes.end() && sim->nextEventTime() >= it->first) {
+					m->setByte(v->getBCSCTL2(), it->second);
+					++it;
+					continue;
+				}
+				sim->execNextEvent();
+			}
+		}
+
+		void checkEdges(int minEdges) {
+			CPPUNIT_ASSERT(mclk->edges >= minEdges);
+			CPPUNIT_ASSERT(smclk->edges >= minEdges);
+			CPPUNIT_ASSERT_EQUAL(0, mclk->errors);
+			CPPUNIT_ASSERT_EQUAL(0, smclk->errors);
+			CPPUNIT_ASSERT_EQUAL(0, aclk->errors);
+		}
+
+		void dividers() {
+			for (int d = 0; d < 4; ++d) {
+				tearDown();
+				setUp();
+				// DIVMx, DIVSx and DIVAx
+				m->setByte(v->getBCSCTL2(), (d << 4) | ((3 - d) << 1));
+				m->setByte(v->getBCSCTL1(), (m->getByte(v->getBCSCTL1()) & 0xcf) | (d << 4));
+				mclk->start();
+				smclk->start();
+				aclk->start();
+
+				run(bc->getDCO()->getStep() * 8 * 40);
+				checkEdges(40);
+				CPPUNIT_ASSERT(aclk->edges > 0);
+			}
+		}
+
+		void dividerChangeInHandler() {
+			// DIVMx and DIVSx changed by the MCLK handler, sometimes on
+			// consecutive edges.
+			uint8_t values[] = { 0x12, 0x32, 0x04, 0x26, 0x00, 0x36, 0x16, 0x20 };
+			int at[] = { 3, 5, 6, 11, 12, 20, 21, 30 };
+			for (int i = 0; i < 8; ++i) {
+				mclk->writes[at[i]] = std::make_pair(v->getBCSCTL2(), values[i]);
+			}
+			mclk->start();
+			smclk->start();
+
+			run(bc->getDCO()->getStep() * 8 * 60);
+			checkEdges(60);
+		}
+
+		void dividerChangeBetweenEvents() {
+			SimulationTime step = bc->getDCO()->getStep();
+			m->setByte(v->getBCSCTL2(), 0x36);
+			smclk->start();
+
+			// The MCLK handler is added while the divided SMCLK is running
+			run(step * 13);
+			mclk->start();
+
+			std::map<SimulationTime, uint8_t> writes;
+			writes[step * 20] = 0x14;
+			writes[step * 27 + step / 2] = 0x20;
+			writes[step * 31] = 0x02;
+			writes[step * 45 + step / 2] = 0x36;
+			writes[step * 49] = 0x00;
+			run(step * 8 * 60, writes);
+			checkEdges(40);
+		}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (ClockPhaseTest);
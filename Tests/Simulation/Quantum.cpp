@@ -0,0 +1,522 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "Peripherals/SimulationObject.h"
+#include "Peripherals/SimulationModel.h"
+#include "CPU/Memory/Memory.h"
+#include "CPU/Memory/RegisterSet.h"
+#include "CPU/Memory/Register.h"
+#include "CPU/Memory/RegisterFile.h"
+#include "CPU/Interrupts/InterruptManager.h"
+#include "CPU/Instructions/Instruction.h"
+#include "CPU/Instructions/InstructionDecoder.h"
+#include "CPU/Instructions/InstructionManager.h"
+#include "CPU/Instructions/IdleLoopExecutor.h"
+#include "CPU/BasicClock/BasicClock.h"
+#include "CPU/BasicClock/MCLK.h"
+#include "CPU/Pins/PinManager.h"
+#include "CPU/Variants/Variant.h"
+#include "CPU/Variants/VariantManager.h"
+#include "SimulationObjects/Timer/AdevsTimerFactory.h"
+#include "SimulationObjects/Timer/DCO.h"
+#include "SimulationObjects/Timer/VLO.h"
+#include "SimulationObjects/Timer/Scheduler.h"
+#include "SimulationObjects/Timer/IdleLoopSkipper.h"
+
+#include <vector>
+
+// Address of the code and of the first instruction after the loop
+#define CODE_START 0xf000
+#define CODE_END 0xf008
+// RAM byte polled by the polling loop
+#define POLLED 0x1100
+
+/// Stands for the MCU clocked by the DCO. It changes its output pin at the
+/// given cycle the same way as MCU_MSP430::handlePinChanged() and takes the
+/// interrupt requested on its input pin at the next rising tick.
+class QuantumCore : public SimulationObject, public MSP430::OscillatorHandler {
+	public:
+		QuantumCore(DCO *dco, int outputCycle) : dco(dco), outputCycle(outputCycle),
+			cycles(0), hasOutput(false), outputDelay(0), pending(false),
+			takenCycle(0), takenTime(0), takenLocalTime(-1) {}
+
+		void tickRising() {
+			cycles++;
+			if (pending) {
+				pending = false;
+				takenCycle = cycles;
+				takenTime = m_wrapper->getTime() + dco->getLocalTime();
+				takenLocalTime = dco->getLocalTime();
+			}
+
+			if (cycles == outputCycle) {
+				hasOutput = true;
+				outputDelay = dco->getLocalTime();
+				dco->synchronize();
+				m_wrapper->reschedule();
+			}
+		}
+
+		void tickFalling() {}
+
+		void internalTransition() {
+			hasOutput = false;
+		}
+
+		void externalEvent(SimulationTime t, const SimulationEventList &) {
+			pending = true;
+		}
+
+		void output(SimulationEventList &output) {
+			if (hasOutput) {
+				output.insert(SimulationEvent(0, 1));
+			}
+		}
+
+		SimulationTime timeAdvance() {
+			return hasOutput ? outputDelay : SIMULATION_TIME_MAX;
+		}
+
+		DCO *dco;
+		int outputCycle;
+		int cycles;
+		bool hasOutput;
+		SimulationTime outputDelay;
+		bool pending;
+		int takenCycle;
+		SimulationTime takenTime;
+		SimulationTime takenLocalTime;
+};
+
+/// Peripheral requesting the interrupt at the given time and right after
+/// every change of its input pin.
+class InterruptSource : public SimulationObject {
+	public:
+		InterruptSource(SimulationTime at) : at(at), requested(false) {}
+
+		void internalTransition() {
+			requested = false;
+			at = SIMULATION_TIME_MAX;
+		}
+
+		void externalEvent(SimulationTime t, const SimulationEventList &) {
+			requested = true;
+		}
+
+		void output(SimulationEventList &output) {
+			output.insert(SimulationEvent(0, 1));
+		}
+
+		SimulationTime timeAdvance() {
+			return requested ? 0 : at;
+		}
+
+		SimulationTime at;
+		bool requested;
+};
+
+/// Stands for the MCU executing the code with the real Basic Clock. With
+/// skipping enabled, the idle loops are skipped the same way as in
+/// MCU_MSP430::tickRising() and the DCO jumps over their cycles. Otherwise
+/// every instruction is executed. Input on the pin sets the polled byte,
+/// and so does the event scheduled in the Scheduler. The first cycle seeing
+/// a queued interrupt is recorded.
+class IdleLoopCore : public SimulationObject, public MSP430::ClockHandler,
+	public MSP430::TimedEventHandler {
+	public:
+		IdleLoopCore(bool skipping) : skipping(skipping), instructionCycles(0),
+			counter(0), pending(false), cycles(0), endCycle(0), endTime(0),
+			interruptCycle(0), interruptTime(0) {
+			mem = new MSP430::Memory(120000);
+			reg = new MSP430::RegisterSet();
+			reg->addDefaultRegisters();
+			variant = getVariant("msp430x241x");
+			intManager = new MSP430::InterruptManager(reg, mem, variant);
+			pinManager = new MSP430::PinManager(mem, intManager, variant);
+			factory = new AdevsTimerFactory();
+			basicClock = new MSP430::BasicClock(mem, variant, intManager, pinManager, factory);
+			decoder = new MSP430::InstructionDecoder(reg, mem);
+			executor = new MSP430::IdleLoopExecutor(reg, mem, decoder, intManager);
+			skipper = new IdleLoopSkipper(basicClock);
+		}
+
+		~IdleLoopCore() {
+			delete skipper;
+			delete executor;
+			delete decoder;
+			delete basicClock;
+			delete factory;
+			delete pinManager;
+			delete intManager;
+			delete reg;
+			delete mem;
+		}
+
+		void start() {
+			reg->getp(0)->setBigEndian(CODE_START);
+			instructionCycles = decoder->decodeCurrentInstruction(&instruction);
+			basicClock->getMCLK()->addHandler(this, MSP430::Clock::Rising);
+		}
+
+		void tickRising() {
+			cycles++;
+			if (interruptCycle == 0 && intManager->hasQueuedInterrupts()) {
+				interruptCycle = cycles;
+				interruptTime = basicClock->getScheduler()->getTime();
+			}
+
+			if (executor->isActive()) {
+				if (skipper->isSkipping()) {
+					countSkippedCycles(skipper->takeSkippedCycles());
+				}
+
+				switch (executor->tick()) {
+					case MSP430::IdleLoopExecutor::Running:
+						skipper->start(executor);
+						return;
+					case MSP430::IdleLoopExecutor::Execute:
+						instructionCycles = decoder->decodeCurrentInstruction(&instruction);
+						counter = executor->getElapsedCycles();
+						pending = false;
+						break;
+					case MSP430::IdleLoopExecutor::Resume:
+						instructionCycles = 1;
+						counter = 0;
+						pending = true;
+						break;
+				}
+			}
+
+			if (++counter != instructionCycles) {
+				return;
+			}
+
+			counter = 0;
+			if (!pending) {
+				executeInstruction(reg, mem, &instruction);
+				if (endCycle == 0 && reg->getp(0)->getBigEndian() == CODE_END) {
+					endCycle = cycles;
+					endTime = basicClock->getScheduler()->getTime();
+					for (int i = 0; i < 16; ++i) {
+						endRegisters.push_back(reg->getRegisterFile()->get(i));
+					}
+				}
+			}
+
+			pending = false;
+			instructionCycles = decoder->decodeCurrentInstruction(&instruction);
+			if (skipping && executor->enter()) {
+				skipper->start(executor);
+			}
+		}
+
+		void tickFalling() {}
+
+		void handleTimedEvent() {
+			mem->setByte(POLLED, 1);
+		}
+
+		void internalTransition() {}
+
+		void externalEvent(SimulationTime t, const SimulationEventList &) {
+			// Same as MCU_MSP430::externalEvent()
+			if (skipper->isSkipping()) {
+				countSkippedCycles(skipper->stop());
+			}
+			mem->setByte(POLLED, 1);
+		}
+
+		void output(SimulationEventList &output) {}
+
+		SimulationTime timeAdvance() {
+			return SIMULATION_TIME_MAX;
+		}
+
+		void countSkippedCycles(uint64_t skipped) {
+			executor->skip(skipped);
+			cycles += skipped;
+		}
+
+		bool skipping;
+		MSP430::Memory *mem;
+		MSP430::RegisterSet *reg;
+		Variant *variant;
+		MSP430::InterruptManager *intManager;
+		MSP430::PinManager *pinManager;
+		AdevsTimerFactory *factory;
+		MSP430::BasicClock *basicClock;
+		MSP430::InstructionDecoder *decoder;
+		MSP430::IdleLoopExecutor *executor;
+		IdleLoopSkipper *skipper;
+		MSP430::Instruction instruction;
+		int instructionCycles;
+		int counter;
+		bool pending;
+		uint64_t cycles;
+		// Cycle, time and registers after the loop ended
+		uint64_t endCycle;
+		SimulationTime endTime;
+		std::vector<uint16_t> endRegisters;
+		// Cycle and time of the first queued interrupt
+		uint64_t interruptCycle;
+		SimulationTime interruptTime;
+};
+
+class QuantumTest : public CPPUNIT_NS :: TestFixture{
+	CPPUNIT_TEST_SUITE(QuantumTest);
+	CPPUNIT_TEST(interruptAfterOutput);
+	CPPUNIT_TEST(interruptMidQuantum);
+	CPPUNIT_TEST(timerInterruptMidQuantum);
+	CPPUNIT_TEST(skipDelayLoop);
+	CPPUNIT_TEST(skipPollingLoopScheduler);
+	CPPUNIT_TEST(skipPollingLoopInput);
+	CPPUNIT_TEST_SUITE_END();
+
+	MSP430::Memory *m;
+	Variant *v;
+	DCO *dco;
+	QuantumCore *core;
+	InterruptSource *source;
+	IdleLoopCore *idleCore;
+
+	public:
+		void setUp (void) {
+			m = new MSP430::Memory(120000);
+			v = getVariant("msp430x241x");
+			dco = new DCO(m, v);
+			core = 0;
+			source = 0;
+			idleCore = 0;
+		}
+
+		void tearDown (void) {
+			delete idleCore;
+			delete source;
+			delete core;
+			delete dco;
+			delete m;
+		}
+
+		/// Simulates the core clocked by the DCO executing the given number of
+		/// cycles in one quantum until the time t.
+		void run(int quantum, int outputCycle, SimulationTime at, SimulationTime t) {
+			// The DCO watches the memory, so both are created again
+			delete source;
+			delete core;
+			delete dco;
+			delete m;
+			m = new MSP430::Memory(120000);
+			dco = new DCO(m, v);
+			dco->setQuantum(quantum);
+			core = new QuantumCore(dco, outputCycle);
+			source = new InterruptSource(at);
+			dco->addHandler(core);
+
+			// The network deletes the wrappers
+			SimulationModel dig;
+			SimulationObjectWrapper *dcoWrapper = new SimulationObjectWrapper(dco);
+			SimulationObjectWrapper *coreWrapper = new SimulationObjectWrapper(core);
+			SimulationObjectWrapper *sourceWrapper = new SimulationObjectWrapper(source);
+			dig.add(dcoWrapper);
+			dig.add(coreWrapper);
+			dig.add(sourceWrapper);
+			dco->setWrapper(dcoWrapper);
+			core->setWrapper(coreWrapper);
+			source->setWrapper(sourceWrapper);
+			coreWrapper->couple(0, sourceWrapper, 0);
+			sourceWrapper->couple(0, coreWrapper, 0);
+
+			SimulationKernel sim(&dig);
+			dcoWrapper->setSimulator(&sim);
+			coreWrapper->setSimulator(&sim);
+			sourceWrapper->setSimulator(&sim);
+			while (sim.nextEventTime() <= t) {
+				sim.execNextEvent();
+			}
+		}
+
+		/// Simulates the idle loop core with the given MCLK divider and
+		/// quantum until the time t. The Scheduler event and the pin input
+		/// set the polled byte at the given times. Timer_A counts SMCLK up to
+		/// ccr0 and requests the CCR0 interrupt, if ccr0 is not 0. Returns the
+		/// number of executed events.
+		long runIdleLoop(bool skipping, bool polling, int divider, int quantum,
+						 SimulationTime eventAt, SimulationTime inputAt, SimulationTime t,
+						 uint16_t ccr0 = 0) {
+			delete idleCore;
+			delete source;
+			idleCore = new IdleLoopCore(skipping);
+			source = new InterruptSource(inputAt);
+			MSP430::Memory *mem = idleCore->mem;
+			if (polling) {
+				// bit.b #1, &POLLED; jz $-4; nop
+				mem->setBigEndian(0xf000, 0xb3d2);
+				mem->setBigEndian(0xf002, POLLED);
+				mem->setBigEndian(0xf004, 0x27fd);
+				mem->setBigEndian(0xf006, 0x4303);
+			}
+			else {
+				// mov #5000, r15; dec r15; jnz $-2
+				mem->setBigEndian(0xf000, 0x403f);
+				mem->setBigEndian(0xf002, 5000);
+				mem->setBigEndian(0xf004, 0x831f);
+				mem->setBigEndian(0xf006, 0x23fe);
+			}
+			// jmp $
+			mem->setBigEndian(CODE_END, 0x3fff);
+
+			MSP430::BasicClock *bc = idleCore->basicClock;
+			DCO *dcoObject = dynamic_cast<DCO *>(bc->getDCO());
+			VLO *vloObject = dynamic_cast<VLO *>(bc->getVLO());
+			Scheduler *schedulerObject = dynamic_cast<Scheduler *>(bc->getScheduler());
+			dcoObject->setQuantum(quantum);
+			idleCore->start();
+			// DIVMx
+			int divm = divider == 8 ? 3 : divider == 4 ? 2 : divider == 2 ? 1 : 0;
+			mem->setByte(idleCore->variant->getBCSCTL2(), divm << 4);
+
+			// The network deletes the wrappers
+			SimulationModel dig;
+			std::vector<SimulationObject *> objects;
+			objects.push_back(dcoObject);
+			objects.push_back(vloObject);
+			objects.push_back(schedulerObject);
+			objects.push_back(idleCore);
+			objects.push_back(source);
+			std::vector<SimulationObjectWrapper *> wrappers;
+			for (std::vector<SimulationObject *>::iterator it = objects.begin(); it != objects.end(); ++it) {
+				SimulationObjectWrapper *wrapper = new SimulationObjectWrapper(*it);
+				dig.add(wrapper);
+				(*it)->setWrapper(wrapper);
+				wrappers.push_back(wrapper);
+			}
+			wrappers[4]->couple(0, wrappers[3], 0);
+
+			SimulationKernel sim(&dig);
+			for (std::vector<SimulationObjectWrapper *>::iterator it = wrappers.begin(); it != wrappers.end(); ++it) {
+				(*it)->setSimulator(&sim);
+			}
+			if (eventAt != SIMULATION_TIME_MAX) {
+				bc->getScheduler()->schedule(idleCore, eventAt);
+			}
+			if (ccr0 != 0) {
+				Variant *variant = idleCore->variant;
+				mem->setBigEndian(variant->getTA0CCR0(), ccr0);
+				// CCIE
+				mem->setBigEndian(variant->getTA0CCTL0(), 16);
+				// SMCLK, up mode
+				mem->setBigEndian(variant->getTA0CTL(), (2 << 8) | (1 << 4));
+			}
+
+			long events = 0;
+			while (sim.nextEventTime() <= t) {
+				sim.execNextEvent();
+				events++;
+			}
+			return events;
+		}
+
+		/// Runs the idle loop with and without skipping and checks that both
+		/// runs leave the loop at the same time, cycle and registers.
+		void compareSkipping(bool polling, SimulationTime eventAt, SimulationTime inputAt) {
+			int dividers[] = { 1, 8 };
+			int quanta[] = { 1, 3 };
+			for (int d = 0; d < 2; ++d) {
+				for (int q = 0; q < 2; ++q) {
+					SimulationTime step = frequencyToPeriod(1000000) * dividers[d];
+					SimulationTime t = 40000 * step;
+					long events = runIdleLoop(false, polling, dividers[d], quanta[q], eventAt, inputAt, t);
+					uint64_t cycle = idleCore->endCycle;
+					SimulationTime time = idleCore->endTime;
+					std::vector<uint16_t> registers = idleCore->endRegisters;
+					CPPUNIT_ASSERT(cycle != 0);
+
+					long skippedEvents = runIdleLoop(true, polling, dividers[d], quanta[q], eventAt, inputAt, t);
+					CPPUNIT_ASSERT_EQUAL(cycle, idleCore->endCycle);
+					CPPUNIT_ASSERT_EQUAL(time, idleCore->endTime);
+					CPPUNIT_ASSERT(registers == idleCore->endRegisters);
+					// The DCO did not tick through the skipped cycles
+					CPPUNIT_ASSERT(skippedEvents < events / 10);
+				}
+			}
+		}
+
+		void skipDelayLoop() {
+			compareSkipping(false, SIMULATION_TIME_MAX, SIMULATION_TIME_MAX);
+		}
+
+		void skipPollingLoopScheduler() {
+			// Event of a peripheral with analytic clock limits the skipping
+			compareSkipping(true, secondsToTime(12345.6e-6), SIMULATION_TIME_MAX);
+		}
+
+		void skipPollingLoopInput() {
+			// Pin input stops the skipping in the middle of the skipped cycles
+			compareSkipping(true, SIMULATION_TIME_MAX, secondsToTime(12345.6e-6));
+		}
+
+		void timerInterruptMidQuantum() {
+			// The compare match of the timer counted analytically happens in
+			// the middle of the quantum, which has to end before it, so the
+			// MCU sees the interrupt at the same cycle as in lock-step.
+			int dividers[] = { 1, 8 };
+			int quanta[] = { 3, 8 };
+			uint16_t compares[] = { 100, 1234 };
+			for (int d = 0; d < 2; ++d) {
+				for (int c = 0; c < 2; ++c) {
+					SimulationTime step = frequencyToPeriod(1000000) * dividers[d];
+					SimulationTime t = 2000 * step;
+					runIdleLoop(false, false, dividers[d], 1, SIMULATION_TIME_MAX,
+								SIMULATION_TIME_MAX, t, compares[c]);
+					uint64_t cycle = idleCore->interruptCycle;
+					SimulationTime time = idleCore->interruptTime;
+					CPPUNIT_ASSERT(cycle != 0);
+
+					for (int q = 0; q < 2; ++q) {
+						runIdleLoop(false, false, dividers[d], quanta[q], SIMULATION_TIME_MAX,
+									SIMULATION_TIME_MAX, t, compares[c]);
+						CPPUNIT_ASSERT_EQUAL(cycle, idleCore->interruptCycle);
+						CPPUNIT_ASSERT_EQUAL(time, idleCore->interruptTime);
+					}
+				}
+			}
+		}
+
+		void interruptAfterOutput() {
+			SimulationTime t = 100 * dco->getStep();
+			run(1, 13, SIMULATION_TIME_MAX, t);
+			int cycle = core->takenCycle;
+			SimulationTime time = core->takenTime;
+			CPPUNIT_ASSERT_EQUAL(14, cycle);
+
+			// The output ends the quantum in its middle and the interrupt
+			// requested in reaction to it is taken at the same cycle and time
+			// as in the lock-step mode.
+			run(8, 13, SIMULATION_TIME_MAX, t);
+			CPPUNIT_ASSERT(core->outputDelay != 0);
+			CPPUNIT_ASSERT_EQUAL(cycle, core->takenCycle);
+			CPPUNIT_ASSERT_EQUAL(time, core->takenTime);
+		}
+
+		void interruptMidQuantum() {
+			SimulationTime step = dco->getStep();
+			SimulationTime t = 100 * step;
+			SimulationTime at = 13 * step + step / 4;
+			run(1, 0, at, t);
+			int cycle = core->takenCycle;
+			SimulationTime time = core->takenTime;
+			CPPUNIT_ASSERT(time >= at);
+			CPPUNIT_ASSERT(time < at + step);
+
+			// Ticks of the current quantum are already executed, so the
+			// interrupt is taken at the first tick of the next one.
+			run(8, 0, at, t);
+			CPPUNIT_ASSERT_EQUAL((SimulationTime) 0, core->takenLocalTime);
+			CPPUNIT_ASSERT(core->takenCycle > cycle);
+			CPPUNIT_ASSERT(core->takenCycle <= cycle + 8);
+			CPPUNIT_ASSERT(core->takenTime > time);
+			CPPUNIT_ASSERT(core->takenTime <= time + 8 * step);
+		}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (QuantumTest);
@@ -0,0 +1,210 @@
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "adevs.h"
+#include "Peripherals/SimulationTime.h"
+#include "BenchmarkProject.h"
+
+#include <set>
+
+typedef adevs::Bag<ScheduledModel *> ImminentModels;
+
+/// Model which is only put into the schedule
+class IdleModel : public ScheduledModel {
+	public:
+		void delta_int() {}
+		void delta_ext(SimulationTime e, const adevs::Bag<int> &xb) {}
+		void delta_conf(const adevs::Bag<int> &xb) {}
+		void output_func(adevs::Bag<int> &yb) {}
+		SimulationTime ta() { return SIMULATION_TIME_MAX; }
+		void gc_output(adevs::Bag<int> &g) {}
+};
+
+/// Linear congruential generator, so both schedules get the same sequence
+/// on every platform.
+class Random {
+	public:
+		Random() : m_state(1) {}
+
+		unsigned int next(unsigned int max) {
+			m_state = m_state * 6364136223846793005ULL + 1442695040888963407ULL;
+			return (m_state >> 33) % max;
+		}
+
+	private:
+		uint64_t m_state;
+};
+
+/// Wheel which can be reached from the test while the Simulator owns it
+class ObservedWheel : public adevs::TimingWheel<int, SimulationTime> {
+	public:
+		ObservedWheel() { last = this; }
+
+		static ObservedWheel *last;
+};
+
+ObservedWheel *ObservedWheel::last = 0;
+
+class TimingWheelTest : public CPPUNIT_NS :: TestFixture{
+	CPPUNIT_TEST_SUITE(TimingWheelTest);
+	CPPUNIT_TEST(sameAsHeap);
+	CPPUNIT_TEST(distantEvents);
+	CPPUNIT_TEST(timeAdvanceChanged);
+	CPPUNIT_TEST(scheduleAtCurrentTime);
+	CPPUNIT_TEST(noRebaseInSimulation);
+	CPPUNIT_TEST_SUITE_END();
+
+	public:
+		void setUp (void) {
+
+		}
+
+		void tearDown (void) {
+
+		}
+
+		std::set<int> imminent(const ImminentModels &imm, IdleModel *models) {
+			std::set<int> ret;
+			for (ImminentModels::const_iterator it = imm.begin(); it != imm.end(); ++it) {
+				ret.insert(static_cast<IdleModel *>(*it) - models);
+			}
+			return ret;
+		}
+
+		void sameAsHeap() {
+			const int count = 50;
+			IdleModel a[count];
+			IdleModel b[count];
+			adevs::Schedule<int, SimulationTime> heap;
+			adevs::TimingWheel<int, SimulationTime> wheel;
+			Random random;
+
+			SimulationTime now = 0;
+			for (int i = 0; i < 100000; ++i) {
+				int model = random.next(count);
+				SimulationTime t;
+				switch (random.next(6)) {
+					case 0: t = SIMULATION_TIME_MAX; break;
+					case 1: t = now + random.next(3); break;
+					case 2: t = now + random.next(100000); break;
+					case 3: t = now + ((SimulationTime) random.next(1000000) << random.next(30)); break;
+					// Inputs can be injected before the next event
+					case 4: t = now - std::min(now, (SimulationTime) random.next(5)); break;
+					default: t = now + frequencyToPeriod(1000000); break;
+				}
+
+				heap.schedule(&a[model], t);
+				wheel.schedule(&b[model], t);
+				CPPUNIT_ASSERT_EQUAL(heap.minPriority(), wheel.minPriority());
+				CPPUNIT_ASSERT_EQUAL(heap.getSize(), wheel.getSize());
+
+				if (random.next(5) == 0 && !heap.empty()) {
+					ImminentModels immHeap;
+					ImminentModels immWheel;
+					heap.getImminent(immHeap);
+					wheel.getImminent(immWheel);
+					CPPUNIT_ASSERT(imminent(immHeap, a) == imminent(immWheel, b));
+					now = heap.minPriority();
+				}
+			}
+		}
+
+		void distantEvents() {
+			IdleModel m[4];
+			adevs::TimingWheel<int, SimulationTime> wheel;
+			CPPUNIT_ASSERT(wheel.empty());
+			CPPUNIT_ASSERT_EQUAL(SIMULATION_TIME_MAX, wheel.minPriority());
+
+			wheel.schedule(&m[0], SIMULATION_TIME_MAX - 1);
+			wheel.schedule(&m[1], 3 * TIME_UNITS_PER_SECOND);
+			wheel.schedule(&m[2], 3 * TIME_UNITS_PER_SECOND);
+			wheel.schedule(&m[3], 1);
+			CPPUNIT_ASSERT_EQUAL(4u, wheel.getSize());
+			CPPUNIT_ASSERT_EQUAL((SimulationTime) 1, wheel.minPriority());
+			CPPUNIT_ASSERT(wheel.getMinimum() == &m[3]);
+
+			wheel.removeMinimum();
+			CPPUNIT_ASSERT_EQUAL(3 * TIME_UNITS_PER_SECOND, wheel.minPriority());
+			ImminentModels imm;
+			wheel.getImminent(imm);
+			CPPUNIT_ASSERT_EQUAL(2u, imm.size());
+
+			wheel.removeImminent();
+			CPPUNIT_ASSERT_EQUAL(SIMULATION_TIME_MAX - 1, wheel.minPriority());
+
+			// Moving the only model back in time
+			wheel.schedule(&m[0], 5);
+			CPPUNIT_ASSERT_EQUAL((SimulationTime) 5, wheel.minPriority());
+
+			wheel.schedule(&m[0], SIMULATION_TIME_MAX);
+			CPPUNIT_ASSERT(wheel.empty());
+			CPPUNIT_ASSERT_EQUAL(SIMULATION_TIME_MAX, wheel.minPriority());
+		}
+
+		void timeAdvanceChanged() {
+			BenchmarkProject<adevs::TimingWheel<int, SimulationTime> > project(10, 0);
+			SimulationTime step = frequencyToPeriod(1000000);
+
+			// Pin changes every 10 DCO cycles are delivered to the peripheral
+			// at the time of the cycle which caused them.
+			project.run(10 * step - 1);
+			CPPUNIT_ASSERT_EQUAL(0, project.peripheral->inputs);
+			project.run(10 * step);
+			CPPUNIT_ASSERT_EQUAL(1, project.peripheral->inputs);
+			project.run(100 * step);
+			CPPUNIT_ASSERT_EQUAL(10, project.peripheral->inputs);
+
+			// Change outside of the transition takes effect at the time of
+			// the next event
+			project.mcu->pending = true;
+			project.sim->timeAdvanceChanged(project.mcu);
+			CPPUNIT_ASSERT_EQUAL(101 * step, project.sim->nextEventTime());
+			project.sim->execNextEvent();
+			CPPUNIT_ASSERT_EQUAL(11, project.peripheral->inputs);
+		}
+
+		void scheduleAtCurrentTime() {
+			IdleModel m[5];
+			adevs::TimingWheel<int, SimulationTime> wheel;
+			wheel.schedule(&m[0], 10);
+			wheel.schedule(&m[1], 10);
+			wheel.schedule(&m[2], 1000);
+
+			ImminentModels imm;
+			wheel.getImminent(imm);
+			CPPUNIT_ASSERT_EQUAL(2u, imm.size());
+
+			// The Simulator schedules the imminent models first and then the
+			// activated ones, which can still be at the current time.
+			wheel.schedule(&m[0], 500);
+			wheel.schedule(&m[1], 2000);
+			wheel.schedule(&m[3], 10);
+			wheel.schedule(&m[4], 60);
+			CPPUNIT_ASSERT_EQUAL(0u, wheel.getRebaseCount());
+			CPPUNIT_ASSERT_EQUAL((SimulationTime) 10, wheel.minPriority());
+			CPPUNIT_ASSERT(wheel.getMinimum() == &m[3]);
+
+			wheel.removeMinimum();
+			CPPUNIT_ASSERT_EQUAL((SimulationTime) 60, wheel.minPriority());
+			wheel.removeMinimum();
+			CPPUNIT_ASSERT_EQUAL((SimulationTime) 500, wheel.minPriority());
+			CPPUNIT_ASSERT_EQUAL(0u, wheel.getRebaseCount());
+
+			// Input injected before the next event builds the wheel again
+			wheel.schedule(&m[3], 100);
+			CPPUNIT_ASSERT_EQUAL(1u, wheel.getRebaseCount());
+			CPPUNIT_ASSERT_EQUAL((SimulationTime) 100, wheel.minPriority());
+			CPPUNIT_ASSERT_EQUAL(4u, wheel.getSize());
+		}
+
+		void noRebaseInSimulation() {
+			// Pin changes are routed through the MCU with zero time advance,
+			// so they are scheduled at the current time after the DCO.
+			BenchmarkProject<ObservedWheel> project(3, 4);
+			project.run(1000 * frequencyToPeriod(1000000));
+			CPPUNIT_ASSERT(project.peripheral->inputs > 300);
+			CPPUNIT_ASSERT_EQUAL(0u, ObservedWheel::last->getRebaseCount());
+		}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION (TimingWheelTest);